@@ -2,6 +2,7 @@
 #include <thread>
 #include <iostream>
 
+#include "common/arena.h"
 #include "common/option_parser.h"
 #include "common/console/console.h"
 #include "common/command/command_console.h"
@@ -42,6 +43,9 @@ void signalHandler( int32_t signal )
  */
 int main( int argc, char *argv[] )
 {
+    // Has to happen before anything creates a cJSON object
+    Arena::installHooks();
+
     // Signal handler
     struct sigaction sa_sigsev;
     struct sigaction sa_quit;
@@ -86,6 +90,12 @@ int main( int argc, char *argv[] )
     CommandConsole cmdConsole;
     hw->addCommand( &cmdConsole );
 
+    // Registration is done, switch command lookups over to the hash table
+    hw->getCommandHandler()->freeze();
+
+    // Nothing is served until the commands are in place
+    hw->start();
+
     std::thread *app = new std::thread( &Console::run, console );
 
     // Run the application and wait for its completion
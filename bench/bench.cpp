@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+namespace Bench
+{
+
+const double min_duration_ns     = 200e6;
+const uint64_t max_iterations    = 1ull << 32;
+
+/**
+ * @brief Keeps the compiler from optimizing away work whose result is unused
+ * @param pointer Pointer to the result
+ */
+void escape( const void *pointer )
+{
+    __asm__ __volatile__( "" : : "g"( pointer ) : "memory" );
+}
+
+/**
+ * @brief Retrieves the resident set size of the process
+ * @return Resident set size in KB, 0 if it couldn't be read
+ */
+size_t getRss()
+{
+    size_t rss = 0;
+
+    FILE *file = fopen( "/proc/self/statm", "r" );
+    if( file != nullptr ) {
+        unsigned long size = 0;
+        unsigned long resident = 0;
+        if( fscanf( file, "%lu %lu", &size, &resident ) == 2 ) {
+            rss = resident * ( sysconf( _SC_PAGESIZE ) / 1024 );
+        }
+        fclose( file );
+    }
+
+    return rss;
+}
+
+/**
+ * @brief Reads a whole file
+ * @param path Path of the file
+ * @param contents String filled with the contents of the file
+ * @return Boolean indicating the file was read
+ */
+bool readFile( const std::string &path, std::string *contents )
+{
+    FILE *file = fopen( path.c_str(), "rb" );
+    if( file == nullptr ) {
+        return false;
+    }
+
+    contents->clear();
+
+    char buffer[ 4096 ];
+    size_t size = 0;
+    while( ( size = fread( buffer, 1, sizeof( buffer ), file ) ) > 0 ) {
+        contents->append( buffer, size );
+    }
+
+    bool r = ferror( file ) == 0;
+    fclose( file );
+    return r;
+}
+
+/**
+ * @brief Lists the files in a directory with a given extension
+ * @param directory Directory to list
+ * @param extension Extension including the dot, e.g. ".json"
+ * @return Paths of the files, sorted by name
+ */
+std::vector< std::string > listFiles( const std::string &directory
+                                      , const char *extension )
+{
+    std::vector< std::string > files;
+
+    DIR *dir = opendir( directory.c_str() );
+    if( dir == nullptr ) {
+        return files;
+    }
+
+    size_t extensionLength = strlen( extension );
+    struct dirent *entry = nullptr;
+    while( ( entry = readdir( dir ) ) != nullptr ) {
+        size_t length = strlen( entry->d_name );
+        if( length > extensionLength
+                && strcmp( entry->d_name + length - extensionLength, extension ) == 0 ) {
+            files.push_back( directory + "/" + entry->d_name );
+        }
+    }
+    closedir( dir );
+
+    std::sort( files.begin(), files.end() );
+    return files;
+}
+
+}
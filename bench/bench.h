@@ -0,0 +1,59 @@
+/** ****************************************************************************
+ * @file bench.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief Helpers shared by the benchmarks. Each benchmark is its own
+ * executable printing one table, built only when BUILD_BENCH is on.
+ * ****************************************************************************/
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Bench
+{
+
+using Clock = std::chrono::steady_clock;
+
+// A measurement is repeated with twice the iterations until it runs this long
+extern const double min_duration_ns;
+extern const uint64_t max_iterations;
+
+/**
+ * @brief Times a piece of work, repeating it until the run is long enough to
+ * trust
+ * @param work Callable running the work a given number of times
+ * @return Nanoseconds per iteration
+ */
+template< typename Work >
+double measure( Work work )
+{
+    uint64_t iterations = 1;
+    for( ;; ) {
+        Clock::time_point start = Clock::now();
+        work( iterations );
+        double elapsed = std::chrono::duration< double, std::nano >(
+                    Clock::now() - start ).count();
+
+        if( elapsed >= min_duration_ns || iterations >= max_iterations ) {
+            return elapsed / iterations;
+        }
+        iterations *= 2;
+    }
+}
+
+void escape( const void *pointer );
+
+size_t getRss();
+
+bool readFile( const std::string &path, std::string *contents );
+std::vector< std::string > listFiles( const std::string &directory
+                                      , const char *extension );
+
+}
+
+#endif // BENCH_H
@@ -0,0 +1,122 @@
+/** ****************************************************************************
+ * @file buffer_append.cpp
+ * @author Trevor Horst
+ * @copyright
+ * @brief Benchmark for accumulating a request body piece by piece, the way
+ * the server receives it. Compares the old copy on every append with Buffer
+ * growing on its own, reserved up front from the Content-Length and chunked.
+ *
+ * Usage: bench_buffer_append [piece size]
+ * ****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "bench.h"
+#include "common/buffer.h"
+
+static const size_t default_piece_size  = 4 * 1024;
+static const size_t min_body_size       = 1024;
+static const size_t max_body_size       = 64 * 1024 * 1024;
+
+// Copying on every append is quadratic, past this it takes minutes
+static const size_t max_copy_body_size  = 4 * 1024 * 1024;
+
+/**
+ * @brief Appends the way the body used to, copying everything received so far
+ * into a new block every time
+ * @param body Body, replaced by the new block
+ * @param bodySize Size of the body, updated
+ * @param data Data to append
+ * @param size Size of the data
+ */
+static void appendCopy( char **body, size_t *bodySize, const char *data, size_t size )
+{
+    char *previous = *body;
+    *body = new char[ *bodySize + size + 1 ];
+    memcpy( *body, previous, *bodySize );
+    memcpy( *body + *bodySize, data, size );
+    *bodySize += size;
+    ( *body )[ *bodySize ] = '\0';
+    delete[] previous;
+}
+
+/**
+ * @brief Prints the throughput of one way of building a body
+ * @param name Name of the method
+ * @param bodySize Size of the body
+ * @param ns Nanoseconds to build the body
+ */
+static void report( const char *name, size_t bodySize, double ns )
+{
+    printf( "%-12s %10zu %14.0f %10.1f\n"
+            , name, bodySize, ns, bodySize / ns * 1e9 / ( 1024 * 1024 ) );
+}
+
+int main( int argc, char *argv[] )
+{
+    size_t pieceSize = argc > 1 ? strtoul( argv[ 1 ], nullptr, 10 ) : default_piece_size;
+    if( pieceSize == 0 ) {
+        fprintf( stderr, "Invalid piece size\n" );
+        return 1;
+    }
+
+    std::vector< char > piece( pieceSize, 'x' );
+
+    printf( "%-12s %10s %14s %10s\n", "method", "bytes", "ns", "MB/s" );
+
+    for( size_t bodySize = min_body_size; bodySize <= max_body_size; bodySize *= 4 ) {
+        size_t pieces = ( bodySize + pieceSize - 1 ) / pieceSize;
+        size_t last = bodySize - ( pieces - 1 ) * pieceSize;
+
+        if( bodySize <= max_copy_body_size ) {
+            report( "copy", bodySize, Bench::measure( [ & ]( uint64_t iterations ) {
+                for( uint64_t i = 0; i < iterations; i++ ) {
+                    char *body = nullptr;
+                    size_t size = 0;
+                    for( size_t p = 0; p < pieces; p++ ) {
+                        appendCopy( &body, &size, piece.data()
+                                    , p + 1 < pieces ? pieceSize : last );
+                    }
+                    Bench::escape( body );
+                    delete[] body;
+                }
+            } ) );
+        }
+
+        report( "grow", bodySize, Bench::measure( [ & ]( uint64_t iterations ) {
+            for( uint64_t i = 0; i < iterations; i++ ) {
+                Buffer buffer;
+                for( size_t p = 0; p < pieces; p++ ) {
+                    buffer.append( piece.data(), p + 1 < pieces ? pieceSize : last );
+                }
+                Bench::escape( buffer.getData() );
+            }
+        } ) );
+
+        report( "reserve", bodySize, Bench::measure( [ & ]( uint64_t iterations ) {
+            for( uint64_t i = 0; i < iterations; i++ ) {
+                Buffer buffer;
+                buffer.reserve( bodySize );
+                for( size_t p = 0; p < pieces; p++ ) {
+                    buffer.append( piece.data(), p + 1 < pieces ? pieceSize : last );
+                }
+                Bench::escape( buffer.getData() );
+            }
+        } ) );
+
+        report( "chunked", bodySize, Bench::measure( [ & ]( uint64_t iterations ) {
+            for( uint64_t i = 0; i < iterations; i++ ) {
+                Buffer buffer( Buffer::Mode::CHUNKED );
+                for( size_t p = 0; p < pieces; p++ ) {
+                    buffer.append( piece.data(), p + 1 < pieces ? pieceSize : last );
+                }
+                size_t size = 0;
+                Bench::escape( buffer.getChunk( 0, &size ) );
+            }
+        } ) );
+    }
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+/** ****************************************************************************
+ * @file command_lookup.cpp
+ * @author Trevor Horst
+ * @copyright
+ * @brief Benchmark for resolving command names. Compares the frozen command
+ * table with the hash map commands are registered in, looking up every
+ * command the BeagleBone Black registers and a name that isn't registered.
+ *
+ * Usage: bench_command_lookup
+ * ****************************************************************************/
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "common/command/command_table.h"
+#include "common/common_types.h"
+#include "common/logger/log.h"
+
+// Registered by hardware/beagleboneblack, accessors and mutators
+static const char *command_names[] = {
+    "help"
+    , "qmetrics"
+    , "gpio"
+    , "qgpio"
+    , "heartbeat"
+    , "qheartbeat"
+    , "system"
+    , "qsystem"
+    , "chrono"
+    , "qchrono"
+    , "server"
+    , "qserver"
+    , "led"
+    , "qled"
+    , "gps"
+    , "qgps"
+    , nullptr
+};
+
+static const char *missing_name = "qunknown";
+
+int main( int argc, char *argv[] )
+{
+    (void)argc;
+    (void)argv;
+
+    log_set_level( LOG_WARN );
+
+    // The table only hands the containers back, they are never dereferenced
+    std::vector< char > containers( sizeof( command_names ) / sizeof( command_names[ 0 ] ) );
+
+    Types::CharHashMap< CommandContainer* > map;
+    for( uint32_t i = 0; command_names[ i ] != nullptr; i++ ) {
+        map[ command_names[ i ] ] = reinterpret_cast< CommandContainer* >( &containers[ i ] );
+    }
+
+    CommandTable table;
+    if( !table.build( map ) ) {
+        fprintf( stderr, "Failed to build the command table\n" );
+        return 1;
+    }
+
+    // Names arrive in request buffers, never as the pointers registered
+    std::vector< std::string > names;
+    for( uint32_t i = 0; command_names[ i ] != nullptr; i++ ) {
+        names.push_back( command_names[ i ] );
+    }
+    std::string missing( missing_name );
+
+    printf( "%-8s %8s %10s %10s\n", "lookup", "commands", "ns/hit", "ns/miss" );
+
+    double hit = Bench::measure( [ & ]( uint64_t iterations ) {
+        for( uint64_t i = 0; i < iterations; i++ ) {
+            auto it = map.find( names[ i % names.size() ].c_str() );
+            Bench::escape( &it );
+        }
+    } );
+    double miss = Bench::measure( [ & ]( uint64_t iterations ) {
+        for( uint64_t i = 0; i < iterations; i++ ) {
+            auto it = map.find( missing.c_str() );
+            Bench::escape( &it );
+        }
+    } );
+    printf( "%-8s %8zu %10.2f %10.2f\n", "map", names.size(), hit, miss );
+
+    hit = Bench::measure( [ & ]( uint64_t iterations ) {
+        for( uint64_t i = 0; i < iterations; i++ ) {
+            CommandContainer *container = table.find( names[ i % names.size() ].c_str() );
+            Bench::escape( container );
+        }
+    } );
+    miss = Bench::measure( [ & ]( uint64_t iterations ) {
+        for( uint64_t i = 0; i < iterations; i++ ) {
+            CommandContainer *container = table.find( missing.c_str() );
+            Bench::escape( container );
+        }
+    } );
+    printf( "%-8s %8u %10.2f %10.2f\n", "table", table.getCount(), hit, miss );
+
+    return 0;
+}
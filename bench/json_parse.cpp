@@ -0,0 +1,102 @@
+/** ****************************************************************************
+ * @file json_parse.cpp
+ * @author Trevor Horst
+ * @copyright
+ * @brief Benchmark for parsing command payloads. Every file in the corpus is
+ * parsed with cJSON and with the JsonParser front end, and the two trees are
+ * checked to be the same. Build with USE_SIMD_JSON for the front end to scan
+ * with SSE2 or NEON, without it the front end is cJSON as well and only the
+ * cJSON timings are reported.
+ *
+ * Usage: bench_json_parse [corpus directory]
+ * ****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "common/cjson/cJSON.h"
+#include "common/json_parser.h"
+
+#if defined( USE_SIMD_JSON )
+static const bool simd = true;
+#else
+static const bool simd = false;
+#endif
+
+/**
+ * @brief Prints the cost of one parser on one payload
+ * @param parser Name of the parser
+ * @param name Name of the payload
+ * @param size Size of the payload
+ * @param ns Nanoseconds per parse
+ */
+static void report( const char *parser, const char *name, size_t size, double ns )
+{
+    printf( "%-8s %-24s %8zu %12.0f %10.1f\n"
+            , parser, name, size, ns, size / ns * 1e9 / ( 1024 * 1024 ) );
+}
+
+int main( int argc, char *argv[] )
+{
+    std::string directory = argc > 1 ? argv[ 1 ] : BENCH_CORPUS_DIR "/commands";
+
+    std::vector< std::string > files = Bench::listFiles( directory, ".json" );
+    if( files.empty() ) {
+        fprintf( stderr, "No payloads in %s\n", directory.c_str() );
+        return 1;
+    }
+
+    if( !simd ) {
+        printf( "Built without USE_SIMD_JSON, the front end is cJSON and isn't timed\n" );
+    }
+    printf( "%-8s %-24s %8s %12s %10s\n", "parser", "payload", "bytes", "ns", "MB/s" );
+
+    int r = 0;
+    for( const std::string &file : files ) {
+        std::string payload;
+        if( !Bench::readFile( file, &payload ) ) {
+            fprintf( stderr, "Failed to read %s\n", file.c_str() );
+            return 1;
+        }
+
+        const char *name = strrchr( file.c_str(), '/' ) + 1;
+        const char *data = payload.c_str();
+        size_t size = payload.size();
+
+        // Both have to agree before their timings mean anything
+        cJSON *expected = cJSON_Parse( data );
+        cJSON *parsed = JsonParser::parse( data, size );
+        bool same = expected != nullptr && cJSON_Compare( expected, parsed, true );
+        cJSON_Delete( expected );
+        cJSON_Delete( parsed );
+        if( !same ) {
+            fprintf( stderr, "%s: the trees differ\n", name );
+            r = 1;
+            continue;
+        }
+
+        report( "cjson", name, size, Bench::measure( [ & ]( uint64_t iterations ) {
+            for( uint64_t i = 0; i < iterations; i++ ) {
+                cJSON *root = cJSON_Parse( data );
+                Bench::escape( root );
+                cJSON_Delete( root );
+            }
+        } ) );
+
+        if( !simd ) {
+            continue;
+        }
+
+        report( "simd", name, size, Bench::measure( [ & ]( uint64_t iterations ) {
+            for( uint64_t i = 0; i < iterations; i++ ) {
+                cJSON *root = JsonParser::parse( data, size );
+                Bench::escape( root );
+                cJSON_Delete( root );
+            }
+        } ) );
+    }
+
+    return r;
+}
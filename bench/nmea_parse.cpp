@@ -0,0 +1,213 @@
+/** ****************************************************************************
+ * @file nmea_parse.cpp
+ * @author Trevor Horst
+ * @copyright
+ * @brief Throughput benchmark for the NMEA parser over logs of receiver
+ * output. Every sentence is validated and parsed into its struct, the way the
+ * qgps accessors do. Reports the whole log and each sentence type.
+ *
+ * Usage: bench_nmea_parse [log]
+ * ****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "common/drivers/devices/gps/nmea_parser.h"
+
+/**
+ * @brief Sentence in the log
+ */
+struct Line {
+    const char *text;
+    uint32_t length;
+};
+
+/**
+ * @brief Sentence types the parser handles
+ */
+enum Type {
+    GGA     = 0
+    , RMC
+    , GSA
+    , GSV
+    , VTG
+    , ZDA
+    , TYPE_MAX
+};
+
+static const char *type_names[] = { "GGA", "RMC", "GSA", "GSV", "VTG", "ZDA" };
+
+/**
+ * @brief Determines the type of a sentence from the three characters after
+ * the talker
+ * @param line Sentence
+ * @return Type, TYPE_MAX if the parser doesn't handle it
+ */
+static Type getType( const Line &line )
+{
+    if( line.length > 6 ) {
+        for( uint32_t t = 0; t < Type::TYPE_MAX; t++ ) {
+            if( strncmp( line.text + 3, type_names[ t ], 3 ) == 0 ) {
+                return static_cast< Type >( t );
+            }
+        }
+    }
+    return Type::TYPE_MAX;
+}
+
+/**
+ * @brief Validates and parses a sentence
+ * @param line Sentence
+ * @param type Type of the sentence
+ * @return Boolean indicating the sentence was parsed
+ */
+static bool parse( const Line &line, Type type )
+{
+    if( !Gps::Nmea::Parser::validate( line.text, line.length ) ) {
+        return false;
+    }
+
+    bool r = false;
+    switch( type ) {
+    case Type::GGA: {
+        Gps::Nmea::Gga gga;
+        r = Gps::Nmea::Parser::parse( line.text, line.length, &gga );
+        Bench::escape( &gga );
+        break;
+    }
+    case Type::RMC: {
+        Gps::Nmea::Rmc rmc;
+        r = Gps::Nmea::Parser::parse( line.text, line.length, &rmc );
+        Bench::escape( &rmc );
+        break;
+    }
+    case Type::GSA: {
+        Gps::Nmea::Gsa gsa;
+        r = Gps::Nmea::Parser::parse( line.text, line.length, &gsa );
+        Bench::escape( &gsa );
+        break;
+    }
+    case Type::GSV: {
+        Gps::Nmea::Gsv gsv;
+        r = Gps::Nmea::Parser::parse( line.text, line.length, &gsv );
+        Bench::escape( &gsv );
+        break;
+    }
+    case Type::VTG: {
+        Gps::Nmea::Vtg vtg;
+        r = Gps::Nmea::Parser::parse( line.text, line.length, &vtg );
+        Bench::escape( &vtg );
+        break;
+    }
+    case Type::ZDA: {
+        Gps::Nmea::Zda zda;
+        r = Gps::Nmea::Parser::parse( line.text, line.length, &zda );
+        Bench::escape( &zda );
+        break;
+    }
+    default:
+        break;
+    }
+
+    return r;
+}
+
+/**
+ * @brief Prints the throughput over a set of sentences
+ * @param name Name of the set
+ * @param count Number of sentences
+ * @param size Size of the sentences
+ * @param ns Nanoseconds to parse all of them
+ */
+static void report( const char *name, size_t count, size_t size, double ns )
+{
+    printf( "%-6s %10zu %10zu %10.1f %12.0f %10.1f\n"
+            , name, count, size, ns / count
+            , count / ns * 1e9, size / ns * 1e9 / ( 1024 * 1024 ) );
+}
+
+int main( int argc, char *argv[] )
+{
+    std::string path = argc > 1 ? argv[ 1 ] : BENCH_CORPUS_DIR "/nmea/venus638flpx_1hz.nmea";
+
+    std::string log;
+    if( !Bench::readFile( path, &log ) ) {
+        fprintf( stderr, "Failed to read %s\n", path.c_str() );
+        return 1;
+    }
+
+    // Sentences are handed to the parser without their line endings, as the
+    // reader thread stores them
+    std::vector< Line > sentences[ Type::TYPE_MAX + 1 ];
+    size_t sizes[ Type::TYPE_MAX + 1 ] = { 0 };
+    std::vector< Line > all;
+    size_t total = 0;
+
+    const char *c = log.c_str();
+    while( *c != '\0' ) {
+        const char *end = strchr( c, '\n' );
+        size_t length = end ? static_cast< size_t >( end - c ) : strlen( c );
+        const char *next = end ? end + 1 : c + length;
+
+        if( length > 0 && c[ length - 1 ] == '\r' ) {
+            length--;
+        }
+        if( length > 0 && c[ 0 ] == '$' ) {
+            Line line = { c, static_cast< uint32_t >( length ) };
+            Type type = getType( line );
+            sentences[ type ].push_back( line );
+            sizes[ type ] += length;
+            all.push_back( line );
+            total += length;
+        }
+
+        c = next;
+    }
+
+    if( all.empty() ) {
+        fprintf( stderr, "No sentences in %s\n", path.c_str() );
+        return 1;
+    }
+
+    // Anything rejected is reported, a bad log would make the numbers lie
+    size_t failed = 0;
+    for( const Line &line : all ) {
+        if( !parse( line, getType( line ) ) ) {
+            failed++;
+        }
+    }
+
+    printf( "%-6s %10s %10s %10s %12s %10s\n"
+            , "type", "sentences", "bytes", "ns/each", "sentences/s", "MB/s" );
+
+    report( "all", all.size(), total, Bench::measure( [ & ]( uint64_t iterations ) {
+        for( uint64_t i = 0; i < iterations; i++ ) {
+            for( const Line &line : all ) {
+                parse( line, getType( line ) );
+            }
+        }
+    } ) );
+
+    for( uint32_t t = 0; t < Type::TYPE_MAX; t++ ) {
+        const std::vector< Line > &set = sentences[ t ];
+        if( set.empty() ) {
+            continue;
+        }
+
+        Type type = static_cast< Type >( t );
+        report( type_names[ t ], set.size(), sizes[ t ], Bench::measure( [ & ]( uint64_t iterations ) {
+            for( uint64_t i = 0; i < iterations; i++ ) {
+                for( const Line &line : set ) {
+                    parse( line, type );
+                }
+            }
+        } ) );
+    }
+
+    printf( "%zu of %zu sentences rejected, %zu of a type not parsed\n"
+            , failed, all.size(), sentences[ Type::TYPE_MAX ].size() );
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+/** ****************************************************************************
+ * @file parameter_dispatch.cpp
+ * @author Trevor Horst
+ * @copyright
+ * @brief Benchmark for calling parameter methods the way a command schema
+ * does, from a table of callables. Compares the Delegate the schema holds with
+ * the std::function wrapping std::bind it replaced and a plain member function
+ * pointer, both for registering the parameters and for calling them.
+ *
+ * Usage: bench_parameter_dispatch
+ * ****************************************************************************/
+#include <functional>
+#include <stdio.h>
+#include <vector>
+
+#include "bench.h"
+#include "common/cjson/cJSON.h"
+#include "common/delegate.h"
+
+static const uint32_t parameter_count = 16;
+
+/**
+ * @brief Stands in for a command, its parameter methods do as little as
+ * possible so the dispatch is what gets measured
+ */
+class Target
+{
+public:
+    Target() : mValue( 0 ) {}
+
+    uint32_t setValue( cJSON *val )
+    {
+        mValue += val->valueint;
+        return 0;
+    }
+
+    uint32_t setOther( cJSON *val )
+    {
+        mValue ^= val->valueint;
+        return 0;
+    }
+
+    int64_t mValue;
+};
+
+using Method = uint32_t ( Target::* )( cJSON* );
+using Function = std::function< uint32_t ( cJSON* ) >;
+using Callback = Delegate< uint32_t ( cJSON* ) >;
+
+/**
+ * @brief Picks the method for a parameter, alternating so the calls can't be
+ * folded into one
+ * @param index Index of the parameter
+ * @return Method
+ */
+static Method method( uint32_t index )
+{
+    return ( index % 2 == 0 ) ? &Target::setValue : &Target::setOther;
+}
+
+int main( int argc, char *argv[] )
+{
+    (void)argc;
+    (void)argv;
+
+    Target *target = new Target();
+    cJSON *value = cJSON_CreateNumber( 3 );
+
+    std::vector< Method > methods;
+    std::vector< Function > functions;
+    std::vector< Callback > callbacks;
+
+    for( uint32_t i = 0; i < parameter_count; i++ ) {
+        methods.push_back( method( i ) );
+        functions.push_back( std::bind( method( i ), target, std::placeholders::_1 ) );
+        callbacks.push_back( Callback( target, method( i ) ) );
+    }
+
+    printf( "%-16s %14s %14s %14s\n"
+            , "callable", "bytes", "ns/register", "ns/call" );
+
+    // Registering, what every command pays for each parameter at startup
+    double registerFunction = Bench::measure( [ & ]( uint64_t iterations ) {
+        for( uint64_t i = 0; i < iterations; i++ ) {
+            Function function = std::bind( method( i ), target, std::placeholders::_1 );
+            Bench::escape( &function );
+        }
+    } );
+    double registerCallback = Bench::measure( [ & ]( uint64_t iterations ) {
+        for( uint64_t i = 0; i < iterations; i++ ) {
+            Callback callback( target, method( i ) );
+            Bench::escape( &callback );
+        }
+    } );
+
+    // Calling, what every request pays for each parameter it carries
+    double callMethod = Bench::measure( [ & ]( uint64_t iterations ) {
+        for( uint64_t i = 0; i < iterations; i++ ) {
+            ( target->*methods[ i % parameter_count ] )( value );
+        }
+        Bench::escape( target );
+    } );
+    double callFunction = Bench::measure( [ & ]( uint64_t iterations ) {
+        for( uint64_t i = 0; i < iterations; i++ ) {
+            functions[ i % parameter_count ]( value );
+        }
+        Bench::escape( target );
+    } );
+    double callCallback = Bench::measure( [ & ]( uint64_t iterations ) {
+        for( uint64_t i = 0; i < iterations; i++ ) {
+            callbacks[ i % parameter_count ]( value );
+        }
+        Bench::escape( target );
+    } );
+
+    printf( "%-16s %14zu %14s %14.2f\n"
+            , "member pointer", sizeof( Method ), "-", callMethod );
+    printf( "%-16s %14zu %14.2f %14.2f\n"
+            , "std::function", sizeof( Function ), registerFunction, callFunction );
+    printf( "%-16s %14zu %14.2f %14.2f\n"
+            , "Delegate", sizeof( Callback ), registerCallback, callCallback );
+
+    cJSON_Delete( value );
+    delete target;
+    return 0;
+}
@@ -0,0 +1,143 @@
+/** ****************************************************************************
+ * @file router_match.cpp
+ * @author Trevor Horst
+ * @copyright
+ * @brief Benchmark for matching request paths against 10 to 1000 registered
+ * routes. Compares the route tree with the regex per route approach it
+ * replaced, which tried every route in turn on a fresh copy of the path.
+ *
+ * Usage: bench_router_match
+ * ****************************************************************************/
+#include <regex>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "common/logger/log.h"
+#include "http/server/router.h"
+
+static const uint32_t route_counts[] = { 10, 100, 1000 };
+
+// What an untyped capture matched in the regex router
+static const char *regex_any = "([a-zA-Z0-9-$_.+!*'(),%]+)";
+static const char *regex_int = "(-?[0-9]+)";
+
+/**
+ * @brief Route handler, never called by the benchmark
+ * @param request Request
+ * @param match Captured parameters
+ */
+static void handle( Http::Request *request, const Http::Router::Match &match )
+{
+    (void)request;
+    (void)match;
+}
+
+/**
+ * @brief Builds a route path and a request path matching it. Routes take
+ * turns being fully static, having an integer capture and having an integer
+ * and a string capture.
+ * @param index Index of the route
+ * @param route Route path
+ * @param path Request path
+ * @param pattern Regular expression equivalent to the route
+ */
+static void makeRoute( uint32_t index, std::string *route, std::string *path
+                       , std::string *pattern )
+{
+    std::string base = "/api/resource" + std::to_string( index );
+
+    *route = base;
+    *path = base;
+    *pattern = "^" + base;
+
+    if( index % 3 > 0 ) {
+        *route += "/:id(int)";
+        *path += "/42";
+        *pattern += std::string( "/" ) + regex_int;
+    }
+    if( index % 3 > 1 ) {
+        *route += "/:field";
+        *path += "/status";
+        *pattern += std::string( "/" ) + regex_any;
+    }
+
+    *pattern += "$";
+}
+
+int main( int argc, char *argv[] )
+{
+    (void)argc;
+    (void)argv;
+
+    log_set_level( LOG_WARN );
+
+    printf( "%-8s %8s %14s %14s\n", "matcher", "routes", "ns/lookup", "ns/miss" );
+
+    for( uint32_t count : route_counts ) {
+        Http::Router router;
+        std::vector< std::regex > regexes;
+        std::vector< std::string > paths;
+
+        for( uint32_t i = 0; i < count; i++ ) {
+            std::string route;
+            std::string path;
+            std::string pattern;
+            makeRoute( i, &route, &path, &pattern );
+
+            router.addRoute( Http::Method::GET, route.c_str()
+                             , Http::Router::Handler( &handle ) );
+            regexes.push_back( std::regex( pattern ) );
+            paths.push_back( path );
+        }
+
+        // Every route is looked up in turn, the miss walks as far as it can
+        const char *miss = "/api/resource/unknown/path";
+
+        auto tree = [ & ]( const char *path ) {
+            const Http::Router::Handler *handler = nullptr;
+            Http::Router::Match match;
+            Http::Router::Result result = router.find(
+                        Http::Method::GET, path, &handler, &match );
+            Bench::escape( &result );
+        };
+
+        auto regex = [ & ]( const char *path ) {
+            for( size_t r = 0; r < regexes.size(); r++ ) {
+                std::string copy( path );
+                std::smatch match;
+                if( std::regex_search( copy, match, regexes[ r ] ) ) {
+                    Bench::escape( &match );
+                    break;
+                }
+            }
+        };
+
+        double found = Bench::measure( [ & ]( uint64_t iterations ) {
+            for( uint64_t i = 0; i < iterations; i++ ) {
+                tree( paths[ i % count ].c_str() );
+            }
+        } );
+        double missed = Bench::measure( [ & ]( uint64_t iterations ) {
+            for( uint64_t i = 0; i < iterations; i++ ) {
+                tree( miss );
+            }
+        } );
+        printf( "%-8s %8u %14.1f %14.1f\n", "tree", count, found, missed );
+
+        found = Bench::measure( [ & ]( uint64_t iterations ) {
+            for( uint64_t i = 0; i < iterations; i++ ) {
+                regex( paths[ i % count ].c_str() );
+            }
+        } );
+        missed = Bench::measure( [ & ]( uint64_t iterations ) {
+            for( uint64_t i = 0; i < iterations; i++ ) {
+                regex( miss );
+            }
+        } );
+        printf( "%-8s %8u %14.1f %14.1f\n", "regex", count, found, missed );
+    }
+
+    return 0;
+}
@@ -0,0 +1,239 @@
+/** ****************************************************************************
+ * @file server_load.cpp
+ * @author Trevor Horst
+ * @copyright
+ * @brief Load benchmark for Http::Server. For each threading model a growing
+ * number of keep-alive connections is held open, then hammered with requests
+ * for the index. Reports the threads and resident memory the connections cost
+ * and the request rate served across them.
+ *
+ * Usage: bench_server_load [port]
+ * ****************************************************************************/
+#include <arpa/inet.h>
+#include <atomic>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "bench.h"
+#include "common/logger/log.h"
+#include "http/server/server.h"
+
+static const uint16_t default_port          = 8181;
+static const uint32_t pool_size             = 2;
+static const uint32_t client_threads        = 4;
+static const uint32_t load_duration_ms      = 1000;
+static const uint32_t connection_counts[]   = { 1, 16, 64, 256 };
+
+static const char index_html[]  = "<html><body>bench</body></html>";
+static const char main_js[]     = "";
+static const char request[]     = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+/**
+ * @brief Retrieves the number of threads in the process
+ * @return Number of threads, 0 if it couldn't be read
+ */
+static uint32_t getThreads()
+{
+    uint32_t threads = 0;
+
+    FILE *file = fopen( "/proc/self/status", "r" );
+    if( file != nullptr ) {
+        char line[ 256 ];
+        while( fgets( line, sizeof( line ), file ) != nullptr ) {
+            if( sscanf( line, "Threads: %u", &threads ) == 1 ) {
+                break;
+            }
+        }
+        fclose( file );
+    }
+
+    return threads;
+}
+
+/**
+ * @brief Opens a connection to the server
+ * @param port Port the server listens on
+ * @return Socket, -1 on failure
+ */
+static int openConnection( uint16_t port )
+{
+    int fd = socket( AF_INET, SOCK_STREAM, 0 );
+    if( fd < 0 ) {
+        return -1;
+    }
+
+    int one = 1;
+    setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof( one ) );
+
+    struct timeval timeout = { 5, 0 };
+    setsockopt( fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof( timeout ) );
+
+    struct sockaddr_in address;
+    memset( &address, 0, sizeof( address ) );
+    address.sin_family = AF_INET;
+    address.sin_port = htons( port );
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+    if( connect( fd, reinterpret_cast< struct sockaddr* >( &address )
+                 , sizeof( address ) ) != 0 ) {
+        close( fd );
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * @brief Sends a request for the index and reads the whole response, leaving
+ * the connection open for the next one
+ * @param fd Socket
+ * @return Boolean indicating a response was received
+ */
+static bool get( int fd )
+{
+    if( send( fd, request, sizeof( request ) - 1, MSG_NOSIGNAL )
+            != static_cast< ssize_t >( sizeof( request ) - 1 ) ) {
+        return false;
+    }
+
+    char buffer[ 4096 ];
+    size_t received = 0;
+    size_t expected = 0;
+
+    for( ;; ) {
+        ssize_t size = recv( fd, buffer + received, sizeof( buffer ) - received - 1, 0 );
+        if( size <= 0 ) {
+            return false;
+        }
+        received += size;
+        buffer[ received ] = '\0';
+
+        if( expected == 0 ) {
+            char *end = strstr( buffer, "\r\n\r\n" );
+            if( end == nullptr ) {
+                continue;
+            }
+
+            const char *length = strcasestr( buffer, "Content-Length:" );
+            if( length == nullptr || length > end ) {
+                return false;
+            }
+            expected = ( end + 4 - buffer )
+                    + strtoul( length + strlen( "Content-Length:" ), nullptr, 10 );
+        }
+
+        if( received >= expected ) {
+            return true;
+        }
+        if( received + 1 >= sizeof( buffer ) ) {
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief Measures one threading model at each connection count
+ * @param threading Threading model
+ * @param port Port to listen on
+ */
+static void run( Http::Server::Threading threading, uint16_t port )
+{
+    Http::Server server( index_html, sizeof( index_html ) - 1
+                         , main_js, sizeof( main_js ) - 1
+                         , port, false, threading, pool_size );
+    if( !server.listen() ) {
+        fprintf( stderr, "Failed to listen on port %u\n", port );
+        return;
+    }
+
+    const char *mode = Http::Server::threading_strings[ threading ];
+    size_t baseRss = Bench::getRss();
+    uint32_t baseThreads = getThreads();
+
+    for( uint32_t count : connection_counts ) {
+        std::vector< int > connections;
+        for( uint32_t i = 0; i < count; i++ ) {
+            int fd = openConnection( port );
+            if( fd < 0 || !get( fd ) ) {
+                if( fd >= 0 ) {
+                    close( fd );
+                }
+                break;
+            }
+            connections.push_back( fd );
+        }
+
+        // What the idle connections cost
+        uint32_t threads = getThreads() - baseThreads;
+        long rss = static_cast< long >( Bench::getRss() ) - static_cast< long >( baseRss );
+
+        // Spread the connections over the client threads and keep every one
+        // of them busy
+        std::atomic< uint64_t > requests( 0 );
+        std::atomic< uint64_t > failures( 0 );
+        Bench::Clock::time_point deadline = Bench::Clock::now()
+                + std::chrono::milliseconds( load_duration_ms );
+
+        std::vector< std::thread > clients;
+        for( uint32_t t = 0; t < client_threads; t++ ) {
+            clients.emplace_back( [ &, t ]() {
+                uint64_t done = 0;
+                for( size_t i = t; Bench::Clock::now() < deadline; ) {
+                    if( i >= connections.size() ) {
+                        i = t;
+                        if( i >= connections.size() ) {
+                            break;
+                        }
+                    }
+                    if( get( connections[ i ] ) ) {
+                        done++;
+                    } else {
+                        failures++;
+                    }
+                    i += client_threads;
+                }
+                requests += done;
+            } );
+        }
+        for( auto &client : clients ) {
+            client.join();
+        }
+
+        printf( "%-24s %8zu %8u %10ld %12.0f %8lu\n"
+                , mode, connections.size(), threads, rss
+                , requests * 1000.0 / load_duration_ms
+                , static_cast< unsigned long >( failures.load() ) );
+
+        for( int fd : connections ) {
+            close( fd );
+        }
+
+        // Let the server notice the closed connections before the next round
+        std::this_thread::sleep_for( std::chrono::milliseconds( 200 ) );
+    }
+
+    server.stop();
+}
+
+int main( int argc, char *argv[] )
+{
+    uint16_t port = argc > 1 ? static_cast< uint16_t >( atoi( argv[ 1 ] ) ) : default_port;
+
+    log_set_level( LOG_WARN );
+
+    printf( "%-24s %8s %8s %10s %12s %8s\n"
+            , "threading", "conns", "threads", "rss_kb", "requests/s", "failed" );
+
+    for( uint32_t t = 0; t < Http::Server::Threading::THREADING_MAX; t++ ) {
+        run( static_cast< Http::Server::Threading >( t ), port + t );
+    }
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+/** ****************************************************************************
+ * @file arena.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief Arena class declaration. Bump allocator for short lived cJSON trees.
+ * Once the cJSON hooks are installed, every cJSON allocation made on a thread
+ * with an arena in scope is carved out of that arena and freeing it does
+ * nothing, the whole arena is released in one go when its owner is done.
+ * Allocations made anywhere else fall through to the heap. Each block is
+ * tagged so trees mixing the two can be deleted from any thread.
+ * ****************************************************************************/
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+class Arena
+{
+    static const size_t default_block_size;
+    static const size_t alignment;
+
+public:
+
+    /**
+     * @brief Makes an arena current on the calling thread until the scope ends
+     */
+    class Scope
+    {
+    public:
+        explicit Scope( Arena *arena );
+        ~Scope();
+
+        Scope( const Scope &scope ) = delete;
+        Scope& operator=( const Scope &scope ) = delete;
+
+    private:
+        Arena *mPrevious;
+    };
+
+    explicit Arena( size_t blockSize = default_block_size );
+    ~Arena();
+
+    Arena( const Arena &arena ) = delete;
+    Arena& operator=( const Arena &arena ) = delete;
+
+    void *allocate( size_t size );
+    void reset();
+
+    uint32_t getAllocations();
+    uint32_t getBlocks();
+    size_t getUsed();
+
+    static void installHooks();
+    static bool isInstalled();
+
+    static uint64_t getArenaAllocations();
+    static uint64_t getHeapAllocations();
+
+private:
+    struct Block {
+        Block *next;
+        size_t size;
+        size_t used;
+    };
+
+    size_t mBlockSize;
+    Block *mBlocks;
+    uint32_t mAllocations;
+    uint32_t mBlockCount;
+    size_t mUsed;
+
+    static thread_local Arena *sCurrent;
+    static std::atomic< bool > sInstalled;
+    static std::atomic< uint64_t > sArenaAllocations;
+    static std::atomic< uint64_t > sHeapAllocations;
+
+    Block *addBlock( size_t size );
+
+    static void *hookMalloc( size_t size );
+    static void hookFree( void *ptr );
+};
+
+#endif // ARENA_H
@@ -0,0 +1,75 @@
+/** ****************************************************************************
+ * @file buffer.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief Buffer class declaration. Growable byte buffer used anywhere data
+ * arrives piece by piece. Contiguous buffers double their capacity so appends
+ * are amortized constant time, chunked buffers keep a list of blocks so large
+ * payloads never have to be moved at all.
+ * ****************************************************************************/
+#ifndef BUFFER_H
+#define BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class Buffer
+{
+    static const size_t min_capacity;
+
+public:
+
+    static const size_t default_chunk_size;
+
+    enum Mode {
+        CONTIGUOUS  = 0
+        , CHUNKED   = 1
+    };
+
+    explicit Buffer( Mode mode = Mode::CONTIGUOUS
+            , size_t chunkSize = default_chunk_size );
+    ~Buffer();
+
+    Buffer( const Buffer &buffer ) = delete;
+    Buffer& operator=( const Buffer &buffer ) = delete;
+
+    bool append( const char *data, size_t size );
+    bool reserve( size_t capacity );
+    void clear();
+
+    char *release();
+
+    bool setMode( Mode mode );
+    Mode getMode();
+
+    const char *getData();
+    size_t getSize();
+    size_t getCapacity();
+
+    size_t getChunkCount();
+    const char *getChunk( size_t index, size_t *size );
+
+private:
+
+    struct Chunk {
+        char *data;
+        size_t size;
+        size_t capacity;
+    };
+
+    Mode mMode;
+    size_t mChunkSize;
+
+    char *mData;
+    size_t mSize;
+    size_t mCapacity;
+
+    std::vector< Chunk > mChunks;
+
+    bool grow( size_t capacity );
+    bool appendChunk( const char *data, size_t size );
+    bool flatten();
+};
+
+#endif // BUFFER_H
@@ -0,0 +1,42 @@
+/** ****************************************************************************
+ * @file codec.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief Codec class declaration. Picks the parser and writer for the
+ * encoding a command arrives in, so JSON and MessagePack clients are answered
+ * in kind by the same commands.
+ * ****************************************************************************/
+#ifndef CODEC_H
+#define CODEC_H
+
+#include <stddef.h>
+
+#include "common/buffer.h"
+#include "common/cjson/cJSON.h"
+
+class Codec
+{
+public:
+
+    enum Encoding {
+        JSON        = 0
+        , MSGPACK   = 1
+        , ENCODING_MAX
+    };
+
+    static const char *encoding_strings[];
+
+    static const char *content_type_json;
+    static const char *content_type_msgpack;
+
+    static cJSON *decode( const char *data, size_t size, Encoding encoding );
+    static bool encode( const cJSON *item, Encoding encoding, Buffer *buffer );
+
+    static const char *encodingToContentType( Encoding encoding );
+    static Encoding contentTypeToEncoding( const char *type );
+
+    static Encoding stringToEncoding( const char *encoding );
+    static const char *encodingToString( Encoding encoding );
+};
+
+#endif // CODEC_H
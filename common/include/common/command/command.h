@@ -1,36 +1,29 @@
 #ifndef COMMAND_H
 #define COMMAND_H
 
+#include <stdlib.h>
 #include <string.h>
 #include <vector>
-#include <functional>
 
 #include "common/cjson/cJSON.h"
 #include "common/control/control.h"
 #include "common/logger/log.h"
 
 #include "common/common_types.h"
+#include "common/command/command_cache.h"
+#include "common/command/command_schema.h"
 
 #define COMMAND_EMPTY   ""
 
 #define COMMAND_USAGE_MAX_SIZE 1024
 #define COMMAND_NAME_MAX_SIZE 64
 
-#define PARAMETER_CALLBACK( X ) std::bind( X, this, std::placeholders::_1 )
-
-#define BIND_PARAMETER( X ) do { \
-    std::bind( X, this, std::placeholders::_1 ); \
-} while( true )
-
 /**
  * @brief The Command class
  */
 class Command
 {
 public:
-    using ParameterCallback     = std::function< uint32_t (cJSON*) >;
-    using ParameterMap          = Types::CharHashMap< ParameterCallback >;
-
     enum Type {
         MUTATOR = 0
         , ACCESSOR = 1
@@ -55,19 +48,110 @@ public:
 
     void setError( uint32_t code, const char* details, cJSON *response );
 
+    CommandCache *getCache();
+    void invalidateCache();
+
 protected:
 
     std::vector< Control* > mCtrlObjList;
 
-    virtual uint32_t handleRequiredParameters( cJSON *params, const char *&details );
-
-    ParameterMap mRequiredMap;
-    ParameterMap mAccessorMap;
-    ParameterMap mMutatorMap;
-
-    ParameterCallback mOptional;
-    ParameterMap mOptionalAccessorMap;
-    ParameterMap mOptionalMutatorMap;
+    /**
+     * @brief Adds a parameter that must be in the params object for both the
+     * accessor and mutator, handled before any other parameter
+     * @param name Parameter name
+     * @param method Method handling the value
+     * @param format Types accepted for the value
+     */
+    template< typename C >
+    void addRequired( const char *name, uint32_t ( C::*method )( cJSON* ), int format )
+    {
+        addParameter( CommandSchema::REQUIRED, name, method, format );
+    }
+
+    /**
+     * @brief Sets the method handling the optional parameter named when the
+     * command was constructed. When the parameter is given the optional
+     * accessors and mutators are used in place of the regular ones.
+     * @param method Method handling the value
+     * @param format Types accepted for the value
+     */
+    template< typename C >
+    void setOptional( uint32_t ( C::*method )( cJSON* ), int format )
+    {
+        addParameter( CommandSchema::OPTIONAL, mOptionalParameter, method, format );
+    }
+
+    /**
+     * @brief Adds a parameter reported by the accessor
+     * @param name Parameter name
+     * @param method Method adding the value to the result
+     */
+    template< typename C >
+    void addAccessor( const char *name, uint32_t ( C::*method )( cJSON* ) )
+    {
+        addParameter( CommandSchema::ACCESSOR, name, method, CommandSchema::ANY );
+    }
+
+    /**
+     * @brief Adds a parameter the mutator may change
+     * @param name Parameter name
+     * @param method Method handling the value
+     * @param format Types accepted for the value
+     */
+    template< typename C >
+    void addMutator( const char *name, uint32_t ( C::*method )( cJSON* ), int format )
+    {
+        addParameter( CommandSchema::MUTATOR, name, method, format );
+    }
+
+    /**
+     * @brief Adds a parameter reported by the accessor when the optional
+     * parameter is given
+     * @param name Parameter name
+     * @param method Method adding the value to the result
+     */
+    template< typename C >
+    void addOptionalAccessor( const char *name, uint32_t ( C::*method )( cJSON* ) )
+    {
+        addParameter( CommandSchema::OPTIONAL_ACCESSOR, name, method, CommandSchema::ANY );
+    }
+
+    /**
+     * @brief Adds a parameter the mutator may change when the optional
+     * parameter is given
+     * @param name Parameter name
+     * @param method Method handling the value
+     * @param format Types accepted for the value
+     */
+    template< typename C >
+    void addOptionalMutator( const char *name, uint32_t ( C::*method )( cJSON* ), int format )
+    {
+        addParameter( CommandSchema::OPTIONAL_MUTATOR, name, method, format );
+    }
+
+    /**
+     * @brief Adds a parameter to the schema
+     * @param role Role the method handles
+     * @param name Parameter name
+     * @param method Method of the derived command
+     * @param format Types accepted for the value
+     */
+    template< typename C >
+    void addParameter( CommandSchema::Role role, const char *name
+                       , uint32_t ( C::*method )( cJSON* ), int format )
+    {
+        mSchema.add( role, name
+                     , CommandSchema::Method( static_cast< C* >( this ), method )
+                     , format );
+    }
+
+    void enableCache( uint32_t ttl );
+
+    uint32_t bindParameters( cJSON *params, Type type, cJSON **bound, const char *&details );
+    uint32_t handleRequiredParameters( cJSON **bound, bool &optional, const char *&details );
+
+    CommandSchema mSchema;
+    CommandCache *mCache;
 
     char mOptionalParameter[ COMMAND_NAME_MAX_SIZE ];
 
@@ -0,0 +1,64 @@
+/** ****************************************************************************
+ * @file command_cache.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief Command cache class declaration. Keeps the serialized result of an
+ * accessor for each distinct params object it was called with, so repeated
+ * queries skip the accessor methods and the serialization of the result. An
+ * entry lives until its time to live runs out or the command's mutator
+ * succeeds.
+ * ****************************************************************************/
+#ifndef COMMAND_CACHE_H
+#define COMMAND_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/cjson/cJSON.h"
+
+class CommandCache
+{
+    static const uint32_t max_entries;
+
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    explicit CommandCache( uint32_t ttl );
+
+    CommandCache( const CommandCache &cache ) = delete;
+    CommandCache& operator=( const CommandCache &cache ) = delete;
+
+    cJSON *find( cJSON *params, uint64_t *generation );
+    void store( cJSON *params, cJSON *result, uint64_t generation );
+    void invalidate();
+
+    uint32_t getTtl();
+    uint32_t getEntries();
+    uint64_t getHits();
+    uint64_t getMisses();
+
+private:
+    struct Entry {
+        std::string key;
+        std::string result;
+        Clock::time_point stored;
+    };
+
+    uint32_t mTtl;
+    uint64_t mGeneration;
+    std::vector< Entry > mEntries;
+    std::mutex mMutex;
+
+    std::atomic< uint64_t > mHits;
+    std::atomic< uint64_t > mMisses;
+
+    bool isExpired( const Entry &entry, Clock::time_point now );
+
+    static bool makeKey( cJSON *params, std::string *key );
+};
+
+#endif // COMMAND_CACHE_H
@@ -7,6 +7,8 @@
 #define COMMAND_CONSOLE     "console"
 #define COMMAND_QCONSOLE    "qconsole"
 
+#define PARAM_ENCODING      "encoding"
+
 class CommandConsole
         : public CommandTemplate< Console >
 {
@@ -14,6 +16,9 @@ public:
     CommandConsole();
 
     virtual uint32_t setQuit( cJSON *val );
+    virtual uint32_t setEncoding( cJSON *val );
+
+    virtual uint32_t getEncoding( cJSON *response );
 };
 
 #endif // COMMAND_CONSOLE_H
@@ -13,8 +13,17 @@
 #define PARAM_INPUT     "input"
 #define PARAM_OUTPUT    "output"
 
+/**
+ * @brief Per call state, the bank and pin selected by the parameters
+ */
+struct CommandGpioState
+{
+    uint32_t bank;
+    uint32_t pin;
+};
+
 class CommandGpio
-        : public CommandTemplate< AM335X::Gpio >
+        : public CommandTemplate< AM335X::Gpio, CommandGpioState >
 {
 public:
     CommandGpio( const char *mutator = COMMAND_GPIO
@@ -33,10 +42,6 @@ public:
 
     virtual uint32_t getBankOutput( cJSON *response );
     virtual uint32_t getBankInput( cJSON *response );
-
-protected:
-    uint32_t mPin;
-    uint32_t mBank;
 };
 
 #endif // COMMAND_GPIO_H
@@ -1,9 +1,19 @@
 #ifndef COMMAND_HANDLER_H
 #define COMMAND_HANDLER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "common/common_types.h"
+#include "common/histogram.h"
 #include "common/control/control_template.h"
 #include "common/command/command.h"
+#include "common/command/command_table.h"
 
 
 /**
@@ -14,10 +24,14 @@ class CommandContainer
 public:
     CommandContainer( Command::Type type, Command *cmdObj );
     const char *getUsage();
+    Command::Type getType();
+    Command *getCommand();
     bool call( cJSON *params, cJSON *response );
+    Histogram *getLatency();
 private:
     Command::Type mType;
     Command *mCmdObj;
+    Histogram mLatency;
 };
 
 using CommandMap = Types::CharHashMap< CommandContainer* >;
@@ -28,17 +42,71 @@ using CommandMap = Types::CharHashMap< CommandContainer* >;
 class CommandHandler
         : public ControlTemplate< CommandHandler >
 {
+    static const uint32_t default_batch_threads;
+
 public:
 
+    // Notified of every mutator that succeeds
+    using Listener = std::function< void ( const char *name, cJSON *params ) >;
+
     CommandHandler();
     ~CommandHandler();
 
     bool handle( const char *cmdStr, cJSON *response );
+    bool dispatch( cJSON *command, cJSON *response );
+    bool dispatchBatch( cJSON *commands, cJSON *responses );
     void addCommand( Command *cmd );
+    bool freeze();
+    bool isFrozen();
     const char *getCommandUsage( const char *cmd );
     CommandMap *getCommandMap();
+
+    uint32_t setBatchThreads( uint32_t threads );
+    uint32_t getBatchThreads();
+
+    void setListener( Listener listener );
+
+    static cJSON *createResponse( cJSON *command );
+
 private:
+
+    /**
+     * @brief Run of consecutive accessors in a batch, shared by the thread
+     * dispatching the batch and whichever helpers are free
+     */
+    struct AccessorRun {
+        cJSON **commands;
+        cJSON **responses;
+        size_t count;
+        std::atomic< size_t > next;
+        uint32_t active;
+    };
+
     CommandMap mCommandMap;
+    uint32_t mBatchThreads;
+
+    // Helpers are kept for the life of the handler, starting threads per
+    // batch costs more than the accessors save on small boards
+    std::mutex mBatchMutex;
+    std::condition_variable mBatchCondition;
+    std::condition_variable mBatchDone;
+    std::deque< AccessorRun* > mRuns;
+    std::vector< std::thread > mHelpers;
+    bool mHelping;
+
+    Listener mListener;
+    std::atomic< CommandTable* > mTable;
+    std::vector< CommandTable* > mRetiredTables;
+
+    CommandContainer *findCommand( cJSON *command );
+    CommandContainer *lookup( const char *name );
+    void dispatchAccessors( cJSON **commands
+                            , cJSON **responses
+                            , size_t count );
+    void dispatchRun( AccessorRun *run );
+    void startHelpers( uint32_t count );
+    void stopHelpers();
+    void help();
 };
 
 #endif // COMMAND_HANDLER_H
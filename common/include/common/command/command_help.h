@@ -11,8 +11,16 @@
 
 #define PARAM_USAGE "usage"
 
+/**
+ * @brief Per call state, the usage of the command asked about
+ */
+struct CommandHelpState
+{
+    const char *usage;
+};
+
 class CommandHelp
-        : public CommandTemplate< CommandHandler >
+        : public CommandTemplate< CommandHandler, CommandHelpState >
 {
 public:
     CommandHelp();
@@ -21,9 +29,6 @@ public:
 
     uint32_t getCommandMap( cJSON *response );
     uint32_t getCommandUsage( cJSON *response );
-protected:
-
-    const char *mUsage;
 };
 
 #endif // COMMAND_HELP_H
@@ -7,8 +7,6 @@
 #define COMMAND_LED     "led"
 #define COMMAND_QLED    "qled"
 
-#define PARAM_ID        "id"
-
 class CommandLed
         : public CommandTemplate< Led >
 {
@@ -0,0 +1,27 @@
+#ifndef COMMAND_METRICS_H
+#define COMMAND_METRICS_H
+
+#include "common/command/command_template.h"
+#include "common/command/command_handler.h"
+#include "common/histogram.h"
+
+#define COMMAND_QMETRICS    "qmetrics"
+
+#define PARAM_COMMANDS  "commands"
+#define PARAM_COUNT     "count"
+#define PARAM_P50       "p50"
+#define PARAM_P99       "p99"
+#define PARAM_MAX       "max"
+
+class CommandMetrics
+        : public CommandTemplate< CommandHandler >
+{
+public:
+    CommandMetrics();
+
+    uint32_t getCommands( cJSON *response );
+
+    static cJSON *createSummary( Histogram *histogram );
+};
+
+#endif // COMMAND_METRICS_H
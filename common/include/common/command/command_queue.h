@@ -0,0 +1,95 @@
+/** ****************************************************************************
+ * @file command_queue.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief Command queue class declaration. Executes parsed commands on a
+ * bounded set of worker threads so transports don't have to block while a
+ * command runs.
+ * ****************************************************************************/
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/command/command_handler.h"
+
+class CommandQueue
+        : public ControlTemplate< CommandQueue >
+{
+    static const uint32_t default_workers;
+    static const uint32_t default_depth;
+
+public:
+
+    using Clock     = std::chrono::steady_clock;
+    using Callback  = std::function< void( bool ) >;
+
+    CommandQueue( CommandHandler *handler
+                  , uint32_t workers = default_workers
+                  , uint32_t depth = default_depth );
+    ~CommandQueue();
+
+    void start();
+    void stop();
+
+    bool push( cJSON *command, cJSON *response, Callback done );
+
+    uint32_t setLimit( const char *command, uint32_t limit );
+
+    bool isRunning();
+
+    uint32_t getDepth();
+    uint32_t getMaxDepth();
+    uint32_t getCapacity();
+    uint32_t getWorkers();
+    uint64_t getProcessed();
+    uint64_t getRejected();
+    uint64_t getAverageWait();
+    uint64_t getMaxWait();
+
+private:
+
+    struct Job {
+        cJSON *command;
+        cJSON *response;
+        std::vector< const char* > names;
+        Clock::time_point queued;
+        Callback done;
+    };
+
+    struct Limit {
+        uint32_t max;
+        uint32_t active;
+    };
+
+    CommandHandler *mHandler;
+    uint32_t mWorkers;
+    uint32_t mCapacity;
+    bool mRunning;
+
+    std::deque< Job > mJobs;
+    std::vector< std::thread* > mThreads;
+    Types::CharHashMap< Limit > mLimits;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+
+    uint32_t mMaxDepth;
+    uint64_t mProcessed;
+    uint64_t mRejected;
+    uint64_t mWaitTotal;
+    uint64_t mWaitMax;
+
+    std::deque< Job >::iterator next();
+    bool isLimited( const Job &job );
+    static void addName( Job &job, cJSON *command );
+    void run();
+};
+
+#endif // COMMAND_QUEUE_H
@@ -0,0 +1,67 @@
+#ifndef COMMAND_SCHEMA_H
+#define COMMAND_SCHEMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common/cjson/cJSON.h"
+#include "common/delegate.h"
+
+/**
+ * @brief Describes the parameters a command takes and the methods that handle
+ * them. Declared once when the command is constructed, each parameter name
+ * has a single entry holding its expected type and a method for every role it
+ * plays, so a params object is bound in one pass.
+ */
+class CommandSchema
+{
+public:
+    using Method = Delegate< uint32_t ( cJSON* ) >;
+
+    enum Role : uint8_t {
+        REQUIRED                = 0
+        , OPTIONAL              = 1
+        , ACCESSOR              = 2
+        , MUTATOR               = 3
+        , OPTIONAL_ACCESSOR     = 4
+        , OPTIONAL_MUTATOR      = 5
+        , ROLE_COUNT            = 6
+    };
+
+    // Matches the cJSON type bits so a type check is a single mask
+    enum Format : int {
+        BOOLEAN     = cJSON_True | cJSON_False
+        , NUMBER    = cJSON_Number
+        , STRING    = cJSON_String
+        , ARRAY     = cJSON_Array
+        , OBJECT    = cJSON_Object
+        , ANY       = 0xFF
+    };
+
+    static const uint32_t max_parameters = 32;
+
+    struct Parameter {
+        const char *name;
+        size_t length;
+        int format;
+        Method methods[ ROLE_COUNT ];
+    };
+
+    CommandSchema();
+
+    bool add( Role role, const char *name, const Method &method, int format );
+
+    int32_t find( const char *name ) const;
+    const Parameter &get( uint32_t index ) const;
+    uint32_t getCount() const;
+
+    bool hasRole( Role role ) const;
+    static bool isInput( Role role );
+
+private:
+    Parameter mParameters[ max_parameters ];
+    uint32_t mCount;
+    uint32_t mRoles;
+};
+
+#endif // COMMAND_SCHEMA_H
@@ -13,6 +13,8 @@
 class CommandSystem
         : public CommandTemplate< System >
 {
+    static const uint32_t cache_ttl;
+
 public:
     CommandSystem();
     uint32_t getHostname( cJSON *response );
@@ -0,0 +1,62 @@
+/** ****************************************************************************
+ * @file command_table.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief Command table class declaration. A perfect hash of the registered
+ * command names, built once registration is done. Every name hashes to its
+ * own slot so a lookup is one hash, one compare of the hash array and one
+ * string compare, with no probing or chaining.
+ * ****************************************************************************/
+#ifndef COMMAND_TABLE_H
+#define COMMAND_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common/common_types.h"
+
+class CommandContainer;
+
+class CommandTable
+{
+    static const uint32_t max_seed_attempts;
+    static const uint32_t max_load_factor;
+
+public:
+
+    CommandTable();
+    ~CommandTable();
+
+    CommandTable( const CommandTable &table ) = delete;
+    CommandTable& operator=( const CommandTable &table ) = delete;
+
+    bool build( const Types::CharHashMap< CommandContainer* > &map );
+
+    CommandContainer *find( const char *name ) const;
+
+    uint32_t getCount() const;
+    uint32_t getSlots() const;
+    uint32_t getSeed() const;
+
+    static uint32_t hash( uint32_t seed, const char *name, size_t *length );
+
+private:
+
+    struct Entry {
+        const char *name;
+        size_t length;
+        CommandContainer *container;
+    };
+
+    // Hashes are kept apart from the entries so a miss only touches the
+    // densely packed hash array
+    uint32_t *mHashes;
+    Entry *mEntries;
+    uint32_t mMask;
+    uint32_t mSeed;
+    uint32_t mCount;
+
+    void release();
+};
+
+#endif // COMMAND_TABLE_H
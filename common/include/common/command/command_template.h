@@ -3,7 +3,15 @@
 
 #include "common/command/command.h"
 
-template< typename T >
+/**
+ * @brief Per call state of a command that keeps nothing beyond the control
+ * object the call is made on
+ */
+struct CommandState
+{
+};
+
+template< typename T, typename S = CommandState >
 class CommandTemplate
         : public Command
 {
@@ -18,11 +26,10 @@ public:
         : Command( mutator, accessor, optional )
         , mControlObject( nullptr )
     {
-        mMutatorMap[ PARAM_VERBOSE ] = PARAMETER_CALLBACK(
-                    &CommandTemplate< T >::setVerbose );
+        addMutator( PARAM_VERBOSE, &CommandTemplate< T, S >::setVerbose
+                    , CommandSchema::BOOLEAN );
 
-        mAccessorMap[ PARAM_VERBOSE ] = PARAMETER_CALLBACK(
-                    &CommandTemplate< T >::getVerbose );
+        addAccessor( PARAM_VERBOSE, &CommandTemplate< T, S >::getVerbose );
 
         if( T::getCount() == 1 ) {
             // If there is only a count of 1, just set it as the control object
@@ -42,9 +49,6 @@ public:
         bool success = false;
         const char *command = nullptr;
 
-        /// @todo Required parameter handling goes here. They should be handled
-        /// the same for both access and mutate
-
         switch( type ) {
         case Type::ACCESSOR:
             command = getAccessorName();
@@ -71,39 +75,31 @@ public:
     {
         uint32_t r = Error::Code::NONE;
         const char *details = nullptr;
-
-        if( r == Error::Code::NONE ) {
-            if( mRequiredMap.size() > 0 ) {
-                if( params == nullptr ) {
-                    // The params object is invalid
-                    r = Error::Code::PARAM_MISSING;
-                    details = PARAM_PARAMS;
-                } else {
-                    // Only handle the required parameters if they exist? Not sure
-                    // what the best way to handle this is.
-                    r = handleRequiredParameters( params, details );
-                }
+        cJSON *bound[ CommandSchema::max_parameters ] = {};
+        bool optional = false;
+        uint64_t generation = 0;
+
+        if( mCache != nullptr ) {
+            cJSON *cached = mCache->find( params, &generation );
+            if( cached != nullptr ) {
+                // Served as is, the accessor methods aren't called
+                cJSON_AddItemToObject( response, PARAM_RESULT, cached );
+                return true;
             }
         }
 
-        ParameterMap *accessorMap = &mAccessorMap;
+        Context context = Context();
+        context.control = mControlObject;
+        Scope scope( &context );
+
+        r = bindParameters( params, Type::ACCESSOR, bound, details );
+
         if( r == Error::Code::NONE ) {
-            if( mOptionalParameter[ 0 ] == '\0' ) {
-                // Do nothing
-            } else {
-                cJSON *p = cJSON_DetachItemFromObject( params, mOptionalParameter );
-                if( p == nullptr ) {
-                    // Do nothing
-                } else {
-                    r = mOptional( p );
-                    accessorMap = &mOptionalAccessorMap;
-                    cJSON_Delete( p );
-                }
-            }
+            r = handleRequiredParameters( bound, optional, details );
         }
 
         if( r == Error::Code::NONE ) {
-            if( mControlObject == nullptr ) {
+            if( context.control == nullptr ) {
                 // The control object is invalid
                 r = Error::Code::CMD_FAILED;
                 details = error_control_unavailable;
@@ -112,29 +108,40 @@ public:
 
         cJSON* result = cJSON_CreateObject();
         if( r == Error::Code::NONE ) {
-            for( auto it = accessorMap->begin()
-                 ; it != accessorMap->end() && r == Error::Code::NONE
-                 ; it++ ) {
-
-                ParameterCallback cb = it->second;
-                r = cb( result );
-
-                if( r != Error::Code::NONE ) {
-                    // Failed to access parameter
-                    details = it->first;
+            CommandSchema::Role role = optional
+                    ? CommandSchema::OPTIONAL_ACCESSOR : CommandSchema::ACCESSOR;
+
+            // Accessors on the same control object run side by side
+            Control::Lock lock( context.control, Control::Lock::SHARED );
+
+            for( uint32_t i = 0
+                 ; i < mSchema.getCount() && r == Error::Code::NONE
+                 ; i++ ) {
+
+                const CommandSchema::Parameter &p = mSchema.get( i );
+                if( p.methods[ role ] ) {
+                    r = p.methods[ role ]( result );
+                    if( r != Error::Code::NONE ) {
+                        // Failed to access parameter
+                        details = p.name;
+                    }
                 }
             }
         }
 
         bool success = false;
         if( r == Error::Code::NONE ) {
+            if( mCache != nullptr ) {
+                mCache->store( params, result, generation );
+            }
+
             // Add the result to the response object
             cJSON_AddItemToObject( response, PARAM_RESULT, result );
             success = true;
         } else {
             // There was an error and our result is invalid, free it
             setError( r, details, response );
-            cJSON_free( result );
+            cJSON_Delete( result );
         }
 
         return success;
@@ -149,40 +156,21 @@ public:
     {
         uint32_t r = Error::Code::NONE;
         const char *details = nullptr;
+        cJSON *bound[ CommandSchema::max_parameters ] = {};
+        bool optional = false;
 
-        if( r == Error::Code::NONE ) {
-            if( mRequiredMap.size() > 0 ) {
-                // Required parameters are expected
-                if( params == nullptr ) {
-                    // The params object is invalid
-                    r = Error::Code::PARAM_MISSING;
-                    details = PARAM_PARAMS;
-                } else {
-                    // Only handle the required parameters if they exist? Not sure
-                    // what the best way to handle this is.
-                    r = handleRequiredParameters( params, details );
-                }
-            }
-        }
+        Context context = Context();
+        context.control = mControlObject;
+        Scope scope( &context );
+
+        r = bindParameters( params, Type::MUTATOR, bound, details );
 
-        ParameterMap *mutatorMap = &mMutatorMap;
         if( r == Error::Code::NONE ) {
-            if( mOptionalParameter[ 0 ] == '\0' ) {
-                // Do nothing
-            } else {
-                cJSON *p = cJSON_DetachItemFromObject( params, mOptionalParameter );
-                if( p == nullptr ) {
-                    // Do nothing
-                } else {
-                    r = mOptional( p );
-                    mutatorMap = &mOptionalMutatorMap;
-                    cJSON_Delete( p );
-                }
-            }
+            r = handleRequiredParameters( bound, optional, details );
         }
 
         if( r == Error::Code::NONE ) {
-            if( mControlObject == nullptr ) {
+            if( context.control == nullptr ) {
                 // The control object isn't valid
                 r = Error::Code::CMD_FAILED;
                 details = error_control_unavailable;
@@ -190,34 +178,50 @@ public:
         }
 
         if( r == Error::Code::NONE ) {
-            // The control object is valid and we have parameters to work with
-            for( cJSON *param = params->child
-                 ; r == Error::Code::NONE && param != nullptr
-                 ; param = param->next ) {
-
-                auto it = mutatorMap->find( param->string );
-                if( it == mutatorMap->end() ) {
-                    // No callback was found
-                    r = Error::Code::PARAM_INVALID;
-
-                } else {
-                    // A callback was found
-                    ParameterCallback cb = it->second;
-                    r = cb( param );
+            CommandSchema::Role role = optional
+                    ? CommandSchema::OPTIONAL_MUTATOR : CommandSchema::MUTATOR;
+
+            // The control object is valid, apply the bound parameters while
+            // no other call is on it
+            Control::Lock lock( context.control, Control::Lock::EXCLUSIVE );
+            for( uint32_t i = 0
+                 ; i < mSchema.getCount() && r == Error::Code::NONE
+                 ; i++ ) {
+
+                const CommandSchema::Parameter &p = mSchema.get( i );
+                if( bound[ i ] == nullptr ) {
+                    // Not given
+                } else if( p.methods[ role ] ) {
+                    r = p.methods[ role ]( bound[ i ] );
                     if( r == Error::Code::NONE ) {
                         // Parameter handled successfully
-                        char *str = cJSON_Print( param );
-                        LOG_DEBUG( "'%s' set to %s\n", param->string, str );
-                        free( str );
+                        char *str = cJSON_Print( bound[ i ] );
+                        LOG_DEBUG( "'%s' set to %s\n", p.name, str );
+                        cJSON_free( str );
                     } else {
                         // Failed to mutate parameter
-                        details = param->string;
+                        details = p.name;
                     }
+                } else if( !p.methods[ CommandSchema::REQUIRED ]
+                           && !p.methods[ CommandSchema::OPTIONAL ] ) {
+                    // Only mutable in the other mode
+                    r = Error::Code::PARAM_INVALID;
+                    details = p.name;
                 }
             }
 
+            lock.release();
+
+            // Applying may restart the control object and wait on calls that
+            // are queued up for the lock, so it's done without it
             if( r == Error::Code::NONE ) {
-                mControlObject->applySettings();
+                context.control->applySettings();
+            }
+
+            // Whatever the accessor cached may have changed, even parameters
+            // applied before a failure
+            if( mCache != nullptr ) {
+                mCache->invalidate();
             }
         }
 
@@ -241,9 +245,9 @@ public:
     {
         uint32_t r = Error::Code::NONE;
         if( cJSON_IsTrue( val ) ) {
-            mControlObject->setVerbose( true );
+            getControl()->setVerbose( true );
         } else if( cJSON_IsFalse( val ) ){
-            mControlObject->setVerbose( false );
+            getControl()->setVerbose( false );
         } else {
             // The type isn't what we expect, syntax error
             r = Error::Code::SYNTAX;
@@ -259,12 +263,77 @@ public:
     virtual uint32_t getVerbose( cJSON *response )
     {
         uint32_t r = Error::Code::NONE;
-        cJSON_AddBoolToObject( response, PARAM_VERBOSE, mControlObject->isVerbose() );
+        cJSON_AddBoolToObject( response, PARAM_VERBOSE, getControl()->isVerbose() );
         return r;
     }
 
 protected:
+
+    /**
+     * @brief State of one call. Required and optional parameters select what
+     * the rest of the call works on here, never in the command, so concurrent
+     * calls can't see each other's selections.
+     */
+    struct Context
+            : public S
+    {
+        T *control;
+    };
+
+    /**
+     * @brief Retrieves the state of the call running on the calling thread,
+     * only valid from within a parameter method
+     * @return Call context
+     */
+    Context &getContext()
+    {
+        return *sContext;
+    }
+
+    /**
+     * @brief Retrieves the control object the current call is made on
+     * @return Pointer to the control object
+     */
+    T *getControl()
+    {
+        return ( sContext != nullptr ) ? sContext->control : mControlObject;
+    }
+
+    // Control object every call starts out on
     T *mControlObject;
+
+private:
+
+    /**
+     * @brief Makes a context current on the calling thread until the scope
+     * ends
+     */
+    class Scope
+    {
+    public:
+        explicit Scope( Context *context )
+            : mPrevious( sContext )
+        {
+            sContext = context;
+        }
+
+        ~Scope()
+        {
+            sContext = mPrevious;
+        }
+
+        Scope( const Scope &scope ) = delete;
+        Scope& operator=( const Scope &scope ) = delete;
+
+    private:
+        Context *mPrevious;
+    };
+
+    static thread_local Context *sContext;
 };
 
+template< typename T, typename S >
+thread_local typename CommandTemplate< T, S >::Context *CommandTemplate< T, S >::sContext
+        = nullptr;
+
 #endif // COMMAND_TEMPLATE_H
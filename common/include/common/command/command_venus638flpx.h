@@ -2,17 +2,64 @@
 #define COMMAND_VENUS638FLPX_H
 
 #include "common/command/command_template.h"
+#include "common/drivers/devices/gps/nmea_parser.h"
 #include "common/drivers/devices/gps/venus638flpx.h"
 
 #define COMMAND_GPS     "gps"
 #define COMMAND_QGPS    "qgps"
 
 #define PARAM_BAUD      "baud"
+#define PARAM_OUTPUT    "output"
+#define PARAM_RATE      "rate"
+#define PARAM_NAV       "nav"
 #define PARAM_GPGGA     "gpgga"
 #define PARAM_GPGSA     "gpgsa"
 #define PARAM_GPRMC     "gprmc"
 #define PARAM_GPVTG     "gpvtg"
 
+#define PARAM_GGA       "gga"
+#define PARAM_RMC       "rmc"
+#define PARAM_GSA       "gsa"
+#define PARAM_GSV       "gsv"
+#define PARAM_VTG       "vtg"
+#define PARAM_ZDA       "zda"
+
+#define PARAM_TIME              "time"
+#define PARAM_DATE              "date"
+#define PARAM_LATITUDE          "latitude"
+#define PARAM_LONGITUDE         "longitude"
+#define PARAM_QUALITY           "quality"
+#define PARAM_SATELLITES        "satellites"
+#define PARAM_PDOP              "pdop"
+#define PARAM_HDOP              "hdop"
+#define PARAM_VDOP              "vdop"
+#define PARAM_ALTITUDE          "altitude"
+#define PARAM_SEPARATION        "separation"
+#define PARAM_VALID             "valid"
+#define PARAM_SPEED_KNOTS       "speed_knots"
+#define PARAM_SPEED_KMH         "speed_kmh"
+#define PARAM_COURSE            "course"
+#define PARAM_COURSE_MAGNETIC   "course_magnetic"
+#define PARAM_VARIATION         "variation"
+#define PARAM_MODE              "mode"
+#define PARAM_FIX               "fix"
+#define PARAM_MESSAGES          "messages"
+#define PARAM_MESSAGE           "message"
+#define PARAM_IN_VIEW           "in_view"
+#define PARAM_PRN               "prn"
+#define PARAM_ELEVATION         "elevation"
+#define PARAM_AZIMUTH           "azimuth"
+#define PARAM_SNR               "snr"
+#define PARAM_ZONE_HOURS        "zone_hours"
+#define PARAM_ZONE_MINUTES      "zone_minutes"
+#define PARAM_WEEK              "week"
+#define PARAM_TIME_OF_WEEK      "tow"
+#define PARAM_ALTITUDE_ELLIPSOID "altitude_ellipsoid"
+#define PARAM_GDOP              "gdop"
+#define PARAM_TDOP              "tdop"
+#define PARAM_ECEF              "ecef"
+#define PARAM_VELOCITY          "velocity"
+
 class CommandVenus638FLPx
         : public CommandTemplate< Gps::Venus638FLPx >
 {
@@ -20,12 +67,39 @@ public:
     CommandVenus638FLPx();
 
     virtual uint32_t setBaud( cJSON *val );
+    virtual uint32_t setOutput( cJSON *val );
+    virtual uint32_t setRate( cJSON *val );
 
     virtual uint32_t getBaud( cJSON *response );
+    virtual uint32_t getOutput( cJSON *response );
+    virtual uint32_t getRate( cJSON *response );
     virtual uint32_t getGpgga( cJSON *response );
     virtual uint32_t getGpgsa( cJSON *response );
     virtual uint32_t getGprmc( cJSON *response );
     virtual uint32_t getGpvtg( cJSON *response );
+
+    virtual uint32_t getGga( cJSON *response );
+    virtual uint32_t getRmc( cJSON *response );
+    virtual uint32_t getGsa( cJSON *response );
+    virtual uint32_t getGsv( cJSON *response );
+    virtual uint32_t getVtg( cJSON *response );
+    virtual uint32_t getZda( cJSON *response );
+    virtual uint32_t getNav( cJSON *response );
+
+private:
+    template< typename T >
+    bool readSentence( Gps::Nmea::Sentence sentence, T *fields )
+    {
+        char text[ Gps::SentenceTable::sentence_size ];
+        int32_t length = getControl()->getSentence(
+                    sentence, reinterpret_cast< uint8_t* >( text ), sizeof( text ) );
+        return length >= 0 && Gps::Nmea::Parser::parse(
+                    text, static_cast< uint32_t >( length ), fields );
+    }
+
+    static void addTime( cJSON *object, const Gps::Nmea::Time &time );
+    static void addDate( cJSON *object, const Gps::Nmea::Date &date );
+    static void addMode( cJSON *object, char mode );
 };
 
 #endif // COMMAND_VENUS638FLPX_H
@@ -15,6 +15,7 @@
 #define PARAM_DETAILS   "details"
 #define PARAM_ENABLE    "enable"
 #define PARAM_ERROR     "error"
+#define PARAM_ID        "id"
 #define PARAM_PARAMS    "params"
 #define PARAM_QUIT      "quit"
 #define PARAM_RESULT    "result"
@@ -38,6 +38,7 @@ public:
     std::vector< std::string > tokenize( char *input, const char *delimiter = " " );
 
     void applyClient( Transport::Client *c );
+    Transport::Client *getClient();
 
 private:
     Console();
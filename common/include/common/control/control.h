@@ -1,6 +1,7 @@
 #ifndef CONTROL_H
 #define CONTROL_H
 
+#include <pthread.h>
 #include <stdio.h>
 #include <stdint.h>
 
@@ -11,9 +12,38 @@
 class Control
 {
 public:
+
+    /**
+     * @brief Holds the reader/writer lock of a control object until the scope
+     * ends. Calls that only read the control object share it, calls that
+     * change it hold it alone.
+     */
+    class Lock
+    {
+    public:
+        enum Mode {
+            SHARED      = 0
+            , EXCLUSIVE = 1
+        };
+
+        Lock( Control *control, Mode mode );
+        ~Lock();
+
+        Lock( const Lock &lock ) = delete;
+        Lock& operator=( const Lock &lock ) = delete;
+
+        void release();
+
+    private:
+        Control *mControl;
+    };
+
     Control();
     virtual ~Control();
 
+    Control( const Control &control ) = delete;
+    Control& operator=( const Control &control ) = delete;
+
     uint32_t setVerbose( bool verbose );
     bool isVerbose();
 
@@ -21,6 +51,7 @@ public:
 
 private:
     bool mVerbose;
+    pthread_rwlock_t mLock;
 };
 
 #endif // CONTROL_H
@@ -0,0 +1,124 @@
+/** ****************************************************************************
+ * @file delegate.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief Fixed size callable holding an object pointer and a member function
+ * pointer. Unlike std::function bound with std::bind it never allocates, is
+ * trivially copyable and calls through a single stub.
+ *
+ * Example usage of the delegate class:
+ *
+ * Delegate< uint32_t ( cJSON* ) > d( this, &CommandLed::setEnable );
+ * uint32_t r = d( value );
+ * ****************************************************************************/
+#ifndef DELEGATE_H
+#define DELEGATE_H
+
+#include <string.h>
+#include <utility>
+
+template< typename Signature >
+class Delegate;
+
+template< typename R, typename... Args >
+class Delegate< R ( Args... ) >
+{
+    // Large enough for a member function pointer on every ABI we build for
+    static const size_t method_size = 2 * sizeof( void* );
+
+public:
+
+    /**
+     * @brief Constructor, creates an empty delegate
+     */
+    Delegate()
+        : mObject( nullptr )
+        , mStub( nullptr )
+    {
+        memset( mMethod, 0, sizeof( mMethod ) );
+    }
+
+    /**
+     * @brief Constructor, binds a member function to an object
+     * @param object Object the method is called on, must outlive the delegate
+     * @param method Member function
+     */
+    template< typename C >
+    Delegate( C *object, R ( C::*method )( Args... ) )
+        : mObject( object )
+        , mStub( &Delegate::memberStub< C > )
+    {
+        static_assert( sizeof( method ) <= method_size
+                       , "member function pointer too large for delegate" );
+        memset( mMethod, 0, sizeof( mMethod ) );
+        memcpy( mMethod, &method, sizeof( method ) );
+    }
+
+    /**
+     * @brief Constructor, binds a free or static function
+     * @param function Function
+     */
+    Delegate( R ( *function )( Args... ) )
+        : mObject( nullptr )
+        , mStub( &Delegate::functionStub )
+    {
+        memset( mMethod, 0, sizeof( mMethod ) );
+        memcpy( mMethod, &function, sizeof( function ) );
+    }
+
+    /**
+     * @brief Calls the bound function, the delegate must not be empty
+     * @param args Arguments
+     * @return Return value of the bound function
+     */
+    R operator()( Args... args ) const
+    {
+        return mStub( *this, std::forward< Args >( args )... );
+    }
+
+    /**
+     * @brief Determines if a function is bound
+     * @return Boolean indicating the delegate can be called
+     */
+    explicit operator bool() const
+    {
+        return mStub != nullptr;
+    }
+
+private:
+    using Stub = R ( * )( const Delegate&, Args... );
+
+    void *mObject;
+    alignas( void* ) unsigned char mMethod[ method_size ];
+    Stub mStub;
+
+    /**
+     * @brief Calls a member function on the bound object
+     * @param delegate Delegate holding the object and method
+     * @param args Arguments
+     * @return Return value of the method
+     */
+    template< typename C >
+    static R memberStub( const Delegate &delegate, Args... args )
+    {
+        R ( C::*method )( Args... );
+        memcpy( &method, delegate.mMethod, sizeof( method ) );
+        return ( static_cast< C* >( delegate.mObject )->*method )(
+                    std::forward< Args >( args )... );
+    }
+
+    /**
+     * @brief Calls the bound free function
+     * @param delegate Delegate holding the function
+     * @param args Arguments
+     * @return Return value of the function
+     */
+    static R functionStub( const Delegate &delegate, Args... args )
+    {
+        R ( *function )( Args... );
+        memcpy( &function, delegate.mMethod, sizeof( function ) );
+        return function( std::forward< Args >( args )... );
+    }
+};
+
+#endif // DELEGATE_H
@@ -34,6 +34,7 @@ enum Sentence {
     , GPWPL // Waypoint location
     , GPXTE // Cross-track error, Measured
     , GPZDA // Date & Time
+    , SENTENCE_MAX
 };
 
 struct SentenceInfo {
@@ -0,0 +1,146 @@
+/** ****************************************************************************
+ * @file nmea_parser.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief NMEA parser declaration. Verifies the checksum of a sentence and
+ * parses the fields of the common fix sentences into fixed structs. Nothing is
+ * allocated and numbers are read as scaled integers, coordinates are never
+ * converted through floating point.
+ *
+ * Empty fields, which receivers send while they have no fix, read as 0. The
+ * talker isn't checked, $GNGGA parses the same as $GPGGA.
+ * ****************************************************************************/
+#ifndef GPS_NMEA_PARSER_H
+#define GPS_NMEA_PARSER_H
+
+#include <stdint.h>
+
+#include "common/drivers/devices/gps/gps.h"
+
+namespace Gps
+{
+
+namespace Nmea {
+
+struct Time {
+    uint8_t hours;
+    uint8_t minutes;
+    uint8_t seconds;
+    uint16_t milliseconds;
+};
+
+struct Date {
+    uint8_t day;
+    uint8_t month;
+    uint16_t year;
+};
+
+struct Gga {
+    Time time;
+    int32_t latitude;           // 1e-7 degrees, south is negative
+    int32_t longitude;          // 1e-7 degrees, west is negative
+    uint8_t quality;            // 0 no fix, 1 GPS, 2 DGPS
+    uint8_t satellites;
+    uint16_t hdop;              // Hundredths
+    int32_t altitude;           // Millimetres above mean sea level
+    int32_t separation;         // Millimetres from the geoid to the ellipsoid
+};
+
+struct Rmc {
+    Time time;
+    bool active;                // Status A, V when the data isn't valid
+    int32_t latitude;           // 1e-7 degrees, south is negative
+    int32_t longitude;          // 1e-7 degrees, west is negative
+    uint32_t speed;             // Thousandths of a knot
+    uint32_t course;            // Hundredths of a degree, true
+    Date date;
+    int32_t variation;          // Hundredths of a degree, west is negative
+    char mode;                  // A autonomous, D differential, N not valid
+};
+
+struct Gsa {
+    static const uint32_t max_satellites = 12;
+
+    char mode;                  // M manual, A automatic
+    uint8_t fix;                // 1 none, 2 2D, 3 3D
+    uint8_t satellites[ max_satellites ];
+    uint8_t count;
+    uint16_t pdop;              // Hundredths
+    uint16_t hdop;
+    uint16_t vdop;
+};
+
+struct Gsv {
+    static const uint32_t max_satellites = 4;
+
+    struct Satellite {
+        uint8_t prn;
+        int8_t elevation;       // Degrees
+        uint16_t azimuth;       // Degrees, true
+        uint8_t snr;            // dB-Hz, 0 when not tracked
+    };
+
+    uint8_t messages;
+    uint8_t message;
+    uint8_t inView;
+    Satellite satellites[ max_satellites ];
+    uint8_t count;
+};
+
+struct Vtg {
+    uint32_t courseTrue;        // Hundredths of a degree
+    uint32_t courseMagnetic;
+    uint32_t speedKnots;        // Thousandths
+    uint32_t speedKmh;          // Thousandths
+    char mode;
+};
+
+struct Zda {
+    Time time;
+    Date date;
+    int8_t zoneHours;
+    uint8_t zoneMinutes;
+};
+
+class Parser
+{
+public:
+
+    static bool validate( const char *text, uint32_t length );
+
+    static bool parse( const char *text, uint32_t length, Gga *gga );
+    static bool parse( const char *text, uint32_t length, Rmc *rmc );
+    static bool parse( const char *text, uint32_t length, Gsa *gsa );
+    static bool parse( const char *text, uint32_t length, Gsv *gsv );
+    static bool parse( const char *text, uint32_t length, Vtg *vtg );
+    static bool parse( const char *text, uint32_t length, Zda *zda );
+
+private:
+    static const uint32_t max_fields = 24;
+
+    struct Fields {
+        const char *field[ max_fields ];
+        uint8_t length[ max_fields ];
+        uint32_t count;
+    };
+
+    static const char *findChecksum( const char *text, uint32_t length );
+    static bool split( const char *text, uint32_t length, const char *type
+                       , uint32_t minimum, Fields *fields );
+
+    static bool readUnsigned( const Fields &fields, uint32_t index
+                              , uint32_t *value );
+    static bool readFixed( const Fields &fields, uint32_t index
+                           , uint32_t decimals, int64_t *value );
+    static bool readCoordinate( const Fields &fields, uint32_t index
+                                , int64_t maximum, int32_t *value );
+    static bool readTime( const Fields &fields, uint32_t index, Time *time );
+    static bool readDate( const Fields &fields, uint32_t index, Date *date );
+    static char readChar( const Fields &fields, uint32_t index );
+};
+
+}
+
+}
+
+#endif // GPS_NMEA_PARSER_H
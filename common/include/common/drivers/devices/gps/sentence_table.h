@@ -0,0 +1,49 @@
+/** ****************************************************************************
+ * @file sentence_table.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief Sentence table class declaration. Holds the latest NMEA sentence of
+ * each type received from a GPS. One thread stores sentences as they arrive,
+ * any number of threads read them without taking a lock. Each slot is a
+ * Seqlock holding the sentence text.
+ * ****************************************************************************/
+#ifndef GPS_SENTENCE_TABLE_H
+#define GPS_SENTENCE_TABLE_H
+
+#include <stdint.h>
+
+#include "common/drivers/devices/gps/gps.h"
+#include "common/seqlock.h"
+
+namespace Gps
+{
+
+class SentenceTable
+{
+public:
+
+    // NMEA 0183 caps a sentence at 82 characters, leave room for extensions
+    static const uint32_t sentence_size = 128;
+
+    SentenceTable() = default;
+
+    SentenceTable( const SentenceTable &table ) = delete;
+    SentenceTable& operator=( const SentenceTable &table ) = delete;
+
+    void store( Nmea::Sentence sentence, const char *text, uint32_t length );
+    int32_t load( Nmea::Sentence sentence, char *buffer, uint32_t size );
+
+    uint32_t getReceived( Nmea::Sentence sentence );
+
+private:
+    struct Text {
+        uint32_t length;
+        char text[ sentence_size ];
+    };
+
+    Seqlock< Text > mSlots[ Nmea::SENTENCE_MAX ];
+};
+
+}
+
+#endif // GPS_SENTENCE_TABLE_H
@@ -1,14 +1,25 @@
 #ifndef VENUS638FLPX_H
 #define VENUS638FLPX_H
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
 #include <stdint.h>
+#include <thread>
+#include <vector>
 
 #include "common/drivers/devices/gps/gps.h"
+#include "common/drivers/devices/gps/sentence_table.h"
 #include "common/drivers/serial.h"
 
 #include "common/control/control_template.h"
+#include "common/seqlock.h"
 
 #define READ_BUFFER_SIZE 1024
+#define RING_BUFFER_SIZE 4096
 
 namespace Gps {
 
@@ -24,10 +35,13 @@ class Venus638FLPx
             , QUERY_SOFTWARE_CRC        = 0x03
             , SET_FACTORY_DEFAULTS      = 0x04
             , CONFIGURE_SERIAL_PORT     = 0x05
-            , SOFTWARE_VERSION          = 0x81
-            , SOFTWARE_CRC              = 0x82
+            , CONFIGURE_MESSAGE_TYPE    = 0x09
+            , CONFIGURE_POSITION_RATE   = 0x0E
+            , SOFTWARE_VERSION          = 0x80
+            , SOFTWARE_CRC              = 0x81
             , ACK                       = 0x83
             , NACK                      = 0x84
+            , NAVIGATION_DATA           = 0xA8
         };
 
         enum SoftwareVersion {
@@ -58,20 +72,97 @@ class Venus638FLPx
 
 public:
 
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Outcome of a message sent to the device
+     */
+    struct Response {
+        int32_t error;                  // NONE, negative if refused or unanswered
+        std::vector< uint8_t > message; // ACK or NACK, or the information queried
+    };
+
+    using Callback = std::function< void( const Response &response ) >;
+    using SentenceListener = std::function< void( Nmea::Sentence sentence
+                                                  , const char *text ) >;
+
+    enum Output {
+        NO_OUTPUT   = 0
+        , NMEA      = 1
+        , BINARY    = 2
+        , OUTPUT_MAX
+    };
+
+    static const char *output_strings[];
+
+    /**
+     * @brief Navigation data message, sent once per fix in binary output mode
+     */
+    struct Navigation {
+        uint8_t fix;                // 0 none, 1 2D, 2 3D, 3 3D with DGPS
+        uint8_t satellites;
+        uint16_t week;
+        uint32_t timeOfWeek;        // Hundredths of a second
+        int32_t latitude;           // 1e-7 degrees, south is negative
+        int32_t longitude;          // 1e-7 degrees, west is negative
+        int32_t ellipsoidAltitude;  // Centimetres
+        int32_t altitude;           // Centimetres above mean sea level
+        uint16_t gdop;              // Hundredths
+        uint16_t pdop;
+        uint16_t hdop;
+        uint16_t vdop;
+        uint16_t tdop;
+        int32_t position[ 3 ];      // ECEF, centimetres
+        int32_t velocity[ 3 ];      // ECEF, centimetres per second
+    };
+
     Venus638FLPx( Serial *serial );
+    ~Venus638FLPx();
+
+    void start();
+    void stop();
 
     void dumpVersion();
 
+    std::future< Response > submit( Message &message, uint8_t responseId
+                                    , int32_t timeout, Callback callback = nullptr );
+
     int32_t sendMessage( Message &message, uint8_t *response, uint32_t size );
-    int32_t sendQuery( Message &message, uint8_t *response, uint32_t size );
+    int32_t sendQuery( Message &message, uint8_t responseId
+                       , uint8_t *response, uint32_t size );
 
     int32_t getSentence( Nmea::Sentence sentence, uint8_t *buffer, uint32_t size );
+    uint32_t getReceived( Nmea::Sentence sentence );
+
+    bool getNavigation( Navigation *navigation );
+
+    void setSentenceListener( SentenceListener listener );
 
     uint32_t getBaudRate();
     int32_t setBaud( Serial::Speed baud );
 
+    Output getOutput();
+    int32_t setOutput( Output output );
+
+    uint32_t getUpdateRate();
+    int32_t setUpdateRate( uint32_t rate );
+
+    static Output stringToOutput( const char *output );
+    static const char *outputToString( Output output );
+
 private:
 
+    /**
+     * @brief Message sent to the device and not answered yet
+     */
+    struct Request {
+        uint8_t id;                 // ID of the message sent
+        uint8_t responseId;         // ID of the information queried, NONE if only ACKed
+        bool acknowledged;
+        Clock::time_point deadline;
+        std::promise< Response > promise;
+        Callback callback;
+    };
 
     static const char start_sequence[];
     static const char end_sequence[];
@@ -85,7 +176,61 @@ private:
     static const int8_t message_id_length;
     static const int8_t checksum_length;
 
+    static const int32_t poll_timeout;
+    static const int32_t response_timeout;
+    static const int32_t probe_timeout;
+
+    static const Serial::Speed device_speeds[];
+    static const uint32_t device_speed_count;
+    static const uint32_t update_rates[];
+    static const uint32_t update_rate_count;
+    static const uint32_t nmea_fix_size;
+    static const uint32_t binary_fix_size;
+    static const uint16_t navigation_data_length;
+
     Serial *mSerial;
+    Output mOutput;
+    uint32_t mUpdateRate;
+
+    std::atomic< bool > mRunning;
+    std::thread *mThread;
+
+    // Only touched by the reader thread
+    uint8_t mRing[ RING_BUFFER_SIZE ];
+    uint32_t mRingHead;
+    uint32_t mRingTail;
+
+    SentenceTable mSentences;
+    Seqlock< Navigation > mNavigation;
+
+    // Called from the reader thread
+    std::mutex mListenerMutex;
+    SentenceListener mListener;
+
+    // Oldest first, the device answers in the order messages are sent
+    std::mutex mRequestMutex;
+    std::list< Request > mRequests;
+
+    void run();
+    void frame();
+    bool frameSentence();
+    bool frameMessage();
+
+    uint8_t peek( uint32_t offset );
+    void copy( uint8_t *buffer, uint32_t size );
+
+    void dispatch( std::vector< uint8_t > &&message );
+    void expire( Clock::time_point now );
+    void cancel();
+    static void complete( Request &request, int32_t error
+                          , std::vector< uint8_t > &&message );
+    static void logVersion( const Response &response );
+
+    bool probe();
+    bool detectBaud( Serial::Speed *speed );
+    bool fits( Output output, uint32_t rate, uint32_t baud );
+
+    static void decodeNavigation( const uint8_t *data, Navigation *navigation );
 };
 
 }
@@ -32,12 +32,14 @@ This is a licence-free software, it can be used by anyone who try to build a bet
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <poll.h>
 
 #include <mutex>
 
 #include "common/logger/log.h"
 
 #define INTERFACE_NAME_MAX_SIZE 64
+#define SERIAL_READ_BUFFER_SIZE 4096
 
 class Serial
 {
@@ -47,6 +49,7 @@ class Serial
     };
 
     static const uint32_t set_speed;
+    static const int32_t read_timeout;
 
 public:
 
@@ -84,6 +87,7 @@ public:
 
     int32_t readByte( uint8_t *buffer );
     int32_t readBytes( uint8_t *buffer, int32_t size );
+    int32_t readAvailable( uint8_t *buffer, uint32_t size, int32_t timeout );
     int32_t readPattern(
             const uint8_t *start, uint32_t startSize
             , const uint8_t *stop, uint32_t stopSize
@@ -101,12 +105,19 @@ private:
 
     Settings mSettings;
 
-    fd_set mFileDescriptorSet;
     uint32_t mSpeed;
 
     termios mOptions;
     std::mutex mMutex;
 
+    // Received bytes not handed out yet, guarded by the mutex
+    uint8_t mReadBuffer[ SERIAL_READ_BUFFER_SIZE ];
+    uint32_t mReadHead;
+    uint32_t mReadTail;
+
+    int32_t fill( int32_t timeout );
+    uint32_t take( uint8_t *buffer, uint32_t size );
+
 };
 
 class Timeout
@@ -20,15 +20,29 @@ public:
 
     virtual CommandHandler *getCommandHandler();
     virtual void addCommand( Command* cmd );
+    virtual void start();
 
     virtual Transport::Client *getClient();
 
     static void setSimulated( bool simulated );
     static bool isSimulated();
 
+    static cJSON *createEvent( const char *command, cJSON *params );
+
 protected:
 
 private:
+
+    /**
+     * @brief Mutator whose changes are streamed, and the parameters that are
+     */
+    struct EventFilter {
+        const char *command;
+        const char *params[ 8 ];
+    };
+
+    static const EventFilter event_filters[];
+
     CommandHandler mCommandHandler;
     static bool mSimulated;
 };
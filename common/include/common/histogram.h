@@ -0,0 +1,87 @@
+/** ****************************************************************************
+ * @file histogram.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief Histogram class declaration. Records latencies in nanoseconds into
+ * log-linear buckets, eight per power of two, so any value is kept to within
+ * 12.5% from 1 ns up to about 18 minutes. Each thread records into its own
+ * shard of counters without taking a lock. Shards are only summed when a
+ * snapshot is taken.
+ * ****************************************************************************/
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+
+class Histogram
+{
+    static const uint32_t sub_bucket_bits = 3;
+    static const uint32_t sub_bucket_count = 1 << sub_bucket_bits;
+    static const uint32_t max_value_bits = 40;
+    static const uint32_t shard_count = 8;
+
+public:
+
+    static const uint32_t bucket_count
+            = ( max_value_bits - sub_bucket_bits + 1 ) * sub_bucket_count;
+
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Records the time from construction to the end of the scope
+     */
+    class Scope
+    {
+    public:
+        explicit Scope( Histogram *histogram );
+        ~Scope();
+
+        Scope( const Scope &scope ) = delete;
+        Scope& operator=( const Scope &scope ) = delete;
+
+    private:
+        Histogram *mHistogram;
+        Clock::time_point mStart;
+    };
+
+    /**
+     * @brief Counters of every shard summed at one point in time
+     */
+    struct Snapshot
+    {
+        uint64_t count;
+        uint64_t sum;
+        uint64_t max;
+        uint64_t buckets[ bucket_count ];
+
+        uint64_t getPercentile( double percentile ) const;
+    };
+
+    Histogram();
+
+    Histogram( const Histogram &histogram ) = delete;
+    Histogram& operator=( const Histogram &histogram ) = delete;
+
+    void record( uint64_t value );
+    void snapshot( Snapshot *snapshot );
+
+    static uint32_t getBucket( uint64_t value );
+    static uint64_t getBucketLimit( uint32_t bucket );
+
+private:
+    struct Shard {
+        std::atomic< uint64_t > buckets[ bucket_count ];
+        std::atomic< uint64_t > sum;
+        std::atomic< uint64_t > max;
+        // Keeps the counters of two threads off the same cache line
+        char padding[ 64 ];
+    };
+
+    Shard mShards[ shard_count ];
+
+    static uint32_t getShard();
+};
+
+#endif // HISTOGRAM_H
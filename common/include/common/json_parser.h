@@ -0,0 +1,53 @@
+/** ****************************************************************************
+ * @file json_parser.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief JSON parser class declaration. Front end for parsing commands into
+ * cJSON trees. Built with USE_SIMD_JSON, the input is first scanned 64 bytes
+ * at a time with SSE2 or NEON, falling back to plain C elsewhere, to find
+ * every structural character, string quote and scalar. The tree is then built
+ * by walking that index instead of the input. Without it cJSON parses as is.
+ * ****************************************************************************/
+#ifndef JSON_PARSER_H
+#define JSON_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common/cjson/cJSON.h"
+
+class JsonParser
+{
+    static const size_t block_size = 64;
+    static const uint32_t max_depth = CJSON_NESTING_LIMIT;
+
+public:
+
+    static cJSON *parse( const char *data );
+    static cJSON *parse( const char *data, size_t size );
+
+private:
+    struct Scanner {
+        uint64_t escaped;
+        uint64_t inString;
+        uint64_t scalar;
+    };
+
+    struct Frame {
+        cJSON *item;
+        cJSON *tail;
+    };
+
+    static bool scan( const char *data, size_t size
+                      , uint32_t *indices, uint32_t *count );
+    static uint64_t scanBlock( Scanner *scanner, const char *block );
+
+    static cJSON *build( const char *data, size_t size
+                         , const uint32_t *indices, uint32_t count
+                         , Frame *stack );
+    static char *parseString( const char *data, uint32_t open, uint32_t close );
+    static bool parseScalar( const char *data, uint32_t start, uint32_t end
+                             , cJSON **item );
+};
+
+#endif // JSON_PARSER_H
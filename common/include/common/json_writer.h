@@ -0,0 +1,63 @@
+/** ****************************************************************************
+ * @file json_writer.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief JSON writer class declaration. Writes compact JSON straight into a
+ * buffer, either token by token or by walking a cJSON tree, so a response is
+ * serialized once into memory that can be handed off without another copy.
+ * ****************************************************************************/
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common/buffer.h"
+#include "common/cjson/cJSON.h"
+
+class JsonWriter
+{
+    static const uint32_t max_depth = 64;
+
+public:
+
+    explicit JsonWriter( Buffer *buffer );
+
+    JsonWriter( const JsonWriter &writer ) = delete;
+    JsonWriter& operator=( const JsonWriter &writer ) = delete;
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    void key( const char *name );
+
+    void value( const char *string );
+    void value( double number );
+    void value( int64_t number );
+    void value( bool boolean );
+    void null();
+    void raw( const char *json );
+
+    void write( const cJSON *item );
+
+    bool isComplete();
+    bool isFailed();
+
+private:
+    Buffer *mBuffer;
+    uint32_t mDepth;
+    bool mFirst[ max_depth ];
+    bool mAfterKey;
+    bool mFailed;
+
+    void separate();
+    void push( char c );
+    void pop( char c );
+    void append( const char *data, size_t size );
+    void appendString( const char *string );
+    void writeItem( const cJSON *item );
+};
+
+#endif // JSON_WRITER_H
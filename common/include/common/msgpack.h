@@ -0,0 +1,50 @@
+/** ****************************************************************************
+ * @file msgpack.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief MessagePack class declaration. Converts between MessagePack and cJSON
+ * trees so binary clients reach the same commands as JSON ones. Only the
+ * types JSON has are supported: nil, booleans, integers, floats, strings,
+ * arrays and maps keyed by strings. Binary and extension types are rejected.
+ * ****************************************************************************/
+#ifndef MSGPACK_H
+#define MSGPACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common/buffer.h"
+#include "common/cjson/cJSON.h"
+
+class MsgPack
+{
+    static const uint32_t max_depth = 64;
+
+public:
+
+    static cJSON *parse( const char *data, size_t size );
+    static bool write( const cJSON *item, Buffer *buffer );
+
+private:
+    struct Frame {
+        cJSON *item;
+        cJSON *tail;
+        uint32_t remaining;
+    };
+
+    static bool readValue( const uint8_t *data, size_t size, size_t *offset
+                           , cJSON **item, uint32_t *count );
+    static bool readString( const uint8_t *data, size_t size, size_t *offset
+                            , char **string );
+    static bool readStringLength( const uint8_t *data, size_t size
+                                  , size_t *offset, uint32_t *length );
+
+    static bool writeItem( const cJSON *item, Buffer *buffer, uint32_t depth );
+    static bool writeNumber( double number, Buffer *buffer );
+    static bool writeString( const char *string, Buffer *buffer );
+    static bool writeHeader( Buffer *buffer, uint32_t count
+                             , uint8_t fixed, uint32_t fixedMax
+                             , uint8_t marker16, uint8_t marker32 );
+};
+
+#endif // MSGPACK_H
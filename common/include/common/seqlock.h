@@ -0,0 +1,108 @@
+/** ****************************************************************************
+ * @file seqlock.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief Seqlock class template. Holds a copy of a plain struct that one thread
+ * replaces and any number of threads read without taking a lock. A sequence
+ * counter is odd while a store is in progress, a reader that overlaps a store
+ * copies again.
+ * ****************************************************************************/
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <string.h>
+#include <stdint.h>
+#include <thread>
+#include <type_traits>
+
+template< typename T >
+class Seqlock
+{
+    static_assert( std::is_trivially_copyable< T >::value
+                   , "Seqlock only holds trivially copyable types" );
+
+    static const uint32_t word_count
+            = ( sizeof( T ) + sizeof( uint32_t ) - 1 ) / sizeof( uint32_t );
+
+public:
+
+    /**
+     * @brief Constructor
+     */
+    Seqlock()
+        : mSequence( 0 )
+    {
+        for( uint32_t i = 0; i < word_count; i++ ) {
+            mWords[ i ].store( 0, std::memory_order_relaxed );
+        }
+    }
+
+    Seqlock( const Seqlock &seqlock ) = delete;
+    Seqlock& operator=( const Seqlock &seqlock ) = delete;
+
+    /**
+     * @brief Replaces the value held. Only one thread may store.
+     * @param value Value
+     */
+    void store( const T &value )
+    {
+        uint32_t words[ word_count ] = {};
+        memcpy( words, &value, sizeof( T ) );
+
+        uint32_t sequence = mSequence.load( std::memory_order_relaxed );
+        mSequence.store( sequence + 1, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_release );
+
+        for( uint32_t i = 0; i < word_count; i++ ) {
+            mWords[ i ].store( words[ i ], std::memory_order_relaxed );
+        }
+
+        mSequence.store( sequence + 2, std::memory_order_release );
+    }
+
+    /**
+     * @brief Copies the value held
+     * @param value Copy of the value
+     * @return Boolean indicating a value was ever stored
+     */
+    bool load( T *value ) const
+    {
+        uint32_t words[ word_count ];
+        uint32_t begin = 0;
+        while( true ) {
+            begin = mSequence.load( std::memory_order_acquire );
+            if( begin & 1 ) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            for( uint32_t i = 0; i < word_count; i++ ) {
+                words[ i ] = mWords[ i ].load( std::memory_order_relaxed );
+            }
+
+            std::atomic_thread_fence( std::memory_order_acquire );
+            if( mSequence.load( std::memory_order_relaxed ) == begin ) {
+                break;
+            }
+        }
+
+        memcpy( value, words, sizeof( T ) );
+        return begin != 0;
+    }
+
+    /**
+     * @brief Retrieves the number of values stored so far
+     * @return Number of stores
+     */
+    uint32_t getStored() const
+    {
+        return mSequence.load( std::memory_order_acquire ) / 2;
+    }
+
+private:
+    std::atomic< uint32_t > mSequence;
+    std::atomic< uint32_t > mWords[ word_count ];
+};
+
+#endif // SEQLOCK_H
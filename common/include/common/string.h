@@ -3,13 +3,14 @@
 
 #include <string.h>
 
+#include "common/buffer.h"
+
 /**
  * @brief The common string class, to be used in place of the c++ string and so
  * I don't have to keep performing common string operations manually
  */
 class String
 {
-    static const size_t max_size;
     static const char null_char;
 public:
 
@@ -17,18 +18,18 @@ public:
     ~String();
 
     String& operator=(const char *str);
-    String& operator=(const String &str);
+    String& operator=(String &str);
 
     const char *getData();
     size_t getLength();
 
     void append( const char *str, const size_t len = 0 );
+    void reserve( const size_t len );
     void clear();
 
 protected:
 private:
-    char *mString;
-    size_t mLength;
+    Buffer mBuffer;
 };
 
 #endif // STRING_H
@@ -1,6 +1,7 @@
 #ifndef CLIENT_H
 #define CLIENT_H
 
+#include "common/codec.h"
 #include "common/error/error.h"
 
 namespace Transport {
@@ -8,8 +9,15 @@ namespace Transport {
 class Client
 {
 public:
+    Client();
     virtual ~Client();
     virtual uint32_t send( const char *str ) = 0;
+
+    uint32_t setEncoding( Codec::Encoding encoding );
+    Codec::Encoding getEncoding();
+
+private:
+    Codec::Encoding mEncoding;
 };
 
 }
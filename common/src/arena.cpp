@@ -0,0 +1,301 @@
+#include <mutex>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/arena.h"
+#include "common/cjson/cJSON.h"
+#include "common/logger/log.h"
+
+namespace
+{
+
+// Every allocation handed to cJSON is preceded by a tag saying where it came
+// from, the header keeps the returned pointer aligned the same as malloc
+struct Tag {
+    uint64_t magic;
+    uint64_t reserved;
+};
+
+const uint64_t tag_arena    = 0x41524e4141524e41ULL;
+const uint64_t tag_heap     = 0x48454150484541ULL;
+
+std::once_flag hooks_once;
+
+}
+
+const size_t Arena::default_block_size  = 4096;
+const size_t Arena::alignment           = 16;
+
+thread_local Arena *Arena::sCurrent = nullptr;
+std::atomic< bool > Arena::sInstalled( false );
+std::atomic< uint64_t > Arena::sArenaAllocations( 0 );
+std::atomic< uint64_t > Arena::sHeapAllocations( 0 );
+
+/**
+ * @brief Rounds a size up to the allocation alignment
+ * @param size Size to round
+ * @param alignment Power of two alignment
+ * @return Rounded size
+ */
+static inline size_t alignSize( size_t size, size_t alignment )
+{
+    return ( size + alignment - 1 ) & ~( alignment - 1 );
+}
+
+/**
+ * @brief Constructor, makes the arena current on the calling thread
+ * @param arena Arena to allocate from, nullptr sends allocations to the heap
+ */
+Arena::Scope::Scope( Arena *arena )
+    : mPrevious( sCurrent )
+{
+    sCurrent = arena;
+}
+
+/**
+ * @brief Destructor, restores the arena that was current before
+ */
+Arena::Scope::~Scope()
+{
+    sCurrent = mPrevious;
+}
+
+/**
+ * @brief Constructor, no memory is taken until the first allocation
+ * @param blockSize Size of each block taken from the heap
+ */
+Arena::Arena( size_t blockSize )
+    : mBlockSize( blockSize > 0 ? blockSize : default_block_size )
+    , mBlocks( nullptr )
+    , mAllocations( 0 )
+    , mBlockCount( 0 )
+    , mUsed( 0 )
+{
+}
+
+/**
+ * @brief Destructor, releases every block. Nothing allocated from the arena
+ * may be used afterwards.
+ */
+Arena::~Arena()
+{
+    while( mBlocks != nullptr ) {
+        Block *next = mBlocks->next;
+        free( mBlocks );
+        mBlocks = next;
+    }
+}
+
+/**
+ * @brief Allocates memory from the arena, tagged so hookFree() leaves it be
+ * @param size Number of bytes
+ * @return Pointer to the memory, nullptr if a block couldn't be allocated
+ */
+void *Arena::allocate( size_t size )
+{
+    if( size > SIZE_MAX / 2 ) {
+        return nullptr;
+    }
+
+    size_t needed = alignSize( sizeof( Tag ) + size, alignment );
+
+    Block *block = mBlocks;
+    if( block == nullptr || block->size - block->used < needed ) {
+        if( needed > mBlockSize && block != nullptr ) {
+            // Give large allocations a block of their own behind the current
+            // one so the space left in it isn't abandoned
+            Block *large = addBlock( needed );
+            if( large == nullptr ) {
+                return nullptr;
+            }
+            mBlocks = block;
+            large->next = block->next;
+            block->next = large;
+            block = large;
+        } else {
+            block = addBlock( ( needed > mBlockSize ) ? needed : mBlockSize );
+            if( block == nullptr ) {
+                return nullptr;
+            }
+        }
+    }
+
+    char *data = reinterpret_cast< char* >( block )
+            + alignSize( sizeof( Block ), alignment ) + block->used;
+    block->used += needed;
+
+    Tag *tag = reinterpret_cast< Tag* >( data );
+    tag->magic = tag_arena;
+
+    mAllocations++;
+    mUsed += needed;
+    return data + sizeof( Tag );
+}
+
+/**
+ * @brief Releases everything allocated from the arena, the most recent block
+ * is kept for reuse
+ */
+void Arena::reset()
+{
+    if( mBlocks == nullptr ) {
+        return;
+    }
+
+    Block *next = mBlocks->next;
+    while( next != nullptr ) {
+        Block *block = next;
+        next = block->next;
+        free( block );
+    }
+
+    mBlocks->next = nullptr;
+    mBlocks->used = 0;
+    mBlockCount   = 1;
+    mAllocations  = 0;
+    mUsed         = 0;
+}
+
+/**
+ * @brief Retrieves the number of allocations made since the last reset
+ * @return Number of allocations
+ */
+uint32_t Arena::getAllocations()
+{
+    return mAllocations;
+}
+
+/**
+ * @brief Retrieves the number of blocks taken from the heap
+ * @return Number of blocks
+ */
+uint32_t Arena::getBlocks()
+{
+    return mBlockCount;
+}
+
+/**
+ * @brief Retrieves the number of bytes handed out since the last reset,
+ * including tags and padding
+ * @return Number of bytes
+ */
+size_t Arena::getUsed()
+{
+    return mUsed;
+}
+
+/**
+ * @brief Routes cJSON allocations through the arena hooks. Must be called
+ * before any cJSON object is created, the first thing in main().
+ */
+void Arena::installHooks()
+{
+    std::call_once( hooks_once, []() {
+        cJSON_Hooks hooks;
+        hooks.malloc_fn = &Arena::hookMalloc;
+        hooks.free_fn   = &Arena::hookFree;
+        cJSON_InitHooks( &hooks );
+        sInstalled = true;
+    } );
+}
+
+/**
+ * @brief Determines if the cJSON hooks have been installed
+ * @return Boolean indicating arenas are in use
+ */
+bool Arena::isInstalled()
+{
+    return sInstalled;
+}
+
+/**
+ * @brief Retrieves the number of cJSON allocations served by an arena
+ * @return Number of allocations
+ */
+uint64_t Arena::getArenaAllocations()
+{
+    return sArenaAllocations.load( std::memory_order_relaxed );
+}
+
+/**
+ * @brief Retrieves the number of cJSON allocations that went to the heap
+ * @return Number of allocations
+ */
+uint64_t Arena::getHeapAllocations()
+{
+    return sHeapAllocations.load( std::memory_order_relaxed );
+}
+
+/**
+ * @brief Takes a new block from the heap and makes it the current block
+ * @param size Usable size of the block
+ * @return Pointer to the block, nullptr on failure
+ */
+Arena::Block *Arena::addBlock( size_t size )
+{
+    void *memory = nullptr;
+    if( posix_memalign( &memory, alignment
+                        , alignSize( sizeof( Block ), alignment ) + size ) != 0 ) {
+        LOG_ERROR( "failed to allocate arena block" );
+        return nullptr;
+    }
+
+    Block *block = static_cast< Block* >( memory );
+    block->next = mBlocks;
+    block->size = size;
+    block->used = 0;
+
+    mBlocks = block;
+    mBlockCount++;
+    return block;
+}
+
+/**
+ * @brief cJSON allocation hook, uses the calling thread's arena if it has one
+ * @param size Number of bytes
+ * @return Pointer to the memory, nullptr on failure
+ */
+void *Arena::hookMalloc( size_t size )
+{
+    Arena *arena = sCurrent;
+    if( arena != nullptr ) {
+        void *data = arena->allocate( size );
+        if( data != nullptr ) {
+            sArenaAllocations.fetch_add( 1, std::memory_order_relaxed );
+            return data;
+        }
+    }
+
+    if( size > SIZE_MAX - sizeof( Tag ) ) {
+        return nullptr;
+    }
+
+    Tag *tag = static_cast< Tag* >( malloc( sizeof( Tag ) + size ) );
+    if( tag == nullptr ) {
+        return nullptr;
+    }
+
+    tag->magic = tag_heap;
+    sHeapAllocations.fetch_add( 1, std::memory_order_relaxed );
+    return tag + 1;
+}
+
+/**
+ * @brief cJSON free hook. Arena memory is released with its arena, anything
+ * else goes back to the heap.
+ * @param ptr Pointer returned by hookMalloc()
+ */
+void Arena::hookFree( void *ptr )
+{
+    if( ptr == nullptr ) {
+        return;
+    }
+
+    Tag *tag = static_cast< Tag* >( ptr ) - 1;
+    if( tag->magic == tag_arena ) {
+        // Released with the arena
+    } else {
+        tag->magic = 0;
+        free( tag );
+    }
+}
@@ -0,0 +1,328 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/buffer.h"
+#include "common/logger/log.h"
+
+const size_t Buffer::min_capacity       = 64;
+const size_t Buffer::default_chunk_size = 64 * 1024;
+
+/**
+ * @brief Constructor
+ * @param mode (Optional) Storage mode of the buffer
+ * @param chunkSize (Optional) Size of each block allocated in chunked mode
+ */
+Buffer::Buffer( Mode mode, size_t chunkSize )
+    : mMode( mode )
+    , mChunkSize( chunkSize > 0 ? chunkSize : default_chunk_size )
+    , mData( nullptr )
+    , mSize( 0 )
+    , mCapacity( 0 )
+{
+}
+
+/**
+ * @brief Destructor
+ */
+Buffer::~Buffer()
+{
+    clear();
+}
+
+/**
+ * @brief Appends data to the end of the buffer
+ * @param data Pointer to the data
+ * @param size Size of the data
+ * @return Boolean indicating the data was appended
+ */
+bool Buffer::append( const char *data, size_t size )
+{
+    if( data == nullptr || size == 0 ) {
+        return true;
+    }
+
+    if( size > SIZE_MAX - mSize - 1 ) {
+        LOG_ERROR( "buffer size overflow" );
+        return false;
+    }
+
+    if( mMode == Mode::CHUNKED ) {
+        return appendChunk( data, size );
+    }
+
+    size_t required = mSize + size;
+    if( required > mCapacity ) {
+        // Double the capacity so repeated appends are amortized constant time
+        size_t capacity = ( mCapacity > min_capacity ) ? mCapacity : min_capacity;
+        while( capacity < required ) {
+            capacity = ( capacity > SIZE_MAX / 2 ) ? required : capacity * 2;
+        }
+        if( !grow( capacity ) ) {
+            return false;
+        }
+    }
+
+    memcpy( &mData[ mSize ], data, size );
+    mSize += size;
+    mData[ mSize ] = '\0';
+
+    return true;
+}
+
+/**
+ * @brief Makes sure the buffer can hold at least the given number of bytes
+ * without reallocating. Ignored by chunked buffers.
+ * @param capacity Desired capacity in bytes
+ * @return Boolean indicating the capacity is available
+ */
+bool Buffer::reserve( size_t capacity )
+{
+    if( mMode == Mode::CHUNKED || capacity <= mCapacity ) {
+        return true;
+    }
+    return grow( capacity );
+}
+
+/**
+ * @brief Releases all data held by the buffer. The storage mode is kept.
+ */
+void Buffer::clear()
+{
+    if( mData ) {
+        free( mData );
+        mData = nullptr;
+    }
+
+    for( auto it = mChunks.begin(); it != mChunks.end(); it++ ) {
+        free( it->data );
+    }
+    mChunks.clear();
+
+    mSize     = 0;
+    mCapacity = 0;
+}
+
+/**
+ * @brief Hands ownership of the data to the caller and empties the buffer.
+ * Chunked data is made contiguous first.
+ * @return Null terminated data that must be released with free(), or nullptr
+ * if the buffer is empty
+ */
+char *Buffer::release()
+{
+    if( mMode == Mode::CHUNKED && !flatten() ) {
+        return nullptr;
+    }
+
+    char *data = mData;
+    mData     = nullptr;
+    mSize     = 0;
+    mCapacity = 0;
+
+    return data;
+}
+
+/**
+ * @brief Sets the storage mode. The mode can only be changed while the buffer
+ * is empty.
+ * @param mode Desired storage mode
+ * @return Boolean indicating the mode was set
+ */
+bool Buffer::setMode( Mode mode )
+{
+    if( mode == mMode ) {
+        return true;
+    }
+
+    if( mSize > 0 ) {
+        LOG_WARN( "cannot change the mode of a buffer holding data" );
+        return false;
+    }
+
+    clear();
+    mMode = mode;
+
+    return true;
+}
+
+/**
+ * @brief Retrieves the storage mode
+ * @return Storage mode
+ */
+Buffer::Mode Buffer::getMode()
+{
+    return mMode;
+}
+
+/**
+ * @brief Retrieves the data as one null terminated block. A chunked buffer is
+ * copied into a single block once and stays contiguous afterwards.
+ * @return Pointer to the data, nullptr if the buffer is empty
+ */
+const char *Buffer::getData()
+{
+    if( mMode == Mode::CHUNKED ) {
+        flatten();
+    }
+    return mData;
+}
+
+/**
+ * @brief Retrieves the number of bytes held by the buffer
+ * @return Size of the data
+ */
+size_t Buffer::getSize()
+{
+    return mSize;
+}
+
+/**
+ * @brief Retrieves the number of bytes the buffer can hold before it has to
+ * allocate again
+ * @return Capacity in bytes
+ */
+size_t Buffer::getCapacity()
+{
+    if( mMode == Mode::CHUNKED ) {
+        size_t capacity = 0;
+        for( auto it = mChunks.begin(); it != mChunks.end(); it++ ) {
+            capacity += it->capacity;
+        }
+        return capacity;
+    }
+    return mCapacity;
+}
+
+/**
+ * @brief Retrieves the number of blocks the data is stored in
+ * @return Number of blocks
+ */
+size_t Buffer::getChunkCount()
+{
+    if( mMode == Mode::CHUNKED ) {
+        return mChunks.size();
+    }
+    return ( mSize > 0 ) ? 1 : 0;
+}
+
+/**
+ * @brief Retrieves a block of data without copying it
+ * @param index Index of the block
+ * @param size Returns the size of the block
+ * @return Pointer to the block, nullptr if the index is out of range
+ */
+const char *Buffer::getChunk( size_t index, size_t *size )
+{
+    const char *data = nullptr;
+    size_t length = 0;
+
+    if( mMode == Mode::CHUNKED ) {
+        if( index < mChunks.size() ) {
+            data   = mChunks[ index ].data;
+            length = mChunks[ index ].size;
+        }
+    } else if( index == 0 && mSize > 0 ) {
+        data   = mData;
+        length = mSize;
+    }
+
+    if( size ) {
+        *size = length;
+    }
+
+    return data;
+}
+
+/**
+ * @brief Resizes the contiguous block, keeping room for the null terminator
+ * @param capacity Desired capacity in bytes
+ * @return Boolean indicating the block was resized
+ */
+bool Buffer::grow( size_t capacity )
+{
+    char *data = static_cast< char* >( realloc( mData, capacity + 1 ) );
+    if( data == nullptr ) {
+        LOG_ERROR( "failed to allocate %zu bytes", capacity + 1 );
+        return false;
+    }
+
+    mData     = data;
+    mCapacity = capacity;
+    mData[ mSize ] = '\0';
+
+    return true;
+}
+
+/**
+ * @brief Appends data to the chunk list, filling the last block before
+ * allocating a new one
+ * @param data Pointer to the data
+ * @param size Size of the data
+ * @return Boolean indicating the data was appended
+ */
+bool Buffer::appendChunk( const char *data, size_t size )
+{
+    while( size > 0 ) {
+        if( mChunks.empty() || mChunks.back().size == mChunks.back().capacity ) {
+            Chunk chunk;
+            chunk.data = static_cast< char* >( malloc( mChunkSize ) );
+            if( chunk.data == nullptr ) {
+                LOG_ERROR( "failed to allocate %zu bytes", mChunkSize );
+                return false;
+            }
+            chunk.size     = 0;
+            chunk.capacity = mChunkSize;
+            mChunks.push_back( chunk );
+        }
+
+        Chunk &chunk = mChunks.back();
+        size_t length = chunk.capacity - chunk.size;
+        if( length > size ) {
+            length = size;
+        }
+
+        memcpy( &chunk.data[ chunk.size ], data, length );
+        chunk.size += length;
+        mSize      += length;
+        data       += length;
+        size       -= length;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Copies the chunk list into a single block and switches the buffer to
+ * contiguous mode
+ * @return Boolean indicating the buffer is contiguous
+ */
+bool Buffer::flatten()
+{
+    if( mMode == Mode::CONTIGUOUS ) {
+        return true;
+    }
+
+    if( mSize > 0 ) {
+        char *data = static_cast< char* >( malloc( mSize + 1 ) );
+        if( data == nullptr ) {
+            LOG_ERROR( "failed to allocate %zu bytes", mSize + 1 );
+            return false;
+        }
+
+        size_t offset = 0;
+        for( auto it = mChunks.begin(); it != mChunks.end(); it++ ) {
+            memcpy( &data[ offset ], it->data, it->size );
+            offset += it->size;
+            free( it->data );
+        }
+        mChunks.clear();
+
+        data[ mSize ] = '\0';
+        mData     = data;
+        mCapacity = mSize;
+    }
+
+    mMode = Mode::CONTIGUOUS;
+
+    return true;
+}
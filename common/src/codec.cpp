@@ -0,0 +1,123 @@
+#include <string.h>
+#include <strings.h>
+
+#include "common/codec.h"
+#include "common/json_parser.h"
+#include "common/json_writer.h"
+#include "common/msgpack.h"
+
+const char *Codec::encoding_strings[] = {
+    "json"
+    , "msgpack"
+    , nullptr
+};
+
+const char *Codec::content_type_json    = "application/json";
+const char *Codec::content_type_msgpack = "application/msgpack";
+
+// Used by clients written before the type was registered
+static const char *content_type_msgpack_legacy = "application/x-msgpack";
+
+/**
+ * @brief Determines if a content type names a media type, ignoring case and
+ * any parameters that follow it
+ * @param type Content type
+ * @param media Media type
+ * @return Boolean indicating the content type is the media type
+ */
+static bool isMediaType( const char *type, const char *media )
+{
+    size_t length = strlen( media );
+    if( strncasecmp( type, media, length ) != 0 ) {
+        return false;
+    }
+    return type[ length ] == '\0' || type[ length ] == ';' || type[ length ] == ' ';
+}
+
+/**
+ * @brief Parses a command
+ * @param data Encoded command
+ * @param size Size of the data in bytes
+ * @param encoding Encoding of the data
+ * @return Parsed tree, nullptr if the data is invalid
+ */
+cJSON *Codec::decode( const char *data, size_t size, Encoding encoding )
+{
+    if( encoding == Encoding::MSGPACK ) {
+        return MsgPack::parse( data, size );
+    }
+    return JsonParser::parse( data, size );
+}
+
+/**
+ * @brief Writes a response
+ * @param item Tree to write
+ * @param encoding Encoding to write it in
+ * @param buffer Buffer to append to
+ * @return Boolean indicating the whole tree was written
+ */
+bool Codec::encode( const cJSON *item, Encoding encoding, Buffer *buffer )
+{
+    if( encoding == Encoding::MSGPACK ) {
+        return MsgPack::write( item, buffer );
+    }
+
+    JsonWriter writer( buffer );
+    writer.write( item );
+    return writer.isComplete();
+}
+
+/**
+ * @brief Converts an encoding to its content type
+ * @param encoding Encoding
+ * @return Content type
+ */
+const char *Codec::encodingToContentType( Encoding encoding )
+{
+    return ( encoding == Encoding::MSGPACK )
+            ? content_type_msgpack : content_type_json;
+}
+
+/**
+ * @brief Converts a content type to an encoding
+ * @param type Content type, may be nullptr
+ * @return MSGPACK for MessagePack content, otherwise JSON
+ */
+Codec::Encoding Codec::contentTypeToEncoding( const char *type )
+{
+    if( type != nullptr
+            && ( isMediaType( type, content_type_msgpack )
+                 || isMediaType( type, content_type_msgpack_legacy ) ) ) {
+        return Encoding::MSGPACK;
+    }
+    return Encoding::JSON;
+}
+
+/**
+ * @brief Converts a string to an encoding
+ * @param encoding Encoding string
+ * @return Encoding, ENCODING_MAX if the string is unknown
+ */
+Codec::Encoding Codec::stringToEncoding( const char *encoding )
+{
+    Encoding e = Encoding::ENCODING_MAX;
+    for( int i = 0; encoding != nullptr && encoding_strings[ i ] != nullptr; i++ ) {
+        if( strcmp( encoding_strings[ i ], encoding ) == 0 ) {
+            e = static_cast< Encoding >( i );
+        }
+    }
+    return e;
+}
+
+/**
+ * @brief Converts an encoding to a string
+ * @param encoding Encoding
+ * @return Character array representation of the encoding
+ */
+const char *Codec::encodingToString( Encoding encoding )
+{
+    if( encoding >= 0 && encoding < Encoding::ENCODING_MAX ) {
+        return encoding_strings[ encoding ];
+    }
+    return nullptr;
+}
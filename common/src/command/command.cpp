@@ -18,7 +18,7 @@ const char *Command::error_control_unavailable = "Control is unavailable";
  *  an optional parameter in the command
  */
 Command::Command( const char *mutator, const char *accessor, const char *optional )
-    : mOptional( nullptr )
+    : mCache( nullptr )
     , mAccessible( false )
     , mMutable( false )
 {
@@ -60,46 +60,152 @@ Command::Command( const char *mutator, const char *accessor, const char *optiona
  */
 Command::~Command()
 {
+    delete mCache;
 }
 
 /**
- * @brief Handles any parameters that are required by the command. This modifies
- * the parameter list
- * @param params List of parameters
- * @param response Response object to populate
- * @return Boolean indicating success of the operation
+ * @brief Retrieves the accessor cache
+ * @return Pointer to the cache, nullptr if the command doesn't cache
  */
-uint32_t Command::handleRequiredParameters( cJSON *params, const char *&details )
+CommandCache *Command::getCache()
+{
+    return mCache;
+}
+
+/**
+ * @brief Drops every cached accessor result, for changes made other than
+ * through the command's own mutator
+ */
+void Command::invalidateCache()
+{
+    if( mCache != nullptr ) {
+        mCache->invalidate();
+    }
+}
+
+/**
+ * @brief Serves identical accessor calls from the result of the last one.
+ * Entries are dropped whenever the mutator succeeds, only opt in when the
+ * accessor reports nothing that changes in between or a stale result for the
+ * time to live is acceptable. Call from the constructor.
+ * @param ttl Time a result is served for in milliseconds, 0 serves it until
+ * the mutator succeeds
+ */
+void Command::enableCache( uint32_t ttl )
+{
+    if( mCache == nullptr ) {
+        mCache = new CommandCache( ttl );
+    }
+}
+
+/**
+ * @brief Binds the params object to the schema in a single pass, checking the
+ * type of every value the command consumes. The params object isn't modified.
+ * @param params List of parameters, may be nullptr
+ * @param type Accessors ignore parameters they don't consume, mutators reject
+ * them
+ * @param bound Value bound to each schema parameter, indexed as the schema
+ * and sized for the schema maximum
+ * @param details Set to the offending parameter on failure
+ * @return Error code
+ */
+uint32_t Command::bindParameters( cJSON *params, Type type, cJSON **bound
+                                  , const char *&details )
 {
     uint32_t r = Error::Code::NONE;
-    const char *param = nullptr;
-    cJSON *p = nullptr;
 
-    for( auto it = mRequiredMap.begin()
-         ; it != mRequiredMap.end() && r == Error::Code::NONE
-         ; it++ ) {
+    if( params == nullptr ) {
+        if( mSchema.hasRole( CommandSchema::REQUIRED ) ) {
+            // Required parameters are expected
+            r = Error::Code::PARAM_MISSING;
+            details = PARAM_PARAMS;
+        }
+        return r;
+    }
+
+    if( !cJSON_IsObject( params ) ) {
+        details = PARAM_PARAMS;
+        return Error::Code::SYNTAX;
+    }
+
+    for( cJSON *param = params->child
+         ; r == Error::Code::NONE && param != nullptr
+         ; param = param->next ) {
+
+        int32_t index = mSchema.find( param->string );
+        bool consumed = false;
 
-        // Detach the required parameter
-        param = it->first;
-        p = cJSON_DetachItemFromObject( params, param );
+        if( index >= 0 ) {
+            const CommandSchema::Parameter &p = mSchema.get( index );
+            consumed = p.methods[ CommandSchema::REQUIRED ]
+                    || p.methods[ CommandSchema::OPTIONAL ]
+                    || ( type == Type::MUTATOR
+                         && ( p.methods[ CommandSchema::MUTATOR ]
+                              || p.methods[ CommandSchema::OPTIONAL_MUTATOR ] ) );
+        }
 
-        if( p == nullptr ) {
-            // Parameter missing
+        if( !consumed ) {
+            if( type == Type::MUTATOR ) {
+                // Nothing handles this parameter
+                r = Error::Code::PARAM_INVALID;
+                details = param->string;
+            }
+        } else if( bound[ index ] == nullptr ) {
+            const CommandSchema::Parameter &p = mSchema.get( index );
+            if( ( param->type & p.format ) == 0 ) {
+                // The type isn't what the command expects
+                r = Error::Code::SYNTAX;
+                details = p.name;
+            } else {
+                bound[ index ] = param;
+            }
+        }
+    }
+
+    return r;
+}
+
+/**
+ * @brief Handles the required parameters followed by the optional parameter
+ * @param bound Values bound by bindParameters
+ * @param optional Set when the optional parameter was given
+ * @param details Set to the offending parameter on failure
+ * @return Error code
+ */
+uint32_t Command::handleRequiredParameters( cJSON **bound, bool &optional
+                                            , const char *&details )
+{
+    uint32_t r = Error::Code::NONE;
+    uint32_t count = mSchema.getCount();
+
+    for( uint32_t i = 0; i < count && r == Error::Code::NONE; i++ ) {
+        const CommandSchema::Parameter &p = mSchema.get( i );
+        if( !p.methods[ CommandSchema::REQUIRED ] ) {
+            // Not required
+        } else if( bound[ i ] == nullptr ) {
             r = Error::Code::PARAM_MISSING;
+            details = p.name;
         } else {
-            // Parameter found, perform a callback
-            r = it->second( p );
+            r = p.methods[ CommandSchema::REQUIRED ]( bound[ i ] );
+            if( r != Error::Code::NONE ) {
+                details = p.name;
+            }
         }
-
-        // Delete all the parameters we detach
-        if( p ) { cJSON_Delete( p ); }
     }
 
-    if( r != Error::Code::NONE ) {
-        details = param;
+    optional = false;
+    for( uint32_t i = 0; i < count && r == Error::Code::NONE; i++ ) {
+        const CommandSchema::Parameter &p = mSchema.get( i );
+        if( p.methods[ CommandSchema::OPTIONAL ] && bound[ i ] != nullptr ) {
+            r = p.methods[ CommandSchema::OPTIONAL ]( bound[ i ] );
+            if( r == Error::Code::NONE ) {
+                optional = true;
+            } else {
+                details = p.name;
+            }
+        }
     }
 
-    // Required parameters handled successfully
     return r;
 }
 
@@ -0,0 +1,196 @@
+#include "common/buffer.h"
+#include "common/json_writer.h"
+#include "common/command/command_cache.h"
+
+const uint32_t CommandCache::max_entries = 8;
+
+/**
+ * @brief Constructor
+ * @param ttl Time an entry is served for in milliseconds, 0 keeps entries
+ * until the cache is invalidated
+ */
+CommandCache::CommandCache( uint32_t ttl )
+    : mTtl( ttl )
+    , mGeneration( 0 )
+    , mHits( 0 )
+    , mMisses( 0 )
+{
+    mEntries.reserve( max_entries );
+}
+
+/**
+ * @brief Looks up the result cached for a params object
+ * @param params Params object the accessor was called with, may be nullptr
+ * @param generation Set to the current generation, pass it to store() along
+ * with the result computed on a miss
+ * @return Raw item holding the serialized result, nullptr on a miss
+ */
+cJSON *CommandCache::find( cJSON *params, uint64_t *generation )
+{
+    std::string key;
+    bool keyed = makeKey( params, &key );
+    Clock::time_point now = Clock::now();
+
+    cJSON *result = nullptr;
+    {
+        std::lock_guard< std::mutex > lock( mMutex );
+        *generation = mGeneration;
+
+        for( auto it = mEntries.begin(); keyed && it != mEntries.end(); it++ ) {
+            if( it->key == key && !isExpired( *it, now ) ) {
+                result = cJSON_CreateRaw( it->result.c_str() );
+                break;
+            }
+        }
+    }
+
+    if( result != nullptr ) {
+        mHits.fetch_add( 1, std::memory_order_relaxed );
+    } else {
+        mMisses.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    return result;
+}
+
+/**
+ * @brief Stores the result of an accessor. Dropped if the cache was
+ * invalidated since the generation was read, the result may predate the
+ * change.
+ * @param params Params object the accessor was called with, may be nullptr
+ * @param result Result object the accessor built
+ * @param generation Generation read by find() before the accessor ran
+ */
+void CommandCache::store( cJSON *params, cJSON *result, uint64_t generation )
+{
+    std::string key;
+    if( !makeKey( params, &key ) ) {
+        return;
+    }
+
+    // Serialize outside the lock
+    Buffer buffer;
+    JsonWriter writer( &buffer );
+    writer.write( result );
+    if( !writer.isComplete() ) {
+        return;
+    }
+
+    Clock::time_point now = Clock::now();
+
+    std::lock_guard< std::mutex > lock( mMutex );
+    if( generation != mGeneration ) {
+        return;
+    }
+
+    // Reuse the entry for the same key, else take a free one, else replace
+    // the oldest, which is also the first to expire
+    Entry *slot = nullptr;
+    for( auto it = mEntries.begin(); it != mEntries.end(); it++ ) {
+        if( it->key == key ) {
+            slot = &( *it );
+            break;
+        }
+    }
+
+    if( slot == nullptr ) {
+        if( mEntries.size() < max_entries ) {
+            mEntries.push_back( Entry() );
+            slot = &mEntries.back();
+        } else {
+            slot = &mEntries.front();
+            for( auto it = mEntries.begin(); it != mEntries.end(); it++ ) {
+                if( it->stored < slot->stored ) {
+                    slot = &( *it );
+                }
+            }
+        }
+    }
+
+    slot->key.swap( key );
+    slot->result.assign( buffer.getData(), buffer.getSize() );
+    slot->stored = now;
+}
+
+/**
+ * @brief Drops every entry. Results still being computed from before the call
+ * won't be stored.
+ */
+void CommandCache::invalidate()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    mGeneration++;
+    mEntries.clear();
+}
+
+/**
+ * @brief Retrieves the time an entry is served for
+ * @return Time to live in milliseconds, 0 if entries don't expire
+ */
+uint32_t CommandCache::getTtl()
+{
+    return mTtl;
+}
+
+/**
+ * @brief Retrieves the number of entries held, expired ones included
+ * @return Number of entries
+ */
+uint32_t CommandCache::getEntries()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return static_cast< uint32_t >( mEntries.size() );
+}
+
+/**
+ * @brief Retrieves the number of lookups served from the cache
+ * @return Number of hits
+ */
+uint64_t CommandCache::getHits()
+{
+    return mHits.load( std::memory_order_relaxed );
+}
+
+/**
+ * @brief Retrieves the number of lookups the accessor had to run for
+ * @return Number of misses
+ */
+uint64_t CommandCache::getMisses()
+{
+    return mMisses.load( std::memory_order_relaxed );
+}
+
+/**
+ * @brief Determines if an entry has outlived the time to live
+ * @param entry Entry to check
+ * @param now Current time
+ * @return Boolean indicating the entry can't be served
+ */
+bool CommandCache::isExpired( const Entry &entry, Clock::time_point now )
+{
+    return mTtl > 0 && now - entry.stored >= std::chrono::milliseconds( mTtl );
+}
+
+/**
+ * @brief Builds the key for a params object, its compact serialization
+ * @param params Params object, nullptr gives an empty key
+ * @param key Key
+ * @return Boolean indicating the params could be serialized
+ */
+bool CommandCache::makeKey( cJSON *params, std::string *key )
+{
+    key->clear();
+    if( params == nullptr ) {
+        return true;
+    }
+
+    Buffer buffer;
+    JsonWriter writer( &buffer );
+    writer.write( params );
+    if( !writer.isComplete() ) {
+        return false;
+    }
+
+    key->assign( buffer.getData(), buffer.getSize() );
+    return true;
+}
@@ -6,7 +6,10 @@ CommandConsole::CommandConsole()
     // Lets just go ahead and set the control object here
     // mControlObject = &Console::getInstance();
 
-    mMutatorMap[ PARAM_QUIT ] = PARAMETER_CALLBACK( &CommandConsole::setQuit );
+    addMutator( PARAM_QUIT, &CommandConsole::setQuit, CommandSchema::BOOLEAN );
+    addMutator( PARAM_ENCODING, &CommandConsole::setEncoding, CommandSchema::STRING );
+
+    addAccessor( PARAM_ENCODING, &CommandConsole::getEncoding );
 }
 
 uint32_t CommandConsole::setQuit( cJSON *val )
@@ -22,3 +25,35 @@ uint32_t CommandConsole::setQuit( cJSON *val )
     }
     return r;
 }
+
+uint32_t CommandConsole::setEncoding( cJSON *val )
+{
+    uint32_t r = Error::Code::NONE;
+    Transport::Client *client = Console::getInstance().getClient();
+    if( client == nullptr ) {
+        r = Error::Code::CMD_FAILED;
+    } else if( cJSON_IsString( val ) ) {
+        Codec::Encoding encoding = Codec::stringToEncoding( val->valuestring );
+        if( encoding == Codec::Encoding::ENCODING_MAX ) {
+            r = Error::Code::PARAM_OUT_OF_RANGE;
+        } else {
+            r = client->setEncoding( encoding );
+        }
+    } else {
+        r = Error::Code::PARAM_INVALID;
+    }
+    return r;
+}
+
+uint32_t CommandConsole::getEncoding( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    Transport::Client *client = Console::getInstance().getClient();
+    if( client == nullptr ) {
+        r = Error::Code::CMD_FAILED;
+    } else {
+        cJSON_AddStringToObject( response, PARAM_ENCODING
+                                 , Codec::encodingToString( client->getEncoding() ) );
+    }
+    return r;
+}
@@ -1,35 +1,34 @@
 #include "common/command/command_gpio.h"
 
 CommandGpio::CommandGpio( const char *mutator, const char *accessor )
-    : CommandTemplate< AM335X::Gpio >( mutator, accessor, PARAM_PIN )
-    , mPin( 0 )
-    , mBank( 0 )
+    : CommandTemplate< AM335X::Gpio, CommandGpioState >( mutator, accessor, PARAM_PIN )
 {
-    mRequiredMap[ PARAM_BANK ] = PARAMETER_CALLBACK( &CommandGpio::setBank );
+    addRequired( PARAM_BANK, &CommandGpio::setBank, CommandSchema::NUMBER );
 
-    mAccessorMap[ PARAM_BANK ] = PARAMETER_CALLBACK( &CommandGpio::getBank );
-    mAccessorMap[ PARAM_OUTPUT ] = PARAMETER_CALLBACK( &CommandGpio::getBankOutput );
-    mAccessorMap[ PARAM_INPUT ] = PARAMETER_CALLBACK( &CommandGpio::getBankInput );
+    addAccessor( PARAM_BANK, &CommandGpio::getBank );
+    addAccessor( PARAM_OUTPUT, &CommandGpio::getBankOutput );
+    addAccessor( PARAM_INPUT, &CommandGpio::getBankInput );
 
-    mOptional = PARAMETER_CALLBACK( &CommandGpio::setPin );
+    setOptional( &CommandGpio::setPin, CommandSchema::NUMBER );
 
-    mOptionalAccessorMap[ PARAM_BANK ] = PARAMETER_CALLBACK( &CommandGpio::getBank );
-    mOptionalAccessorMap[ PARAM_PIN ] = PARAMETER_CALLBACK( &CommandGpio::getPin );
-    mOptionalAccessorMap[ PARAM_OUTPUT ] = PARAMETER_CALLBACK( &CommandGpio::getOutput );
-    mOptionalAccessorMap[ PARAM_INPUT ] = PARAMETER_CALLBACK( &CommandGpio::getInput );
-    mOptionalAccessorMap[ PARAM_DIR ] = PARAMETER_CALLBACK( &CommandGpio::getDirection );
+    addOptionalAccessor( PARAM_BANK, &CommandGpio::getBank );
+    addOptionalAccessor( PARAM_PIN, &CommandGpio::getPin );
+    addOptionalAccessor( PARAM_OUTPUT, &CommandGpio::getOutput );
+    addOptionalAccessor( PARAM_INPUT, &CommandGpio::getInput );
+    addOptionalAccessor( PARAM_DIR, &CommandGpio::getDirection );
 
-    mOptionalMutatorMap[ PARAM_OUTPUT ] = PARAMETER_CALLBACK( &CommandGpio::setOutput );
-    mOptionalMutatorMap[ PARAM_DIR ] = PARAMETER_CALLBACK( &CommandGpio::setDirection );
+    addOptionalMutator( PARAM_OUTPUT, &CommandGpio::setOutput, CommandSchema::BOOLEAN );
+    addOptionalMutator( PARAM_DIR, &CommandGpio::setDirection, CommandSchema::STRING );
 }
 
 uint32_t CommandGpio::setBank( cJSON *val )
 {
     uint32_t r = Error::Code::NONE;
     if( cJSON_IsNumber( val ) ) {
-        mBank = static_cast< uint32_t >( val->valueint );
-        mControlObject = AM335X::Gpio::getControlObject( mBank );
-        if( mControlObject == nullptr ) {
+        Context &context = getContext();
+        context.bank = static_cast< uint32_t >( val->valueint );
+        context.control = AM335X::Gpio::getControlObject( context.bank );
+        if( context.control == nullptr ) {
             r = Error::Code::PARAM_OUT_OF_RANGE;
         }
     } else {
@@ -42,7 +41,7 @@ uint32_t CommandGpio::setPin( cJSON *val )
 {
     uint32_t r = Error::Code::NONE;
     if( cJSON_IsNumber( val ) ) {
-        mPin = static_cast< uint32_t >( val->valueint );
+        getContext().pin = static_cast< uint32_t >( val->valueint );
     } else {
         r = Error::Code::SYNTAX;
     }
@@ -53,9 +52,9 @@ uint32_t CommandGpio::setOutput( cJSON *val )
 {
     uint32_t r = Error::Code::NONE;
     if( cJSON_IsTrue( val ) ) {
-        mControlObject->setOutput( mPin, true );
+        getControl()->setOutput( getContext().pin, true );
     } else if( cJSON_IsFalse( val ) ) {
-        mControlObject->setOutput( mPin, false );
+        getControl()->setOutput( getContext().pin, false );
     } else {
         r = Error::Code::SYNTAX;
     }
@@ -66,7 +65,7 @@ uint32_t CommandGpio::setDirection( cJSON *val )
 {
     uint32_t r = Error::Code::NONE;
     if( cJSON_IsString( val ) ) {
-        mControlObject->setDirection( mPin, val->valuestring );
+        getControl()->setDirection( getContext().pin, val->valuestring );
     } else {
         r = Error::Code::SYNTAX;
     }
@@ -76,48 +75,48 @@ uint32_t CommandGpio::setDirection( cJSON *val )
 uint32_t CommandGpio::getBank( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
-    cJSON_AddNumberToObject( response, PARAM_BANK, mControlObject->getId() );
+    cJSON_AddNumberToObject( response, PARAM_BANK, getControl()->getId() );
     return r;
 }
 
 uint32_t CommandGpio::getPin( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
-    cJSON_AddNumberToObject( response, PARAM_PIN, mPin );
+    cJSON_AddNumberToObject( response, PARAM_PIN, getContext().pin );
     return r;
 }
 
 uint32_t CommandGpio::getOutput( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
-    cJSON_AddBoolToObject( response, PARAM_OUTPUT, mControlObject->getOutput( mPin ) );
+    cJSON_AddBoolToObject( response, PARAM_OUTPUT, getControl()->getOutput( getContext().pin ) );
     return r;
 }
 
 uint32_t CommandGpio::getInput( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
-    cJSON_AddBoolToObject( response, PARAM_INPUT, mControlObject->getInput( mPin ) );
+    cJSON_AddBoolToObject( response, PARAM_INPUT, getControl()->getInput( getContext().pin ) );
     return r;
 }
 
 uint32_t CommandGpio::getDirection( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
-    cJSON_AddStringToObject( response, PARAM_DIR, mControlObject->getDirection( mPin ) );
+    cJSON_AddStringToObject( response, PARAM_DIR, getControl()->getDirection( getContext().pin ) );
     return r;
 }
 
 uint32_t CommandGpio::getBankOutput( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
-    cJSON_AddNumberToObject( response, PARAM_OUTPUT, mControlObject->getOutput() );
+    cJSON_AddNumberToObject( response, PARAM_OUTPUT, getControl()->getOutput() );
     return r;
 }
 
 uint32_t CommandGpio::getBankInput( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
-    cJSON_AddNumberToObject( response, PARAM_INPUT, mControlObject->getInput() );
+    cJSON_AddNumberToObject( response, PARAM_INPUT, getControl()->getInput() );
     return r;
 }
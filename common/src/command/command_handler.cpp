@@ -1,5 +1,11 @@
+#include <algorithm>
+#include <atomic>
+
+#include "common/json_parser.h"
 #include "common/command/command_handler.h"
 
+const uint32_t CommandHandler::default_batch_threads = 1;
+
 /**
  * @brief Constructor
  * @param type Command type
@@ -18,22 +24,53 @@ const char *CommandContainer::getUsage()
 }
 
 /**
- * @brief Command call wrapper
+ * @brief Retrieves the type of call the container makes
+ * @return Command type
+ */
+Command::Type CommandContainer::getType()
+{
+    return mType;
+}
+
+/**
+ * @brief Retrieves the command object the container calls
+ * @return Pointer to the command
+ */
+Command *CommandContainer::getCommand()
+{
+    return mCmdObj;
+}
+
+/**
+ * @brief Command call wrapper, records how long the call took
  * @param params Parameters to pass to the command
  * @return Response to the call
  */
 bool CommandContainer::call( cJSON *params, cJSON *response )
 {
+    Histogram::Scope scope( &mLatency );
     return mCmdObj->call( params, response, mType );
 }
 
+/**
+ * @brief Retrieves the latencies of the calls made through the container
+ * @return Pointer to the histogram, in nanoseconds
+ */
+Histogram *CommandContainer::getLatency()
+{
+    return &mLatency;
+}
+
 /**
  * @brief CommandHandler Constructor
  */
 CommandHandler::CommandHandler()
     : mCommandMap{}
+    , mBatchThreads( default_batch_threads )
+    , mHelping( false )
+    , mTable( nullptr )
 {
-
+    startHelpers( mBatchThreads - 1 );
 }
 
 /**
@@ -41,11 +78,18 @@ CommandHandler::CommandHandler()
  */
 CommandHandler::~CommandHandler()
 {
+    stopHelpers();
+
     for( auto it = mCommandMap.begin(); it != mCommandMap.end(); it++ ) {
         if( it->second ) {
             delete it->second;
         }
     }
+
+    delete mTable.load();
+    for( auto it = mRetiredTables.begin(); it != mRetiredTables.end(); it++ ) {
+        delete *it;
+    }
 }
 
 CommandMap *CommandHandler::getCommandMap()
@@ -61,11 +105,11 @@ CommandMap *CommandHandler::getCommandMap()
 const char *CommandHandler::getCommandUsage( const char *cmd )
 {
     const char *usage = nullptr;
-    auto it = mCommandMap.find( cmd );
+    CommandContainer *container = lookup( cmd );
 
-    if( it == mCommandMap.end() ) {
+    if( container == nullptr ) {
     } else {
-        usage = it->second->getUsage();
+        usage = container->getUsage();
     }
 
     return usage;
@@ -73,36 +117,71 @@ const char *CommandHandler::getCommandUsage( const char *cmd )
 
 /**
  * @brief Handles a command
- * @param cmdStr Command string to handle
+ * @param cmdStr Command string to handle, either one command object or an
+ * array of them
+ * @param response Response object to populate, must be an array when a batch
+ * is handled, see createResponse()
  * @return Response to the call
  */
 bool CommandHandler::handle( const char *cmdStr, cJSON *response )
 {
     bool ok = true;
 
-    cJSON *parsed = cJSON_Parse( cmdStr );
+    cJSON *parsed = JsonParser::parse( cmdStr );
     if( parsed == nullptr ) {
         /// @todo The cmdStr is invalid, handle this response
         LOG_WARN( "%s: command string is invalid", __FUNCTION__ );
         ok = false;
     }
 
-    cJSON *cmd = cJSON_GetObjectItem( parsed, PARAM_COMMAND );
-    if( ok && cJSON_IsString( cmd ) ) {
+    if( ok ) {
+        ok = dispatch( parsed, response );
+    }
+
+    cJSON_Delete( parsed );
+    return ok;
+}
 
-        auto it = mCommandMap.find( cmd->valuestring );
-        if( it == mCommandMap.end() ) {
+/**
+ * @brief Dispatches an already parsed command
+ * @param command Parsed command object or array of command objects, ownership
+ * remains with the caller
+ * @param response Response object to populate
+ * @return Boolean indicating the command was dispatched
+ */
+bool CommandHandler::dispatch( cJSON *command, cJSON *response )
+{
+    bool ok = true;
+
+    if( cJSON_IsArray( command ) ) {
+        if( cJSON_IsArray( response ) ) {
+            return dispatchBatch( command, response );
+        }
+        LOG_WARN( "%s: a batch needs an array response", __FUNCTION__ );
+        return false;
+    }
+
+    cJSON *cmd = cJSON_GetObjectItem( command, PARAM_COMMAND );
+    if( cJSON_IsString( cmd ) ) {
+
+        CommandContainer *container = lookup( cmd->valuestring );
+        if( container == nullptr ) {
             /// @todo The command does not exist, handle this response
             LOG_WARN( "%s: the '%s' command does not exist\n"
                     , __FUNCTION__, cmd->valuestring );
             ok = false;
         } else {
             // The command exists
-            cJSON *params = cJSON_GetObjectItem( parsed, PARAM_PARAMS );
-            bool success = it->second->call( params, response );
+            cJSON *params = cJSON_GetObjectItem( command, PARAM_PARAMS );
+            bool success = container->call( params, response );
 
             // Add the success parameter to the response object
             cJSON_AddBoolToObject( response, PARAM_SUCCESS, success );
+
+            if( success && mListener
+                    && container->getType() == Command::Type::MUTATOR ) {
+                mListener( cmd->valuestring, params );
+            }
         }
 
     } else {
@@ -110,16 +189,22 @@ bool CommandHandler::handle( const char *cmdStr, cJSON *response )
         ok = false;
     }
 
-    cJSON_Delete( parsed );
     return ok;
 }
 
 /**
- * @brief Adds a command to the command map
+ * @brief Adds a command to the command map. Refused once the handler is
+ * frozen, the map is read without a lock from then on.
  * @param cmd Command to add to the map
  */
 void CommandHandler::addCommand( Command *cmd )
 {
+    if( mTable != nullptr ) {
+        LOG_ERROR( "%s: %s registered after the command table was built"
+                   , __FUNCTION__, cmd->getAccessorName() );
+        return;
+    }
+
     if( cmd->isAccessible() ) {
         mCommandMap[ cmd->getAccessorName() ]
                 = new CommandContainer( Command::Type::ACCESSOR, cmd );
@@ -129,4 +214,305 @@ void CommandHandler::addCommand( Command *cmd )
         mCommandMap[ cmd->getMutatorName() ]
                 = new CommandContainer( Command::Type::MUTATOR, cmd );
     }
+
+    // Anything that cached the list of commands is out of date
+    for( auto it = mCommandMap.begin(); it != mCommandMap.end(); it++ ) {
+        it->second->getCommand()->invalidateCache();
+    }
+}
+
+/**
+ * @brief Builds the perfect hash table used to look up commands. Call once
+ * every command has been registered and before anything serves requests,
+ * lookups fall back to the command map until then.
+ * @return Boolean indicating the table was built
+ */
+bool CommandHandler::freeze()
+{
+    CommandTable *table = new CommandTable();
+    if( !table->build( mCommandMap ) ) {
+        delete table;
+        return false;
+    }
+
+    // Lookups may be running, the table being replaced is kept until the
+    // handler is destroyed
+    CommandTable *previous = mTable.exchange( table );
+    if( previous != nullptr ) {
+        mRetiredTables.push_back( previous );
+    }
+
+    LOG_INFO( "command table holds %u commands in %u slots"
+              , table->getCount(), table->getSlots() );
+    return true;
+}
+
+/**
+ * @brief Determines if the command table has been built
+ * @return Boolean indicating the handler is frozen
+ */
+bool CommandHandler::isFrozen()
+{
+    return mTable != nullptr;
+}
+
+/**
+ * @brief Dispatches an array of commands in one pass, adding one response per
+ * command to the response array in the same order. When more than one batch
+ * thread is allowed, consecutive accessors run in parallel, mutators always
+ * run alone and in order.
+ * @param commands Array of parsed command objects
+ * @param responses Array to populate with the responses
+ * @return Boolean indicating every command was dispatched
+ */
+bool CommandHandler::dispatchBatch( cJSON *commands, cJSON *responses )
+{
+    bool ok = true;
+
+    std::vector< cJSON* > items;
+    std::vector< cJSON* > results;
+
+    cJSON *item = nullptr;
+    cJSON_ArrayForEach( item, commands ) {
+        cJSON *result = cJSON_CreateObject();
+        cJSON_AddItemToArray( responses, result );
+        items.push_back( item );
+        results.push_back( result );
+    }
+
+    size_t i = 0;
+    while( i < items.size() ) {
+        CommandContainer *container = findCommand( items[ i ] );
+
+        if( mBatchThreads > 1
+                && container != nullptr
+                && container->getType() == Command::Type::ACCESSOR ) {
+            // Take the whole run of accessors. Each call keeps its state to
+            // itself and only shares the lock of the control object it reads,
+            // so any of them can run side by side, the same command included.
+            size_t first = i;
+            for( ; i < items.size(); i++ ) {
+                container = findCommand( items[ i ] );
+                if( container == nullptr
+                        || container->getType() != Command::Type::ACCESSOR ) {
+                    break;
+                }
+            }
+
+            dispatchAccessors( items.data() + first, results.data() + first
+                               , i - first );
+        } else {
+            if( !dispatch( items[ i ], results[ i ] ) ) {
+                ok = false;
+            }
+            i++;
+        }
+    }
+
+    // Give every command that couldn't be dispatched a failed response
+    for( i = 0; i < items.size(); i++ ) {
+        if( cJSON_GetObjectItem( results[ i ], PARAM_SUCCESS ) == nullptr ) {
+            cJSON *cmd = cJSON_GetObjectItem( items[ i ], PARAM_COMMAND );
+            if( cJSON_IsString( cmd ) ) {
+                cJSON_AddStringToObject( results[ i ], PARAM_COMMAND, cmd->valuestring );
+            }
+            cJSON_AddBoolToObject( results[ i ], PARAM_SUCCESS, false );
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * @brief Runs consecutive accessors on the calling thread and whichever batch
+ * helpers are free. Concurrent batches share the helpers, so no more threads
+ * than allowed run accessors besides the callers.
+ * @param commands Parsed command objects
+ * @param responses Response objects, one per command
+ * @param count Number of commands
+ */
+void CommandHandler::dispatchAccessors( cJSON **commands
+                                        , cJSON **responses
+                                        , size_t count )
+{
+    AccessorRun run;
+    run.commands = commands;
+    run.responses = responses;
+    run.count = count;
+    run.next = 0;
+    run.active = 0;
+
+    {
+        std::lock_guard< std::mutex > lock( mBatchMutex );
+        mRuns.push_back( &run );
+    }
+    mBatchCondition.notify_all();
+
+    // The calling thread takes a share of the work as well
+    dispatchRun( &run );
+
+    // Every command has been taken, wait for the helpers still running one
+    std::unique_lock< std::mutex > lock( mBatchMutex );
+    auto it = std::find( mRuns.begin(), mRuns.end(), &run );
+    if( it != mRuns.end() ) {
+        mRuns.erase( it );
+    }
+    mBatchDone.wait( lock, [ &run ]() { return run.active == 0; } );
+}
+
+/**
+ * @brief Dispatches the commands of a run until none are left
+ * @param run Run of accessors
+ */
+void CommandHandler::dispatchRun( AccessorRun *run )
+{
+    size_t c;
+    while( ( c = run->next++ ) < run->count ) {
+        dispatch( run->commands[ c ], run->responses[ c ] );
+    }
+}
+
+/**
+ * @brief Starts the batch helper threads
+ * @param count Number of helpers
+ */
+void CommandHandler::startHelpers( uint32_t count )
+{
+    std::lock_guard< std::mutex > lock( mBatchMutex );
+    mHelping = true;
+    for( uint32_t i = 0; i < count; i++ ) {
+        mHelpers.push_back( std::thread( &CommandHandler::help, this ) );
+    }
+}
+
+/**
+ * @brief Stops the batch helper threads once they finish what they're running
+ */
+void CommandHandler::stopHelpers()
+{
+    {
+        std::lock_guard< std::mutex > lock( mBatchMutex );
+        mHelping = false;
+    }
+    mBatchCondition.notify_all();
+
+    for( auto it = mHelpers.begin(); it != mHelpers.end(); it++ ) {
+        if( it->joinable() ) {
+            it->join();
+        }
+    }
+    mHelpers.clear();
+}
+
+/**
+ * @brief Batch helper thread loop, works on the oldest run with commands left
+ */
+void CommandHandler::help()
+{
+    std::unique_lock< std::mutex > lock( mBatchMutex );
+
+    while( true ) {
+        while( !mRuns.empty() && mRuns.front()->next >= mRuns.front()->count ) {
+            mRuns.pop_front();
+        }
+
+        if( mRuns.empty() ) {
+            if( !mHelping ) {
+                break;
+            }
+            mBatchCondition.wait( lock );
+            continue;
+        }
+
+        AccessorRun *run = mRuns.front();
+        run->active++;
+
+        lock.unlock();
+        dispatchRun( run );
+        lock.lock();
+
+        run->active--;
+        mBatchDone.notify_all();
+    }
+}
+
+/**
+ * @brief Sets the number of threads a batch may use for its accessors
+ * @param threads Desired number of threads, 1 runs batches sequentially
+ * @return Error code
+ */
+uint32_t CommandHandler::setBatchThreads( uint32_t threads )
+{
+    uint32_t r = Error::Code::NONE;
+    if( threads == 0 ) {
+        r = Error::Code::PARAM_OUT_OF_RANGE;
+    } else if( threads != mBatchThreads ) {
+        // The caller of a batch is one of its threads
+        stopHelpers();
+        mBatchThreads = threads;
+        startHelpers( mBatchThreads - 1 );
+    }
+    return r;
+}
+
+/**
+ * @brief Retrieves the number of threads a batch may use for its accessors
+ * @return Number of threads
+ */
+uint32_t CommandHandler::getBatchThreads()
+{
+    return mBatchThreads;
+}
+
+/**
+ * @brief Sets the listener notified of every successful mutator. Must be set
+ * before commands are dispatched, it's called from whichever thread executed
+ * the command.
+ * @param listener Desired listener
+ */
+void CommandHandler::setListener( Listener listener )
+{
+    mListener = listener;
+}
+
+/**
+ * @brief Creates the response container for a parsed command
+ * @param command Parsed command object or array of command objects
+ * @return An array for a batch, otherwise an object
+ */
+cJSON *CommandHandler::createResponse( cJSON *command )
+{
+    return cJSON_IsArray( command ) ? cJSON_CreateArray() : cJSON_CreateObject();
+}
+
+/**
+ * @brief Looks up the call a command object refers to
+ * @param command Parsed command object
+ * @return Pointer to the container, nullptr if the command doesn't exist
+ */
+CommandContainer *CommandHandler::findCommand( cJSON *command )
+{
+    cJSON *cmd = cJSON_GetObjectItem( command, PARAM_COMMAND );
+    if( !cJSON_IsString( cmd ) ) {
+        return nullptr;
+    }
+
+    return lookup( cmd->valuestring );
+}
+
+/**
+ * @brief Looks up a command by name
+ * @param name Command name
+ * @return Pointer to the container, nullptr if the command doesn't exist
+ */
+CommandContainer *CommandHandler::lookup( const char *name )
+{
+    CommandTable *table = mTable.load( std::memory_order_acquire );
+    if( table != nullptr ) {
+        return table->find( name );
+    }
+
+    auto it = mCommandMap.find( name );
+    return ( it == mCommandMap.end() ) ? nullptr : it->second;
 }
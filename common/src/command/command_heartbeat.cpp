@@ -3,18 +3,18 @@
 CommandHeartbeat::CommandHeartbeat()
     : CommandTemplate< Timer >( COMMAND_HEARTBEAT, COMMAND_QHEARTBEAT )
 {
-    mMutatorMap[ PARAM_ENABLE ] = PARAMETER_CALLBACK( &CommandHeartbeat::setEnable );
+    addMutator( PARAM_ENABLE, &CommandHeartbeat::setEnable, CommandSchema::BOOLEAN );
 
-    mAccessorMap[ PARAM_ENABLE ] = PARAMETER_CALLBACK( &CommandHeartbeat::getEnable );
+    addAccessor( PARAM_ENABLE, &CommandHeartbeat::getEnable );
 }
 
 uint32_t CommandHeartbeat::setEnable(cJSON *val)
 {
     uint32_t r = Error::Code::NONE;
     if( cJSON_IsTrue( val ) ) {
-        mControlObject->setEnable( true );
+        getControl()->setEnable( true );
     } else if( cJSON_IsFalse( val ) ) {
-        mControlObject->setEnable( false );
+        getControl()->setEnable( false );
     } else {
         r = Error::Code::SYNTAX;
     }
@@ -24,6 +24,6 @@ uint32_t CommandHeartbeat::setEnable(cJSON *val)
 uint32_t CommandHeartbeat::getEnable(cJSON *response)
 {
     uint32_t r = Error::Code::NONE;
-    cJSON_AddBoolToObject( response, PARAM_ENABLE, mControlObject->isEnabled() );
+    cJSON_AddBoolToObject( response, PARAM_ENABLE, getControl()->isEnabled() );
     return r;
 }
@@ -1,12 +1,15 @@
 #include "common/command/command_help.h"
 
 CommandHelp::CommandHelp()
-    : CommandTemplate< CommandHandler > ( COMMAND_EMPTY, COMMAND_HELP, PARAM_COMMAND )
+    : CommandTemplate< CommandHandler, CommandHelpState > ( COMMAND_EMPTY, COMMAND_HELP, PARAM_COMMAND )
 {
-    mAccessorMap[ PARAM_COMMANDS ] = PARAMETER_CALLBACK( &CommandHelp::getCommandMap );
+    addAccessor( PARAM_COMMANDS, &CommandHelp::getCommandMap );
 
-    mOptional = PARAMETER_CALLBACK( &CommandHelp::setCommand );
-    mOptionalAccessorMap[ PARAM_USAGE ] = PARAMETER_CALLBACK( &CommandHelp::getCommandUsage );
+    setOptional( &CommandHelp::setCommand, CommandSchema::STRING );
+    addOptionalAccessor( PARAM_USAGE, &CommandHelp::getCommandUsage );
+
+    // Only changes when a command is added, which invalidates it
+    enableCache( 0 );
 }
 
 uint32_t CommandHelp::getCommandMap( cJSON *response )
@@ -16,7 +19,7 @@ uint32_t CommandHelp::getCommandMap( cJSON *response )
     cJSON *array = cJSON_CreateArray();
     cJSON_AddItemToObject( response, PARAM_COMMANDS, array );
     // Iterate through the map for the available commands
-    CommandMap *map = mControlObject->getCommandMap();
+    CommandMap *map = getControl()->getCommandMap();
     for( CommandMap::const_iterator it = map->begin(); it != map->end(); it++ ) {
         cJSON *str = cJSON_CreateString( it->first );
         cJSON_AddItemToArray( array, str );
@@ -28,12 +31,12 @@ uint32_t CommandHelp::setCommand( cJSON *val )
 {
     uint32_t r = Error::Code::NONE;
     if( cJSON_IsString( val ) ) {
-        CommandMap *map = mControlObject->getCommandMap();
+        CommandMap *map = getControl()->getCommandMap();
         auto it = map->find( val->valuestring );
         if( it == map->end() ) {
             r = Error::Code::PARAM_INVALID;
         } else {
-            mUsage = it->second->getUsage();
+            getContext().usage = it->second->getUsage();
         }
     }
     return r;
@@ -42,6 +45,6 @@ uint32_t CommandHelp::setCommand( cJSON *val )
 uint32_t CommandHelp::getCommandUsage( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
-    cJSON_AddStringToObject( response, PARAM_COMMAND, mUsage );
+    cJSON_AddStringToObject( response, PARAM_COMMAND, getContext().usage );
     return r;
 }
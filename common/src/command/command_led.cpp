@@ -3,19 +3,20 @@
 CommandLed::CommandLed()
     : CommandTemplate< Led >( COMMAND_LED, COMMAND_QLED )
 {
-    mRequiredMap[ PARAM_ID ] = PARAMETER_CALLBACK( &CommandLed::setId );
+    addRequired( PARAM_ID, &CommandLed::setId, CommandSchema::NUMBER );
 
-    mMutatorMap[ PARAM_ENABLE ] = PARAMETER_CALLBACK( &CommandLed::setEnable );
+    addMutator( PARAM_ENABLE, &CommandLed::setEnable, CommandSchema::BOOLEAN );
 
-    mAccessorMap[ PARAM_ENABLE ] = PARAMETER_CALLBACK( &CommandLed::getEnable );
+    addAccessor( PARAM_ENABLE, &CommandLed::getEnable );
 }
 
 uint32_t CommandLed::setId(cJSON *val)
 {
     uint32_t r = Error::Code::NONE;
     if( cJSON_IsNumber( val ) ) {
-        mControlObject = Led::getControlObject( static_cast< uint32_t >( val->valuedouble ) );
-        if( mControlObject == nullptr ) {
+        Context &context = getContext();
+        context.control = Led::getControlObject( static_cast< uint32_t >( val->valuedouble ) );
+        if( context.control == nullptr ) {
             r = Error::Code::PARAM_OUT_OF_RANGE;
         }
     } else {
@@ -30,9 +31,9 @@ uint32_t CommandLed::setEnable( cJSON *val )
 {
     uint32_t r = Error::Code::NONE;
     if( cJSON_IsTrue( val ) ) {
-        mControlObject->setEnable( true );
+        getControl()->setEnable( true );
     } else if( cJSON_IsFalse( val ) ) {
-        mControlObject->setEnable( false );
+        getControl()->setEnable( false );
     } else {
         r = Error::Code::SYNTAX;
     }
@@ -42,6 +43,6 @@ uint32_t CommandLed::setEnable( cJSON *val )
 uint32_t CommandLed::getEnable(cJSON *response)
 {
     uint32_t r = Error::Code::NONE;
-    cJSON_AddBoolToObject( response, PARAM_ENABLE, mControlObject->isEnabled() );
+    cJSON_AddBoolToObject( response, PARAM_ENABLE, getControl()->isEnabled() );
     return r;
 }
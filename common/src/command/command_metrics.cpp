@@ -0,0 +1,48 @@
+#include "common/command/command_metrics.h"
+
+CommandMetrics::CommandMetrics()
+    : CommandTemplate< CommandHandler >( COMMAND_EMPTY, COMMAND_QMETRICS )
+{
+    addAccessor( PARAM_COMMANDS, &CommandMetrics::getCommands );
+}
+
+/**
+ * @brief Adds the latency summary of every command to the response
+ * @param response Response object to populate
+ * @return Error code
+ */
+uint32_t CommandMetrics::getCommands( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    cJSON *commands = cJSON_CreateObject();
+    cJSON_AddItemToObject( response, PARAM_COMMANDS, commands );
+
+    CommandMap *map = getControl()->getCommandMap();
+    for( CommandMap::const_iterator it = map->begin(); it != map->end(); it++ ) {
+        cJSON_AddItemToObject( commands, it->first
+                               , createSummary( it->second->getLatency() ) );
+    }
+    return r;
+}
+
+/**
+ * @brief Summarizes a latency histogram
+ * @param histogram Histogram in nanoseconds
+ * @return Object holding the number of calls and the median, 99th percentile
+ * and largest latencies in microseconds
+ */
+cJSON *CommandMetrics::createSummary( Histogram *histogram )
+{
+    Histogram::Snapshot snapshot;
+    histogram->snapshot( &snapshot );
+
+    cJSON *summary = cJSON_CreateObject();
+    cJSON_AddNumberToObject( summary, PARAM_COUNT
+                             , static_cast< double >( snapshot.count ) );
+    cJSON_AddNumberToObject( summary, PARAM_P50
+                             , snapshot.getPercentile( 50.0 ) / 1000.0 );
+    cJSON_AddNumberToObject( summary, PARAM_P99
+                             , snapshot.getPercentile( 99.0 ) / 1000.0 );
+    cJSON_AddNumberToObject( summary, PARAM_MAX, snapshot.max / 1000.0 );
+    return summary;
+}
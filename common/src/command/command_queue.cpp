@@ -0,0 +1,343 @@
+#include <string.h>
+
+#include "common/command/command_queue.h"
+
+const uint32_t CommandQueue::default_workers = 2;
+const uint32_t CommandQueue::default_depth   = 32;
+
+/**
+ * @brief Constructor
+ * @param handler Command handler used to execute queued commands
+ * @param workers Number of worker threads
+ * @param depth Maximum number of commands waiting to be executed
+ */
+CommandQueue::CommandQueue( CommandHandler *handler
+                            , uint32_t workers
+                            , uint32_t depth )
+    : mHandler( handler )
+    , mWorkers( workers )
+    , mCapacity( depth )
+    , mRunning( false )
+    , mMaxDepth( 0 )
+    , mProcessed( 0 )
+    , mRejected( 0 )
+    , mWaitTotal( 0 )
+    , mWaitMax( 0 )
+{
+}
+
+/**
+ * @brief Destructor
+ */
+CommandQueue::~CommandQueue()
+{
+    stop();
+}
+
+/**
+ * @brief Starts the worker threads
+ */
+void CommandQueue::start()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    if( !mRunning ) {
+        mRunning = true;
+        for( uint32_t i = 0; i < mWorkers; i++ ) {
+            mThreads.push_back( new std::thread( &CommandQueue::run, this ) );
+        }
+    }
+}
+
+/**
+ * @brief Stops the worker threads once every queued command has executed
+ */
+void CommandQueue::stop()
+{
+    {
+        std::lock_guard< std::mutex > lock( mMutex );
+        mRunning = false;
+    }
+    mCondition.notify_all();
+
+    for( auto it = mThreads.begin(); it != mThreads.end(); it++ ) {
+        if( (*it)->joinable() ) {
+            (*it)->join();
+        }
+        delete *it;
+    }
+    mThreads.clear();
+}
+
+/**
+ * @brief Determines if the worker threads are running
+ * @return Boolean indicating running status
+ */
+bool CommandQueue::isRunning()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return mRunning;
+}
+
+/**
+ * @brief Queues a parsed command for execution. The command and response
+ * objects must stay valid until the callback has been invoked
+ * @param command Parsed command object or array of command objects
+ * @param response Response object to populate, see
+ * CommandHandler::createResponse()
+ * @param done Invoked from the worker thread once the command has executed
+ * @return Boolean indicating the command was queued, false if the queue is
+ * full or not running
+ */
+bool CommandQueue::push( cJSON *command, cJSON *response, Callback done )
+{
+    bool queued = false;
+
+    Job job;
+    job.command  = command;
+    job.response = response;
+    job.queued   = Clock::now();
+    job.done     = done;
+
+    // A batch is held back by the limits of every command it contains
+    if( cJSON_IsArray( command ) ) {
+        cJSON *item = nullptr;
+        cJSON_ArrayForEach( item, command ) {
+            addName( job, item );
+        }
+    } else {
+        addName( job, command );
+    }
+
+    {
+        std::lock_guard< std::mutex > lock( mMutex );
+        if( !mRunning || mJobs.size() >= mCapacity ) {
+            mRejected++;
+        } else {
+            mJobs.push_back( job );
+            if( mJobs.size() > mMaxDepth ) {
+                mMaxDepth = static_cast< uint32_t >( mJobs.size() );
+            }
+            queued = true;
+        }
+    }
+
+    if( queued ) {
+        mCondition.notify_one();
+    } else {
+        LOG_WARN( "command queue is full, rejecting '%s'%s"
+                  , job.names.empty() ? "" : job.names.front()
+                  , ( job.names.size() > 1 ) ? " batch" : "" );
+    }
+
+    return queued;
+}
+
+/**
+ * @brief Limits the number of instances of a command that may execute at once
+ * @param command Command name, must remain valid for the life of the queue
+ * @param limit Maximum concurrent executions, 0 removes the limit
+ * @return Error code
+ */
+uint32_t CommandQueue::setLimit( const char *command, uint32_t limit )
+{
+    uint32_t r = Error::Code::NONE;
+    std::lock_guard< std::mutex > lock( mMutex );
+    if( command == nullptr ) {
+        r = Error::Code::PARAM_INVALID;
+    } else {
+        // Limits are never erased so running jobs can keep hold of them
+        mLimits[ command ].max = limit;
+    }
+    return r;
+}
+
+/**
+ * @brief Finds the oldest job that is not held back by its concurrency limit.
+ * The queue mutex must be held.
+ * @return Iterator to the job, or the end of the queue if none can run
+ */
+std::deque< CommandQueue::Job >::iterator CommandQueue::next()
+{
+    auto it = mJobs.begin();
+    for( ; it != mJobs.end(); it++ ) {
+        if( !isLimited( *it ) ) {
+            break;
+        }
+    }
+    return it;
+}
+
+/**
+ * @brief Determines if any command in a job has reached its concurrency
+ * limit. The queue mutex must be held.
+ * @param job Job to check
+ * @return Boolean indicating the job has to wait
+ */
+bool CommandQueue::isLimited( const Job &job )
+{
+    for( auto name = job.names.begin(); name != job.names.end(); name++ ) {
+        auto limit = mLimits.find( *name );
+        if( limit != mLimits.end()
+                && limit->second.max != 0
+                && limit->second.active >= limit->second.max ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Records the name of a command in a job, each name is only recorded
+ * once so a batch takes one slot of a limit
+ * @param job Job to record the name in
+ * @param command Parsed command object
+ */
+void CommandQueue::addName( Job &job, cJSON *command )
+{
+    cJSON *cmd = cJSON_GetObjectItem( command, PARAM_COMMAND );
+    if( !cJSON_IsString( cmd ) ) {
+        return;
+    }
+
+    for( auto name = job.names.begin(); name != job.names.end(); name++ ) {
+        if( strcmp( *name, cmd->valuestring ) == 0 ) {
+            return;
+        }
+    }
+    job.names.push_back( cmd->valuestring );
+}
+
+/**
+ * @brief Worker thread loop
+ */
+void CommandQueue::run()
+{
+    std::unique_lock< std::mutex > lock( mMutex );
+
+    while( true ) {
+
+        auto it = next();
+        if( it == mJobs.end() ) {
+            if( !mRunning && mJobs.empty() ) {
+                break;
+            }
+            mCondition.wait( lock );
+            continue;
+        }
+
+        Job job = *it;
+        mJobs.erase( it );
+
+        std::vector< Limit* > limits;
+        for( auto name = job.names.begin(); name != job.names.end(); name++ ) {
+            auto l = mLimits.find( *name );
+            if( l != mLimits.end() ) {
+                limits.push_back( &l->second );
+                l->second.active++;
+            }
+        }
+
+        uint64_t wait = static_cast< uint64_t >(
+                    std::chrono::duration_cast< std::chrono::microseconds >(
+                        Clock::now() - job.queued ).count() );
+
+        lock.unlock();
+        bool ok = mHandler->dispatch( job.command, job.response );
+        lock.lock();
+
+        if( !limits.empty() ) {
+            for( auto limit = limits.begin(); limit != limits.end(); limit++ ) {
+                ( *limit )->active--;
+            }
+            mCondition.notify_all();
+        }
+
+        mProcessed++;
+        mWaitTotal += wait;
+        if( wait > mWaitMax ) {
+            mWaitMax = wait;
+        }
+
+        lock.unlock();
+        job.done( ok );
+        lock.lock();
+    }
+}
+
+/**
+ * @brief Retrieves the number of commands waiting to execute
+ * @return Queue depth
+ */
+uint32_t CommandQueue::getDepth()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return static_cast< uint32_t >( mJobs.size() );
+}
+
+/**
+ * @brief Retrieves the deepest the queue has been
+ * @return Maximum queue depth
+ */
+uint32_t CommandQueue::getMaxDepth()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return mMaxDepth;
+}
+
+/**
+ * @brief Retrieves the number of commands that may wait in the queue
+ * @return Queue capacity
+ */
+uint32_t CommandQueue::getCapacity()
+{
+    return mCapacity;
+}
+
+/**
+ * @brief Retrieves the number of worker threads
+ * @return Number of workers
+ */
+uint32_t CommandQueue::getWorkers()
+{
+    return mWorkers;
+}
+
+/**
+ * @brief Retrieves the number of commands executed
+ * @return Number of commands
+ */
+uint64_t CommandQueue::getProcessed()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return mProcessed;
+}
+
+/**
+ * @brief Retrieves the number of commands rejected because the queue was full
+ * @return Number of commands
+ */
+uint64_t CommandQueue::getRejected()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return mRejected;
+}
+
+/**
+ * @brief Retrieves the average time commands waited before executing
+ * @return Wait time in microseconds
+ */
+uint64_t CommandQueue::getAverageWait()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return ( mProcessed > 0 ) ? mWaitTotal / mProcessed : 0;
+}
+
+/**
+ * @brief Retrieves the longest time a command waited before executing
+ * @return Wait time in microseconds
+ */
+uint64_t CommandQueue::getMaxWait()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return mWaitMax;
+}
@@ -0,0 +1,121 @@
+#include <string.h>
+
+#include "common/logger/log.h"
+#include "common/command/command_schema.h"
+
+/**
+ * @brief Constructor, the schema starts out empty
+ */
+CommandSchema::CommandSchema()
+    : mCount( 0 )
+    , mRoles( 0 )
+{
+}
+
+/**
+ * @brief Adds a role to a parameter, creating the parameter the first time its
+ * name is seen
+ * @param role Role the method handles
+ * @param name Parameter name, must stay valid for the life of the schema
+ * @param method Method handling the parameter
+ * @param format Types accepted for the parameter, ignored for accessors since
+ * they don't take a value
+ * @return Boolean indicating the parameter was added
+ */
+bool CommandSchema::add( Role role, const char *name, const Method &method, int format )
+{
+    if( role >= ROLE_COUNT || name == nullptr || !method ) {
+        return false;
+    }
+
+    int32_t index = find( name );
+    if( index < 0 ) {
+        if( mCount >= max_parameters ) {
+            LOG_ERROR( "too many parameters, '%s' not added", name );
+            return false;
+        }
+
+        index = static_cast< int32_t >( mCount++ );
+        mParameters[ index ].name   = name;
+        mParameters[ index ].length = strlen( name );
+        mParameters[ index ].format = ANY;
+    }
+
+    Parameter &parameter = mParameters[ index ];
+    if( parameter.methods[ role ] ) {
+        LOG_WARN( "'%s' already has a method for this role", name );
+        return false;
+    }
+
+    parameter.methods[ role ] = method;
+    if( isInput( role ) ) {
+        parameter.format = format;
+    }
+
+    mRoles |= ( 1U << role );
+    return true;
+}
+
+/**
+ * @brief Finds a parameter by name
+ * @param name Parameter name
+ * @return Index of the parameter, -1 if it isn't in the schema
+ */
+int32_t CommandSchema::find( const char *name ) const
+{
+    if( name == nullptr ) {
+        return -1;
+    }
+
+    size_t length = strlen( name );
+    for( uint32_t i = 0; i < mCount; i++ ) {
+        if( mParameters[ i ].length == length
+                && memcmp( mParameters[ i ].name, name, length ) == 0 ) {
+            return static_cast< int32_t >( i );
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Retrieves a parameter
+ * @param index Index of the parameter, must be less than the count
+ * @return Parameter
+ */
+const CommandSchema::Parameter &CommandSchema::get( uint32_t index ) const
+{
+    return mParameters[ index ];
+}
+
+/**
+ * @brief Retrieves the number of parameters in the schema
+ * @return Number of parameters
+ */
+uint32_t CommandSchema::getCount() const
+{
+    return mCount;
+}
+
+/**
+ * @brief Determines if any parameter plays a role
+ * @param role Role to check
+ * @return Boolean indicating the role is used
+ */
+bool CommandSchema::hasRole( Role role ) const
+{
+    return ( mRoles & ( 1U << role ) ) != 0;
+}
+
+/**
+ * @brief Determines if a role takes its value from the params object
+ * @param role Role to check
+ * @return Boolean indicating the role consumes a value
+ */
+bool CommandSchema::isInput( Role role )
+{
+    return role == REQUIRED
+            || role == OPTIONAL
+            || role == MUTATOR
+            || role == OPTIONAL_MUTATOR;
+}
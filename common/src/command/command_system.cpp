@@ -1,21 +1,23 @@
 #include "common/command/command_system.h"
 
+// Interfaces come and go on their own, the hostname only through the mutator
+const uint32_t CommandSystem::cache_ttl = 5000;
+
 CommandSystem::CommandSystem()
     : CommandTemplate< System >( COMMAND_SYSTEM, COMMAND_QSYSTEM )
 {
-    mMutatorMap[ PARAM_HOSTNAME ]
-            = PARAMETER_CALLBACK( &CommandSystem::setHostname );
+    addMutator( PARAM_HOSTNAME, &CommandSystem::setHostname, CommandSchema::STRING );
+
+    addAccessor( PARAM_HOSTNAME, &CommandSystem::getHostname );
+    addAccessor( PARAM_INTERFACE, &CommandSystem::getInterfaces );
 
-    mAccessorMap[ PARAM_HOSTNAME ]
-            = PARAMETER_CALLBACK( &CommandSystem::getHostname );
-    mAccessorMap[ PARAM_INTERFACE ]
-            = PARAMETER_CALLBACK( &CommandSystem::getInterfaces );
+    enableCache( cache_ttl );
 }
 
 uint32_t CommandSystem::getHostname( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
-    cJSON_AddStringToObject( response, PARAM_HOSTNAME, mControlObject->getHostname() );
+    cJSON_AddStringToObject( response, PARAM_HOSTNAME, getControl()->getHostname() );
     return r;
 }
 
@@ -23,7 +25,7 @@ uint32_t CommandSystem::getInterfaces( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
     (void)response;
-    // mControlObject->getInterfaces();
+    // getControl()->getInterfaces();
     return r;
 }
 
@@ -31,7 +33,7 @@ uint32_t CommandSystem::setHostname( cJSON *val )
 {
     uint32_t r = Error::Code::NONE;
     if( cJSON_IsString( val ) ) {
-        r = mControlObject->setHostname( val->string );
+        r = getControl()->setHostname( val->string );
     } else {
         r = Error::Code::SYNTAX;
     }
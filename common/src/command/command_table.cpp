@@ -0,0 +1,217 @@
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "common/logger/log.h"
+#include "common/command/command_table.h"
+
+// Seeds tried at each table size before the table is doubled
+const uint32_t CommandTable::max_seed_attempts = 4096;
+// Largest table tried, in slots per command
+const uint32_t CommandTable::max_load_factor   = 8;
+
+/**
+ * @brief Constructor, the table is empty until built
+ */
+CommandTable::CommandTable()
+    : mHashes( nullptr )
+    , mEntries( nullptr )
+    , mMask( 0 )
+    , mSeed( 0 )
+    , mCount( 0 )
+{
+}
+
+/**
+ * @brief Destructor
+ */
+CommandTable::~CommandTable()
+{
+    release();
+}
+
+/**
+ * @brief Builds the table from the registered commands, searching for a seed
+ * that gives every name its own slot
+ * @param map Registered commands, the names must stay valid for the life of
+ * the table
+ * @return Boolean indicating a perfect hash was found
+ */
+bool CommandTable::build( const Types::CharHashMap< CommandContainer* > &map )
+{
+    release();
+
+    uint32_t count = static_cast< uint32_t >( map.size() );
+    if( count == 0 ) {
+        return false;
+    }
+
+    std::vector< const char* > names;
+    std::vector< size_t > lengths;
+    std::vector< CommandContainer* > containers;
+    for( auto it = map.begin(); it != map.end(); it++ ) {
+        names.push_back( it->first );
+        lengths.push_back( 0 );
+        containers.push_back( it->second );
+    }
+
+    // Start at the first power of two with at least twice as many slots
+    uint32_t slots = 8;
+    while( slots < count * 2 ) {
+        slots <<= 1;
+    }
+
+    std::vector< uint32_t > hashes( count );
+    std::vector< uint8_t > used;
+
+    for( ; slots <= count * max_load_factor; slots <<= 1 ) {
+        uint32_t mask = slots - 1;
+
+        for( uint32_t seed = 1; seed <= max_seed_attempts; seed++ ) {
+            used.assign( slots, 0 );
+
+            uint32_t i = 0;
+            for( ; i < count; i++ ) {
+                hashes[ i ] = hash( seed, names[ i ], &lengths[ i ] );
+                uint32_t slot = hashes[ i ] & mask;
+                if( used[ slot ] ) {
+                    break;
+                }
+                used[ slot ] = 1;
+            }
+
+            if( i < count ) {
+                continue;
+            }
+
+            // Found one, lay the table out on cache line boundaries
+            void *h = nullptr;
+            void *e = nullptr;
+            if( posix_memalign( &h, 64, slots * sizeof( uint32_t ) ) != 0
+                    || posix_memalign( &e, 64, slots * sizeof( Entry ) ) != 0 ) {
+                free( h );
+                LOG_ERROR( "failed to allocate command table" );
+                return false;
+            }
+
+            mHashes  = static_cast< uint32_t* >( h );
+            mEntries = static_cast< Entry* >( e );
+            memset( mHashes, 0, slots * sizeof( uint32_t ) );
+            memset( mEntries, 0, slots * sizeof( Entry ) );
+
+            for( i = 0; i < count; i++ ) {
+                uint32_t slot = hashes[ i ] & mask;
+                mHashes[ slot ]            = hashes[ i ];
+                mEntries[ slot ].name      = names[ i ];
+                mEntries[ slot ].length    = lengths[ i ];
+                mEntries[ slot ].container = containers[ i ];
+            }
+
+            mMask  = mask;
+            mSeed  = seed;
+            mCount = count;
+            return true;
+        }
+    }
+
+    LOG_WARN( "no perfect hash found for %u commands", count );
+    return false;
+}
+
+/**
+ * @brief Looks up a command
+ * @param name Command name
+ * @return Pointer to the command's container, nullptr if it doesn't exist or
+ * the table hasn't been built
+ */
+CommandContainer *CommandTable::find( const char *name ) const
+{
+    if( mEntries == nullptr ) {
+        return nullptr;
+    }
+
+    size_t length = 0;
+    uint32_t h = hash( mSeed, name, &length );
+    uint32_t slot = h & mMask;
+
+    // Only one name can live in the slot, anything else is a miss
+    if( mHashes[ slot ] != h ) {
+        return nullptr;
+    }
+
+    const Entry &entry = mEntries[ slot ];
+    if( entry.container == nullptr
+            || entry.length != length
+            || memcmp( entry.name, name, length ) != 0 ) {
+        return nullptr;
+    }
+
+    return entry.container;
+}
+
+/**
+ * @brief Retrieves the number of commands in the table
+ * @return Number of commands
+ */
+uint32_t CommandTable::getCount() const
+{
+    return mCount;
+}
+
+/**
+ * @brief Retrieves the number of slots in the table
+ * @return Number of slots
+ */
+uint32_t CommandTable::getSlots() const
+{
+    return ( mEntries == nullptr ) ? 0 : mMask + 1;
+}
+
+/**
+ * @brief Retrieves the seed the table was built with
+ * @return Hash seed
+ */
+uint32_t CommandTable::getSeed() const
+{
+    return mSeed;
+}
+
+/**
+ * @brief Seeded FNV-1a with a final mix so the low bits used to pick a slot
+ * depend on every byte of the name
+ * @param seed Hash seed
+ * @param name Null terminated name
+ * @param length Set to the length of the name
+ * @return Hash value
+ */
+uint32_t CommandTable::hash( uint32_t seed, const char *name, size_t *length )
+{
+    uint32_t h = 2166136261U ^ ( seed * 0x9E3779B9U );
+    const uint8_t *c = reinterpret_cast< const uint8_t* >( name );
+
+    while( *c ) {
+        h ^= *c++;
+        h *= 16777619U;
+    }
+
+    *length = static_cast< size_t >( reinterpret_cast< const char* >( c ) - name );
+
+    h ^= h >> 16;
+    h *= 0x85EBCA6BU;
+    h ^= h >> 13;
+    return h;
+}
+
+/**
+ * @brief Frees the table
+ */
+void CommandTable::release()
+{
+    free( mHashes );
+    free( mEntries );
+    mHashes  = nullptr;
+    mEntries = nullptr;
+    mMask    = 0;
+    mSeed    = 0;
+    mCount   = 0;
+}
@@ -3,30 +3,90 @@
 CommandVenus638FLPx::CommandVenus638FLPx()
     : CommandTemplate< Gps::Venus638FLPx > ( COMMAND_GPS, COMMAND_QGPS )
 {
-    mMutatorMap[ PARAM_BAUD ] = PARAMETER_CALLBACK( &CommandVenus638FLPx::setBaud );
+    addMutator( PARAM_BAUD, &CommandVenus638FLPx::setBaud, CommandSchema::NUMBER );
+    addMutator( PARAM_OUTPUT, &CommandVenus638FLPx::setOutput, CommandSchema::STRING );
+    addMutator( PARAM_RATE, &CommandVenus638FLPx::setRate, CommandSchema::NUMBER );
 
-    mAccessorMap[ PARAM_BAUD ] = PARAMETER_CALLBACK( &CommandVenus638FLPx::getBaud );
-    mAccessorMap[ PARAM_GPGGA ] = PARAMETER_CALLBACK( &CommandVenus638FLPx::getGpgga );
-    mAccessorMap[ PARAM_GPGSA ] = PARAMETER_CALLBACK( &CommandVenus638FLPx::getGpgsa );
-    mAccessorMap[ PARAM_GPRMC ] = PARAMETER_CALLBACK( &CommandVenus638FLPx::getGprmc );
-    mAccessorMap[ PARAM_GPVTG ] = PARAMETER_CALLBACK( &CommandVenus638FLPx::getGpvtg );
+    addAccessor( PARAM_BAUD, &CommandVenus638FLPx::getBaud );
+    addAccessor( PARAM_OUTPUT, &CommandVenus638FLPx::getOutput );
+    addAccessor( PARAM_RATE, &CommandVenus638FLPx::getRate );
+    addAccessor( PARAM_GPGGA, &CommandVenus638FLPx::getGpgga );
+    addAccessor( PARAM_GPGSA, &CommandVenus638FLPx::getGpgsa );
+    addAccessor( PARAM_GPRMC, &CommandVenus638FLPx::getGprmc );
+    addAccessor( PARAM_GPVTG, &CommandVenus638FLPx::getGpvtg );
+
+    addAccessor( PARAM_GGA, &CommandVenus638FLPx::getGga );
+    addAccessor( PARAM_RMC, &CommandVenus638FLPx::getRmc );
+    addAccessor( PARAM_GSA, &CommandVenus638FLPx::getGsa );
+    addAccessor( PARAM_GSV, &CommandVenus638FLPx::getGsv );
+    addAccessor( PARAM_VTG, &CommandVenus638FLPx::getVtg );
+    addAccessor( PARAM_ZDA, &CommandVenus638FLPx::getZda );
+    addAccessor( PARAM_NAV, &CommandVenus638FLPx::getNav );
 }
 
 uint32_t CommandVenus638FLPx::setBaud( cJSON *val )
 {
     uint32_t r = Error::Code::NONE;
     if( cJSON_IsNumber( val ) ) {
-        mControlObject->setBaud( static_cast< Serial::Speed>( val->valueint ) );
+        int32_t error = getControl()->setBaud( static_cast< Serial::Speed>( val->valueint ) );
+        r = ( error < 0 ) ? static_cast< uint32_t >( Error::Code::CMD_FAILED )
+            : static_cast< uint32_t >( error );
     } else {
         r = Error::Code::SYNTAX;
     }
     return r;
 }
 
+uint32_t CommandVenus638FLPx::setOutput( cJSON *val )
+{
+    uint32_t r = Error::Code::NONE;
+    if( cJSON_IsString( val ) ) {
+        Gps::Venus638FLPx::Output output = Gps::Venus638FLPx::stringToOutput( val->valuestring );
+        if( output == Gps::Venus638FLPx::Output::OUTPUT_MAX ) {
+            r = Error::Code::PARAM_OUT_OF_RANGE;
+        } else {
+            int32_t error = getControl()->setOutput( output );
+            r = ( error < 0 ) ? static_cast< uint32_t >( Error::Code::CMD_FAILED )
+                : static_cast< uint32_t >( error );
+        }
+    } else {
+        r = Error::Code::PARAM_INVALID;
+    }
+    return r;
+}
+
+uint32_t CommandVenus638FLPx::setRate( cJSON *val )
+{
+    uint32_t r = Error::Code::NONE;
+    if( cJSON_IsNumber( val ) && val->valueint > 0 ) {
+        int32_t error = getControl()->setUpdateRate( static_cast< uint32_t >( val->valueint ) );
+        r = ( error < 0 ) ? static_cast< uint32_t >( Error::Code::CMD_FAILED )
+            : static_cast< uint32_t >( error );
+    } else {
+        r = Error::Code::PARAM_INVALID;
+    }
+    return r;
+}
+
 uint32_t CommandVenus638FLPx::getBaud( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
-    cJSON_AddNumberToObject( response, PARAM_BAUD, mControlObject->getBaudRate() );
+    cJSON_AddNumberToObject( response, PARAM_BAUD, getControl()->getBaudRate() );
+    return r;
+}
+
+uint32_t CommandVenus638FLPx::getOutput( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    cJSON_AddStringToObject( response, PARAM_OUTPUT
+                             , Gps::Venus638FLPx::outputToString( getControl()->getOutput() ) );
+    return r;
+}
+
+uint32_t CommandVenus638FLPx::getRate( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    cJSON_AddNumberToObject( response, PARAM_RATE, getControl()->getUpdateRate() );
     return r;
 }
 
@@ -34,7 +94,7 @@ uint32_t CommandVenus638FLPx::getGpgga( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
     uint8_t buffer[ READ_BUFFER_SIZE ];
-    mControlObject->getSentence( Gps::Nmea::Sentence::GPGGA, buffer, READ_BUFFER_SIZE );
+    getControl()->getSentence( Gps::Nmea::Sentence::GPGGA, buffer, READ_BUFFER_SIZE );
     cJSON_AddStringToObject( response, PARAM_GPGGA, reinterpret_cast< char * >( buffer ) );
     return r;
 }
@@ -43,7 +103,7 @@ uint32_t CommandVenus638FLPx::getGpgsa( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
     uint8_t buffer[ READ_BUFFER_SIZE ];
-    mControlObject->getSentence( Gps::Nmea::Sentence::GPGSA, buffer, READ_BUFFER_SIZE );
+    getControl()->getSentence( Gps::Nmea::Sentence::GPGSA, buffer, READ_BUFFER_SIZE );
     cJSON_AddStringToObject( response, PARAM_GPGSA, reinterpret_cast< char * >( buffer ) );
     return r;
 }
@@ -52,7 +112,7 @@ uint32_t CommandVenus638FLPx::getGprmc( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
     uint8_t buffer[ READ_BUFFER_SIZE ];
-    mControlObject->getSentence( Gps::Nmea::Sentence::GPRMC, buffer, READ_BUFFER_SIZE );
+    getControl()->getSentence( Gps::Nmea::Sentence::GPRMC, buffer, READ_BUFFER_SIZE );
     cJSON_AddStringToObject( response, PARAM_GPRMC, reinterpret_cast< char * >( buffer ) );
     return r;
 }
@@ -61,7 +121,255 @@ uint32_t CommandVenus638FLPx::getGpvtg( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
     uint8_t buffer[ READ_BUFFER_SIZE ];
-    mControlObject->getSentence( Gps::Nmea::Sentence::GPVTG, buffer, READ_BUFFER_SIZE );
+    getControl()->getSentence( Gps::Nmea::Sentence::GPVTG, buffer, READ_BUFFER_SIZE );
     cJSON_AddStringToObject( response, PARAM_GPVTG, reinterpret_cast< char * >( buffer ) );
     return r;
 }
+
+/**
+ * @brief Adds the latest fix, null until a valid GGA sentence is received
+ * @param response Response object to populate
+ * @return Error code
+ */
+uint32_t CommandVenus638FLPx::getGga( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    Gps::Nmea::Gga gga;
+    if( !readSentence( Gps::Nmea::Sentence::GPGGA, &gga ) ) {
+        cJSON_AddNullToObject( response, PARAM_GGA );
+        return r;
+    }
+
+    cJSON *object = cJSON_AddObjectToObject( response, PARAM_GGA );
+    addTime( object, gga.time );
+    cJSON_AddNumberToObject( object, PARAM_LATITUDE, gga.latitude / 1e7 );
+    cJSON_AddNumberToObject( object, PARAM_LONGITUDE, gga.longitude / 1e7 );
+    cJSON_AddNumberToObject( object, PARAM_QUALITY, gga.quality );
+    cJSON_AddNumberToObject( object, PARAM_SATELLITES, gga.satellites );
+    cJSON_AddNumberToObject( object, PARAM_HDOP, gga.hdop / 100.0 );
+    cJSON_AddNumberToObject( object, PARAM_ALTITUDE, gga.altitude / 1000.0 );
+    cJSON_AddNumberToObject( object, PARAM_SEPARATION, gga.separation / 1000.0 );
+    return r;
+}
+
+/**
+ * @brief Adds the latest recommended minimum data, null until a valid RMC
+ * sentence is received
+ * @param response Response object to populate
+ * @return Error code
+ */
+uint32_t CommandVenus638FLPx::getRmc( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    Gps::Nmea::Rmc rmc;
+    if( !readSentence( Gps::Nmea::Sentence::GPRMC, &rmc ) ) {
+        cJSON_AddNullToObject( response, PARAM_RMC );
+        return r;
+    }
+
+    cJSON *object = cJSON_AddObjectToObject( response, PARAM_RMC );
+    addTime( object, rmc.time );
+    addDate( object, rmc.date );
+    cJSON_AddBoolToObject( object, PARAM_VALID, rmc.active );
+    cJSON_AddNumberToObject( object, PARAM_LATITUDE, rmc.latitude / 1e7 );
+    cJSON_AddNumberToObject( object, PARAM_LONGITUDE, rmc.longitude / 1e7 );
+    cJSON_AddNumberToObject( object, PARAM_SPEED_KNOTS, rmc.speed / 1000.0 );
+    cJSON_AddNumberToObject( object, PARAM_COURSE, rmc.course / 100.0 );
+    cJSON_AddNumberToObject( object, PARAM_VARIATION, rmc.variation / 100.0 );
+    addMode( object, rmc.mode );
+    return r;
+}
+
+/**
+ * @brief Adds the latest dilution of precision and satellites used, null
+ * until a valid GSA sentence is received
+ * @param response Response object to populate
+ * @return Error code
+ */
+uint32_t CommandVenus638FLPx::getGsa( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    Gps::Nmea::Gsa gsa;
+    if( !readSentence( Gps::Nmea::Sentence::GPGSA, &gsa ) ) {
+        cJSON_AddNullToObject( response, PARAM_GSA );
+        return r;
+    }
+
+    cJSON *object = cJSON_AddObjectToObject( response, PARAM_GSA );
+    addMode( object, gsa.mode );
+    cJSON_AddNumberToObject( object, PARAM_FIX, gsa.fix );
+
+    cJSON *satellites = cJSON_AddArrayToObject( object, PARAM_SATELLITES );
+    for( uint32_t i = 0; i < gsa.count; i++ ) {
+        cJSON_AddItemToArray( satellites, cJSON_CreateNumber( gsa.satellites[ i ] ) );
+    }
+
+    cJSON_AddNumberToObject( object, PARAM_PDOP, gsa.pdop / 100.0 );
+    cJSON_AddNumberToObject( object, PARAM_HDOP, gsa.hdop / 100.0 );
+    cJSON_AddNumberToObject( object, PARAM_VDOP, gsa.vdop / 100.0 );
+    return r;
+}
+
+/**
+ * @brief Adds the latest message of satellites in view, null until a valid
+ * GSV sentence is received. Receivers spread the list over several messages,
+ * only the last one received is held.
+ * @param response Response object to populate
+ * @return Error code
+ */
+uint32_t CommandVenus638FLPx::getGsv( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    Gps::Nmea::Gsv gsv;
+    if( !readSentence( Gps::Nmea::Sentence::GPGSV, &gsv ) ) {
+        cJSON_AddNullToObject( response, PARAM_GSV );
+        return r;
+    }
+
+    cJSON *object = cJSON_AddObjectToObject( response, PARAM_GSV );
+    cJSON_AddNumberToObject( object, PARAM_MESSAGES, gsv.messages );
+    cJSON_AddNumberToObject( object, PARAM_MESSAGE, gsv.message );
+    cJSON_AddNumberToObject( object, PARAM_IN_VIEW, gsv.inView );
+
+    cJSON *satellites = cJSON_AddArrayToObject( object, PARAM_SATELLITES );
+    for( uint32_t i = 0; i < gsv.count; i++ ) {
+        const Gps::Nmea::Gsv::Satellite &satellite = gsv.satellites[ i ];
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject( item, PARAM_PRN, satellite.prn );
+        cJSON_AddNumberToObject( item, PARAM_ELEVATION, satellite.elevation );
+        cJSON_AddNumberToObject( item, PARAM_AZIMUTH, satellite.azimuth );
+        cJSON_AddNumberToObject( item, PARAM_SNR, satellite.snr );
+        cJSON_AddItemToArray( satellites, item );
+    }
+    return r;
+}
+
+/**
+ * @brief Adds the latest course and speed over ground, null until a valid VTG
+ * sentence is received
+ * @param response Response object to populate
+ * @return Error code
+ */
+uint32_t CommandVenus638FLPx::getVtg( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    Gps::Nmea::Vtg vtg;
+    if( !readSentence( Gps::Nmea::Sentence::GPVTG, &vtg ) ) {
+        cJSON_AddNullToObject( response, PARAM_VTG );
+        return r;
+    }
+
+    cJSON *object = cJSON_AddObjectToObject( response, PARAM_VTG );
+    cJSON_AddNumberToObject( object, PARAM_COURSE, vtg.courseTrue / 100.0 );
+    cJSON_AddNumberToObject( object, PARAM_COURSE_MAGNETIC, vtg.courseMagnetic / 100.0 );
+    cJSON_AddNumberToObject( object, PARAM_SPEED_KNOTS, vtg.speedKnots / 1000.0 );
+    cJSON_AddNumberToObject( object, PARAM_SPEED_KMH, vtg.speedKmh / 1000.0 );
+    addMode( object, vtg.mode );
+    return r;
+}
+
+/**
+ * @brief Adds the latest date and time, null until a valid ZDA sentence is
+ * received
+ * @param response Response object to populate
+ * @return Error code
+ */
+uint32_t CommandVenus638FLPx::getZda( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    Gps::Nmea::Zda zda;
+    if( !readSentence( Gps::Nmea::Sentence::GPZDA, &zda ) ) {
+        cJSON_AddNullToObject( response, PARAM_ZDA );
+        return r;
+    }
+
+    cJSON *object = cJSON_AddObjectToObject( response, PARAM_ZDA );
+    addTime( object, zda.time );
+    addDate( object, zda.date );
+    cJSON_AddNumberToObject( object, PARAM_ZONE_HOURS, zda.zoneHours );
+    cJSON_AddNumberToObject( object, PARAM_ZONE_MINUTES, zda.zoneMinutes );
+    return r;
+}
+
+
+/**
+ * @brief Adds the latest binary navigation data, null until a navigation data
+ * message is received. Only sent while the output is binary.
+ * @param response Response object to populate
+ * @return Error code
+ */
+uint32_t CommandVenus638FLPx::getNav( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    Gps::Venus638FLPx::Navigation nav;
+    if( !getControl()->getNavigation( &nav ) ) {
+        cJSON_AddNullToObject( response, PARAM_NAV );
+        return r;
+    }
+
+    cJSON *object = cJSON_AddObjectToObject( response, PARAM_NAV );
+    cJSON_AddNumberToObject( object, PARAM_FIX, nav.fix );
+    cJSON_AddNumberToObject( object, PARAM_SATELLITES, nav.satellites );
+    cJSON_AddNumberToObject( object, PARAM_WEEK, nav.week );
+    cJSON_AddNumberToObject( object, PARAM_TIME_OF_WEEK, nav.timeOfWeek / 100.0 );
+    cJSON_AddNumberToObject( object, PARAM_LATITUDE, nav.latitude / 1e7 );
+    cJSON_AddNumberToObject( object, PARAM_LONGITUDE, nav.longitude / 1e7 );
+    cJSON_AddNumberToObject( object, PARAM_ALTITUDE, nav.altitude / 100.0 );
+    cJSON_AddNumberToObject( object, PARAM_ALTITUDE_ELLIPSOID, nav.ellipsoidAltitude / 100.0 );
+    cJSON_AddNumberToObject( object, PARAM_GDOP, nav.gdop / 100.0 );
+    cJSON_AddNumberToObject( object, PARAM_PDOP, nav.pdop / 100.0 );
+    cJSON_AddNumberToObject( object, PARAM_HDOP, nav.hdop / 100.0 );
+    cJSON_AddNumberToObject( object, PARAM_VDOP, nav.vdop / 100.0 );
+    cJSON_AddNumberToObject( object, PARAM_TDOP, nav.tdop / 100.0 );
+
+    cJSON *ecef = cJSON_AddArrayToObject( object, PARAM_ECEF );
+    cJSON *velocity = cJSON_AddArrayToObject( object, PARAM_VELOCITY );
+    for( uint32_t i = 0; i < 3; i++ ) {
+        cJSON_AddItemToArray( ecef, cJSON_CreateNumber( nav.position[ i ] / 100.0 ) );
+        cJSON_AddItemToArray( velocity, cJSON_CreateNumber( nav.velocity[ i ] / 100.0 ) );
+    }
+    return r;
+}
+
+/**
+ * @brief Adds a UTC time as hh:mm:ss.sss
+ * @param object Object to populate
+ * @param time Time
+ */
+void CommandVenus638FLPx::addTime( cJSON *object, const Gps::Nmea::Time &time )
+{
+    // Sized for the widest values the fields can hold
+    char text[ 32 ];
+    snprintf( text, sizeof( text ), "%02u:%02u:%02u.%03u"
+              , time.hours, time.minutes, time.seconds, time.milliseconds );
+    cJSON_AddStringToObject( object, PARAM_TIME, text );
+}
+
+/**
+ * @brief Adds a date as yyyy-mm-dd
+ * @param object Object to populate
+ * @param date Date
+ */
+void CommandVenus638FLPx::addDate( cJSON *object, const Gps::Nmea::Date &date )
+{
+    // Sized for the widest values the fields can hold
+    char text[ 32 ];
+    snprintf( text, sizeof( text ), "%04u-%02u-%02u"
+              , date.year, date.month, date.day );
+    cJSON_AddStringToObject( object, PARAM_DATE, text );
+}
+
+/**
+ * @brief Adds a mode indicator, null when the receiver didn't send one
+ * @param object Object to populate
+ * @param mode Mode character
+ */
+void CommandVenus638FLPx::addMode( cJSON *object, char mode )
+{
+    if( mode == '\0' ) {
+        cJSON_AddNullToObject( object, PARAM_MODE );
+    } else {
+        char text[] = { mode, '\0' };
+        cJSON_AddStringToObject( object, PARAM_MODE, text );
+    }
+}
@@ -224,3 +224,12 @@ void Console::applyClient( Transport::Client *c )
 {
     client = c;
 }
+
+/**
+ * @brief Retrieves the client commands are sent through
+ * @return Pointer to the client, nullptr if there is none
+ */
+Transport::Client *Console::getClient()
+{
+    return client;
+}
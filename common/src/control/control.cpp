@@ -1,14 +1,48 @@
 #include "common/control/control.h"
 
+/**
+ * @brief Constructor, takes the lock of a control object
+ * @param control Control object to lock
+ * @param mode Whether the lock is shared with other readers
+ */
+Control::Lock::Lock( Control *control, Mode mode )
+    : mControl( control )
+{
+    if( mode == EXCLUSIVE ) {
+        pthread_rwlock_wrlock( &mControl->mLock );
+    } else {
+        pthread_rwlock_rdlock( &mControl->mLock );
+    }
+}
+
+/**
+ * @brief Destructor, releases the lock if it's still held
+ */
+Control::Lock::~Lock()
+{
+    release();
+}
+
+/**
+ * @brief Releases the lock before the scope ends
+ */
+void Control::Lock::release()
+{
+    if( mControl != nullptr ) {
+        pthread_rwlock_unlock( &mControl->mLock );
+        mControl = nullptr;
+    }
+}
+
 Control::Control()
     : mVerbose( false )
 {
-
+    pthread_rwlock_init( &mLock, nullptr );
 }
 
 Control::~Control()
 {
-
+    pthread_rwlock_destroy( &mLock );
 }
 
 uint32_t Control::setVerbose( bool verbose )
@@ -0,0 +1,618 @@
+#include <string.h>
+
+#include "common/drivers/devices/gps/nmea_parser.h"
+
+namespace Gps
+{
+
+namespace Nmea {
+
+// Powers of ten used to scale fixed point fields
+static const int64_t scale[] = {
+    1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL
+    , 100000000LL, 1000000000LL
+};
+
+// Fixed point numbers are limited to what fits an int64_t
+static const uint32_t max_digits = 18;
+
+/**
+ * @brief Converts a hexadecimal digit
+ * @param c Character
+ * @return Value of the digit, -1 if the character isn't one
+ */
+static int32_t hexValue( char c )
+{
+    if( c >= '0' && c <= '9' ) {
+        return c - '0';
+    } else if( c >= 'A' && c <= 'F' ) {
+        return c - 'A' + 10;
+    } else if( c >= 'a' && c <= 'f' ) {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/**
+ * @brief Determines if a sentence is complete and its checksum matches
+ * @param text Sentence from the '$' on, a line ending may follow the checksum
+ * @param length Length of the sentence
+ * @return Boolean indicating the sentence is valid
+ */
+bool Parser::validate( const char *text, uint32_t length )
+{
+    return findChecksum( text, length ) != nullptr;
+}
+
+/**
+ * @brief Parses a GGA sentence, the fix
+ * @param text Sentence
+ * @param length Length of the sentence
+ * @param gga Parsed fields
+ * @return Boolean indicating the sentence is a valid GGA sentence
+ */
+bool Parser::parse( const char *text, uint32_t length, Gga *gga )
+{
+    memset( gga, 0, sizeof( *gga ) );
+
+    Fields fields;
+    if( !split( text, length, "GGA", 15, &fields ) ) {
+        return false;
+    }
+
+    uint32_t quality = 0;
+    uint32_t satellites = 0;
+    int64_t hdop = 0;
+    int64_t altitude = 0;
+    int64_t separation = 0;
+
+    bool valid = readTime( fields, 1, &gga->time )
+            && readCoordinate( fields, 2, 90, &gga->latitude )
+            && readCoordinate( fields, 4, 180, &gga->longitude )
+            && readUnsigned( fields, 6, &quality )
+            && readUnsigned( fields, 7, &satellites )
+            && readFixed( fields, 8, 2, &hdop )
+            && readFixed( fields, 9, 3, &altitude )
+            && readFixed( fields, 11, 3, &separation )
+            && quality <= UINT8_MAX && satellites <= UINT8_MAX
+            && hdop >= 0 && hdop <= UINT16_MAX
+            && altitude >= INT32_MIN && altitude <= INT32_MAX
+            && separation >= INT32_MIN && separation <= INT32_MAX;
+
+    gga->quality = static_cast< uint8_t >( quality );
+    gga->satellites = static_cast< uint8_t >( satellites );
+    gga->hdop = static_cast< uint16_t >( hdop );
+    gga->altitude = static_cast< int32_t >( altitude );
+    gga->separation = static_cast< int32_t >( separation );
+
+    return valid;
+}
+
+/**
+ * @brief Parses an RMC sentence, the recommended minimum data
+ * @param text Sentence
+ * @param length Length of the sentence
+ * @param rmc Parsed fields
+ * @return Boolean indicating the sentence is a valid RMC sentence
+ */
+bool Parser::parse( const char *text, uint32_t length, Rmc *rmc )
+{
+    memset( rmc, 0, sizeof( *rmc ) );
+
+    Fields fields;
+    if( !split( text, length, "RMC", 12, &fields ) ) {
+        return false;
+    }
+
+    int64_t speed = 0;
+    int64_t course = 0;
+    int64_t variation = 0;
+
+    bool valid = readTime( fields, 1, &rmc->time )
+            && readCoordinate( fields, 3, 90, &rmc->latitude )
+            && readCoordinate( fields, 5, 180, &rmc->longitude )
+            && readFixed( fields, 7, 3, &speed )
+            && readFixed( fields, 8, 2, &course )
+            && readDate( fields, 9, &rmc->date )
+            && readFixed( fields, 10, 2, &variation )
+            && speed >= 0 && speed <= UINT32_MAX
+            && course >= 0 && course <= UINT32_MAX
+            && variation >= INT32_MIN && variation <= INT32_MAX;
+
+    rmc->active = ( readChar( fields, 2 ) == 'A' );
+    rmc->speed = static_cast< uint32_t >( speed );
+    rmc->course = static_cast< uint32_t >( course );
+    rmc->variation = static_cast< int32_t >(
+                ( readChar( fields, 11 ) == 'W' ) ? -variation : variation );
+    rmc->mode = readChar( fields, 12 );
+
+    return valid;
+}
+
+/**
+ * @brief Parses a GSA sentence, the dilution of precision and the satellites
+ * used for the fix
+ * @param text Sentence
+ * @param length Length of the sentence
+ * @param gsa Parsed fields
+ * @return Boolean indicating the sentence is a valid GSA sentence
+ */
+bool Parser::parse( const char *text, uint32_t length, Gsa *gsa )
+{
+    memset( gsa, 0, sizeof( *gsa ) );
+
+    Fields fields;
+    if( !split( text, length, "GSA", 18, &fields ) ) {
+        return false;
+    }
+
+    uint32_t fix = 0;
+    int64_t pdop = 0;
+    int64_t hdop = 0;
+    int64_t vdop = 0;
+
+    bool valid = readUnsigned( fields, 2, &fix )
+            && readFixed( fields, 15, 2, &pdop )
+            && readFixed( fields, 16, 2, &hdop )
+            && readFixed( fields, 17, 2, &vdop )
+            && fix <= UINT8_MAX
+            && pdop >= 0 && pdop <= UINT16_MAX
+            && hdop >= 0 && hdop <= UINT16_MAX
+            && vdop >= 0 && vdop <= UINT16_MAX;
+
+    for( uint32_t i = 0; valid && i < Gsa::max_satellites; i++ ) {
+        uint32_t prn = 0;
+        valid = readUnsigned( fields, 3 + i, &prn ) && prn <= UINT8_MAX;
+        if( valid && prn != 0 ) {
+            gsa->satellites[ gsa->count++ ] = static_cast< uint8_t >( prn );
+        }
+    }
+
+    gsa->mode = readChar( fields, 1 );
+    gsa->fix = static_cast< uint8_t >( fix );
+    gsa->pdop = static_cast< uint16_t >( pdop );
+    gsa->hdop = static_cast< uint16_t >( hdop );
+    gsa->vdop = static_cast< uint16_t >( vdop );
+
+    return valid;
+}
+
+/**
+ * @brief Parses a GSV sentence, one of the messages listing the satellites in
+ * view
+ * @param text Sentence
+ * @param length Length of the sentence
+ * @param gsv Parsed fields
+ * @return Boolean indicating the sentence is a valid GSV sentence
+ */
+bool Parser::parse( const char *text, uint32_t length, Gsv *gsv )
+{
+    memset( gsv, 0, sizeof( *gsv ) );
+
+    Fields fields;
+    if( !split( text, length, "GSV", 4, &fields ) ) {
+        return false;
+    }
+
+    uint32_t messages = 0;
+    uint32_t message = 0;
+    uint32_t inView = 0;
+
+    bool valid = readUnsigned( fields, 1, &messages )
+            && readUnsigned( fields, 2, &message )
+            && readUnsigned( fields, 3, &inView )
+            && messages <= UINT8_MAX && message <= UINT8_MAX && inView <= UINT8_MAX;
+
+    // Four fields per satellite, newer receivers add a signal ID at the end
+    uint32_t groups = ( fields.count - 4 ) / 4;
+    if( groups > Gsv::max_satellites ) {
+        groups = Gsv::max_satellites;
+    }
+
+    for( uint32_t i = 0; valid && i < groups; i++ ) {
+        uint32_t index = 4 + i * 4;
+        uint32_t prn = 0;
+        int64_t elevation = 0;
+        uint32_t azimuth = 0;
+        uint32_t snr = 0;
+
+        valid = readUnsigned( fields, index, &prn )
+                && readFixed( fields, index + 1, 0, &elevation )
+                && readUnsigned( fields, index + 2, &azimuth )
+                && readUnsigned( fields, index + 3, &snr )
+                && prn <= UINT8_MAX && snr <= UINT8_MAX
+                && elevation >= -90 && elevation <= 90
+                && azimuth <= UINT16_MAX;
+
+        if( valid && prn != 0 ) {
+            Gsv::Satellite &satellite = gsv->satellites[ gsv->count++ ];
+            satellite.prn = static_cast< uint8_t >( prn );
+            satellite.elevation = static_cast< int8_t >( elevation );
+            satellite.azimuth = static_cast< uint16_t >( azimuth );
+            satellite.snr = static_cast< uint8_t >( snr );
+        }
+    }
+
+    gsv->messages = static_cast< uint8_t >( messages );
+    gsv->message = static_cast< uint8_t >( message );
+    gsv->inView = static_cast< uint8_t >( inView );
+
+    return valid;
+}
+
+/**
+ * @brief Parses a VTG sentence, the course and speed over ground
+ * @param text Sentence
+ * @param length Length of the sentence
+ * @param vtg Parsed fields
+ * @return Boolean indicating the sentence is a valid VTG sentence
+ */
+bool Parser::parse( const char *text, uint32_t length, Vtg *vtg )
+{
+    memset( vtg, 0, sizeof( *vtg ) );
+
+    Fields fields;
+    if( !split( text, length, "VTG", 9, &fields ) ) {
+        return false;
+    }
+
+    int64_t courseTrue = 0;
+    int64_t courseMagnetic = 0;
+    int64_t speedKnots = 0;
+    int64_t speedKmh = 0;
+
+    bool valid = readFixed( fields, 1, 2, &courseTrue )
+            && readFixed( fields, 3, 2, &courseMagnetic )
+            && readFixed( fields, 5, 3, &speedKnots )
+            && readFixed( fields, 7, 3, &speedKmh );
+
+    vtg->courseTrue = static_cast< uint32_t >( courseTrue );
+    vtg->courseMagnetic = static_cast< uint32_t >( courseMagnetic );
+    vtg->speedKnots = static_cast< uint32_t >( speedKnots );
+    vtg->speedKmh = static_cast< uint32_t >( speedKmh );
+    vtg->mode = readChar( fields, 9 );
+
+    return valid;
+}
+
+/**
+ * @brief Parses a ZDA sentence, the date and time
+ * @param text Sentence
+ * @param length Length of the sentence
+ * @param zda Parsed fields
+ * @return Boolean indicating the sentence is a valid ZDA sentence
+ */
+bool Parser::parse( const char *text, uint32_t length, Zda *zda )
+{
+    memset( zda, 0, sizeof( *zda ) );
+
+    Fields fields;
+    if( !split( text, length, "ZDA", 7, &fields ) ) {
+        return false;
+    }
+
+    uint32_t day = 0;
+    uint32_t month = 0;
+    uint32_t year = 0;
+    int64_t zoneHours = 0;
+    uint32_t zoneMinutes = 0;
+
+    bool valid = readTime( fields, 1, &zda->time )
+            && readUnsigned( fields, 2, &day )
+            && readUnsigned( fields, 3, &month )
+            && readUnsigned( fields, 4, &year )
+            && readFixed( fields, 5, 0, &zoneHours )
+            && readUnsigned( fields, 6, &zoneMinutes )
+            && day <= 31 && month <= 12 && year <= UINT16_MAX
+            && zoneHours >= -13 && zoneHours <= 13 && zoneMinutes < 60;
+
+    zda->date.day = static_cast< uint8_t >( day );
+    zda->date.month = static_cast< uint8_t >( month );
+    zda->date.year = static_cast< uint16_t >( year );
+    zda->zoneHours = static_cast< int8_t >( zoneHours );
+    zda->zoneMinutes = static_cast< uint8_t >( zoneMinutes );
+
+    return valid;
+}
+
+/**
+ * @brief Verifies the checksum of a sentence
+ * @param text Sentence
+ * @param length Length of the sentence
+ * @return Pointer to the '*' ending the data, nullptr if the sentence is
+ * malformed or the checksum doesn't match
+ */
+const char *Parser::findChecksum( const char *text, uint32_t length )
+{
+    if( text == nullptr ) {
+        return nullptr;
+    }
+
+    // The line ending is optional
+    while( length > 0 && ( text[ length - 1 ] == '\n' || text[ length - 1 ] == '\r' ) ) {
+        length--;
+    }
+
+    // $, at least the address, *, two digits
+    if( length < 4 || text[ 0 ] != '$' || text[ length - 3 ] != '*' ) {
+        return nullptr;
+    }
+
+    int32_t high = hexValue( text[ length - 2 ] );
+    int32_t low = hexValue( text[ length - 1 ] );
+    if( high < 0 || low < 0 ) {
+        return nullptr;
+    }
+
+    const char *end = &text[ length - 3 ];
+    uint8_t checksum = 0;
+    for( const char *c = &text[ 1 ]; c < end; c++ ) {
+        checksum ^= static_cast< uint8_t >( *c );
+    }
+
+    return ( checksum == ( high << 4 | low ) ) ? end : nullptr;
+}
+
+/**
+ * @brief Verifies a sentence and splits its data into fields
+ * @param text Sentence
+ * @param length Length of the sentence
+ * @param type Sentence type expected, the address without the talker
+ * @param minimum Minimum number of fields, the address included
+ * @param fields Fields, pointing into the sentence
+ * @return Boolean indicating the sentence is valid and of the type expected
+ */
+bool Parser::split( const char *text, uint32_t length, const char *type
+                    , uint32_t minimum, Fields *fields )
+{
+    const char *end = findChecksum( text, length );
+    if( end == nullptr ) {
+        return false;
+    }
+
+    fields->count = 0;
+    const char *field = &text[ 1 ];
+    while( fields->count < max_fields ) {
+        const char *comma = static_cast< const char* >(
+                    memchr( field, ',', static_cast< size_t >( end - field ) ) );
+        const char *fieldEnd = ( comma != nullptr ) ? comma : end;
+        if( fieldEnd - field > UINT8_MAX ) {
+            return false;
+        }
+
+        fields->field[ fields->count ] = field;
+        fields->length[ fields->count ] = static_cast< uint8_t >( fieldEnd - field );
+        fields->count++;
+
+        if( comma == nullptr ) {
+            break;
+        }
+        field = comma + 1;
+    }
+
+    // Talker ID and a three letter type
+    return fields->count >= minimum
+            && fields->length[ 0 ] == 5
+            && memcmp( fields->field[ 0 ] + 2, type, 3 ) == 0;
+}
+
+/**
+ * @brief Reads an unsigned integer field
+ * @param fields Fields
+ * @param index Index of the field
+ * @param value Value read, 0 if the field is empty
+ * @return Boolean indicating the field is empty or an integer
+ */
+bool Parser::readUnsigned( const Fields &fields, uint32_t index, uint32_t *value )
+{
+    *value = 0;
+    if( index >= fields.count ) {
+        return true;
+    }
+
+    const char *field = fields.field[ index ];
+    uint32_t length = fields.length[ index ];
+    if( length > 9 ) {
+        return false;
+    }
+
+    uint32_t result = 0;
+    for( uint32_t i = 0; i < length; i++ ) {
+        if( field[ i ] < '0' || field[ i ] > '9' ) {
+            return false;
+        }
+        result = result * 10 + static_cast< uint32_t >( field[ i ] - '0' );
+    }
+
+    *value = result;
+    return true;
+}
+
+/**
+ * @brief Reads a decimal field as a fixed point number. Digits past the
+ * precision asked for are dropped.
+ * @param fields Fields
+ * @param index Index of the field
+ * @param decimals Number of decimals to keep, the value is scaled by as many
+ * powers of ten
+ * @param value Value read, 0 if the field is empty
+ * @return Boolean indicating the field is empty or a number
+ */
+bool Parser::readFixed( const Fields &fields, uint32_t index, uint32_t decimals
+                        , int64_t *value )
+{
+    *value = 0;
+    if( index >= fields.count ) {
+        return true;
+    }
+
+    const char *field = fields.field[ index ];
+    const char *end = field + fields.length[ index ];
+    if( field == end ) {
+        return true;
+    }
+
+    if( decimals >= sizeof( scale ) / sizeof( scale[ 0 ] ) ) {
+        return false;
+    }
+
+    bool negative = false;
+    if( *field == '-' ) {
+        negative = true;
+        field++;
+    }
+
+    int64_t result = 0;
+    uint32_t digits = 0;
+    uint32_t fraction = 0;
+    bool point = false;
+    for( ; field < end; field++ ) {
+        if( *field == '.' && !point ) {
+            point = true;
+        } else if( *field >= '0' && *field <= '9' ) {
+            if( point && fraction == decimals ) {
+                continue;
+            }
+            if( ++digits > max_digits ) {
+                return false;
+            }
+            result = result * 10 + ( *field - '0' );
+            if( point ) {
+                fraction++;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    // Scaling adds the missing decimals as digits
+    if( digits == 0 || digits + ( decimals - fraction ) > max_digits ) {
+        return false;
+    }
+
+    result *= scale[ decimals - fraction ];
+    *value = negative ? -result : result;
+    return true;
+}
+
+/**
+ * @brief Reads a coordinate, ddmm.mmmm or dddmm.mmmm followed by the
+ * hemisphere field
+ * @param fields Fields
+ * @param index Index of the coordinate field
+ * @param maximum Largest number of degrees, 90 for a latitude and 180 for a
+ * longitude
+ * @param value Coordinate in 1e-7 degrees, 0 if the field is empty
+ * @return Boolean indicating the fields are empty or a coordinate
+ */
+bool Parser::readCoordinate( const Fields &fields, uint32_t index
+                             , int64_t maximum, int32_t *value )
+{
+    *value = 0;
+
+    // Minutes are kept to 1e-7, a hundredth of a millimetre
+    int64_t raw = 0;
+    if( !readFixed( fields, index, 7, &raw ) || raw < 0 ) {
+        return false;
+    }
+
+    int64_t degrees = raw / ( 100 * scale[ 7 ] );
+    int64_t minutes = raw % ( 100 * scale[ 7 ] );
+    if( minutes >= 60 * scale[ 7 ] ) {
+        return false;
+    }
+
+    // Round the minutes to the nearest 1e-7 degree
+    int64_t result = degrees * scale[ 7 ] + ( minutes + 30 ) / 60;
+    if( result > maximum * scale[ 7 ] ) {
+        return false;
+    }
+
+    char hemisphere = readChar( fields, index + 1 );
+    if( hemisphere == 'S' || hemisphere == 'W' ) {
+        result = -result;
+    } else if( hemisphere != 'N' && hemisphere != 'E' && hemisphere != '\0' ) {
+        return false;
+    }
+
+    *value = static_cast< int32_t >( result );
+    return true;
+}
+
+/**
+ * @brief Reads a UTC time, hhmmss with optional fractions of a second
+ * @param fields Fields
+ * @param index Index of the field
+ * @param time Time read, all 0 if the field is empty
+ * @return Boolean indicating the field is empty or a time
+ */
+bool Parser::readTime( const Fields &fields, uint32_t index, Time *time )
+{
+    memset( time, 0, sizeof( *time ) );
+    if( index >= fields.count || fields.length[ index ] == 0 ) {
+        return true;
+    }
+
+    int64_t value = 0;
+    if( fields.length[ index ] < 6 || !readFixed( fields, index, 3, &value )
+            || value < 0 ) {
+        return false;
+    }
+
+    int64_t seconds = value / 1000;
+    time->hours = static_cast< uint8_t >( seconds / 10000 );
+    time->minutes = static_cast< uint8_t >( seconds / 100 % 100 );
+    time->seconds = static_cast< uint8_t >( seconds % 100 );
+    time->milliseconds = static_cast< uint16_t >( value % 1000 );
+
+    // Leap seconds make a 60th second
+    return seconds < 240000 && time->minutes < 60 && time->seconds <= 60;
+}
+
+/**
+ * @brief Reads a date, ddmmyy
+ * @param fields Fields
+ * @param index Index of the field
+ * @param date Date read, all 0 if the field is empty
+ * @return Boolean indicating the field is empty or a date
+ */
+bool Parser::readDate( const Fields &fields, uint32_t index, Date *date )
+{
+    memset( date, 0, sizeof( *date ) );
+    if( index >= fields.count || fields.length[ index ] == 0 ) {
+        return true;
+    }
+
+    uint32_t value = 0;
+    if( fields.length[ index ] != 6 || !readUnsigned( fields, index, &value ) ) {
+        return false;
+    }
+
+    date->day = static_cast< uint8_t >( value / 10000 );
+    date->month = static_cast< uint8_t >( value / 100 % 100 );
+
+    // Two digit years, receivers predating 1980 don't exist
+    uint32_t year = value % 100;
+    date->year = static_cast< uint16_t >( ( year < 80 ) ? 2000 + year : 1900 + year );
+
+    return date->day >= 1 && date->day <= 31
+            && date->month >= 1 && date->month <= 12;
+}
+
+/**
+ * @brief Reads a single character field
+ * @param fields Fields
+ * @param index Index of the field
+ * @return First character of the field, NUL if the field is empty
+ */
+char Parser::readChar( const Fields &fields, uint32_t index )
+{
+    if( index >= fields.count || fields.length[ index ] == 0 ) {
+        return '\0';
+    }
+    return fields.field[ index ][ 0 ];
+}
+
+}
+
+}
@@ -0,0 +1,76 @@
+#include <string.h>
+
+#include "common/drivers/devices/gps/sentence_table.h"
+
+namespace Gps
+{
+
+/**
+ * @brief Replaces the sentence held for a type. Only one thread may store.
+ * @param sentence Sentence type
+ * @param text Sentence text, doesn't need to be NUL terminated
+ * @param length Length of the text, truncated to fit the slot
+ */
+void SentenceTable::store( Nmea::Sentence sentence, const char *text
+                           , uint32_t length )
+{
+    if( sentence >= Nmea::SENTENCE_MAX ) {
+        return;
+    }
+
+    if( length > sentence_size - 1 ) {
+        length = sentence_size - 1;
+    }
+
+    Text value = {};
+    value.length = length;
+    memcpy( value.text, text, length );
+
+    mSlots[ sentence ].store( value );
+}
+
+/**
+ * @brief Copies the latest sentence of a type
+ * @param sentence Sentence type
+ * @param buffer Buffer to copy the sentence to, always NUL terminated
+ * @param size Size of the buffer
+ * @return Length of the sentence copied, -1 if none was received yet
+ */
+int32_t SentenceTable::load( Nmea::Sentence sentence, char *buffer, uint32_t size )
+{
+    if( buffer == nullptr || size == 0 ) {
+        return -1;
+    }
+
+    buffer[ 0 ] = '\0';
+    if( sentence >= Nmea::SENTENCE_MAX ) {
+        return -1;
+    }
+
+    Text value;
+    bool received = mSlots[ sentence ].load( &value );
+
+    uint32_t length = value.length;
+    if( length > size - 1 ) {
+        length = size - 1;
+    }
+    memcpy( buffer, value.text, length );
+    buffer[ length ] = '\0';
+
+    return received ? static_cast< int32_t >( length ) : -1;
+}
+
+/**
+ * @brief Retrieves the number of sentences of a type stored so far
+ * @param sentence Sentence type
+ * @return Number of sentences
+ */
+uint32_t SentenceTable::getReceived( Nmea::Sentence sentence )
+{
+    if( sentence >= Nmea::SENTENCE_MAX ) {
+        return 0;
+    }
+    return mSlots[ sentence ].getStored();
+}
+
+}
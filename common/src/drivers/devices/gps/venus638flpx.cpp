@@ -5,10 +5,28 @@
  * @brief Implementation of the Venus638FLPx driver
  * ****************************************************************************/
 
+#include <chrono>
+#include <ctype.h>
+
 #include "common/drivers/devices/gps/venus638flpx.h"
 
 namespace Gps {
 
+/**
+ * @brief Reads a big endian unsigned integer
+ * @param data Data
+ * @param size Size of the integer in bytes, up to 4
+ * @return Value
+ */
+static uint32_t readBigEndian( const uint8_t *data, uint32_t size )
+{
+    uint32_t value = 0;
+    for( uint32_t i = 0; i < size; i++ ) {
+        value = ( value << 8 ) | data[ i ];
+    }
+    return value;
+}
+
 const uint8_t Venus638FLPx::Message::start_sequence[] = { 0xA0, 0xA1 };
 const uint8_t Venus638FLPx::Message::end_sequence[] = { 0x0D, 0x0A };
 
@@ -100,105 +118,211 @@ uint32_t Venus638FLPx::Message::getDataLength()
 const char Venus638FLPx::gps_sentence_start_sequence[] = "$";
 const char Venus638FLPx::gps_sentence_end_sequence[] = "\n";
 
+const int32_t Venus638FLPx::poll_timeout = 100;
+const int32_t Venus638FLPx::response_timeout = 5000;
+const int32_t Venus638FLPx::probe_timeout = 500;
+
+// Indexed by the baud setting of CONFIGURE_SERIAL_PORT
+const Serial::Speed Venus638FLPx::device_speeds[] = {
+    Serial::Speed::BAUD_4800
+    , Serial::Speed::BAUD_9600
+    , Serial::Speed::BAUD_19200
+    , Serial::Speed::BAUD_38400
+    , Serial::Speed::BAUD_57600
+    , Serial::Speed::BAUD_115200
+};
+const uint32_t Venus638FLPx::device_speed_count
+        = sizeof( device_speeds ) / sizeof( device_speeds[ 0 ] );
+
+const uint32_t Venus638FLPx::update_rates[] = { 1, 2, 4, 5, 8, 10, 20 };
+const uint32_t Venus638FLPx::update_rate_count
+        = sizeof( update_rates ) / sizeof( update_rates[ 0 ] );
+
+// Bytes sent per fix, GGA, GSA, RMC, VTG and three GSV sentences against one
+// framed navigation data message
+const uint32_t Venus638FLPx::nmea_fix_size = 460;
+const uint32_t Venus638FLPx::binary_fix_size = 66;
+const uint16_t Venus638FLPx::navigation_data_length = 59;
+
+const char *Venus638FLPx::output_strings[] = {
+    "none"
+    , "nmea"
+    , "binary"
+    , nullptr
+};
+
 /**
- * @brief Constructor
+ * @brief Constructor, starts reading from the device. The version is logged
+ * once the device answers, construction doesn't wait for it.
  */
 Venus638FLPx::Venus638FLPx( Serial *serial )
     : mSerial( serial )
+    , mOutput( Output::NMEA )
+    , mUpdateRate( 1 )
+    , mRunning( false )
+    , mThread( nullptr )
+    , mRingHead( 0 )
+    , mRingTail( 0 )
 {
-    // setBaud( Serial::Speed::BAUD_9600 );
-    // The device doesn't seem to acknowledge the following command if we don't
-    // sleep some
-    usleep( 25000 );
+    start();
     dumpVersion();
 }
 
 /**
- * @brief Send a message to the device
- * @param message Message container
- * @param response Buffer to store the response
- * @param size Size of the response buffer
- * @return int32_t error code
+ * @brief Destructor, stops reading from the device
  */
-int32_t Venus638FLPx::sendMessage(
-        Message &message, uint8_t *response, uint32_t size )
+Venus638FLPx::~Venus638FLPx()
 {
-    int32_t error = 0;
+    stop();
+}
 
-    // Write the message to the device
-    error = mSerial->writeBytes( message.getData(), message.getDataLength() );
+/**
+ * @brief Starts the thread reading from the device. Does nothing if the
+ * interface isn't open.
+ */
+void Venus638FLPx::start()
+{
+    if( mThread != nullptr ) {
+        return;
+    }
 
-    // Read the response to our command
-    if( error >= 0 ) {
-        error = mSerial->readPattern(
-                    Message::start_sequence, Message::start_sequence_length
-                    , Message::end_sequence, Message::end_sequence_length
-                    , response, size );
+    if( !mSerial->isInterfaceOpen() ) {
+        LOG_WARN( "gps interface is not open, not reading" );
+        return;
     }
 
-    int32_t messageIdOffset = Message::start_sequence_length 
-        + Message::end_sequence_length;
-    
-    // In the event the command was successful we will receive an ACK
-    if( ( error >= 0 ) && ( response[ messageIdOffset ] == Message::Id::ACK ) ) {
-        LOG_INFO( "ACK Received" );
-        // We received an ACK, read again to get the verification of our command
-        error = mSerial->readPattern(
-                    Message::start_sequence, Message::start_sequence_length
-                    , Message::end_sequence, Message::end_sequence_length
-                    , response, size );
+    mRunning = true;
+    mThread = new std::thread( &Venus638FLPx::run, this );
+}
+
+/**
+ * @brief Stops the thread reading from the device and joins it. Messages
+ * still waiting for an answer fail.
+ */
+void Venus638FLPx::stop()
+{
+    mRunning = false;
+    if( mThread ) {
+        if( mThread->joinable() ) {
+            mThread->join();
+        }
+        delete mThread;
+        mThread = nullptr;
     }
 
-    return error;
+    cancel();
 }
 
 /**
- * @brief Send a message to the device
+ * @brief Sends a message to the device without waiting for the answer. The
+ * reader thread matches the ACK or NACK, and the information queried if any,
+ * to the message.
+ *
+ * The callback is called from the reader thread, it must not wait on the
+ * device itself.
+ * @param message Message container
+ * @param responseId ID of the message with the information queried, NONE if
+ * the message is only acknowledged
+ * @param timeout Time to wait for the answer in milliseconds
+ * @param callback Called with the response, may be null
+ * @return Future response
+ */
+std::future< Venus638FLPx::Response > Venus638FLPx::submit(
+        Message &message, uint8_t responseId, int32_t timeout, Callback callback )
+{
+    const uint32_t messageIdOffset = Message::start_sequence_length
+        + Message::payload_length;
+
+    Request request;
+    request.id = message.getData()[ messageIdOffset ];
+    request.responseId = responseId;
+    request.acknowledged = false;
+    request.deadline = Clock::now() + std::chrono::milliseconds( timeout );
+    request.callback = callback;
+    std::future< Response > future = request.promise.get_future();
+
+    bool sent = false;
+    {
+        // Sent while holding the table so it stays in the order sent. Without
+        // the reader thread nothing would ever answer or expire the request.
+        std::lock_guard< std::mutex > lock( mRequestMutex );
+        if( mRunning && mSerial->writeBytes(
+                message.getData(), message.getDataLength() ) >= 0 ) {
+            mRequests.push_back( std::move( request ) );
+            sent = true;
+        }
+    }
+
+    if( !sent ) {
+        LOG_ERROR( "failed to send message %02x", request.id );
+        complete( request, -1, std::vector< uint8_t >() );
+    }
+
+    return future;
+}
+
+/**
+ * @brief Send a message to the device and wait for it to be acknowledged
  * @param message Message container
  * @param response Buffer to store the response
  * @param size Size of the response buffer
- * @return int32_t error code
+ * @return int32_t number of bytes of the response, negative if the device
+ * didn't answer or refused the message
  */
-int32_t Venus638FLPx::sendQuery(
+int32_t Venus638FLPx::sendMessage(
         Message &message, uint8_t *response, uint32_t size )
 {
-    int32_t error = 0;
-
-    // Write the message to the device
-    error = mSerial->writeBytes( message.getData(), message.getDataLength() );
+    return sendQuery( message, Message::Id::NONE, response, size );
+}
 
-    // Read the response to our command
-    if( error >= 0 ) {
-        error = mSerial->readPattern(
-                    Message::start_sequence, Message::start_sequence_length
-                    , Message::end_sequence, Message::end_sequence_length
-                    , response, size );
+/**
+ * @brief Send a query to the device and wait for the information queried
+ * @param message Message container
+ * @param responseId ID of the message with the information queried, NONE to
+ * only wait for the ACK
+ * @param response Buffer to store the response
+ * @param size Size of the response buffer
+ * @return int32_t number of bytes of the response, negative if the device
+ * didn't answer or refused the query
+ */
+int32_t Venus638FLPx::sendQuery(
+        Message &message, uint8_t responseId, uint8_t *response, uint32_t size )
+{
+    Response answer = submit( message, responseId, response_timeout ).get();
+    if( answer.error < 0 ) {
+        return answer.error;
     }
 
-    int32_t messageIdOffset = Message::start_sequence_length
-        + Message::end_sequence_length;
-
-    // In the event the command was successful we will receive an ACK
-    if( ( error >= 0 ) && ( response[ messageIdOffset ] == Message::Id::ACK ) ) {
-        // We received an ACK, read again to get the verification of our command
-        LOG_INFO( "ACK Received" );
-        error = mSerial->readPattern(
-                    Message::start_sequence, Message::start_sequence_length
-                    , Message::end_sequence, Message::end_sequence_length
-                    , response, size );
+    uint32_t length = static_cast< uint32_t >( answer.message.size() );
+    if( length > size ) {
+        length = size;
     }
+    memcpy( response, answer.message.data(), length );
 
-    // The final response will contain the information we queried
-    if( ( error >= 0 ) && ( response[ messageIdOffset ] == Message::Id::ACK ) ) {
-        // We received a response for our message, read one more time
-        LOG_INFO( "ACK Received" );
-        error = mSerial->readPattern(
-                    Message::start_sequence, Message::start_sequence_length
-                    , Message::end_sequence, Message::end_sequence_length
-                    , response, size );
-    }
+    return static_cast< int32_t >( length );
+}
 
-    return error;
+/**
+ * @brief Retrieves the latest navigation data message, only sent in binary
+ * output mode
+ * @param navigation Navigation data
+ * @return Boolean indicating a message was received
+ */
+bool Venus638FLPx::getNavigation( Navigation *navigation )
+{
+    return mNavigation.load( navigation );
+}
+
+/**
+ * @brief Sets the listener told about every sentence received. It is called
+ * from the reader thread and must not block. Once this returns the previous
+ * listener is no longer running.
+ * @param listener Listener, nullptr to stop listening
+ */
+void Venus638FLPx::setSentenceListener( SentenceListener listener )
+{
+    std::lock_guard< std::mutex > lock( mListenerMutex );
+    mListener = listener;
 }
 
 uint32_t Venus638FLPx::getBaudRate()
@@ -207,24 +331,35 @@ uint32_t Venus638FLPx::getBaudRate()
 }
 
 /**
- * @brief Sets the baud rate for the device
+ * @brief Sets the baud rate for the device. The device is looked for at
+ * every baud rate first if it doesn't answer at the current one. The interface
+ * is left as it was if the device doesn't answer at the new rate.
  * @param baud Desired baud rate
  * @return int32_t error code
  */
 int32_t Venus638FLPx::setBaud( Serial::Speed baud )
 {
-    int32_t error = Error::Code::NONE;
-
     // Determine the baud setting for the device
-    uint8_t baudToSet = 1;
-    switch( baud ) {
-        case Serial::Speed::BAUD_4800  : baudToSet = 0; break;
-        case Serial::Speed::BAUD_9600  : baudToSet = 1; break;
-        case Serial::Speed::BAUD_19200 : baudToSet = 2; break;
-        case Serial::Speed::BAUD_38400 : baudToSet = 3; break;
-        case Serial::Speed::BAUD_57600 : baudToSet = 4; break;
-        case Serial::Speed::BAUD_115200: baudToSet = 5; break;
-        default: error = Error::Code::PARAM_OUT_OF_RANGE;
+    uint8_t baudToSet = device_speed_count;
+    for( uint8_t i = 0; i < device_speed_count; i++ ) {
+        if( device_speeds[ i ] == baud ) {
+            baudToSet = i;
+        }
+    }
+
+    if( baudToSet == device_speed_count || !fits( mOutput, mUpdateRate, baud ) ) {
+        return Error::Code::PARAM_OUT_OF_RANGE;
+    }
+
+    // Find the device if it isn't at the interface speed
+    Serial::Speed current = static_cast< Serial::Speed >( mSerial->getInterfaceSpeed() );
+    if( !probe() && !detectBaud( &current ) ) {
+        LOG_ERROR( "failed to configure baud, no answer at any baud" );
+        return -1;
+    }
+
+    if( current == baud ) {
+        return Error::Code::NONE;
     }
 
     uint8_t body[] = { 0x00, 0x00, 0x00 };
@@ -234,68 +369,614 @@ int32_t Venus638FLPx::setBaud( Serial::Speed baud )
     Message message( Message::Id::CONFIGURE_SERIAL_PORT, body, sizeof( body ) );
 
     // Configure the device first
-    error = sendMessage( message, buffer, READ_BUFFER_SIZE );
+    int32_t error = sendMessage( message, buffer, READ_BUFFER_SIZE );
 
     if( error >= 0 ) {
         // If the device is configured properly then configure the interface
         mSerial->setInterfaceSpeed( baud );
         mSerial->applySettings();
+
+        if( !probe() ) {
+            LOG_ERROR( "no answer at %u baud, staying at %u baud"
+                       , static_cast< uint32_t >( baud )
+                       , static_cast< uint32_t >( current ) );
+            mSerial->setInterfaceSpeed( current );
+            mSerial->applySettings();
+            error = -1;
+        }
     } else {
         LOG_ERROR( "failed to configure baud" );
     }
 
-    return error;
+    return ( error >= 0 ) ? Error::Code::NONE : error;
 }
 
 /**
- * @brief Dumps version info from the device
+ * @brief Retrieves the output the device was last configured for
+ * @return Output type
  */
-void Venus638FLPx::dumpVersion()
+Venus638FLPx::Output Venus638FLPx::getOutput()
+{
+    return mOutput;
+}
+
+/**
+ * @brief Configures what the device sends, NMEA sentences or navigation data
+ * messages
+ * @param output Output type
+ * @return int32_t error code
+ */
+int32_t Venus638FLPx::setOutput( Output output )
 {
-    int32_t error = 0;
+    if( output >= OUTPUT_MAX ) {
+        return Error::Code::PARAM_INVALID;
+    } else if( !fits( output, mUpdateRate, mSerial->getInterfaceSpeed() ) ) {
+        return Error::Code::PARAM_OUT_OF_RANGE;
+    }
+
+    // Only the running configuration is changed, not the flash
+    uint8_t body[] = { static_cast< uint8_t >( output ), 0x00 };
 
-    uint8_t body = 0;
     uint8_t buffer[ READ_BUFFER_SIZE ];
+    Message message( Message::Id::CONFIGURE_MESSAGE_TYPE, body, sizeof( body ) );
 
-    Message message( Message::Id::QUERY_SOFTWARE_VERSION, &body, 1 );
+    int32_t error = sendMessage( message, buffer, READ_BUFFER_SIZE );
+    if( error >= 0 ) {
+        mOutput = output;
+        error = Error::Code::NONE;
+    } else {
+        LOG_ERROR( "failed to configure output" );
+    }
+
+    return error;
+}
+
+/**
+ * @brief Retrieves the position update rate the device was last configured for
+ * @return uint32_t rate in Hz
+ */
+uint32_t Venus638FLPx::getUpdateRate()
+{
+    return mUpdateRate;
+}
+
+/**
+ * @brief Configures the position update rate. The output of every fix must
+ * fit the baud rate, raise the baud or switch to binary output first.
+ * @param rate Rate in Hz, 1, 2, 4, 5, 8, 10 or 20
+ * @return int32_t error code
+ */
+int32_t Venus638FLPx::setUpdateRate( uint32_t rate )
+{
+    bool supported = false;
+    for( uint32_t i = 0; i < update_rate_count; i++ ) {
+        if( update_rates[ i ] == rate ) {
+            supported = true;
+        }
+    }
+
+    if( !supported || !fits( mOutput, rate, mSerial->getInterfaceSpeed() ) ) {
+        return Error::Code::PARAM_OUT_OF_RANGE;
+    }
 
-    error = sendQuery( message, buffer, READ_BUFFER_SIZE );
+    // Only the running configuration is changed, not the flash
+    uint8_t body[] = { static_cast< uint8_t >( rate ), 0x00 };
 
+    uint8_t buffer[ READ_BUFFER_SIZE ];
+    Message message( Message::Id::CONFIGURE_POSITION_RATE, body, sizeof( body ) );
+
+    int32_t error = sendMessage( message, buffer, READ_BUFFER_SIZE );
     if( error >= 0 ) {
-        int32_t idOffset = Message::start_sequence_length
-                               + Message::end_sequence_length;
-
-        uint8_t *kernel = &buffer[ idOffset + Message::SoftwareVersion::KERNEL_VERSION ];
-        LOG_INFO( "Kernel Version: %02x.%02x.%02x"
-            , kernel[ 1 ], kernel[ 2 ], kernel[ 3 ] );
-        uint8_t *odm = &buffer[ idOffset + Message::SoftwareVersion::ODM_VERSION ];
-        LOG_INFO( "   ODM Version: %02x.%02x.%02x"
-            , odm[ 1 ], odm[ 2 ], odm[ 3 ] );
-        uint8_t *revision = &buffer[ idOffset + Message::SoftwareVersion::REVISION ];
-        LOG_INFO( "      Revision: %02x.%02x.%02x"
-            , revision[ 1 ], revision[ 2 ], revision[ 3 ] );
+        mUpdateRate = rate;
+        error = Error::Code::NONE;
     } else {
-        LOG_ERROR( "failed to query version" );
+        LOG_ERROR( "failed to configure update rate" );
+    }
+
+    return error;
+}
+
+/**
+ * @brief Converts a string to an output type
+ * @param output Output type string
+ * @return Output type, OUTPUT_MAX if the string is unknown
+ */
+Venus638FLPx::Output Venus638FLPx::stringToOutput( const char *output )
+{
+    Output o = Output::OUTPUT_MAX;
+    for( int i = 0; output != nullptr && output_strings[ i ] != nullptr; i++ ) {
+        if( strcmp( output_strings[ i ], output ) == 0 ) {
+            o = static_cast< Output >( i );
+        }
+    }
+    return o;
+}
+
+/**
+ * @brief Converts an output type to a string
+ * @param output Output type
+ * @return Character array representation of the output type
+ */
+const char *Venus638FLPx::outputToString( Output output )
+{
+    if( output >= 0 && output < Output::OUTPUT_MAX ) {
+        return output_strings[ output ];
     }
+    return nullptr;
+}
+
+/**
+ * @brief Queries the version of the device, it is logged once the device
+ * answers
+ */
+void Venus638FLPx::dumpVersion()
+{
+    uint8_t body = 0;
+    Message message( Message::Id::QUERY_SOFTWARE_VERSION, &body, 1 );
+
+    submit( message, Message::Id::SOFTWARE_VERSION, response_timeout
+            , &Venus638FLPx::logVersion );
 }
 
 /**
- * @brief Prints the first GPS sentence found from the device
+ * @brief Retrieves the latest sentence of a type received from the device,
+ * without waiting for the device
+ * @param sentence Sentence type
+ * @param buffer Buffer to store the sentence, always NUL terminated
+ * @param size Size of the buffer
+ * @return int32_t length of the sentence, negative if none was received yet
  */
 int32_t Venus638FLPx::getSentence(
         Nmea::Sentence sentence, uint8_t *buffer, uint32_t size )
 {
-    int32_t error = 0;
-    const char *sequence = Nmea::sentence[ sentence ].name;
+    return mSentences.load( sentence, reinterpret_cast< char* >( buffer ), size );
+}
+
+/**
+ * @brief Retrieves the number of sentences of a type received from the device
+ * @param sentence Sentence type
+ * @return uint32_t number of sentences
+ */
+uint32_t Venus638FLPx::getReceived( Nmea::Sentence sentence )
+{
+    return mSentences.getReceived( sentence );
+}
 
-    error = mSerial->readPattern(
-                reinterpret_cast< const uint8_t* >( sequence )
-                , static_cast< uint32_t >( strlen( sequence ) )
-                , reinterpret_cast< const uint8_t* >( gps_sentence_end_sequence )
-                , strlen( gps_sentence_end_sequence )
-                ,  buffer, size );
+/**
+ * @brief Reader thread. Reads whatever the device sent into the ring buffer
+ * and frames the sentences and messages in it.
+ */
+void Venus638FLPx::run()
+{
+    while( mRunning ) {
+        // Read into the free space up to the end of the ring, framing always
+        // leaves some since frames are far smaller than the ring
+        uint32_t tail = mRingTail % RING_BUFFER_SIZE;
+        uint32_t space = RING_BUFFER_SIZE - ( mRingTail - mRingHead );
+        if( space > RING_BUFFER_SIZE - tail ) {
+            space = RING_BUFFER_SIZE - tail;
+        }
+
+        int32_t bytesRead = mSerial->readAvailable(
+                    &mRing[ tail ], space, poll_timeout );
+        if( bytesRead < 0 ) {
+            LOG_ERROR( "gps read failed, no longer reading - %s"
+                       , strerror( errno ) );
+            break;
+        }
+
+        mRingTail += static_cast< uint32_t >( bytesRead );
+        frame();
+        expire( Clock::now() );
+    }
 
-    return error;
+    mRunning = false;
+    cancel();
+}
+
+/**
+ * @brief Frames everything complete in the ring buffer. Bytes that can't
+ * start a sentence or a message are skipped.
+ */
+void Venus638FLPx::frame()
+{
+    while( mRingHead != mRingTail ) {
+        bool consumed = true;
+
+        uint8_t byte = peek( 0 );
+        if( byte == static_cast< uint8_t >( gps_sentence_start_sequence[ 0 ] ) ) {
+            consumed = frameSentence();
+        } else if( byte == Message::start_sequence[ 0 ] ) {
+            consumed = frameMessage();
+        } else {
+            mRingHead++;
+        }
+
+        if( !consumed ) {
+            // Wait for the rest of the frame
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Frames the NMEA sentence at the head of the ring buffer, stores it
+ * in the sentence table and hands it to the listener. Sentences of unknown
+ * types are dropped.
+ * @return Boolean indicating bytes were consumed, false if the sentence is
+ * incomplete
+ */
+bool Venus638FLPx::frameSentence()
+{
+    const uint32_t available = mRingTail - mRingHead;
+    const uint8_t end = static_cast< uint8_t >( gps_sentence_end_sequence[ 0 ] );
+    const uint8_t start = static_cast< uint8_t >( gps_sentence_start_sequence[ 0 ] );
+
+    uint32_t length = 0;
+    for( uint32_t i = 1; i < available && i <= SentenceTable::sentence_size; i++ ) {
+        uint8_t byte = peek( i );
+        if( byte == end ) {
+            length = i + 1;
+            break;
+        } else if( byte == start || ( byte != '\r' && !isprint( byte ) ) ) {
+            // Sentences are printable, the sentence was cut short by another
+            // sentence or a message. Start over from there.
+            mRingHead += i;
+            return true;
+        }
+    }
+
+    if( length == 0 ) {
+        if( available > SentenceTable::sentence_size ) {
+            // Too long to be a sentence
+            mRingHead++;
+            return true;
+        }
+        return false;
+    }
+
+    char text[ SentenceTable::sentence_size + 1 ];
+    copy( reinterpret_cast< uint8_t* >( text ), length );
+    mRingHead += length;
+
+    // Drop the line ending
+    length--;
+    if( length > 0 && text[ length - 1 ] == '\r' ) {
+        length--;
+    }
+
+    for( uint32_t s = 0; s < Nmea::SENTENCE_MAX; s++ ) {
+        const char *name = Nmea::sentence[ s ].name;
+        size_t nameLength = strlen( name );
+        if( length > nameLength
+                && strncmp( text, name, nameLength ) == 0
+                && text[ nameLength ] == ',' ) {
+            mSentences.store( static_cast< Nmea::Sentence >( s ), text, length );
+
+            text[ length ] = '\0';
+            std::lock_guard< std::mutex > lock( mListenerMutex );
+            if( mListener ) {
+                mListener( static_cast< Nmea::Sentence >( s ), text );
+            }
+            break;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Frames the binary message at the head of the ring buffer and queues
+ * it to the message it answers. Navigation data is stored instead. Messages
+ * with a bad checksum are dropped.
+ * @return Boolean indicating bytes were consumed, false if the message is
+ * incomplete
+ */
+bool Venus638FLPx::frameMessage()
+{
+    const uint32_t available = mRingTail - mRingHead;
+    const uint32_t header = Message::start_sequence_length + Message::payload_length;
+
+    if( available < Message::start_sequence_length ) {
+        return false;
+    } else if( peek( 1 ) != Message::start_sequence[ 1 ] ) {
+        mRingHead++;
+        return true;
+    } else if( available < header ) {
+        return false;
+    }
+
+    uint32_t payload = ( static_cast< uint32_t >( peek( 2 ) ) << 8 ) | peek( 3 );
+    uint32_t length = header + payload
+            + Message::checksum_length + Message::end_sequence_length;
+    if( payload == 0 || length > READ_BUFFER_SIZE ) {
+        mRingHead++;
+        return true;
+    } else if( available < length ) {
+        return false;
+    }
+
+    uint8_t checksum = 0;
+    for( uint32_t i = 0; i < payload; i++ ) {
+        checksum ^= peek( header + i );
+    }
+
+    if( checksum != peek( header + payload )
+            || peek( length - 2 ) != Message::end_sequence[ 0 ]
+            || peek( length - 1 ) != Message::end_sequence[ 1 ] ) {
+        mRingHead++;
+        return true;
+    }
+
+    std::vector< uint8_t > message( length );
+    copy( message.data(), length );
+    mRingHead += length;
+
+    // Navigation data isn't an answer to anything, keep the latest
+    if( message[ header ] == Message::Id::NAVIGATION_DATA ) {
+        if( payload == navigation_data_length ) {
+            Navigation navigation;
+            decodeNavigation( &message[ header ], &navigation );
+            mNavigation.store( navigation );
+        }
+        return true;
+    }
+
+    dispatch( std::move( message ) );
+
+    return true;
+}
+
+/**
+ * @brief Retrieves a byte of the ring buffer
+ * @param offset Offset from the head
+ * @return uint8_t byte
+ */
+uint8_t Venus638FLPx::peek( uint32_t offset )
+{
+    return mRing[ ( mRingHead + offset ) % RING_BUFFER_SIZE ];
+}
+
+/**
+ * @brief Copies bytes from the head of the ring buffer, leaves the head as is
+ * @param buffer Buffer to copy to
+ * @param size Number of bytes to copy
+ */
+void Venus638FLPx::copy( uint8_t *buffer, uint32_t size )
+{
+    uint32_t head = mRingHead % RING_BUFFER_SIZE;
+    uint32_t first = RING_BUFFER_SIZE - head;
+    if( first > size ) {
+        first = size;
+    }
+    memcpy( buffer, &mRing[ head ], first );
+    memcpy( buffer + first, mRing, size - first );
+}
+
+/**
+ * @brief Completes the request a message answers. ACK and NACK answer the
+ * oldest request with the ID they carry, the information queried answers the
+ * oldest acknowledged request for it. Anything else is dropped.
+ * @param message Message received
+ */
+void Venus638FLPx::dispatch( std::vector< uint8_t > &&message )
+{
+    const uint32_t messageIdOffset = Message::start_sequence_length
+        + Message::payload_length;
+    const uint8_t id = message[ messageIdOffset ];
+    const bool acknowledge = ( id == Message::Id::ACK || id == Message::Id::NACK );
+
+    std::list< Request > answered;
+    int32_t error = Error::Code::NONE;
+    {
+        std::lock_guard< std::mutex > lock( mRequestMutex );
+        for( auto it = mRequests.begin(); it != mRequests.end(); ++it ) {
+            if( acknowledge ) {
+                if( it->acknowledged || it->id != message[ messageIdOffset + 1 ] ) {
+                    continue;
+                }
+
+                if( id == Message::Id::NACK ) {
+                    error = -1;
+                } else if( it->responseId != Message::Id::NONE ) {
+                    // The information queried follows
+                    it->acknowledged = true;
+                    break;
+                }
+            } else if( !it->acknowledged || it->responseId != id ) {
+                continue;
+            }
+
+            answered.splice( answered.begin(), mRequests, it );
+            break;
+        }
+    }
+
+    for( Request &request : answered ) {
+        if( error < 0 ) {
+            LOG_WARN( "NACK received for message %02x", request.id );
+        }
+        complete( request, error, std::move( message ) );
+    }
+}
+
+/**
+ * @brief Fails the requests the device didn't answer in time
+ * @param now Current time
+ */
+void Venus638FLPx::expire( Clock::time_point now )
+{
+    std::list< Request > expired;
+    {
+        std::lock_guard< std::mutex > lock( mRequestMutex );
+        for( auto it = mRequests.begin(); it != mRequests.end(); ) {
+            auto next = std::next( it );
+            if( it->deadline <= now ) {
+                expired.splice( expired.end(), mRequests, it );
+            }
+            it = next;
+        }
+    }
+
+    for( Request &request : expired ) {
+        LOG_WARN( "no answer to message %02x", request.id );
+        complete( request, -1, std::vector< uint8_t >() );
+    }
+}
+
+/**
+ * @brief Fails every request waiting for an answer
+ */
+void Venus638FLPx::cancel()
+{
+    std::list< Request > cancelled;
+    {
+        std::lock_guard< std::mutex > lock( mRequestMutex );
+        cancelled.swap( mRequests );
+    }
+
+    for( Request &request : cancelled ) {
+        complete( request, -1, std::vector< uint8_t >() );
+    }
+}
+
+/**
+ * @brief Hands the response to a request to its callback and future
+ * @param request Request answered
+ * @param error Error code, negative if refused or unanswered
+ * @param message Message answering the request, empty if none
+ */
+void Venus638FLPx::complete( Request &request, int32_t error
+                             , std::vector< uint8_t > &&message )
+{
+    Response response;
+    response.error = error;
+    response.message = std::move( message );
+
+    if( request.callback ) {
+        request.callback( response );
+    }
+    request.promise.set_value( std::move( response ) );
+}
+
+/**
+ * @brief Logs the software version the device answered with
+ * @param response Response to the version query
+ */
+void Venus638FLPx::logVersion( const Response &response )
+{
+    const uint32_t idOffset = Message::start_sequence_length
+        + Message::payload_length;
+
+    if( response.error < 0 || response.message.size()
+            < idOffset + Message::SoftwareVersion::REVISION + 4 ) {
+        LOG_ERROR( "failed to query version" );
+        return;
+    }
+
+    const uint8_t *kernel = &response.message[ idOffset + Message::SoftwareVersion::KERNEL_VERSION ];
+    LOG_INFO( "Kernel Version: %02x.%02x.%02x"
+        , kernel[ 1 ], kernel[ 2 ], kernel[ 3 ] );
+    const uint8_t *odm = &response.message[ idOffset + Message::SoftwareVersion::ODM_VERSION ];
+    LOG_INFO( "   ODM Version: %02x.%02x.%02x"
+        , odm[ 1 ], odm[ 2 ], odm[ 3 ] );
+    const uint8_t *revision = &response.message[ idOffset + Message::SoftwareVersion::REVISION ];
+    LOG_INFO( "      Revision: %02x.%02x.%02x"
+        , revision[ 1 ], revision[ 2 ], revision[ 3 ] );
+}
+
+/**
+ * @brief Determines if the device answers at the interface speed. The version
+ * query is used since it changes nothing.
+ * @return Boolean indicating the device acknowledged the query
+ */
+bool Venus638FLPx::probe()
+{
+    uint8_t body = 0;
+    Message message( Message::Id::QUERY_SOFTWARE_VERSION, &body, 1 );
+
+    // Only the ACK is waited for, the version that follows is dropped
+    Response response = submit( message, Message::Id::NONE, probe_timeout ).get();
+    return response.error >= 0;
+}
+
+/**
+ * @brief Looks for the device at every baud rate it supports. The interface
+ * is left at the rate the device answered at, or as it was if it never did.
+ * @param speed Baud rate the device answered at
+ * @return Boolean indicating the device was found
+ */
+bool Venus638FLPx::detectBaud( Serial::Speed *speed )
+{
+    Serial::Speed original = static_cast< Serial::Speed >( mSerial->getInterfaceSpeed() );
+
+    // Faster rates first, they are what the device is usually left at
+    for( uint32_t i = device_speed_count; i > 0; i-- ) {
+        Serial::Speed candidate = device_speeds[ i - 1 ];
+        if( candidate == original ) {
+            continue;
+        }
+
+        mSerial->setInterfaceSpeed( candidate );
+        mSerial->applySettings();
+        if( probe() ) {
+            LOG_INFO( "device found at %u baud", static_cast< uint32_t >( candidate ) );
+            *speed = candidate;
+            return true;
+        }
+    }
+
+    mSerial->setInterfaceSpeed( original );
+    mSerial->applySettings();
+    return false;
+}
+
+/**
+ * @brief Determines if the output of every fix can be sent before the next
+ * @param output Output type
+ * @param rate Position update rate in Hz
+ * @param baud Baud rate
+ * @return Boolean indicating the output fits
+ */
+bool Venus638FLPx::fits( Output output, uint32_t rate, uint32_t baud )
+{
+    uint32_t size = 0;
+    if( output == Output::NMEA ) {
+        size = nmea_fix_size;
+    } else if( output == Output::BINARY ) {
+        size = binary_fix_size;
+    }
+
+    // Ten bits a byte with the start and stop bits
+    return static_cast< uint64_t >( size ) * 10 * rate <= baud;
+}
+
+/**
+ * @brief Decodes a navigation data message, fields are big endian
+ * @param data Payload of the message, from the message ID on
+ * @param navigation Navigation data
+ */
+void Venus638FLPx::decodeNavigation( const uint8_t *data, Navigation *navigation )
+{
+    navigation->fix = data[ 1 ];
+    navigation->satellites = data[ 2 ];
+    navigation->week = static_cast< uint16_t >( readBigEndian( &data[ 3 ], 2 ) );
+    navigation->timeOfWeek = readBigEndian( &data[ 5 ], 4 );
+    navigation->latitude = static_cast< int32_t >( readBigEndian( &data[ 9 ], 4 ) );
+    navigation->longitude = static_cast< int32_t >( readBigEndian( &data[ 13 ], 4 ) );
+    navigation->ellipsoidAltitude = static_cast< int32_t >( readBigEndian( &data[ 17 ], 4 ) );
+    navigation->altitude = static_cast< int32_t >( readBigEndian( &data[ 21 ], 4 ) );
+    navigation->gdop = static_cast< uint16_t >( readBigEndian( &data[ 25 ], 2 ) );
+    navigation->pdop = static_cast< uint16_t >( readBigEndian( &data[ 27 ], 2 ) );
+    navigation->hdop = static_cast< uint16_t >( readBigEndian( &data[ 29 ], 2 ) );
+    navigation->vdop = static_cast< uint16_t >( readBigEndian( &data[ 31 ], 2 ) );
+    navigation->tdop = static_cast< uint16_t >( readBigEndian( &data[ 33 ], 2 ) );
+    for( uint32_t i = 0; i < 3; i++ ) {
+        navigation->position[ i ] = static_cast< int32_t >(
+                    readBigEndian( &data[ 35 + i * 4 ], 4 ) );
+        navigation->velocity[ i ] = static_cast< int32_t >(
+                    readBigEndian( &data[ 47 + i * 4 ], 4 ) );
+    }
 }
 
 }
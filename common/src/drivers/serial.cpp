@@ -18,6 +18,7 @@ This is a licence-free software, it can be used by anyone who try to build a bet
 #include "common/drivers/serial.h"
 
 const uint32_t Serial::set_speed = 1 << 0;
+const int32_t Serial::read_timeout = 5000;
 
 /**
  * @brief Constructor
@@ -26,6 +27,8 @@ Serial::Serial( const char* interface , Speed speed, bool simulated )
     : mSimulated( simulated )
     , mFileDescriptor( -1 )
     , mSpeed( B0 )
+    , mReadHead( 0 )
+    , mReadTail( 0 )
 {
     // Add an interface name
     if( interface == nullptr || interface[ 0 ] == '\0' ) {
@@ -156,6 +159,12 @@ bool Serial::isInterfaceOpen()
  */
 void Serial::flushReceiver()
 {
+    {
+        std::lock_guard< std::mutex > lock( mMutex );
+        mReadHead = 0;
+        mReadTail = 0;
+    }
+
     if( tcflush( mFileDescriptor, TCIFLUSH ) < 0 ) {
         LOG_WARN( "%s: failed to flush receiver - %s"
             , mInterface, strerror( errno ) );
@@ -176,166 +185,259 @@ void Serial::flushTransmitter()
 
 /**
  * @brief Determine the number of bytes available on the receiver
- * @return int32_t bytes
+ * @return int32_t bytes, buffered ones included
  */
 int32_t Serial::availableBytes()
 {
     int32_t bytes = 0;
     ioctl( mFileDescriptor, FIONREAD, &bytes );
-    return bytes;
+
+    std::lock_guard< std::mutex > lock( mMutex );
+    return bytes + static_cast< int32_t >( mReadTail - mReadHead );
 }
 
 /**
- * @brief Read a byte from the interface
+ * @brief Read a byte from the interface, without waiting for one
  * @param buffer Buffer to store data
  * @return int32_t error code
  */
 int32_t Serial::readByte( uint8_t *buffer )
 {
-    int32_t error = 0;
-
-    mMutex.lock();
+    std::lock_guard< std::mutex > lock( mMutex );
 
-    if( read( mFileDescriptor, buffer, 1 ) != 1 ) {
-        error = -1;
+    if( mReadHead == mReadTail && fill( 0 ) <= 0 ) {
+        return -1;
     }
 
-    mMutex.unlock();
-
-    return error;
+    *buffer = mReadBuffer[ mReadHead++ ];
+    return 0;
 }
 
 /**
- * @brief Read several bytes from th interface
+ * @brief Read several bytes from the interface, waits up to read_timeout for
+ * all of them to arrive
  * @param buffer Buffer to store the data
- * @param size Size of the buffer to store the data
- * @return
+ * @param size Number of bytes to read
+ * @return int32_t number of bytes read, less than size on a timeout, negative
+ * on an error
  */
 int32_t Serial::readBytes( uint8_t *buffer, int32_t size )
 {
-    int32_t error = 0;
+    if( !isInterfaceOpen() ) {
+        return -1;
+    } else if( size <= 0 ) {
+        return 0;
+    }
 
-    int32_t bytesRead = 0;
+    std::lock_guard< std::mutex > lock( mMutex );
 
-    if( !isInterfaceOpen() ) {
-        error = -1;
-    } else {
-        mMutex.lock();
-        while( error > 0
-               && bytesRead < size ) {
+    uint32_t wanted = static_cast< uint32_t >( size );
+    uint32_t bytesRead = take( buffer, wanted );
 
-            FD_ZERO( &mFileDescriptorSet );
-            FD_SET( mFileDescriptor, &mFileDescriptorSet );
+    Timeout timer;
+    timer.init();
 
-            int32_t sel = select( FD_SETSIZE, &mFileDescriptorSet
-                , nullptr, nullptr, nullptr );
-            if( sel == 1 ) {
-                readByte( &buffer[ bytesRead++ ] );
-            }
+    while( bytesRead < wanted ) {
+        int32_t remaining = read_timeout - static_cast< int32_t >( timer.elapsedTime() );
+        if( remaining <= 0 ) {
+            break;
+        }
+
+        int32_t filled = fill( remaining );
+        if( filled < 0 ) {
+            LOG_ERROR( "%s: read error - %s", mInterface, strerror( errno ) );
+            return -1;
         }
-        mMutex.unlock();
+        bytesRead += take( &buffer[ bytesRead ], wanted - bytesRead );
     }
 
-    return error;
+    return static_cast< int32_t >( bytesRead );
 }
 
 /**
- * @brief Reads a specified pattern from the interface
+ * @brief Waits for data and reads as much of it as fits with a single read
+ * @param buffer Buffer to store the data
+ * @param size Size of the buffer
+ * @param timeout Time to wait for data in milliseconds
+ * @return int32_t number of bytes read, 0 on a timeout, negative on an error
+ */
+int32_t Serial::readAvailable( uint8_t *buffer, uint32_t size, int32_t timeout )
+{
+    if( !isInterfaceOpen() ) {
+        return -1;
+    }
+
+    std::lock_guard< std::mutex > lock( mMutex );
+
+    // Hand out what is buffered first, the caller will be back for more
+    if( mReadHead != mReadTail ) {
+        return static_cast< int32_t >( take( buffer, size ) );
+    }
+
+    pollfd descriptor = { mFileDescriptor, POLLIN, 0 };
+    int32_t ready = poll( &descriptor, 1, timeout );
+    if( ready < 0 ) {
+        return ( errno == EINTR ) ? 0 : -1;
+    } else if( ready == 0 ) {
+        return 0;
+    } else if( !( descriptor.revents & POLLIN ) ) {
+        // Hung up or failed with nothing left to read
+        return -1;
+    }
+
+    // The caller has a buffer of its own, read straight into it
+    ssize_t bytesRead = read( mFileDescriptor, buffer, size );
+    if( bytesRead < 0 ) {
+        return ( errno == EAGAIN || errno == EINTR ) ? 0 : -1;
+    }
+
+    return static_cast< int32_t >( bytesRead );
+}
+
+/**
+ * @brief Reads a specified pattern from the interface. Anything received
+ * before the start sequence is discarded.
  * @param start Start sequence
  * @param startSize Size of the start sequence
  * @param stop Stop sequence
  * @param stopSize Size of the stop sequence
- * @param buffer Buffer to store data
+ * @param buffer Buffer to store data, NUL terminated
  * @param bufferSize Size of the storage buffer
- * @return int32_t error code
+ * @return int32_t number of bytes stored, the pattern is cut short if it
+ * doesn't fit. Negative on an error or if no pattern arrived within
+ * read_timeout.
  */
-int32_t Serial::readPattern( 
+int32_t Serial::readPattern(
     const uint8_t *start, uint32_t startSize
     , const uint8_t *stop, uint32_t stopSize
     , uint8_t *buffer, uint32_t bufferSize )
 {
-    int32_t error = 0;
+    if( !isInterfaceOpen() || startSize == 0 || stopSize == 0 || bufferSize == 0 ) {
+        return -1;
+    }
 
-    bool startFound = false;
-    bool stopFound = false;
-    uint32_t startIncr = 0;
-    uint32_t stopIncr = 0;
-    uint32_t bytesRead = 0;
+    std::lock_guard< std::mutex > lock( mMutex );
 
     Timeout timer;
+    timer.init();
 
-    if( !isInterfaceOpen() ) {
-        error = -1;
-    } else {
-        timer.init();
-    }
+    bool startFound = false;
+    while( true ) {
+        uint8_t *data = &mReadBuffer[ mReadHead ];
+        uint32_t size = mReadTail - mReadHead;
+        uint32_t length = 0;
+
+        if( !startFound ) {
+            const uint8_t *found = static_cast< const uint8_t* >(
+                        memmem( data, size, start, startSize ) );
+            if( found != nullptr ) {
+                mReadHead += static_cast< uint32_t >( found - data );
+                startFound = true;
+                continue;
+            }
 
-    while( error >= 0
-           && timer.elapsedTime() <= 5000
-           && !stopFound
-           && ( bytesRead < bufferSize ) ) {
-
-        FD_ZERO( &mFileDescriptorSet );
-        FD_SET( mFileDescriptor, &mFileDescriptorSet );
-
-        timeval timeout = { 0, 10000 };
-        int32_t sel = select( FD_SETSIZE, &mFileDescriptorSet
-            , nullptr, nullptr, &timeout );
-
-        if( sel == 1 ) {
-            // Read a byte from the buffer
-            error = readByte( &buffer[ bytesRead ] );
-
-            if( error < 0 ) {
-                LOG_ERROR( "%s: read pattern error - %s"
-                           , mInterface, strerror( errno ) );
-            } else if( !startFound ) {
-                // The start byte hasn't been found, look for the start
-                if( buffer[ bytesRead ] == start[ startIncr ] ) {
-                    // Our current byte matches our start byte, increment both
-                    startIncr++;
-                    bytesRead++;
-                } else {
-                    // Our current byte does not match our start byte, reset the
-                    // increment and the bytes read
-                    startIncr = 0;
-                    bytesRead = 0;
-                }
-
-                if( startIncr == startSize ) {
-                    // We have matched all of our start bytes
-                    startFound = true;
-                }
-
-            } else {
-                // The start has been found, look for the stop
-                if( buffer[ bytesRead ] == stop[ stopIncr ] ) {
-                    // Our current byte matches our stop byte, increment both
-                    stopIncr++;
-                    bytesRead++;
-                } else {
-                    // Our current byte does not match our stop byte, reset
-                    // the increment
-                    stopIncr = 0;
-                    bytesRead++;
-                    /// @todo In some cases we may want to ignore empty bytes
-                    /// may need to come up with a separate method
-                    // if( buffer[ bytesRead ] != 0 ) {
-                    //     bytesRead++;
-                    // }
-                }
-
-                if( stopIncr == stopSize ) {
-                    // We have matched all of our stop bytes
-                    buffer[ bytesRead ] = '\0';
-                    stopFound = true;
-                }
+            // Keep what could be the beginning of a start sequence
+            if( size >= startSize ) {
+                mReadHead = mReadTail - ( startSize - 1 );
+            }
+        } else {
+            const uint8_t *found = nullptr;
+            if( size > startSize ) {
+                found = static_cast< const uint8_t* >(
+                            memmem( data + startSize, size - startSize
+                                    , stop, stopSize ) );
+            }
 
+            if( found != nullptr ) {
+                length = static_cast< uint32_t >( found - data ) + stopSize;
+            } else if( size >= bufferSize - 1 || size == SERIAL_READ_BUFFER_SIZE ) {
+                // The pattern won't fit, hand out as much as does
+                length = size;
             }
         }
+
+        if( length > 0 ) {
+            if( length > bufferSize - 1 ) {
+                length = bufferSize - 1;
+            }
+            memcpy( buffer, data, length );
+            buffer[ length ] = '\0';
+            mReadHead += length;
+            return static_cast< int32_t >( length );
+        }
+
+        int32_t remaining = read_timeout - static_cast< int32_t >( timer.elapsedTime() );
+        if( remaining <= 0 ) {
+            return -1;
+        }
+
+        if( fill( remaining ) < 0 ) {
+            LOG_ERROR( "%s: read pattern error - %s"
+                       , mInterface, strerror( errno ) );
+            return -1;
+        }
+    }
+}
+
+/**
+ * @brief Refills the read buffer with a single read of everything received,
+ * up to the space left. Must be called with the mutex held.
+ * @param timeout Time to wait for data in milliseconds, 0 to only take what
+ * has arrived already
+ * @return int32_t number of bytes added, 0 on a timeout, negative on an error
+ */
+int32_t Serial::fill( int32_t timeout )
+{
+    if( mReadHead == mReadTail ) {
+        mReadHead = 0;
+        mReadTail = 0;
+    } else if( mReadTail == SERIAL_READ_BUFFER_SIZE && mReadHead > 0 ) {
+        // Make room at the end
+        memmove( mReadBuffer, &mReadBuffer[ mReadHead ], mReadTail - mReadHead );
+        mReadTail -= mReadHead;
+        mReadHead = 0;
+    }
+
+    if( mReadTail == SERIAL_READ_BUFFER_SIZE ) {
+        return 0;
+    }
+
+    pollfd descriptor = { mFileDescriptor, POLLIN, 0 };
+    int32_t ready = poll( &descriptor, 1, timeout );
+    if( ready < 0 ) {
+        return ( errno == EINTR ) ? 0 : -1;
+    } else if( ready == 0 ) {
+        return 0;
+    } else if( !( descriptor.revents & POLLIN ) ) {
+        return -1;
+    }
+
+    ssize_t bytesRead = read( mFileDescriptor, &mReadBuffer[ mReadTail ]
+                              , SERIAL_READ_BUFFER_SIZE - mReadTail );
+    if( bytesRead < 0 ) {
+        return ( errno == EAGAIN || errno == EINTR ) ? 0 : -1;
+    }
+
+    mReadTail += static_cast< uint32_t >( bytesRead );
+    return static_cast< int32_t >( bytesRead );
+}
+
+/**
+ * @brief Hands out buffered bytes. Must be called with the mutex held.
+ * @param buffer Buffer to copy to
+ * @param size Size of the buffer
+ * @return uint32_t number of bytes copied
+ */
+uint32_t Serial::take( uint8_t *buffer, uint32_t size )
+{
+    uint32_t length = mReadTail - mReadHead;
+    if( length > size ) {
+        length = size;
     }
 
-    return ( error >= 0 ) ? static_cast< int32_t >( bytesRead ) : error;
+    memcpy( buffer, &mReadBuffer[ mReadHead ], length );
+    mReadHead += length;
+    return length;
 }
 
 /**
@@ -414,8 +516,9 @@ int32_t Serial::applySettings()
         tty.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN );
         tty.c_oflag &= ~OPOST;
 
-        tty.c_cc[ VTIME ] = 1;          // Timeout unused
-        tty.c_cc[ VMIN ] = 1;           // At least on character before satisfy reading
+        // Reads return whatever has arrived, poll() does the waiting
+        tty.c_cc[ VTIME ] = 0;
+        tty.c_cc[ VMIN ] = 0;
 
         // Activate mOptions
         error = tcsetattr( mFileDescriptor, TCSANOW, &tty );
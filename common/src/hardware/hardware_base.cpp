@@ -1,7 +1,19 @@
 #include "common/hardware/hardware_base.h"
+#include "common/command/command_gpio.h"
+#include "common/command/command_heartbeat.h"
+#include "common/command/command_led.h"
 
 bool HardwareBase::mSimulated = false;
 
+// Events go to unauthenticated subscribers and are replayed to later ones.
+// Only state changes are listed, parameters like credentials never leave.
+const HardwareBase::EventFilter HardwareBase::event_filters[] = {
+    { COMMAND_HEARTBEAT, { PARAM_ENABLE, nullptr } }
+    , { COMMAND_GPIO, { PARAM_BANK, PARAM_PIN, PARAM_OUTPUT, PARAM_DIR, nullptr } }
+    , { COMMAND_LED, { PARAM_ID, PARAM_ENABLE, nullptr } }
+    , { nullptr, { nullptr } }
+};
+
 bool HardwareBase::isSimulated()
 {
     return mSimulated;
@@ -46,7 +58,56 @@ void HardwareBase::addCommand( Command *cmd )
     mCommandHandler.addCommand( cmd );
 }
 
+/**
+ * @brief Starts serving requests. Call once every command has been added and
+ * the command handler frozen.
+ */
+void HardwareBase::start()
+{
+
+}
+
 Transport::Client *HardwareBase::getClient()
 {
     return nullptr;
 }
+
+/**
+ * @brief Creates the event streamed for a mutator that succeeded. Only the
+ * listed parameters of listed mutators are copied.
+ * @param command Mutator name
+ * @param params Parameters the mutator was given
+ * @return Event data to be deleted by the caller, null if the change isn't
+ * streamed
+ */
+cJSON *HardwareBase::createEvent( const char *command, cJSON *params )
+{
+    if( command == nullptr || !cJSON_IsObject( params ) ) {
+        return nullptr;
+    }
+
+    const EventFilter *filter = event_filters;
+    for( ; filter->command != nullptr; filter++ ) {
+        if( strcmp( filter->command, command ) == 0 ) {
+            break;
+        }
+    }
+    if( filter->command == nullptr ) {
+        return nullptr;
+    }
+
+    cJSON *event = cJSON_CreateObject();
+    for( const char * const *param = filter->params; *param != nullptr; param++ ) {
+        cJSON *value = cJSON_GetObjectItem( params, *param );
+        if( value != nullptr ) {
+            cJSON_AddItemToObject( event, *param, cJSON_Duplicate( value, false ) );
+        }
+    }
+
+    // Nothing listed changed
+    if( event->child == nullptr ) {
+        cJSON_Delete( event );
+        event = nullptr;
+    }
+    return event;
+}
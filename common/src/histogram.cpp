@@ -0,0 +1,173 @@
+#include "common/histogram.h"
+
+// Hands each thread the next shard in turn the first time it records
+static std::atomic< uint32_t > next_shard( 0 );
+
+/**
+ * @brief Constructor, starts timing
+ * @param histogram Histogram to record the time into
+ */
+Histogram::Scope::Scope( Histogram *histogram )
+    : mHistogram( histogram )
+    , mStart( Clock::now() )
+{
+
+}
+
+/**
+ * @brief Destructor, records the time elapsed since construction
+ */
+Histogram::Scope::~Scope()
+{
+    mHistogram->record( static_cast< uint64_t >(
+            std::chrono::duration_cast< std::chrono::nanoseconds >(
+                Clock::now() - mStart ).count() ) );
+}
+
+/**
+ * @brief Retrieves the smallest value at or below which the given share of
+ * the recorded values lie
+ * @param percentile Share of the values, from 0 to 100
+ * @return Upper limit of the bucket holding that value, never above the
+ * largest value recorded, 0 if nothing was recorded
+ */
+uint64_t Histogram::Snapshot::getPercentile( double percentile ) const
+{
+    if( count == 0 ) {
+        return 0;
+    }
+
+    uint64_t rank = static_cast< uint64_t >( percentile * count / 100.0 + 0.5 );
+    if( rank < 1 ) {
+        rank = 1;
+    } else if( rank > count ) {
+        rank = count;
+    }
+
+    uint64_t seen = 0;
+    for( uint32_t i = 0; i < bucket_count; i++ ) {
+        seen += buckets[ i ];
+        if( seen >= rank ) {
+            uint64_t limit = getBucketLimit( i );
+            return ( limit < max ) ? limit : max;
+        }
+    }
+
+    return max;
+}
+
+/**
+ * @brief Constructor
+ */
+Histogram::Histogram()
+{
+    for( uint32_t s = 0; s < shard_count; s++ ) {
+        Shard &shard = mShards[ s ];
+        for( uint32_t i = 0; i < bucket_count; i++ ) {
+            shard.buckets[ i ].store( 0, std::memory_order_relaxed );
+        }
+        shard.sum.store( 0, std::memory_order_relaxed );
+        shard.max.store( 0, std::memory_order_relaxed );
+    }
+}
+
+/**
+ * @brief Records a value into the calling thread's shard
+ * @param value Value to record, nanoseconds for latencies
+ */
+void Histogram::record( uint64_t value )
+{
+    Shard &shard = mShards[ getShard() ];
+
+    shard.buckets[ getBucket( value ) ].fetch_add( 1, std::memory_order_relaxed );
+    shard.sum.fetch_add( value, std::memory_order_relaxed );
+
+    uint64_t max = shard.max.load( std::memory_order_relaxed );
+    while( value > max
+           && !shard.max.compare_exchange_weak( max, value
+                                                , std::memory_order_relaxed ) ) {
+    }
+}
+
+/**
+ * @brief Sums the shards. Values recorded while this runs may or may not be
+ * included.
+ * @param snapshot Snapshot to fill in
+ */
+void Histogram::snapshot( Snapshot *snapshot )
+{
+    snapshot->count = 0;
+    snapshot->sum = 0;
+    snapshot->max = 0;
+    for( uint32_t i = 0; i < bucket_count; i++ ) {
+        snapshot->buckets[ i ] = 0;
+    }
+
+    for( uint32_t s = 0; s < shard_count; s++ ) {
+        Shard &shard = mShards[ s ];
+        for( uint32_t i = 0; i < bucket_count; i++ ) {
+            snapshot->buckets[ i ] += shard.buckets[ i ].load( std::memory_order_relaxed );
+        }
+        snapshot->sum += shard.sum.load( std::memory_order_relaxed );
+
+        uint64_t max = shard.max.load( std::memory_order_relaxed );
+        if( max > snapshot->max ) {
+            snapshot->max = max;
+        }
+    }
+
+    // Counting the buckets keeps the percentiles consistent with the count,
+    // even with a record in flight
+    for( uint32_t i = 0; i < bucket_count; i++ ) {
+        snapshot->count += snapshot->buckets[ i ];
+    }
+}
+
+/**
+ * @brief Finds the bucket a value falls in. Values below the sub bucket count
+ * get a bucket each, every power of two above is split in sub_bucket_count.
+ * @param value Value
+ * @return Bucket index, values past the range land in the last bucket
+ */
+uint32_t Histogram::getBucket( uint64_t value )
+{
+    if( value < sub_bucket_count ) {
+        return static_cast< uint32_t >( value );
+    }
+
+    uint32_t msb = 63 - static_cast< uint32_t >( __builtin_clzll( value ) );
+    if( msb >= max_value_bits ) {
+        return bucket_count - 1;
+    }
+
+    uint32_t shift = msb - sub_bucket_bits;
+    return ( shift + 1 ) * sub_bucket_count
+            + static_cast< uint32_t >( ( value >> shift ) & ( sub_bucket_count - 1 ) );
+}
+
+/**
+ * @brief Retrieves the largest value that falls in a bucket
+ * @param bucket Bucket index
+ * @return Largest value of the bucket
+ */
+uint64_t Histogram::getBucketLimit( uint32_t bucket )
+{
+    if( bucket < sub_bucket_count ) {
+        return bucket;
+    }
+
+    uint32_t shift = bucket / sub_bucket_count - 1;
+    uint64_t sub = sub_bucket_count + bucket % sub_bucket_count;
+    return ( ( sub + 1 ) << shift ) - 1;
+}
+
+/**
+ * @brief Retrieves the shard of the calling thread
+ * @return Shard index
+ */
+uint32_t Histogram::getShard()
+{
+    static thread_local uint32_t shard
+            = next_shard.fetch_add( 1, std::memory_order_relaxed ) % shard_count;
+    return shard;
+}
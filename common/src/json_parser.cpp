@@ -0,0 +1,700 @@
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( USE_SIMD_JSON )
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#include <arm_neon.h>
+#endif
+#endif
+
+#include "common/json_parser.h"
+
+/**
+ * @brief Parses a null terminated JSON string
+ * @param data JSON string
+ * @return Root of the parsed tree to be released with cJSON_Delete(), nullptr
+ * if the string isn't valid JSON
+ */
+cJSON *JsonParser::parse( const char *data )
+{
+    if( data == nullptr ) {
+        return nullptr;
+    }
+
+    return parse( data, strlen( data ) );
+}
+
+#if !defined( USE_SIMD_JSON )
+
+/**
+ * @brief Parses JSON, handed straight to cJSON
+ * @param data JSON data, must be null terminated
+ * @param size Size of the data, unused
+ * @return Root of the parsed tree to be released with cJSON_Delete(), nullptr
+ * if the data isn't valid JSON
+ */
+cJSON *JsonParser::parse( const char *data, size_t size )
+{
+    (void)size;
+    return cJSON_Parse( data );
+}
+
+#else
+
+namespace
+{
+
+struct Classes {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t structural;
+    uint64_t whitespace;
+};
+
+#if defined( __SSE2__ )
+
+/**
+ * @brief Classifies 16 bytes
+ * @param data Data to classify
+ * @param shift Position of the bytes within the block
+ * @param classes Masks the bytes are added to
+ */
+inline void classify16( const char *data, uint32_t shift, Classes *classes )
+{
+    const __m128i v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( data ) );
+    const __m128i space = _mm_set1_epi8( ' ' );
+
+    // Setting bit 5 folds '[' onto '{' and ']' onto '}'
+    const __m128i folded = _mm_or_si128( v, space );
+    __m128i structural = _mm_or_si128(
+                _mm_cmpeq_epi8( folded, _mm_set1_epi8( '{' ) )
+                , _mm_cmpeq_epi8( folded, _mm_set1_epi8( '}' ) ) );
+    structural = _mm_or_si128( structural, _mm_cmpeq_epi8( v, _mm_set1_epi8( ':' ) ) );
+    structural = _mm_or_si128( structural, _mm_cmpeq_epi8( v, _mm_set1_epi8( ',' ) ) );
+
+    // cJSON skips every control character as whitespace, so does this
+    const __m128i whitespace = _mm_cmpeq_epi8( _mm_max_epu8( v, space ), space );
+
+    classes->quote |= static_cast< uint64_t >( static_cast< uint32_t >(
+                _mm_movemask_epi8( _mm_cmpeq_epi8( v, _mm_set1_epi8( '"' ) ) ) ) ) << shift;
+    classes->backslash |= static_cast< uint64_t >( static_cast< uint32_t >(
+                _mm_movemask_epi8( _mm_cmpeq_epi8( v, _mm_set1_epi8( '\\' ) ) ) ) ) << shift;
+    classes->structural |= static_cast< uint64_t >( static_cast< uint32_t >(
+                _mm_movemask_epi8( structural ) ) ) << shift;
+    classes->whitespace |= static_cast< uint64_t >( static_cast< uint32_t >(
+                _mm_movemask_epi8( whitespace ) ) ) << shift;
+}
+
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+
+/**
+ * @brief Gathers the top bit of each byte into a mask, NEON has no movemask
+ * @param v Comparison result, each byte all ones or all zeros
+ * @return One bit per byte
+ */
+inline uint64_t movemask( uint8x16_t v )
+{
+    static const uint8_t bits[ 16 ] = {
+        1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128
+    };
+
+    // Pairwise adds only, so this works on ARMv7 as well as AArch64
+    uint8x16_t masked = vandq_u8( v, vld1q_u8( bits ) );
+    uint8x8_t sum = vpadd_u8( vget_low_u8( masked ), vget_high_u8( masked ) );
+    sum = vpadd_u8( sum, sum );
+    sum = vpadd_u8( sum, sum );
+
+    return static_cast< uint64_t >( vget_lane_u8( sum, 0 ) )
+            | ( static_cast< uint64_t >( vget_lane_u8( sum, 1 ) ) << 8 );
+}
+
+/**
+ * @brief Classifies 16 bytes
+ * @param data Data to classify
+ * @param shift Position of the bytes within the block
+ * @param classes Masks the bytes are added to
+ */
+inline void classify16( const char *data, uint32_t shift, Classes *classes )
+{
+    const uint8x16_t v = vld1q_u8( reinterpret_cast< const uint8_t* >( data ) );
+    const uint8x16_t space = vdupq_n_u8( ' ' );
+
+    // Setting bit 5 folds '[' onto '{' and ']' onto '}'
+    const uint8x16_t folded = vorrq_u8( v, space );
+    uint8x16_t structural = vorrq_u8(
+                vceqq_u8( folded, vdupq_n_u8( '{' ) )
+                , vceqq_u8( folded, vdupq_n_u8( '}' ) ) );
+    structural = vorrq_u8( structural, vceqq_u8( v, vdupq_n_u8( ':' ) ) );
+    structural = vorrq_u8( structural, vceqq_u8( v, vdupq_n_u8( ',' ) ) );
+
+    // cJSON skips every control character as whitespace, so does this
+    const uint8x16_t whitespace = vcleq_u8( v, space );
+
+    classes->quote      |= movemask( vceqq_u8( v, vdupq_n_u8( '"' ) ) ) << shift;
+    classes->backslash  |= movemask( vceqq_u8( v, vdupq_n_u8( '\\' ) ) ) << shift;
+    classes->structural |= movemask( structural ) << shift;
+    classes->whitespace |= movemask( whitespace ) << shift;
+}
+
+#endif
+
+/**
+ * @brief Classifies every byte of a block
+ * @param block Block of 64 bytes
+ * @param classes Masks to fill in, bit n describes byte n
+ */
+inline void classify( const char *block, Classes *classes )
+{
+    classes->quote      = 0;
+    classes->backslash  = 0;
+    classes->structural = 0;
+    classes->whitespace = 0;
+
+#if defined( __SSE2__ ) || defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+    classify16( block, 0, classes );
+    classify16( block + 16, 16, classes );
+    classify16( block + 32, 32, classes );
+    classify16( block + 48, 48, classes );
+#else
+    for( uint32_t i = 0; i < 64; i++ ) {
+        const unsigned char c = static_cast< unsigned char >( block[ i ] );
+        const uint64_t bit = 1ULL << i;
+        switch( c ) {
+        case '"':  classes->quote |= bit; break;
+        case '\\': classes->backslash |= bit; break;
+        case '{': case '}': case '[': case ']': case ':': case ',':
+            classes->structural |= bit;
+            break;
+        default:
+            if( c <= ' ' ) {
+                classes->whitespace |= bit;
+            }
+            break;
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Turns each set bit into the start of a run that lasts until the next
+ * set bit, which is exactly the inside of each string given its quotes
+ * @param bits Quote mask
+ * @return Running XOR of the mask
+ */
+inline uint64_t prefixXor( uint64_t bits )
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// Scratch memory for the index and the nesting stack, kept by each thread
+// between parses. Taking a fresh block for every parse costs more than the
+// scan itself once the heap is busy with the tree's small allocations.
+struct Scratch {
+    char *memory;
+    size_t size;
+
+    ~Scratch() { free( memory ); }
+};
+
+thread_local Scratch scratch = { nullptr, 0 };
+
+// Scratch larger than this is released after the parse that needed it
+const size_t max_scratch_size = 256 * 1024;
+
+}
+
+/**
+ * @brief Parses JSON into a cJSON tree. The input is scanned into an index of
+ * structural positions, then the tree is built from that index.
+ * @param data JSON data
+ * @param size Size of the data, stops at the first null the same as cJSON
+ * @return Root of the parsed tree to be released with cJSON_Delete(), nullptr
+ * if the data isn't valid JSON
+ */
+cJSON *JsonParser::parse( const char *data, size_t size )
+{
+    if( data == nullptr || size >= UINT32_MAX ) {
+        return nullptr;
+    }
+
+    const char *end = static_cast< const char* >( memchr( data, '\0', size ) );
+    if( end != nullptr ) {
+        size = static_cast< size_t >( end - data );
+    }
+
+    // Every byte could be a structural and nesting can't go deeper than the
+    // number of bytes
+    size_t indexSize = ( ( size + 1 ) * sizeof( uint32_t ) + sizeof( Frame ) - 1 )
+            & ~( sizeof( Frame ) - 1 );
+    size_t depth = ( size < max_depth ) ? size + 1 : max_depth + 1;
+    size_t needed = indexSize + depth * sizeof( Frame );
+    if( scratch.size < needed ) {
+        free( scratch.memory );
+        scratch.size   = 0;
+        scratch.memory = static_cast< char* >( malloc( needed ) );
+        if( scratch.memory == nullptr ) {
+            return nullptr;
+        }
+        scratch.size = needed;
+    }
+
+    uint32_t *indices = reinterpret_cast< uint32_t* >( scratch.memory );
+    Frame *stack = reinterpret_cast< Frame* >( scratch.memory + indexSize );
+    uint32_t count = 0;
+
+    cJSON *root = nullptr;
+    if( scan( data, size, indices, &count ) ) {
+        root = build( data, size, indices, count, stack );
+    }
+
+    if( scratch.size > max_scratch_size ) {
+        free( scratch.memory );
+        scratch.memory = nullptr;
+        scratch.size   = 0;
+    }
+
+    return root;
+}
+
+/**
+ * @brief Scans the data for the position of every structural character, every
+ * unescaped quote and the first character of every scalar outside a string
+ * @param data JSON data
+ * @param size Size of the data
+ * @param indices Positions found, room for one more than the size
+ * @param count Number of positions found
+ * @return Boolean indicating every string was closed
+ */
+bool JsonParser::scan( const char *data, size_t size
+                       , uint32_t *indices, uint32_t *count )
+{
+    Scanner scanner = { 0, 0, 0 };
+    uint32_t found = 0;
+
+    for( size_t base = 0; base < size; base += block_size ) {
+        uint64_t bits = 0;
+        if( size - base >= block_size ) {
+            bits = scanBlock( &scanner, data + base );
+        } else {
+            // Pad the tail with whitespace, it never shows up in the index
+            char block[ block_size ];
+            memset( block, ' ', block_size );
+            memcpy( block, data + base, size - base );
+            bits = scanBlock( &scanner, block );
+        }
+
+        while( bits != 0 ) {
+            indices[ found++ ] = static_cast< uint32_t >(
+                        base + static_cast< size_t >( __builtin_ctzll( bits ) ) );
+            bits &= bits - 1;
+        }
+    }
+
+    *count = found;
+    return scanner.inString == 0;
+}
+
+/**
+ * @brief Scans one block, carrying escapes, strings and scalars that run past
+ * its end over to the next block
+ * @param scanner State carried between blocks
+ * @param block Block of 64 bytes
+ * @return Mask of the positions to index
+ */
+uint64_t JsonParser::scanBlock( Scanner *scanner, const char *block )
+{
+    static const uint64_t even_bits = 0x5555555555555555ULL;
+    static const uint64_t odd_bits  = ~even_bits;
+
+    Classes classes;
+    classify( block, &classes );
+
+    // A character is escaped when it follows an odd length run of backslashes.
+    // Adding the start of each run to the run carries a bit out past its end,
+    // whether that lands on an odd or even position gives the run's parity.
+    const uint64_t backslash = classes.backslash;
+    const uint64_t starts = backslash & ~( backslash << 1 );
+    const uint64_t evenStartMask = even_bits ^ scanner->escaped;
+    const uint64_t evenStarts = starts & evenStartMask;
+    const uint64_t oddStarts = starts & ~evenStartMask;
+
+    const uint64_t evenCarries = backslash + evenStarts;
+    uint64_t oddCarries = backslash + oddStarts;
+    const uint64_t overflow = ( oddCarries < backslash ) ? 1 : 0;
+    oddCarries |= scanner->escaped;
+    scanner->escaped = overflow;
+
+    const uint64_t escaped = ( evenCarries & ~backslash & odd_bits )
+            | ( oddCarries & ~backslash & even_bits );
+
+    // Opening quotes and everything up to the closing quote are in a string
+    const uint64_t quote = classes.quote & ~escaped;
+    const uint64_t inString = prefixXor( quote ) ^ scanner->inString;
+    scanner->inString = 0ULL - ( inString >> 63 );
+
+    // Scalars are whatever is left outside strings, only their first
+    // character is indexed
+    const uint64_t scalar = ~( classes.structural | classes.whitespace | quote )
+            & ~inString;
+    const uint64_t scalarStarts = scalar & ~( ( scalar << 1 ) | scanner->scalar );
+    scanner->scalar = scalar >> 63;
+
+    return ( classes.structural & ~inString ) | quote | scalarStarts;
+}
+
+/**
+ * @brief Builds the tree by walking the index. Strings take two entries, their
+ * opening and closing quotes.
+ * @param data JSON data
+ * @param size Size of the data
+ * @param indices Positions found by scan()
+ * @param count Number of positions
+ * @param stack Open objects and arrays, room for the nesting limit
+ * @return Root of the tree, nullptr if the data isn't valid JSON
+ */
+cJSON *JsonParser::build( const char *data, size_t size
+                          , const uint32_t *indices, uint32_t count
+                          , Frame *stack )
+{
+    cJSON *root = nullptr;
+    char *key = nullptr;
+    uint32_t depth = 0;
+    uint32_t i = 0;
+
+    // Links an item under the innermost object or array, or makes it the root
+    auto attach = [ & ]( cJSON *item ) {
+        if( depth == 0 ) {
+            root = item;
+            return;
+        }
+
+        Frame &frame = stack[ depth - 1 ];
+        if( frame.tail == nullptr ) {
+            frame.item->child = item;
+        } else {
+            frame.tail->next = item;
+            item->prev = frame.tail;
+        }
+        frame.tail = item;
+
+        if( key != nullptr ) {
+            item->string = key;
+            key = nullptr;
+        }
+    };
+
+    // Parses the string whose opening quote is at i, nullptr on failure
+    auto nextString = [ & ]() -> char* {
+        if( i + 1 >= count ) {
+            return nullptr;
+        }
+        char *s = parseString( data, indices[ i ], indices[ i + 1 ] );
+        i += 2;
+        return s;
+    };
+
+    // Each pass handles one value followed by whatever closes or separates it
+    while( i < count ) {
+        const char c = data[ indices[ i ] ];
+        cJSON *item = nullptr;
+
+        if( c == '{' || c == '[' ) {
+            if( depth >= max_depth ) {
+                break;
+            }
+
+            item = ( c == '{' ) ? cJSON_CreateObject() : cJSON_CreateArray();
+            if( item == nullptr ) {
+                break;
+            }
+
+            attach( item );
+            stack[ depth ].item = item;
+            stack[ depth ].tail = nullptr;
+            depth++;
+            i++;
+
+            const char close = ( c == '{' ) ? '}' : ']';
+            if( i < count && data[ indices[ i ] ] == close ) {
+                // Empty, carries on with whatever follows it
+                depth--;
+                i++;
+            } else if( c == '[' ) {
+                continue;
+            } else {
+                // The first key of the object
+                if( i >= count || data[ indices[ i ] ] != '"' ) {
+                    break;
+                }
+                key = nextString();
+                if( key == nullptr || i >= count || data[ indices[ i ] ] != ':' ) {
+                    break;
+                }
+                i++;
+                continue;
+            }
+        } else if( c == '"' ) {
+            char *s = nextString();
+            if( s == nullptr ) {
+                break;
+            }
+
+            item = cJSON_CreateNull();
+            if( item == nullptr ) {
+                cJSON_free( s );
+                break;
+            }
+            item->type = cJSON_String;
+            item->valuestring = s;
+            attach( item );
+        } else {
+            const uint32_t next = ( i + 1 < count )
+                    ? indices[ i + 1 ] : static_cast< uint32_t >( size );
+            if( !parseScalar( data, indices[ i ], next, &item ) ) {
+                break;
+            }
+            attach( item );
+            i++;
+        }
+
+        // Close every object and array that ends here, then expect either the
+        // next value or the next key
+        bool separated = false;
+        while( depth > 0 && i < count ) {
+            const Frame &frame = stack[ depth - 1 ];
+            const char n = data[ indices[ i ] ];
+            if( n == ',' ) {
+                separated = true;
+                i++;
+                break;
+            }
+
+            if( n != ( ( frame.item->type == cJSON_Object ) ? '}' : ']' ) ) {
+                break;
+            }
+
+            depth--;
+            i++;
+        }
+
+        if( depth == 0 ) {
+            // Only whitespace may follow the root
+            if( i == count ) {
+                cJSON_free( key );
+                return root;
+            }
+            break;
+        }
+
+        if( !separated ) {
+            break;
+        }
+
+        if( stack[ depth - 1 ].item->type == cJSON_Object ) {
+            if( i >= count || data[ indices[ i ] ] != '"' ) {
+                break;
+            }
+            key = nextString();
+            if( key == nullptr || i >= count || data[ indices[ i ] ] != ':' ) {
+                break;
+            }
+            i++;
+        }
+    }
+
+    cJSON_free( key );
+    cJSON_Delete( root );
+    return nullptr;
+}
+
+/**
+ * @brief Copies a string out of the data, resolving escapes the way cJSON does
+ * @param data JSON data
+ * @param open Position of the opening quote
+ * @param close Position of the closing quote
+ * @return String allocated with cJSON_malloc(), nullptr if an escape is invalid
+ */
+char *JsonParser::parseString( const char *data, uint32_t open, uint32_t close )
+{
+    if( data[ open ] != '"' || data[ close ] != '"' || close <= open ) {
+        return nullptr;
+    }
+
+    // Escapes only ever shrink the string
+    char *string = static_cast< char* >( cJSON_malloc( close - open ) );
+    if( string == nullptr ) {
+        return nullptr;
+    }
+
+    // Reads four hex digits, cJSON takes anything else as zero but that lets
+    // the escape swallow whatever follows so it's rejected here
+    auto hex4 = []( const char *in, uint32_t *value ) -> bool {
+        *value = 0;
+        for( uint32_t n = 0; n < 4; n++ ) {
+            const char h = in[ n ];
+            *value <<= 4;
+            if( h >= '0' && h <= '9' ) {
+                *value |= static_cast< uint32_t >( h - '0' );
+            } else if( h >= 'a' && h <= 'f' ) {
+                *value |= static_cast< uint32_t >( h - 'a' + 10 );
+            } else if( h >= 'A' && h <= 'F' ) {
+                *value |= static_cast< uint32_t >( h - 'A' + 10 );
+            } else {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    const char *in = data + open + 1;
+    const char *end = data + close;
+    char *out = string;
+
+    while( in < end ) {
+        // Copy everything up to the next escape in one go
+        const char *escape = static_cast< const char* >(
+                    memchr( in, '\\', static_cast< size_t >( end - in ) ) );
+        const char *run = ( escape != nullptr ) ? escape : end;
+        memcpy( out, in, static_cast< size_t >( run - in ) );
+        out += run - in;
+        in = run;
+        if( in == end ) {
+            break;
+        }
+
+        if( end - in < 2 ) {
+            cJSON_free( string );
+            return nullptr;
+        }
+
+        switch( in[ 1 ] ) {
+        case 'b': *out++ = '\b'; in += 2; break;
+        case 'f': *out++ = '\f'; in += 2; break;
+        case 'n': *out++ = '\n'; in += 2; break;
+        case 'r': *out++ = '\r'; in += 2; break;
+        case 't': *out++ = '\t'; in += 2; break;
+        case '"':
+        case '\\':
+        case '/':
+            *out++ = in[ 1 ];
+            in += 2;
+            break;
+        case 'u': {
+            if( end - in < 6 ) {
+                cJSON_free( string );
+                return nullptr;
+            }
+
+            uint32_t codepoint = 0;
+            const bool valid = hex4( in + 2, &codepoint );
+            in += 6;
+            if( !valid || ( codepoint >= 0xDC00 && codepoint <= 0xDFFF ) ) {
+                cJSON_free( string );
+                return nullptr;
+            }
+
+            if( codepoint >= 0xD800 && codepoint <= 0xDBFF ) {
+                // The second half of a surrogate pair has to follow
+                if( end - in < 6 || in[ 0 ] != '\\' || in[ 1 ] != 'u' ) {
+                    cJSON_free( string );
+                    return nullptr;
+                }
+
+                uint32_t low = 0;
+                const bool pair = hex4( in + 2, &low );
+                in += 6;
+                if( !pair || low < 0xDC00 || low > 0xDFFF ) {
+                    cJSON_free( string );
+                    return nullptr;
+                }
+                codepoint = 0x10000 + ( ( ( codepoint & 0x3FF ) << 10 ) | ( low & 0x3FF ) );
+            }
+
+            if( codepoint < 0x80 ) {
+                *out++ = static_cast< char >( codepoint );
+            } else if( codepoint < 0x800 ) {
+                *out++ = static_cast< char >( 0xC0 | ( codepoint >> 6 ) );
+                *out++ = static_cast< char >( 0x80 | ( codepoint & 0x3F ) );
+            } else if( codepoint < 0x10000 ) {
+                *out++ = static_cast< char >( 0xE0 | ( codepoint >> 12 ) );
+                *out++ = static_cast< char >( 0x80 | ( ( codepoint >> 6 ) & 0x3F ) );
+                *out++ = static_cast< char >( 0x80 | ( codepoint & 0x3F ) );
+            } else {
+                *out++ = static_cast< char >( 0xF0 | ( codepoint >> 18 ) );
+                *out++ = static_cast< char >( 0x80 | ( ( codepoint >> 12 ) & 0x3F ) );
+                *out++ = static_cast< char >( 0x80 | ( ( codepoint >> 6 ) & 0x3F ) );
+                *out++ = static_cast< char >( 0x80 | ( codepoint & 0x3F ) );
+            }
+            break;
+        }
+        default:
+            cJSON_free( string );
+            return nullptr;
+        }
+    }
+
+    *out = '\0';
+    return string;
+}
+
+/**
+ * @brief Parses a number, true, false or null
+ * @param data JSON data
+ * @param start Position of the first character
+ * @param end Position of whatever follows, only whitespace lies in between
+ * @param item Parsed item
+ * @return Boolean indicating the scalar is valid
+ */
+bool JsonParser::parseScalar( const char *data, uint32_t start, uint32_t end
+                              , cJSON **item )
+{
+    const char *token = data + start;
+    size_t length = 0;
+    while( start + length < end
+           && static_cast< unsigned char >( token[ length ] ) > ' ' ) {
+        length++;
+    }
+
+    if( length == 4 && memcmp( token, "true", 4 ) == 0 ) {
+        *item = cJSON_CreateTrue();
+    } else if( length == 5 && memcmp( token, "false", 5 ) == 0 ) {
+        *item = cJSON_CreateFalse();
+    } else if( length == 4 && memcmp( token, "null", 4 ) == 0 ) {
+        *item = cJSON_CreateNull();
+    } else if( token[ 0 ] == '-' || ( token[ 0 ] >= '0' && token[ 0 ] <= '9' ) ) {
+        // Same character set and length limit as cJSON, strtod alone would
+        // also take hex, inf and nan
+        char number[ 64 ];
+        if( length >= sizeof( number ) ) {
+            return false;
+        }
+        for( size_t n = 0; n < length; n++ ) {
+            if( strchr( "0123456789+-eE.", token[ n ] ) == nullptr ) {
+                return false;
+            }
+        }
+        memcpy( number, token, length );
+        number[ length ] = '\0';
+
+        char *after = nullptr;
+        const double value = strtod( number, &after );
+        if( after != number + length ) {
+            return false;
+        }
+        *item = cJSON_CreateNumber( value );
+    } else {
+        return false;
+    }
+
+    return *item != nullptr;
+}
+
+#endif
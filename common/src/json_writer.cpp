@@ -0,0 +1,351 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/json_writer.h"
+
+/**
+ * @brief Constructor
+ * @param buffer Buffer the JSON is appended to
+ */
+JsonWriter::JsonWriter( Buffer *buffer )
+    : mBuffer( buffer )
+    , mDepth( 0 )
+    , mAfterKey( false )
+    , mFailed( buffer == nullptr )
+{
+}
+
+/**
+ * @brief Opens an object
+ */
+void JsonWriter::beginObject()
+{
+    push( '{' );
+}
+
+/**
+ * @brief Closes the innermost object
+ */
+void JsonWriter::endObject()
+{
+    pop( '}' );
+}
+
+/**
+ * @brief Opens an array
+ */
+void JsonWriter::beginArray()
+{
+    push( '[' );
+}
+
+/**
+ * @brief Closes the innermost array
+ */
+void JsonWriter::endArray()
+{
+    pop( ']' );
+}
+
+/**
+ * @brief Writes the key of the next value in an object
+ * @param name Key
+ */
+void JsonWriter::key( const char *name )
+{
+    separate();
+    appendString( name );
+    append( ":", 1 );
+    mAfterKey = true;
+}
+
+/**
+ * @brief Writes a string value
+ * @param string Null terminated string, nullptr writes null
+ */
+void JsonWriter::value( const char *string )
+{
+    separate();
+    if( string == nullptr ) {
+        append( "null", 4 );
+    } else {
+        appendString( string );
+    }
+}
+
+/**
+ * @brief Writes a number the way cJSON prints it, integral values without a
+ * fraction and everything else with just enough digits to read back the same
+ * @param number Number
+ */
+void JsonWriter::value( double number )
+{
+    char text[ 32 ];
+    int length = 0;
+
+    if( isnan( number ) || isinf( number ) ) {
+        separate();
+        append( "null", 4 );
+        return;
+    }
+
+    if( number == floor( number ) && fabs( number ) < 1e15 ) {
+        value( static_cast< int64_t >( number ) );
+        return;
+    }
+
+    length = snprintf( text, sizeof( text ), "%1.15g", number );
+    if( strtod( text, nullptr ) != number ) {
+        length = snprintf( text, sizeof( text ), "%1.17g", number );
+    }
+
+    separate();
+    append( text, static_cast< size_t >( length ) );
+}
+
+/**
+ * @brief Writes an integer value
+ * @param number Number
+ */
+void JsonWriter::value( int64_t number )
+{
+    char text[ 24 ];
+    int length = snprintf( text, sizeof( text ), "%" PRId64, number );
+
+    separate();
+    append( text, static_cast< size_t >( length ) );
+}
+
+/**
+ * @brief Writes a boolean value
+ * @param boolean Boolean
+ */
+void JsonWriter::value( bool boolean )
+{
+    separate();
+    if( boolean ) {
+        append( "true", 4 );
+    } else {
+        append( "false", 5 );
+    }
+}
+
+/**
+ * @brief Writes a null value
+ */
+void JsonWriter::null()
+{
+    separate();
+    append( "null", 4 );
+}
+
+/**
+ * @brief Writes JSON that has already been serialized, as is
+ * @param json Null terminated JSON value
+ */
+void JsonWriter::raw( const char *json )
+{
+    separate();
+    if( json == nullptr ) {
+        append( "null", 4 );
+    } else {
+        append( json, strlen( json ) );
+    }
+}
+
+/**
+ * @brief Writes a cJSON tree as a value
+ * @param item Root of the tree, nullptr writes null
+ */
+void JsonWriter::write( const cJSON *item )
+{
+    writeItem( item );
+}
+
+/**
+ * @brief Determines if every object and array has been closed
+ * @return Boolean indicating the output is a complete JSON value
+ */
+bool JsonWriter::isComplete()
+{
+    return !mFailed && mDepth == 0 && !mAfterKey;
+}
+
+/**
+ * @brief Determines if the output was cut short, either the buffer couldn't
+ * grow or the nesting went too deep
+ * @return Boolean indicating the output is unusable
+ */
+bool JsonWriter::isFailed()
+{
+    return mFailed;
+}
+
+/**
+ * @brief Writes the comma between values, a value following a key needs none
+ */
+void JsonWriter::separate()
+{
+    if( mAfterKey ) {
+        mAfterKey = false;
+        return;
+    }
+
+    if( mDepth > 0 ) {
+        if( !mFirst[ mDepth - 1 ] ) {
+            append( ",", 1 );
+        }
+        mFirst[ mDepth - 1 ] = false;
+    }
+}
+
+/**
+ * @brief Opens an object or array
+ * @param c Opening character
+ */
+void JsonWriter::push( char c )
+{
+    separate();
+
+    if( mDepth >= max_depth ) {
+        mFailed = true;
+        return;
+    }
+
+    append( &c, 1 );
+    mFirst[ mDepth++ ] = true;
+}
+
+/**
+ * @brief Closes an object or array
+ * @param c Closing character
+ */
+void JsonWriter::pop( char c )
+{
+    if( mDepth == 0 ) {
+        mFailed = true;
+        return;
+    }
+
+    mDepth--;
+    append( &c, 1 );
+}
+
+/**
+ * @brief Appends to the buffer, once an append fails nothing more is written
+ * @param data Data to append
+ * @param size Size of the data
+ */
+void JsonWriter::append( const char *data, size_t size )
+{
+    if( !mFailed && !mBuffer->append( data, size ) ) {
+        mFailed = true;
+    }
+}
+
+/**
+ * @brief Appends a quoted string, escaping what JSON requires. Runs of plain
+ * characters are appended in one go.
+ * @param string Null terminated string
+ */
+void JsonWriter::appendString( const char *string )
+{
+    static const char hex[] = "0123456789abcdef";
+
+    append( "\"", 1 );
+
+    const char *run = string;
+    const char *c = string;
+    for( ; *c != '\0'; c++ ) {
+        unsigned char u = static_cast< unsigned char >( *c );
+        if( u >= 0x20 && u != '"' && u != '\\' ) {
+            continue;
+        }
+
+        append( run, static_cast< size_t >( c - run ) );
+        run = c + 1;
+
+        char escape[ 6 ] = { '\\', 0, 0, 0, 0, 0 };
+        size_t length = 2;
+        switch( u ) {
+        case '"':  escape[ 1 ] = '"'; break;
+        case '\\': escape[ 1 ] = '\\'; break;
+        case '\b': escape[ 1 ] = 'b'; break;
+        case '\f': escape[ 1 ] = 'f'; break;
+        case '\n': escape[ 1 ] = 'n'; break;
+        case '\r': escape[ 1 ] = 'r'; break;
+        case '\t': escape[ 1 ] = 't'; break;
+        default:
+            escape[ 1 ] = 'u';
+            escape[ 2 ] = '0';
+            escape[ 3 ] = '0';
+            escape[ 4 ] = hex[ u >> 4 ];
+            escape[ 5 ] = hex[ u & 0xF ];
+            length = 6;
+            break;
+        }
+        append( escape, length );
+    }
+
+    append( run, static_cast< size_t >( c - run ) );
+    append( "\"", 1 );
+}
+
+/**
+ * @brief Writes a cJSON item and everything below it
+ * @param item Item to write
+ */
+void JsonWriter::writeItem( const cJSON *item )
+{
+    if( item == nullptr ) {
+        null();
+        return;
+    }
+
+    switch( item->type & 0xFF ) {
+    case cJSON_False:
+        value( false );
+        break;
+    case cJSON_True:
+        value( true );
+        break;
+    case cJSON_NULL:
+        null();
+        break;
+    case cJSON_Number:
+        value( item->valuedouble );
+        break;
+    case cJSON_String:
+        value( item->valuestring );
+        break;
+    case cJSON_Raw:
+        raw( item->valuestring );
+        break;
+    case cJSON_Array:
+        beginArray();
+        for( const cJSON *child = item->child
+             ; child != nullptr && !mFailed
+             ; child = child->next ) {
+            writeItem( child );
+        }
+        endArray();
+        break;
+    case cJSON_Object:
+        beginObject();
+        for( const cJSON *child = item->child
+             ; child != nullptr && !mFailed
+             ; child = child->next ) {
+            key( child->string != nullptr ? child->string : "" );
+            writeItem( child );
+        }
+        endObject();
+        break;
+    default:
+        // Invalid items are written as null, the same as an empty slot
+        null();
+        break;
+    }
+}
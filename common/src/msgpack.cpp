@@ -0,0 +1,521 @@
+#include <math.h>
+#include <string.h>
+
+#include "common/json_parser.h"
+#include "common/msgpack.h"
+
+/**
+ * @brief Reads a big endian unsigned integer
+ * @param data Data to read from
+ * @param size Number of bytes, at most 8
+ * @return Value read
+ */
+static uint64_t readUnsigned( const uint8_t *data, size_t size )
+{
+    uint64_t value = 0;
+    for( size_t i = 0; i < size; i++ ) {
+        value = ( value << 8 ) | data[ i ];
+    }
+    return value;
+}
+
+/**
+ * @brief Appends a marker followed by a big endian unsigned integer
+ * @param buffer Buffer to append to
+ * @param marker Type marker
+ * @param value Value to write
+ * @param size Number of bytes the value takes, at most 8
+ * @return Boolean indicating the bytes were appended
+ */
+static bool writeUnsigned( Buffer *buffer, uint8_t marker, uint64_t value
+                           , size_t size )
+{
+    char bytes[ 9 ];
+    bytes[ 0 ] = static_cast< char >( marker );
+    for( size_t i = 0; i < size; i++ ) {
+        bytes[ size - i ] = static_cast< char >( value & 0xFF );
+        value >>= 8;
+    }
+    return buffer->append( bytes, size + 1 );
+}
+
+/**
+ * @brief Parses a MessagePack document into a cJSON tree. Nothing may follow
+ * the root value.
+ * @param data MessagePack data
+ * @param size Size of the data in bytes
+ * @return Parsed tree, nullptr if the data is malformed, uses an unsupported
+ * type or nests deeper than max_depth
+ */
+cJSON *MsgPack::parse( const char *data, size_t size )
+{
+    if( data == nullptr ) {
+        return nullptr;
+    }
+
+    const uint8_t *bytes = reinterpret_cast< const uint8_t* >( data );
+    size_t offset = 0;
+
+    Frame stack[ max_depth ];
+    uint32_t depth = 0;
+    cJSON *root = nullptr;
+    char *key = nullptr;
+
+    while( true ) {
+        Frame *frame = ( depth > 0 ) ? &stack[ depth - 1 ] : nullptr;
+
+        if( frame != nullptr && frame->item->type == cJSON_Object
+                && key == nullptr ) {
+            // Each value of a map is preceded by its key
+            if( !readString( bytes, size, &offset, &key ) ) {
+                break;
+            }
+            continue;
+        }
+
+        cJSON *item = nullptr;
+        uint32_t count = 0;
+        if( !readValue( bytes, size, &offset, &item, &count ) ) {
+            break;
+        }
+
+        // Link the item under the innermost map or array, or make it the root
+        if( frame == nullptr ) {
+            root = item;
+        } else {
+            if( frame->tail == nullptr ) {
+                frame->item->child = item;
+            } else {
+                frame->tail->next = item;
+                item->prev = frame->tail;
+            }
+            frame->tail = item;
+            frame->remaining--;
+
+            if( key != nullptr ) {
+                item->string = key;
+                key = nullptr;
+            }
+        }
+
+        if( count > 0 ) {
+            if( depth >= max_depth ) {
+                break;
+            }
+            stack[ depth ].item = item;
+            stack[ depth ].tail = nullptr;
+            stack[ depth ].remaining = count;
+            depth++;
+            continue;
+        }
+
+        // Close every map and array that is now complete
+        while( depth > 0 && stack[ depth - 1 ].remaining == 0 ) {
+            depth--;
+        }
+
+        if( depth == 0 ) {
+            if( offset == size ) {
+                return root;
+            }
+            break;
+        }
+    }
+
+    cJSON_free( key );
+    cJSON_Delete( root );
+    return nullptr;
+}
+
+/**
+ * @brief Writes a cJSON tree as MessagePack. Integral numbers are written as
+ * the smallest integer that holds them, anything else as a 64 bit float. Raw
+ * items are parsed as JSON and written as what they hold.
+ * @param item Tree to write
+ * @param buffer Buffer to append to
+ * @return Boolean indicating the whole tree was written
+ */
+bool MsgPack::write( const cJSON *item, Buffer *buffer )
+{
+    return writeItem( item, buffer, 0 );
+}
+
+/**
+ * @brief Reads one value
+ * @param data MessagePack data
+ * @param size Size of the data in bytes
+ * @param offset Offset of the value, moved past it. Past the header only for
+ * maps and arrays, their entries follow.
+ * @param item Created item
+ * @param count Number of entries of a map or array, 0 for anything else
+ * @return Boolean indicating a value was read
+ */
+bool MsgPack::readValue( const uint8_t *data, size_t size, size_t *offset
+                         , cJSON **item, uint32_t *count )
+{
+    if( *offset >= size ) {
+        return false;
+    }
+
+    const uint8_t marker = data[ *offset ];
+    const size_t left = size - *offset - 1;
+
+    // Size of whatever follows the marker before the value itself
+    size_t extra = 0;
+    *count = 0;
+
+    if( marker <= 0x7F || marker >= 0xE0 ) {
+        // Positive and negative fixint
+        *item = cJSON_CreateNumber( static_cast< int8_t >( marker ) );
+    } else if( marker >= 0xA0 && marker <= 0xBF ) {
+        char *string = nullptr;
+        if( !readString( data, size, offset, &string ) ) {
+            return false;
+        }
+        *item = cJSON_CreateNull();
+        if( *item == nullptr ) {
+            cJSON_free( string );
+            return false;
+        }
+        ( *item )->type = cJSON_String;
+        ( *item )->valuestring = string;
+        return true;
+    } else if( marker <= 0x9F ) {
+        // Fixmap and fixarray
+        *count = marker & 0x0F;
+        *item = ( marker <= 0x8F ) ? cJSON_CreateObject() : cJSON_CreateArray();
+    } else {
+        switch( marker ) {
+        case 0xC0:
+            *item = cJSON_CreateNull();
+            break;
+        case 0xC2:
+            *item = cJSON_CreateFalse();
+            break;
+        case 0xC3:
+            *item = cJSON_CreateTrue();
+            break;
+        case 0xCA:
+        case 0xCB: {
+            extra = ( marker == 0xCA ) ? 4 : 8;
+            if( left < extra ) {
+                return false;
+            }
+            uint64_t bits = readUnsigned( data + *offset + 1, extra );
+            double value;
+            if( extra == 4 ) {
+                uint32_t bits32 = static_cast< uint32_t >( bits );
+                float f;
+                memcpy( &f, &bits32, sizeof( f ) );
+                value = f;
+            } else {
+                memcpy( &value, &bits, sizeof( value ) );
+            }
+            if( !isfinite( value ) ) {
+                // JSON has no way to carry it
+                return false;
+            }
+            *item = cJSON_CreateNumber( value );
+            break;
+        }
+        case 0xCC:
+        case 0xCD:
+        case 0xCE:
+        case 0xCF:
+            extra = static_cast< size_t >( 1 ) << ( marker - 0xCC );
+            if( left < extra ) {
+                return false;
+            }
+            *item = cJSON_CreateNumber( static_cast< double >(
+                        readUnsigned( data + *offset + 1, extra ) ) );
+            break;
+        case 0xD0:
+        case 0xD1:
+        case 0xD2:
+        case 0xD3: {
+            extra = static_cast< size_t >( 1 ) << ( marker - 0xD0 );
+            if( left < extra ) {
+                return false;
+            }
+            // Sign extend from the width read
+            uint64_t bits = readUnsigned( data + *offset + 1, extra );
+            uint32_t shift = static_cast< uint32_t >( 64 - extra * 8 );
+            int64_t value = static_cast< int64_t >( bits << shift ) >> shift;
+            *item = cJSON_CreateNumber( static_cast< double >( value ) );
+            break;
+        }
+        case 0xD9:
+        case 0xDA:
+        case 0xDB: {
+            char *string = nullptr;
+            if( !readString( data, size, offset, &string ) ) {
+                return false;
+            }
+            *item = cJSON_CreateNull();
+            if( *item == nullptr ) {
+                cJSON_free( string );
+                return false;
+            }
+            ( *item )->type = cJSON_String;
+            ( *item )->valuestring = string;
+            return true;
+        }
+        case 0xDC:
+        case 0xDD:
+        case 0xDE:
+        case 0xDF:
+            extra = ( marker == 0xDC || marker == 0xDE ) ? 2 : 4;
+            if( left < extra ) {
+                return false;
+            }
+            *count = static_cast< uint32_t >( readUnsigned( data + *offset + 1
+                                                            , extra ) );
+            *item = ( marker >= 0xDE ) ? cJSON_CreateObject() : cJSON_CreateArray();
+            break;
+        default:
+            // Binary, extension and never used
+            return false;
+        }
+    }
+
+    *offset += 1 + extra;
+
+    // Every entry takes at least a byte, a map entry two
+    if( *count > 0 ) {
+        uint64_t needed = static_cast< uint64_t >( *count )
+                * ( ( *item != nullptr && ( *item )->type == cJSON_Object ) ? 2 : 1 );
+        if( needed > size - *offset ) {
+            cJSON_Delete( *item );
+            *item = nullptr;
+        }
+    }
+
+    return *item != nullptr;
+}
+
+/**
+ * @brief Reads a string value into memory allocated with cJSON_malloc()
+ * @param data MessagePack data
+ * @param size Size of the data in bytes
+ * @param offset Offset of the string, moved past it
+ * @param string Copy of the string, NUL terminated
+ * @return Boolean indicating a string was read
+ */
+bool MsgPack::readString( const uint8_t *data, size_t size, size_t *offset
+                          , char **string )
+{
+    uint32_t length = 0;
+    if( !readStringLength( data, size, offset, &length ) ) {
+        return false;
+    }
+
+    char *copy = static_cast< char* >( cJSON_malloc( length + 1 ) );
+    if( copy == nullptr ) {
+        return false;
+    }
+
+    memcpy( copy, data + *offset, length );
+    copy[ length ] = '\0';
+    *offset += length;
+    *string = copy;
+    return true;
+}
+
+/**
+ * @brief Reads the header of a string
+ * @param data MessagePack data
+ * @param size Size of the data in bytes
+ * @param offset Offset of the string, moved past its header
+ * @param length Length of the string in bytes, all of which are present
+ * @return Boolean indicating the value is a complete string
+ */
+bool MsgPack::readStringLength( const uint8_t *data, size_t size
+                                , size_t *offset, uint32_t *length )
+{
+    if( *offset >= size ) {
+        return false;
+    }
+
+    const uint8_t marker = data[ *offset ];
+    size_t extra = 0;
+    if( marker >= 0xA0 && marker <= 0xBF ) {
+        *length = marker & 0x1F;
+    } else if( marker >= 0xD9 && marker <= 0xDB ) {
+        extra = static_cast< size_t >( 1 ) << ( marker - 0xD9 );
+        if( size - *offset - 1 < extra ) {
+            return false;
+        }
+        *length = static_cast< uint32_t >( readUnsigned( data + *offset + 1
+                                                         , extra ) );
+    } else {
+        return false;
+    }
+
+    *offset += 1 + extra;
+    return *length <= size - *offset;
+}
+
+/**
+ * @brief Writes an item and everything under it
+ * @param item Item to write
+ * @param buffer Buffer to append to
+ * @param depth Number of maps and arrays the item is in
+ * @return Boolean indicating the item was written
+ */
+bool MsgPack::writeItem( const cJSON *item, Buffer *buffer, uint32_t depth )
+{
+    if( item == nullptr ) {
+        return false;
+    }
+
+    switch( item->type & 0xFF ) {
+    case cJSON_NULL: {
+        const char nil = static_cast< char >( 0xC0 );
+        return buffer->append( &nil, 1 );
+    }
+    case cJSON_False:
+    case cJSON_True: {
+        const char boolean = static_cast< char >(
+                    ( item->type & cJSON_True ) ? 0xC3 : 0xC2 );
+        return buffer->append( &boolean, 1 );
+    }
+    case cJSON_Number:
+        return writeNumber( item->valuedouble, buffer );
+    case cJSON_String:
+        return writeString( item->valuestring, buffer );
+    case cJSON_Raw: {
+        // Cached results are kept as JSON text
+        cJSON *parsed = JsonParser::parse( item->valuestring );
+        bool ok = ( parsed != nullptr ) && writeItem( parsed, buffer, depth );
+        cJSON_Delete( parsed );
+        return ok;
+    }
+    case cJSON_Array:
+    case cJSON_Object: {
+        if( depth >= max_depth ) {
+            return false;
+        }
+
+        bool object = ( item->type & 0xFF ) == cJSON_Object;
+        uint32_t count = 0;
+        for( const cJSON *child = item->child; child != nullptr; child = child->next ) {
+            count++;
+        }
+
+        bool ok = object
+                ? writeHeader( buffer, count, 0x80, 0x0F, 0xDE, 0xDF )
+                : writeHeader( buffer, count, 0x90, 0x0F, 0xDC, 0xDD );
+        for( const cJSON *child = item->child
+             ; ok && child != nullptr
+             ; child = child->next ) {
+            if( object ) {
+                ok = writeString( child->string, buffer );
+            }
+            ok = ok && writeItem( child, buffer, depth + 1 );
+        }
+        return ok;
+    }
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Writes a number
+ * @param number Number to write
+ * @param buffer Buffer to append to
+ * @return Boolean indicating the number was written
+ */
+bool MsgPack::writeNumber( double number, Buffer *buffer )
+{
+    // Integers take up to 9 bytes against always 9 for a double, and decode
+    // back to the same value
+    if( number == floor( number )
+            && number >= -9223372036854775808.0
+            && number < 18446744073709551616.0 ) {
+        if( number >= 0 ) {
+            uint64_t value = static_cast< uint64_t >( number );
+            if( value <= 0x7F ) {
+                const char fixint = static_cast< char >( value );
+                return buffer->append( &fixint, 1 );
+            } else if( value <= 0xFF ) {
+                return writeUnsigned( buffer, 0xCC, value, 1 );
+            } else if( value <= 0xFFFF ) {
+                return writeUnsigned( buffer, 0xCD, value, 2 );
+            } else if( value <= 0xFFFFFFFF ) {
+                return writeUnsigned( buffer, 0xCE, value, 4 );
+            }
+            return writeUnsigned( buffer, 0xCF, value, 8 );
+        }
+
+        int64_t value = static_cast< int64_t >( number );
+        if( value >= -32 ) {
+            const char fixint = static_cast< char >( value );
+            return buffer->append( &fixint, 1 );
+        } else if( value >= INT8_MIN ) {
+            return writeUnsigned( buffer, 0xD0, static_cast< uint64_t >( value ), 1 );
+        } else if( value >= INT16_MIN ) {
+            return writeUnsigned( buffer, 0xD1, static_cast< uint64_t >( value ), 2 );
+        } else if( value >= INT32_MIN ) {
+            return writeUnsigned( buffer, 0xD2, static_cast< uint64_t >( value ), 4 );
+        }
+        return writeUnsigned( buffer, 0xD3, static_cast< uint64_t >( value ), 8 );
+    }
+
+    uint64_t bits;
+    memcpy( &bits, &number, sizeof( bits ) );
+    return writeUnsigned( buffer, 0xCB, bits, 8 );
+}
+
+/**
+ * @brief Writes a string
+ * @param string NUL terminated string to write
+ * @param buffer Buffer to append to
+ * @return Boolean indicating the string was written
+ */
+bool MsgPack::writeString( const char *string, Buffer *buffer )
+{
+    if( string == nullptr ) {
+        return false;
+    }
+
+    size_t length = strlen( string );
+    bool ok;
+    if( length <= 0x1F ) {
+        const char fixstr = static_cast< char >( 0xA0 | length );
+        ok = buffer->append( &fixstr, 1 );
+    } else if( length <= 0xFF ) {
+        ok = writeUnsigned( buffer, 0xD9, length, 1 );
+    } else if( length <= 0xFFFF ) {
+        ok = writeUnsigned( buffer, 0xDA, length, 2 );
+    } else if( length <= 0xFFFFFFFF ) {
+        ok = writeUnsigned( buffer, 0xDB, length, 4 );
+    } else {
+        return false;
+    }
+
+    return ok && buffer->append( string, length );
+}
+
+/**
+ * @brief Writes the header of a map or array
+ * @param buffer Buffer to append to
+ * @param count Number of entries
+ * @param fixed Marker of the form holding the count in its low bits
+ * @param fixedMax Largest count the fixed form holds
+ * @param marker16 Marker of the form with a 16 bit count
+ * @param marker32 Marker of the form with a 32 bit count
+ * @return Boolean indicating the header was written
+ */
+bool MsgPack::writeHeader( Buffer *buffer, uint32_t count
+                           , uint8_t fixed, uint32_t fixedMax
+                           , uint8_t marker16, uint8_t marker32 )
+{
+    if( count <= fixedMax ) {
+        const char header = static_cast< char >( fixed | count );
+        return buffer->append( &header, 1 );
+    } else if( count <= 0xFFFF ) {
+        return writeUnsigned( buffer, marker16, count, 2 );
+    }
+    return writeUnsigned( buffer, marker32, count, 4 );
+}
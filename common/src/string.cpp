@@ -1,7 +1,5 @@
 #include "common/string.h"
 
-const size_t String::max_size = 4096;
-
 const char String::null_char = '\0';
 
 /**
@@ -10,22 +8,78 @@ const char String::null_char = '\0';
  * @param len (Optional) Desired initializer length
  */
 String::String( const char *str, size_t len )
-    : mString( nullptr )
-    , mLength( 0 )
 {
     append( str, len );
 }
 
+/**
+ * @brief Destructor
+ */
+String::~String()
+{
+}
+
+/**
+ * @brief Replaces the string data
+ * @param str Desired string
+ * @return Reference to the string
+ */
+String& String::operator=( const char *str )
+{
+    clear();
+    append( str );
+    return *this;
+}
+
+/**
+ * @brief Replaces the string data with a copy of another string
+ * @param str Desired string
+ * @return Reference to the string
+ */
+String& String::operator=( String &str )
+{
+    if( &str != this ) {
+        clear();
+        append( str.getData(), str.getLength() );
+    }
+    return *this;
+}
+
+/**
+ * @brief Retrieves the string data
+ * @return Null terminated string, never nullptr
+ */
+const char *String::getData()
+{
+    const char *data = mBuffer.getData();
+    return ( data != nullptr ) ? data : &null_char;
+}
+
+/**
+ * @brief Retrieves the length of the string
+ * @return Length of the string
+ */
+size_t String::getLength()
+{
+    return mBuffer.getSize();
+}
+
 /**
  * @brief Clears all string data
  */
 void String::clear()
 {
-    if( mString ) {
-        delete[] mString;
-        mString = nullptr;
-        mLength = 0;
-    }
+    mBuffer.clear();
+}
+
+/**
+ * @brief Makes sure the string can grow to the given length without
+ * reallocating
+ * @param len Desired length
+ */
+void String::reserve( const size_t len )
+{
+    mBuffer.reserve( len );
 }
 
 /**
@@ -36,27 +90,6 @@ void String::clear()
 void String::append( const char *str, const size_t len )
 {
     if( str != nullptr && str[ 0 ] != null_char ) {
-        // Increase the len of our str
-        if( len > 0 ) {
-            mLength += len;
-        } else {
-            mLength += strlen( str );
-        }
-        // Save off a pointer to the old str
-        char *t = mString;
-        // Create a new block of memory
-        mString = new char[ mLength + 1 ];
-        // Copy the old str to the new block
-        memcpy( static_cast< void* >( mString ), t, mLength - len );
-        // Copy the new str to the end of the new block
-        char *n = &mString[ mLength - len ];
-        memcpy( static_cast< void* >( n ), str, len );
-        // Append the null character
-        mString[ mLength ] = '\0';
-
-        if( t ) {
-            // Delete the pointer to the old str block
-            delete[] t;
-        }
+        mBuffer.append( str, ( len > 0 ) ? len : strlen( str ) );
     }
 }
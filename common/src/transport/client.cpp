@@ -2,9 +2,41 @@
 
 namespace Transport {
 
+Client::Client()
+    : mEncoding( Codec::Encoding::JSON )
+{
+
+}
+
 Client::~Client()
 {
 
 }
 
+/**
+ * @brief Sets the encoding commands are sent in. Commands are always handed
+ * to send() as JSON, the client converts them.
+ * @param encoding Desired encoding
+ * @return Error code
+ */
+uint32_t Client::setEncoding( Codec::Encoding encoding )
+{
+    uint32_t r = Error::Code::NONE;
+    if( encoding >= Codec::Encoding::ENCODING_MAX ) {
+        r = Error::Code::PARAM_OUT_OF_RANGE;
+    } else {
+        mEncoding = encoding;
+    }
+    return r;
+}
+
+/**
+ * @brief Retrieves the encoding commands are sent in
+ * @return Encoding
+ */
+Codec::Encoding Client::getEncoding()
+{
+    return mEncoding;
+}
+
 }
@@ -12,6 +12,8 @@
 #include "common/timer.h"
 
 #include "common/command/command_help.h"
+#include "common/command/command_metrics.h"
+#include "common/command/command_queue.h"
 #include "common/command/command_datetime.h"
 #include "common/command/command_gpio.h"
 #include "common/command/command_led.h"
@@ -45,17 +47,16 @@ class Hardware
     static const char *str_gps_device;
     static const char *str_dev_i2c0;
     static const uint8_t ssd1306_address;
+    static const uint32_t server_thread_pool_size;
+    static const uint32_t batch_threads;
 public:
     Transport::Client * getClient() override;
+    void start() override;
 
 private:
     Hardware();
     ~Hardware();
 
-    const char *mIndexHtml;
-    const char *mBundleJs;
-
-
     Serial mGpsSerial;
     I2C mI2C[ NUM_I2C_BUSES ];
     SSD1306 mDisplay;
@@ -65,12 +66,14 @@ private:
     AM335X::Gpio mGpio[ NUM_GPIO_HEADERS ];
     Led mLed[ LED_HEADERS ];
     DateTime mDateTime;
+    CommandQueue mCommandQueue;
     Http::Server mServer;
     Http::Client mClient;
     System mSystem;
     Timer mHeartbeatTimer;
 
     CommandHelp mCmdHelp;
+    CommandMetrics mCmdMetrics;
     CommandDateTime mCmdDateTime;
     CommandGpio mCmdGpio;
     CommandHeartbeat mCmdHeartbeat;
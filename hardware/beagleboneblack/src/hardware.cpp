@@ -3,14 +3,14 @@
 const char *Hardware::str_gps_device = "/dev/ttyS1";
 const char *Hardware::str_dev_i2c0 = "/dev/i2c-2";
 const uint8_t Hardware::ssd1306_address = 0x3C;
+const uint32_t Hardware::server_thread_pool_size = 2;
+const uint32_t Hardware::batch_threads = 4;
 
 /**
  * @brief Constructor
  */
 Hardware::Hardware()
     : HardwareBase()
-    , mIndexHtml( Resources::load( Resources::index_html, Resources::index_html_size ) )
-    , mBundleJs( Resources::load( Resources::bundle_js, Resources::bundle_js_size ) )
     , mGpsSerial( str_gps_device, Serial::Speed::BAUD_9600, isSimulated() )
     , mI2C{ { str_dev_i2c0, ssd1306_address, 0 } }
     , mDisplay( &mI2C[ 0 ], ssd1306_address )
@@ -27,11 +27,18 @@ Hardware::Hardware()
             , { &mGpio[ 1 ], 23 }
             , { &mGpio[ 1 ], 24 }
             }
-    , mServer( mIndexHtml, mBundleJs )
+    , mCommandQueue( getCommandHandler() )
+    , mServer( Resources::index_html, Resources::index_html_size
+               , Resources::bundle_js, Resources::bundle_js_size
+               , Http::default_port
+               , false
+               , Http::Server::Threading::THREAD_POOL
+               , server_thread_pool_size )
     , mHeartbeatTimer( 1000, Timer::Type::INTERVAL, std::bind( &Hardware::heartbeat, this ) )
 {
     // Add the individual commands
     addCommand( &mCmdHelp );
+    addCommand( &mCmdMetrics );
     addCommand( &mCmdGpio );
     addCommand( &mCmdHeartbeat );
     addCommand( &mCmdSystem );
@@ -40,8 +47,67 @@ Hardware::Hardware()
     addCommand( &mCmdLed );
     addCommand( &mCmdGps );
 
-    // Set the command handler and start the server
+    // GPS settings wait on the device to answer, don't let them hog the
+    // workers. Queries are served from the sentences already received.
+    mCommandQueue.setLimit( COMMAND_GPS, 1 );
+
+    // Let a batch query the peripherals in parallel
+    getCommandHandler()->setBatchThreads( batch_threads );
+
+    // Offer the precompressed web resources
+    mServer.getIndexHtml()->addEncoding(
+                Http::encoding_gzip
+                , Resources::index_html_gz, Resources::index_html_gz_size );
+    mServer.getMainJs()->addEncoding(
+                Http::encoding_gzip
+                , Resources::bundle_js_gz, Resources::bundle_js_gz_size );
+#ifdef USE_BROTLI
+    mServer.getIndexHtml()->addEncoding(
+                Http::encoding_brotli
+                , Resources::index_html_br, Resources::index_html_br_size );
+    mServer.getMainJs()->addEncoding(
+                Http::encoding_brotli
+                , Resources::bundle_js_br, Resources::bundle_js_br_size );
+#endif
+
+    // Stream state changes made through a command to the web clients
+    getCommandHandler()->setListener( [ this ]( const char *name, cJSON *params ) {
+        cJSON *event = createEvent( name, params );
+        if( event != nullptr ) {
+            mServer.getEventStream()->publish( name, event );
+            cJSON_Delete( event );
+        }
+    } );
+
+    // Stream fixes to the web clients as the receiver reports them
+    mGps.setSentenceListener( [ this ]( Gps::Nmea::Sentence sentence, const char *text ) {
+        const char *param = nullptr;
+        if( sentence == Gps::Nmea::Sentence::GPGGA ) {
+            param = PARAM_GPGGA;
+        } else if( sentence == Gps::Nmea::Sentence::GPRMC ) {
+            param = PARAM_GPRMC;
+        } else {
+            return;
+        }
+
+        cJSON *event = cJSON_CreateObject();
+        cJSON_AddStringToObject( event, param, text );
+        mServer.getEventStream()->publish( COMMAND_GPS, event );
+        cJSON_Delete( event );
+    } );
+
+    // Set the command handler, the server is started once registration is done
     mServer.setCommandHandler( getCommandHandler() );
+    mServer.setCommandQueue( &mCommandQueue );
+}
+
+/**
+ * @brief Starts the command queue, the server and the heartbeat. Commands
+ * can't be added from here on.
+ */
+void Hardware::start()
+{
+    mCommandQueue.start();
     mServer.listen();
 
     mHeartbeatTimer.start();
@@ -54,10 +120,10 @@ Hardware::~Hardware()
 {
     // Destruct things in the reverse order
     mHeartbeatTimer.stop();
+    mGps.setSentenceListener( nullptr );
 
     mServer.stop();
-    Resources::unload( mIndexHtml );
-    Resources::unload( mBundleJs );
+    mCommandQueue.stop();
 }
 
 Transport::Client *Hardware::getClient()
@@ -77,4 +143,17 @@ void Hardware::heartbeat()
 
     // Toggle LED for heartbeat
     mLed[ 0 ].setEnable( !mLed[ 0 ].isEnabled() );
+
+    cJSON *event = cJSON_CreateObject();
+    cJSON_AddNumberToObject( event, PARAM_DATETIME
+                             , static_cast< double >( time( nullptr ) ) );
+    mServer.getEventStream()->publish( COMMAND_HEARTBEAT, event );
+    cJSON_Delete( event );
+
+    // Report the toggle the same way a led command would
+    event = cJSON_CreateObject();
+    cJSON_AddNumberToObject( event, PARAM_ID, 0 );
+    cJSON_AddBoolToObject( event, PARAM_ENABLE, mLed[ 0 ].isEnabled() );
+    mServer.getEventStream()->publish( COMMAND_LED, event );
+    cJSON_Delete( event );
 }
@@ -0,0 +1,12 @@
+    .section .rodata
+    .global index_html_br
+    .type   index_html_br, %object
+    .align  4
+index_html_br:
+    .incbin "index.html.br"
+index_html_br_end:
+    .global index_html_br_size
+    .type   index_html_br_size, %object
+    .align  4
+index_html_br_size:
+    .int    index_html_br_end - index_html_br
@@ -0,0 +1,12 @@
+    .section .rodata
+    .global index_html_gz
+    .type   index_html_gz, %object
+    .align  4
+index_html_gz:
+    .incbin "index.html.gz"
+index_html_gz_end:
+    .global index_html_gz_size
+    .type   index_html_gz_size, %object
+    .align  4
+index_html_gz_size:
+    .int    index_html_gz_end - index_html_gz
@@ -14,6 +14,21 @@ namespace Resources
 
     extern "C" const char index_html[];
     extern "C" const unsigned int index_html_size;
+
+    // Precompressed variants, generated at build time
+    extern "C" const char bundle_js_gz[];
+    extern "C" const unsigned int bundle_js_gz_size;
+
+    extern "C" const char index_html_gz[];
+    extern "C" const unsigned int index_html_gz_size;
+
+#ifdef USE_BROTLI
+    extern "C" const char bundle_js_br[];
+    extern "C" const unsigned int bundle_js_br_size;
+
+    extern "C" const char index_html_br[];
+    extern "C" const unsigned int index_html_br_size;
+#endif
 }
 
 #endif // BEAGLEBONEBLACK_RESOURCES_H
@@ -12,6 +12,8 @@
 #include "common/timer.h"
 
 #include "common/command/command_help.h"
+#include "common/command/command_metrics.h"
+#include "common/command/command_queue.h"
 #include "common/command/command_datetime.h"
 #include "common/command/command_gpio.h"
 #include "common/command/command_led.h"
@@ -56,15 +58,14 @@ class Hardware
 
 public:
     Transport::Client * getClient() override;
+    void start() override;
 
 private:
     Hardware();
     ~Hardware() override;
 
-    const char *mIndexHtml;
-    const char *mBundleJs;
-
     DateTime mDateTime;
+    CommandQueue mCommandQueue;
     Http::Server mServer;
     System mSystem;
     Timer mHeartbeatTimer;
@@ -73,6 +74,7 @@ private:
     Http::Client mHttpClient;
 
     CommandHelp mCmdHelp;
+    CommandMetrics mCmdMetrics;
     CommandDateTime mCmdDateTime;
     CommandHeartbeat mCmdHeartbeat;
     CommandServer mCmdServer;
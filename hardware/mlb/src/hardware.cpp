@@ -26,9 +26,9 @@ const char *Hardware::mlb_api_date = "%Y%m%d";
  */
 Hardware::Hardware()
     : HardwareBase()
-    , mIndexHtml( Resources::load( Resources::index_html, Resources::index_html_size ) )
-    , mBundleJs( Resources::load( Resources::bundle_js, Resources::bundle_js_size ) )
-    , mServer( mIndexHtml, mBundleJs )
+    , mCommandQueue( getCommandHandler() )
+    , mServer( Resources::index_html, Resources::index_html_size
+               , Resources::bundle_js, Resources::bundle_js_size )
     , mHeartbeatTimer( heartbeat_delay_60000_ms
                        , Timer::Type::INTERVAL
                        , std::bind( &Hardware::heartbeat, this ) )
@@ -46,14 +46,50 @@ Hardware::Hardware()
 
     // Add the individual commands
     addCommand( &mCmdHelp );
+    addCommand( &mCmdMetrics );
     addCommand( &mCmdHeartbeat );
     addCommand( &mCmdSystem );
     addCommand( &mCmdDateTime );
     addCommand( &mCmdServer );
     addCommand( &mCmdSmtp );
 
-    // Set the command handler and start the server
+    // Offer the precompressed web resources
+    mServer.getIndexHtml()->addEncoding(
+                Http::encoding_gzip
+                , Resources::index_html_gz, Resources::index_html_gz_size );
+    mServer.getMainJs()->addEncoding(
+                Http::encoding_gzip
+                , Resources::bundle_js_gz, Resources::bundle_js_gz_size );
+#ifdef USE_BROTLI
+    mServer.getIndexHtml()->addEncoding(
+                Http::encoding_brotli
+                , Resources::index_html_br, Resources::index_html_br_size );
+    mServer.getMainJs()->addEncoding(
+                Http::encoding_brotli
+                , Resources::bundle_js_br, Resources::bundle_js_br_size );
+#endif
+
+    // Stream state changes made through a command to the web clients
+    getCommandHandler()->setListener( [ this ]( const char *name, cJSON *params ) {
+        cJSON *event = createEvent( name, params );
+        if( event != nullptr ) {
+            mServer.getEventStream()->publish( name, event );
+            cJSON_Delete( event );
+        }
+    } );
+
+    // Set the command handler, the server is started once registration is done
     mServer.setCommandHandler( getCommandHandler() );
+    mServer.setCommandQueue( &mCommandQueue );
+}
+
+/**
+ * @brief Starts the command queue, the server and the heartbeat. Commands
+ * can't be added from here on.
+ */
+void Hardware::start()
+{
+    mCommandQueue.start();
     mServer.listen();
 
     testApi();
@@ -70,8 +106,7 @@ Hardware::~Hardware()
     mHeartbeatTimer.stop();
 
     mServer.stop();
-    Resources::unload( mIndexHtml );
-    Resources::unload( mBundleJs );
+    mCommandQueue.stop();
 }
 
 /**
@@ -92,6 +127,12 @@ void Hardware::heartbeat()
     // char date[ 9 ] = "20171201";
     // getDate( date, 9 );
     // queryTransactions( date, date );
+
+    cJSON *event = cJSON_CreateObject();
+    cJSON_AddNumberToObject( event, PARAM_DATETIME
+                             , static_cast< double >( time( nullptr ) ) );
+    mServer.getEventStream()->publish( COMMAND_HEARTBEAT, event );
+    cJSON_Delete( event );
 }
 
 /**
@@ -153,7 +194,7 @@ uint32_t Hardware::queryTransactions( const char *startDate, const char *stopDat
                     char *printItem = cJSON_Print( item );
                     // printf( "%s\n", printItem );
                     mSmtpClient.send( printItem );
-                    free( printItem );
+                    cJSON_free( printItem );
                 }
             }
         }
@@ -0,0 +1,12 @@
+    .section .rodata
+    .global bundle_js_br
+    .type   bundle_js_br, %object
+    .align  4
+bundle_js_br:
+    .incbin "bundle.js.br"
+bundle_js_br_end:
+    .global bundle_js_br_size
+    .type   bundle_js_br_size, %object
+    .align  4
+bundle_js_br_size:
+    .int    bundle_js_br_end - bundle_js_br
@@ -0,0 +1,12 @@
+    .section .rodata
+    .global bundle_js_gz
+    .type   bundle_js_gz, %object
+    .align  4
+bundle_js_gz:
+    .incbin "bundle.js.gz"
+bundle_js_gz_end:
+    .global bundle_js_gz_size
+    .type   bundle_js_gz_size, %object
+    .align  4
+bundle_js_gz_size:
+    .int    bundle_js_gz_end - bundle_js_gz
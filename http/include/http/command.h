@@ -2,23 +2,82 @@
 #define COMMAND_SERVER_H
 
 #include "common/command/command_template.h"
+#include "common/command/command_metrics.h"
 #include "http/server/server.h"
 
 #define COMMAND_SERVER  "server"
 #define COMMAND_QSERVER "qserver"
 
-#define PARAM_ACTIVE    "active"
-#define PARAM_PORT      "port"
-#define PARAM_SECURE    "secure"
+#define PARAM_ACTIVE        "active"
+#define PARAM_CONNECTIONS   "connections"
+#define PARAM_POOL          "pool"
+#define PARAM_PORT          "port"
+#define PARAM_SECURE        "secure"
+#define PARAM_THREADING     "threading"
+#define PARAM_QUEUE         "queue"
+#define PARAM_UPLOAD        "upload"
+#define PARAM_UPLOAD_DIR    "upload_dir"
+#define PARAM_UPLOAD_DIRECT "upload_direct"
+#define PARAM_UPLOAD_PREALLOCATE "upload_prealloc"
+#define PARAM_EVENTS        "events"
+#define PARAM_SUBSCRIBERS   "subscribers"
+#define PARAM_SESSIONS      "sessions"
+#define PARAM_WEBSOCKET     "websocket"
+
+#define PARAM_CAPACITY      "capacity"
+#define PARAM_DEPTH         "depth"
+#define PARAM_MAX_DEPTH     "max_depth"
+#define PARAM_PROCESSED     "processed"
+#define PARAM_REJECTED      "rejected"
+#define PARAM_WAIT_AVG      "wait_avg_us"
+#define PARAM_WAIT_MAX      "wait_max_us"
+#define PARAM_WORKERS       "workers"
+
+#define PARAM_BYTES         "bytes"
+#define PARAM_FAILURES      "failures"
+#define PARAM_FILES         "files"
+#define PARAM_THROUGHPUT    "throughput_bps"
+
+#define PARAM_DISCONNECTED  "disconnected"
+#define PARAM_DROPPED       "dropped"
+#define PARAM_MAX           "max"
+#define PARAM_PUBLISHED     "published"
+
+#define PARAM_ALLOCATIONS   "allocations"
+#define PARAM_ARENA         "arena"
+#define PARAM_HEAP          "heap"
+
+#define PARAM_LATENCY       "latency"
 
 class CommandServer
         : public CommandTemplate< Http::Server >
 {
 public:
     CommandServer();
+
+    virtual uint32_t setThreading( cJSON *val );
+    virtual uint32_t setPool( cJSON *val );
+    virtual uint32_t setUploadDirectory( cJSON *val );
+    virtual uint32_t setUploadDirect( cJSON *val );
+    virtual uint32_t setUploadPreallocate( cJSON *val );
+    virtual uint32_t setSubscribers( cJSON *val );
+    virtual uint32_t setSessions( cJSON *val );
+
     virtual uint32_t getPort( cJSON *response );
     virtual uint32_t getActive( cJSON *response );
     virtual uint32_t getSecure( cJSON *response );
+    virtual uint32_t getThreading( cJSON *response );
+    virtual uint32_t getPool( cJSON *response );
+    virtual uint32_t getConnections( cJSON *response );
+    virtual uint32_t getQueue( cJSON *response );
+    virtual uint32_t getUpload( cJSON *response );
+    virtual uint32_t getUploadDirectory( cJSON *response );
+    virtual uint32_t getUploadDirect( cJSON *response );
+    virtual uint32_t getUploadPreallocate( cJSON *response );
+    virtual uint32_t getEvents( cJSON *response );
+    virtual uint32_t getWebSocket( cJSON *response );
+    virtual uint32_t getArena( cJSON *response );
+    virtual uint32_t getLatency( cJSON *response );
 };
 
 #endif // COMMAND_SERVER_H
@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include <string>
 
+#include "common/buffer.h"
 #include "common/logger/log.h"
 
 #define HTTP_URL_TEMPLATE   "http://%s:%d"
@@ -82,26 +83,16 @@ extern const uint16_t default_port;
 
 extern const char *method_strings[];
 
+extern const char *encoding_gzip;
+extern const char *encoding_brotli;
+
 Method stringToMethod( const char *method );
 const char *methodToString( Method method );
 
 HttpVersion stringToHttpVersion( const char *version );
 
-class Body {
-public:
-    Body();
-    ~Body();
-
-    void append( const char *data, size_t size );
-    void clear();
-
-    const char *getData();
-    uint32_t getSize();
-
-private:
-    char *mData;
-    uint32_t mSize;
-};
+/// Request and response bodies, see Buffer
+using Body = Buffer;
 
 }
 
@@ -0,0 +1,64 @@
+/** ****************************************************************************
+ * @file asset.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief Asset class declaration. A static resource that is served straight
+ * out of the memory it was embedded in. The responses are built once and
+ * reused by every request, precompressed variants are picked based on the
+ * client's Accept-Encoding.
+ * ****************************************************************************/
+#ifndef HTTP_ASSET_H
+#define HTTP_ASSET_H
+
+#include <microhttpd.h>
+#include <stdint.h>
+#include <vector>
+
+namespace Http
+{
+
+class Asset
+{
+    static const char *cache_control;
+    static const char *vary;
+    static const char *encoding_identity;
+
+public:
+
+    Asset( const char *data, size_t size, const char *type );
+    ~Asset();
+
+    Asset( const Asset &asset ) = delete;
+    Asset& operator=( const Asset &asset ) = delete;
+
+    uint32_t addEncoding( const char *encoding, const char *data, size_t size );
+
+    int serve( MHD_Connection *connection );
+
+    const char *getETag();
+    size_t getSize();
+
+private:
+
+    struct Variant {
+        const char *encoding;
+        size_t size;
+        char etag[ 48 ];
+        MHD_Response *response;
+        MHD_Response *notModified;
+    };
+
+    const char *mType;
+    uint64_t mHash;
+    std::vector< Variant > mVariants;
+
+    bool createVariant( Variant &variant, const char *data );
+    Variant *select( const char *acceptEncoding );
+    bool matches( Variant *variant, const char *ifNoneMatch );
+
+    static float quality( const char *acceptEncoding, const char *encoding );
+};
+
+}
+
+#endif // HTTP_ASSET_H
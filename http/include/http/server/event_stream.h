@@ -0,0 +1,103 @@
+/** ****************************************************************************
+ * @file event_stream.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief Event stream class declaration. Pushes state changes to subscribed
+ * clients as Server-Sent Events so they don't have to poll for them.
+ *
+ * Every subscriber has a bounded queue of formatted events. A subscriber with
+ * nothing to send is suspended until the next event is published. When a slow
+ * client lets its queue fill up the oldest events are dropped and the client
+ * is told how many it missed, a client that keeps falling behind is
+ * disconnected.
+ * ****************************************************************************/
+#ifndef HTTP_EVENT_STREAM_H
+#define HTTP_EVENT_STREAM_H
+
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <microhttpd.h>
+#include <stdint.h>
+
+#include "common/cjson/cJSON.h"
+
+namespace Http
+{
+
+class EventStream
+{
+    static const uint32_t default_max_subscribers;
+    static const uint32_t default_queue_depth;
+    static const size_t block_size;
+    static const char *type_text_event_stream;
+    static const char *cache_control;
+
+public:
+
+    EventStream( uint32_t maxSubscribers = default_max_subscribers
+                 , uint32_t queueDepth = default_queue_depth );
+    ~EventStream();
+
+    EventStream( const EventStream &stream ) = delete;
+    EventStream& operator=( const EventStream &stream ) = delete;
+
+    void open();
+    void close();
+
+    uint32_t publish( const char *event, cJSON *data );
+
+    MHD_Response *subscribe( MHD_Connection *connection, const char *lastEventId );
+
+    uint32_t setMaxSubscribers( uint32_t max );
+
+    uint32_t getSubscribers();
+    uint32_t getMaxSubscribers();
+    uint32_t getQueueDepth();
+    uint64_t getPublished();
+    uint64_t getDropped();
+    uint64_t getDisconnected();
+
+private:
+
+    using Event = std::shared_ptr< const std::string >;
+
+    struct Entry {
+        uint64_t id;
+        Event event;
+    };
+
+    struct Subscriber {
+        EventStream *stream;
+        MHD_Connection *connection;
+        std::deque< Event > events;
+        size_t offset;
+        uint64_t dropped;
+        bool suspended;
+        bool overrun;
+    };
+
+    std::mutex mMutex;
+    std::list< Subscriber* > mSubscribers;
+    std::deque< Entry > mHistory;
+    uint32_t mMaxSubscribers;
+    uint32_t mQueueDepth;
+    uint64_t mLastId;
+    bool mClosed;
+
+    uint64_t mPublished;
+    uint64_t mDropped;
+    uint64_t mDisconnected;
+
+    void enqueue( Subscriber *subscriber, const Event &event );
+    void wake( Subscriber *subscriber );
+
+    static ssize_t read( void *cls, uint64_t pos, char *buf, size_t max );
+    static void release( void *cls );
+};
+
+}
+
+#endif // HTTP_EVENT_STREAM_H
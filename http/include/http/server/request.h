@@ -8,10 +8,15 @@
 #ifndef HTTP_REQUEST_H
 #define HTTP_REQUEST_H
 
+#include <chrono>
 #include <microhttpd.h>
 
+#include "common/arena.h"
+#include "common/buffer.h"
+#include "common/cjson/cJSON.h"
 #include "common/common_types.h"
 #include "http/http.h"
+#include "http/server/upload.h"
 
 namespace Http
 {
@@ -22,27 +27,43 @@ public:
 
     using HeaderMap = Types::CharHashMap< const char* >;
 
+    enum State {
+        RECEIVING   = 0
+        , QUEUED    = 1
+        , COMPLETE  = 2
+        , REJECTED  = 3
+    };
+
     explicit Request( MHD_Connection *connection );
     ~Request();
 
     MHD_Connection *mConnection;
     MHD_PostProcessor *mPostProcessor;
     HeaderMap mHeaders;
-    FILE* mFp;
+    Upload *mUpload;
     const char *mMethod;
     const char *mPath;
     Body mBody;
     char* mData;
     uint32_t mDataSize;
+    State mState;
+    cJSON *mCommand;
+    cJSON *mResponse;
+    Arena mArena;
+    std::chrono::steady_clock::time_point mStart;
 
     void setMethod( const char *method );
     void setPath( const char *path );
+    void setState( State state );
 
     const char *getMethod();
     const char *getPath();
+    State getState();
 
     Body *getBody();
     HeaderMap *getHeaders();
+    Arena *getArena();
+    uint64_t getElapsed();
 
     void addHeader( const char *key, const char *value );
     void appendData( const char *data, size_t size );
@@ -50,6 +71,9 @@ public:
     int sendResponse( const char *responseData
                       , const char *responseType
                       , int statusCode );
+    int sendResponse( Buffer *responseData
+                      , const char *responseType
+                      , int statusCode );
 
 private:
     static const uint32_t header_key_size_max;
@@ -1,58 +1,125 @@
+/** ****************************************************************************
+ * @file router.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief Router class declaration. Routes are stored in a tree keyed on path
+ * segments so a lookup only walks the segments of the requested path, no
+ * matter how many routes are registered.
+ *
+ * Route paths are made of static segments and typed captures:
+ *     /api/gpio/:pin(int)/:name
+ * A capture without a type matches any segment.
+ * ****************************************************************************/
 #ifndef HTTP_ROUTER_H
 #define HTTP_ROUTER_H
 
-#include <vector>
 #include <string>
-#include <regex>
-#include <functional>
+#include <vector>
 
+#include "common/delegate.h"
 #include "http/http.h"
 #include "http/server/request.h"
 
-#define ROUTE_STRINGIZE( ARG ) #ARG
-
 namespace Http
 {
 
-class Route
+class Router
 {
 public:
-    Route();
-    const std::vector< Http::Method > &getVerbs() const;
-    uint32_t setVerbs( const std::vector< Http::Method > &verbs );
-    uint32_t setVerbs( Http::Method verb );
-    uint32_t setAction( const std::string &action );
-    uint32_t setPath( const std::string &path );
-
-    bool match( const std::string &path
-                , Method verb
-                , std::unordered_map< std::string, std::string > *paramsPtr
-                , bool *pathOkPtr
-                , bool *methodOkPtr ) const;
 
-private:
-    std::vector< Http::Method > mVerbs;
-    std::string mPath;
-    std::vector< std::string > mPathKeys;
-    std::string mAction;
-    std::regex mRegex;
-};
+    static const uint32_t max_params = 8;
 
-class Router
-{
-    using ParameterCallback = std::function< uint32_t (Request*) >;
+    enum ParamType {
+        STRING          = 0
+        , INTEGER       = 1
+        , HEX           = 2
+        , PARAM_TYPE_MAX
+    };
 
-public:
+    static const char *param_type_strings[];
+
+    enum Result {
+        FOUND                   = 0
+        , NOT_FOUND             = 1
+        , METHOD_NOT_ALLOWED    = 2
+    };
+
+    struct Param {
+        const char *key;
+        const char *value;
+        size_t length;
+        ParamType type;
+        int64_t integer;
+    };
+
+    class Match {
+    public:
+        Match();
+
+        uint32_t getCount() const;
+        const Param *getParam( const char *key ) const;
+        bool getInteger( const char *key, int64_t *value ) const;
+        std::string getString( const char *key ) const;
 
-    void addRoute( const std::string &method
-                   , const std::string &path
-                   , const std::string action );
+    private:
+        friend class Router;
+        uint32_t mCount;
+        Param mParams[ max_params ];
+    };
 
-    void processRequest( Request *request );
+    using Handler = Delegate< void ( Request*, const Match& ) >;
+
+    Router();
+    ~Router();
+
+    Router( const Router &router ) = delete;
+    Router& operator=( const Router &router ) = delete;
+
+    uint32_t addRoute( const char *methods, const char *path, Handler handler );
+    uint32_t addRoute( Method method, const char *path, Handler handler );
+
+    Result find( Method method
+                 , const char *path
+                 , const Handler **handler
+                 , Match *match );
+    Result dispatch( Request *request );
+
+    uint32_t getNumRoutes();
+
+    static ParamType stringToParamType( const char *type );
 
 private:
-    std::vector< Route > mRoutes;
 
+    struct Node {
+        std::string segment;
+        std::string key;
+        ParamType type;
+
+        // Static children are kept sorted so they can be binary searched,
+        // captures are tried in type order with the most specific first
+        std::vector< Node* > statics;
+        std::vector< Node* > params;
+
+        Handler handlers[ DELETE + 1 ];
+        bool routed;
+
+        Node();
+        ~Node();
+    };
+
+    Node mRoot;
+    uint32_t mNumRoutes;
+
+    Node *insertStatic( Node *parent, const char *segment, size_t length );
+    Node *insertParam( Node *parent, const char *segment, size_t length );
+    Node *findStatic( Node *parent, const char *segment, size_t length );
+
+    bool matchNode( Node *node, const char *path, Match *match, Node **found );
+
+    static bool parseParam( ParamType type
+                            , const char *segment
+                            , size_t length
+                            , int64_t *integer );
 };
 
 }
@@ -1,16 +1,29 @@
 #ifndef HTTP_SERVER_H
 #define HTTP_SERVER_H
 
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string>
 #include <string.h>
+#include <thread>
 #include <microhttpd.h>
 
 
+#include "common/buffer.h"
+#include "common/codec.h"
+#include "common/histogram.h"
 #include "common/cjson/cJSON.h"
 #include "common/control/control.h"
 #include "common/command/command_handler.h"
+#include "common/command/command_queue.h"
 
 #include "http/http.h"
+#include "http/server/asset.h"
+#include "http/server/event_stream.h"
 #include "http/server/request.h"
+#include "http/server/router.h"
+#include "http/server/websocket.h"
 
 #define POST_BUFFER_SIZE 512
 
@@ -26,30 +39,89 @@ class Server
     static const char *response_success;
     static const char *response_failed;
     static const char *response_bad_request;
+    static const char *response_unavailable;
+    static const char *response_not_found;
+    static const char *response_method_not_allowed;
 
     static const char *type_text_html;
     static const char *type_text_javascript;
+    static const char *type_text_metrics;
 
     static const char *path_base;
     static const char *path_index_html;
     static const char *path_bundle_js;
+    static const char *path_upload;
+    static const char *path_events;
+    static const char *path_websocket;
+    static const char *path_metrics;
+
+    static const uint32_t default_thread_pool_size;
+    static const uint32_t default_max_sessions;
+
+    static const size_t body_reserve_max;
+
+    static const char *default_upload_directory;
 
 public:
+
+    enum Threading {
+        THREAD_PER_CONNECTION   = 0
+        , THREAD_POOL           = 1
+        , THREADING_MAX
+    };
+
+    static const char *threading_strings[];
+
     Server( const char *index
+            , size_t indexSize
             , const char *main
+            , size_t mainSize
             , uint16_t port = default_port
-            , bool secure = false );
+            , bool secure = false
+            , Threading threading = Threading::THREAD_PER_CONNECTION
+            , uint32_t poolSize = default_thread_pool_size );
     ~Server();
 
     bool listen();
     void stop();
 
+    uint32_t applySettings() override;
+
     void setCommandHandler( CommandHandler *handler );
+    void setCommandQueue( CommandQueue *queue );
+
+    CommandQueue *getCommandQueue();
+    Asset *getIndexHtml();
+    Asset *getMainJs();
+    EventStream *getEventStream();
+    Histogram *getLatency();
+
+    uint32_t setThreading( Threading threading );
+    uint32_t setThreadPoolSize( uint32_t size );
+    uint32_t setUploadDirectory( const char *directory );
+    uint32_t setUploadPreallocate( bool preallocate );
+    uint32_t setUploadDirect( bool direct );
+    uint32_t setMaxSessions( uint32_t max );
 
     bool isRunning();
     bool isSecure();
 
     uint32_t getPort();
+    Threading getThreading();
+    uint32_t getThreadPoolSize();
+
+    std::string getUploadDirectory();
+    bool isUploadPreallocate();
+    bool isUploadDirect();
+    uint64_t getUploadFiles();
+    uint64_t getUploadBytes();
+    uint64_t getUploadFailures();
+    uint64_t getUploadThroughput();
+    uint32_t getSessions();
+    uint32_t getMaxSessions();
+
+    static Threading stringToThreading( const char *threading );
+    static const char *threadingToString( Threading threading );
 
     static int iterateHeaderValues(
             void *cls
@@ -82,6 +154,12 @@ public:
 
 
     void process( Request *request );
+    void processIndex( Request *request, const Router::Match &match );
+    void processMain( Request *request, const Router::Match &match );
+    void processPost( Request *request, const Router::Match &match );
+    void processEvents( Request *request, const Router::Match &match );
+    void processWebSocket( Request *request, const Router::Match &match );
+    void processMetrics( Request *request, const Router::Match &match );
     // void processRequest( Request *request );
 
     uint32_t getNumConnections();
@@ -95,10 +173,59 @@ public:
 private:
     MHD_Daemon *mServerDaemon;
     CommandHandler *mCommandHandler;
-    const char *mIndexHtml;
-    const char *mMainJs;
+    CommandQueue *mCommandQueue;
+    Asset mIndexHtml;
+    Asset mMainJs;
+    EventStream mEventStream;
+    Router mRouter;
+    Histogram mLatency;
     uint16_t mPort;
     bool mSecure;
+    Threading mThreading;
+    uint32_t mThreadPoolSize;
+    std::atomic< bool > mRestart;
+    std::atomic< uint32_t > mSuspended;
+
+    std::mutex mRestartMutex;
+    std::thread *mRestartThread;
+    bool mRestarting;
+
+    std::mutex mUploadMutex;
+    std::string mUploadDirectory;
+    std::atomic< uint32_t > mUploadFlags;
+    std::atomic< uint64_t > mUploadFiles;
+    std::atomic< uint64_t > mUploadBytes;
+    std::atomic< uint64_t > mUploadTime;
+    std::atomic< uint64_t > mUploadFailures;
+
+    std::mutex mSessionMutex;
+    std::list< WebSocket* > mSessions;
+    uint32_t mMaxSessions;
+
+    void restart();
+
+    bool queueCommand( Request *request );
+    void respondCommand( Request *request );
+    bool finishUpload( Request *request );
+
+    void onMessage( WebSocket *session, const char *data, size_t size );
+    void reapSessions();
+
+    static void writeSummary( Buffer *buffer, const char *name
+                              , const char *labels, Histogram *histogram );
+
+    static Codec::Encoding getEncoding( Request *request );
+    static const char *getResponseType( Codec::Encoding encoding );
+    void closeSessions();
+
+    static void onUpgrade( void *cls
+                           , MHD_Connection *connection
+                           , void *request
+                           , const char *extra
+                           , size_t extraSize
+                           , MHD_socket socket
+                           , MHD_UpgradeResponseHandle *handle );
+    static void finishMessage( cJSON *command, cJSON *response, bool rejected );
 };
 
 }
@@ -0,0 +1,84 @@
+/** ****************************************************************************
+ * @file upload.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief Upload class declaration. Writes an uploaded file to disk as it
+ * arrives so the body never has to be held in memory.
+ * ****************************************************************************/
+#ifndef HTTP_UPLOAD_H
+#define HTTP_UPLOAD_H
+
+#include <chrono>
+#include <stdint.h>
+#include <string>
+
+namespace Http
+{
+
+class Upload
+{
+    static const size_t direct_alignment;
+    static const size_t direct_buffer_size;
+    static const uint64_t preallocate_max;
+    static const uint64_t preallocate_reserve;
+
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    enum Flags : uint32_t {
+        NONE            = 0x0
+        , PREALLOCATE   = 0x1
+        , DIRECT        = 0x2
+    };
+
+    Upload( const char *directory, uint32_t flags, uint64_t expected );
+    ~Upload();
+
+    Upload( const Upload &upload ) = delete;
+    Upload& operator=( const Upload &upload ) = delete;
+
+    bool open( const char *filename );
+    bool write( const char *data, size_t size );
+    bool close();
+    void abort();
+
+    bool isOpen();
+    bool isFailed();
+
+    const char *getFilename();
+    uint32_t getFiles();
+    uint64_t getWritten();
+    uint64_t getElapsed();
+
+    static bool sanitizeFilename( const char *filename, std::string &name );
+
+private:
+    std::string mDirectory;
+    std::string mFilename;
+    std::string mPath;
+    uint32_t mFlags;
+    uint64_t mExpected;
+
+    int mFd;
+    bool mDirect;
+    bool mFailed;
+
+    char *mStage;
+    size_t mStaged;
+
+    uint64_t mFileWritten;
+    Clock::time_point mStart;
+
+    uint32_t mFiles;
+    uint64_t mWritten;
+    uint64_t mElapsed;
+
+    bool writeAll( const char *data, size_t size );
+    bool flushStage( bool final );
+    uint64_t getPreallocation();
+};
+
+}
+
+#endif // HTTP_UPLOAD_H
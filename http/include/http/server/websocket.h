@@ -0,0 +1,111 @@
+/** ****************************************************************************
+ * @file websocket.h
+ * @author Trevor Horst
+ * @copyright
+ * @brief WebSocket class declaration. Runs one RFC 6455 session over a
+ * connection the server has upgraded. Frames are read on a dedicated thread
+ * and every complete message is passed to a handler, replies may be sent from
+ * any thread.
+ * ****************************************************************************/
+#ifndef HTTP_WEBSOCKET_H
+#define HTTP_WEBSOCKET_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <microhttpd.h>
+
+#include "common/buffer.h"
+
+namespace Http
+{
+
+class WebSocket
+{
+    static const size_t message_size_max;
+    static const char *accept_guid;
+
+public:
+
+    enum Opcode : uint8_t {
+        CONTINUATION    = 0x0
+        , TEXT          = 0x1
+        , BINARY        = 0x2
+        , CLOSE         = 0x8
+        , PING          = 0x9
+        , PONG          = 0xA
+    };
+
+    enum Status : uint16_t {
+        NORMAL              = 1000
+        , GOING_AWAY        = 1001
+        , PROTOCOL_ERROR    = 1002
+        , UNSUPPORTED       = 1003
+        , TOO_BIG           = 1009
+        , INTERNAL_ERROR    = 1011
+    };
+
+    static const size_t accept_size = 29;
+
+    using MessageHandler = std::function< void ( WebSocket*, const char*, size_t ) >;
+
+    WebSocket( MHD_socket socket
+               , MHD_UpgradeResponseHandle *handle
+               , const char *extra
+               , size_t extraSize
+               , MessageHandler handler );
+    ~WebSocket();
+
+    WebSocket( const WebSocket &socket ) = delete;
+    WebSocket& operator=( const WebSocket &socket ) = delete;
+
+    void start();
+    void stop();
+    void close( Status status );
+
+    bool send( const char *data, size_t size, Opcode opcode = Opcode::TEXT );
+
+    void acquire();
+    void release();
+
+    bool isOpen();
+    bool isDone();
+
+    static bool createAccept( const char *key, char *accept );
+
+private:
+    MHD_socket mSocket;
+    MHD_UpgradeResponseHandle *mHandle;
+    MessageHandler mHandler;
+
+    Buffer mExtra;
+    size_t mExtraOffset;
+
+    std::thread *mThread;
+    std::mutex mSendMutex;
+    std::atomic< bool > mOpen;
+    std::atomic< bool > mFinished;
+    std::atomic< bool > mReleased;
+    bool mCloseSent;
+
+    std::mutex mPendingMutex;
+    std::condition_variable mPendingCondition;
+    uint32_t mPending;
+
+    Buffer mMessage;
+    bool mFragmented;
+
+    void run();
+    bool readFrame();
+    bool readExact( char *data, size_t size );
+    bool sendFrame( Opcode opcode, const char *data, size_t size );
+    void sendClose( Status status );
+    void releaseConnection();
+};
+
+}
+
+#endif // HTTP_WEBSOCKET_H
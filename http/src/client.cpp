@@ -1,6 +1,8 @@
 #include <cstdlib>
 #include <string.h>
 
+#include "common/codec.h"
+#include "common/json_parser.h"
 #include "common/cjson/cJSON.h"
 
 #include "http/client.h"
@@ -110,23 +112,47 @@ uint32_t Client::applyWriteFunction( WriteFunction *function )
 }
 
 /**
- * @brief Sends a message
- * @param str Message to send
+ * @brief Sends a message, converted to MessagePack first when that's the
+ * encoding the client is set to
+ * @param str JSON message to send
  */
 uint32_t Client::send( const char *str )
 {
     uint32_t error = Error::Code::NONE;
+    Codec::Encoding encoding = getEncoding();
+
+    const char *body = str;
+    size_t bodySize = strlen( str );
+
+    Buffer encoded;
+    if( encoding != Codec::Encoding::JSON ) {
+        cJSON *message = JsonParser::parse( str, bodySize );
+        bool ok = ( message != nullptr )
+                && Codec::encode( message, encoding, &encoded );
+        cJSON_Delete( message );
+
+        if( !ok ) {
+            fprintf( stderr, "failed to encode the message as %s\n"
+                     , Codec::encodingToString( encoding ) );
+            return Error::Code::SYNTAX;
+        }
+        body = encoded.getData();
+        bodySize = encoded.getSize();
+    }
 
     // Create the headers
+    std::string contentType = std::string( "Content-Type: " )
+            + Codec::encodingToContentType( encoding );
     struct curl_slist *headers = nullptr;
-    headers = curl_slist_append( headers, "Content-Type: application/json" );
+    headers = curl_slist_append( headers, contentType.c_str() );
     headers = curl_slist_append( headers, "charset=utf-8" );
 
     // Set the options for cURL
     curl_easy_setopt( mCurl,           CURLOPT_URL, mUrl.c_str() );
     curl_easy_setopt( mCurl,    CURLOPT_HTTPHEADER, headers );
     curl_easy_setopt( mCurl,  CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1 );
-    curl_easy_setopt( mCurl,    CURLOPT_POSTFIELDS, str );
+    curl_easy_setopt( mCurl, CURLOPT_POSTFIELDSIZE, static_cast< long >( bodySize ) );
+    curl_easy_setopt( mCurl,    CURLOPT_POSTFIELDS, body );
     curl_easy_setopt( mCurl,      CURLOPT_NOSIGNAL, 0 );
     curl_easy_setopt( mCurl, CURLOPT_WRITEFUNCTION, Client::writeFunction );
     curl_easy_setopt( mCurl,     CURLOPT_WRITEDATA, &mDataString );
@@ -144,8 +170,14 @@ uint32_t Client::send( const char *str )
         fprintf( stderr, "curl_easy_perform() failed: %s\n",
                       curl_easy_strerror( res ) );
     } else {
-        // Handle the response
-        printf( "%s\n", mDataString.c_str() );
+        // Handle the response, the server answers in the encoding it was sent
+        // and compactly, so lay it out as JSON for reading on the console
+        cJSON *rsp = Codec::decode( mDataString.data(), mDataString.size()
+                                    , encoding );
+        char *rspStr = ( rsp != nullptr ) ? cJSON_Print( rsp ) : nullptr;
+        printf( "%s\n", ( rspStr != nullptr ) ? rspStr : mDataString.c_str() );
+        cJSON_free( rspStr );
+        cJSON_Delete( rsp );
     }
 
     mDataString.clear();
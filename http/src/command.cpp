@@ -3,28 +3,281 @@
 CommandServer::CommandServer()
     : CommandTemplate< Http::Server >( COMMAND_SERVER, COMMAND_QSERVER )
 {
-    mAccessorMap[ PARAM_ACTIVE ] = PARAMETER_CALLBACK( &CommandServer::getActive );
-    mAccessorMap[ PARAM_PORT ]   = PARAMETER_CALLBACK( &CommandServer::getPort );
-    mAccessorMap[ PARAM_SECURE ] = PARAMETER_CALLBACK( &CommandServer::getSecure );
+    addMutator( PARAM_THREADING, &CommandServer::setThreading, CommandSchema::STRING );
+    addMutator( PARAM_POOL, &CommandServer::setPool, CommandSchema::NUMBER );
+    addMutator( PARAM_UPLOAD_DIR, &CommandServer::setUploadDirectory
+                , CommandSchema::STRING );
+    addMutator( PARAM_UPLOAD_DIRECT, &CommandServer::setUploadDirect
+                , CommandSchema::BOOLEAN );
+    addMutator( PARAM_UPLOAD_PREALLOCATE, &CommandServer::setUploadPreallocate
+                , CommandSchema::BOOLEAN );
+    addMutator( PARAM_SUBSCRIBERS, &CommandServer::setSubscribers
+                , CommandSchema::NUMBER );
+    addMutator( PARAM_SESSIONS, &CommandServer::setSessions, CommandSchema::NUMBER );
+
+    addAccessor( PARAM_ACTIVE, &CommandServer::getActive );
+    addAccessor( PARAM_PORT, &CommandServer::getPort );
+    addAccessor( PARAM_SECURE, &CommandServer::getSecure );
+    addAccessor( PARAM_THREADING, &CommandServer::getThreading );
+    addAccessor( PARAM_POOL, &CommandServer::getPool );
+    addAccessor( PARAM_CONNECTIONS, &CommandServer::getConnections );
+    addAccessor( PARAM_QUEUE, &CommandServer::getQueue );
+    addAccessor( PARAM_UPLOAD, &CommandServer::getUpload );
+    addAccessor( PARAM_UPLOAD_DIR, &CommandServer::getUploadDirectory );
+    addAccessor( PARAM_UPLOAD_DIRECT, &CommandServer::getUploadDirect );
+    addAccessor( PARAM_UPLOAD_PREALLOCATE, &CommandServer::getUploadPreallocate );
+    addAccessor( PARAM_EVENTS, &CommandServer::getEvents );
+    addAccessor( PARAM_WEBSOCKET, &CommandServer::getWebSocket );
+    addAccessor( PARAM_ARENA, &CommandServer::getArena );
+    addAccessor( PARAM_LATENCY, &CommandServer::getLatency );
+
+    // Not cached, connection, queue and latency counters move with every
+    // request and a stale copy would misreport them
+}
+
+uint32_t CommandServer::setThreading( cJSON *val )
+{
+    uint32_t r = Error::Code::NONE;
+    if( cJSON_IsString( val ) ) {
+        Http::Server::Threading threading
+                = Http::Server::stringToThreading( val->valuestring );
+        if( threading == Http::Server::Threading::THREADING_MAX ) {
+            r = Error::Code::PARAM_OUT_OF_RANGE;
+        } else {
+            r = getControl()->setThreading( threading );
+        }
+    } else {
+        r = Error::Code::SYNTAX;
+    }
+    return r;
+}
+
+uint32_t CommandServer::setPool( cJSON *val )
+{
+    uint32_t r = Error::Code::NONE;
+    if( cJSON_IsNumber( val ) ) {
+        if( val->valueint <= 0 ) {
+            r = Error::Code::PARAM_OUT_OF_RANGE;
+        } else {
+            r = getControl()->setThreadPoolSize(
+                        static_cast< uint32_t >( val->valueint ) );
+        }
+    } else {
+        r = Error::Code::SYNTAX;
+    }
+    return r;
+}
+
+uint32_t CommandServer::setUploadDirectory( cJSON *val )
+{
+    uint32_t r = Error::Code::NONE;
+    if( cJSON_IsString( val ) ) {
+        r = getControl()->setUploadDirectory( val->valuestring );
+    } else {
+        r = Error::Code::SYNTAX;
+    }
+    return r;
+}
+
+uint32_t CommandServer::setUploadDirect( cJSON *val )
+{
+    uint32_t r = Error::Code::NONE;
+    if( cJSON_IsBool( val ) ) {
+        r = getControl()->setUploadDirect( cJSON_IsTrue( val ) );
+    } else {
+        r = Error::Code::SYNTAX;
+    }
+    return r;
+}
+
+uint32_t CommandServer::setUploadPreallocate( cJSON *val )
+{
+    uint32_t r = Error::Code::NONE;
+    if( cJSON_IsBool( val ) ) {
+        r = getControl()->setUploadPreallocate( cJSON_IsTrue( val ) );
+    } else {
+        r = Error::Code::SYNTAX;
+    }
+    return r;
+}
+
+uint32_t CommandServer::setSubscribers( cJSON *val )
+{
+    uint32_t r = Error::Code::NONE;
+    if( cJSON_IsNumber( val ) ) {
+        if( val->valueint < 0 ) {
+            r = Error::Code::PARAM_OUT_OF_RANGE;
+        } else {
+            r = getControl()->getEventStream()->setMaxSubscribers(
+                        static_cast< uint32_t >( val->valueint ) );
+        }
+    } else {
+        r = Error::Code::SYNTAX;
+    }
+    return r;
+}
+
+uint32_t CommandServer::setSessions( cJSON *val )
+{
+    uint32_t r = Error::Code::NONE;
+    if( cJSON_IsNumber( val ) ) {
+        if( val->valueint < 0 ) {
+            r = Error::Code::PARAM_OUT_OF_RANGE;
+        } else {
+            r = getControl()->setMaxSessions(
+                        static_cast< uint32_t >( val->valueint ) );
+        }
+    } else {
+        r = Error::Code::SYNTAX;
+    }
+    return r;
 }
 
 uint32_t CommandServer::getPort( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
-    cJSON_AddNumberToObject( response, PARAM_PORT, mControlObject->getPort() );
+    cJSON_AddNumberToObject( response, PARAM_PORT, getControl()->getPort() );
     return r;
 }
 
 uint32_t CommandServer::getActive( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
-    cJSON_AddBoolToObject( response, PARAM_ACTIVE, mControlObject->isRunning() );
+    cJSON_AddBoolToObject( response, PARAM_ACTIVE, getControl()->isRunning() );
     return r;
 }
 
 uint32_t CommandServer::getSecure( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
-    cJSON_AddBoolToObject( response, PARAM_SECURE, mControlObject->isSecure() );
+    cJSON_AddBoolToObject( response, PARAM_SECURE, getControl()->isSecure() );
+    return r;
+}
+
+uint32_t CommandServer::getThreading( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    cJSON_AddStringToObject( response, PARAM_THREADING
+                             , Http::Server::threadingToString(
+                                 getControl()->getThreading() ) );
+    return r;
+}
+
+uint32_t CommandServer::getPool( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    cJSON_AddNumberToObject( response, PARAM_POOL
+                             , getControl()->getThreadPoolSize() );
+    return r;
+}
+
+uint32_t CommandServer::getConnections( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    cJSON_AddNumberToObject( response, PARAM_CONNECTIONS
+                             , getControl()->getNumConnections() );
+    return r;
+}
+
+uint32_t CommandServer::getQueue( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    CommandQueue *queue = getControl()->getCommandQueue();
+    if( queue == nullptr ) {
+        // Commands are executed inline
+        cJSON_AddNullToObject( response, PARAM_QUEUE );
+    } else {
+        cJSON *q = cJSON_CreateObject();
+        cJSON_AddNumberToObject( q, PARAM_WORKERS, queue->getWorkers() );
+        cJSON_AddNumberToObject( q, PARAM_CAPACITY, queue->getCapacity() );
+        cJSON_AddNumberToObject( q, PARAM_DEPTH, queue->getDepth() );
+        cJSON_AddNumberToObject( q, PARAM_MAX_DEPTH, queue->getMaxDepth() );
+        cJSON_AddNumberToObject( q, PARAM_PROCESSED, queue->getProcessed() );
+        cJSON_AddNumberToObject( q, PARAM_REJECTED, queue->getRejected() );
+        cJSON_AddNumberToObject( q, PARAM_WAIT_AVG, queue->getAverageWait() );
+        cJSON_AddNumberToObject( q, PARAM_WAIT_MAX, queue->getMaxWait() );
+        cJSON_AddItemToObject( response, PARAM_QUEUE, q );
+    }
+    return r;
+}
+
+uint32_t CommandServer::getUpload( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    cJSON *u = cJSON_CreateObject();
+    cJSON_AddNumberToObject( u, PARAM_FILES, getControl()->getUploadFiles() );
+    cJSON_AddNumberToObject( u, PARAM_BYTES, getControl()->getUploadBytes() );
+    cJSON_AddNumberToObject( u, PARAM_FAILURES
+                             , getControl()->getUploadFailures() );
+    cJSON_AddNumberToObject( u, PARAM_THROUGHPUT
+                             , getControl()->getUploadThroughput() );
+    cJSON_AddItemToObject( response, PARAM_UPLOAD, u );
+    return r;
+}
+
+uint32_t CommandServer::getUploadDirectory( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    cJSON_AddStringToObject( response, PARAM_UPLOAD_DIR
+                             , getControl()->getUploadDirectory().c_str() );
+    return r;
+}
+
+uint32_t CommandServer::getUploadDirect( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    cJSON_AddBoolToObject( response, PARAM_UPLOAD_DIRECT
+                           , getControl()->isUploadDirect() );
+    return r;
+}
+
+uint32_t CommandServer::getUploadPreallocate( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    cJSON_AddBoolToObject( response, PARAM_UPLOAD_PREALLOCATE
+                           , getControl()->isUploadPreallocate() );
+    return r;
+}
+
+uint32_t CommandServer::getEvents( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    Http::EventStream *stream = getControl()->getEventStream();
+    cJSON *e = cJSON_CreateObject();
+    cJSON_AddNumberToObject( e, PARAM_SUBSCRIBERS, stream->getSubscribers() );
+    cJSON_AddNumberToObject( e, PARAM_MAX, stream->getMaxSubscribers() );
+    cJSON_AddNumberToObject( e, PARAM_DEPTH, stream->getQueueDepth() );
+    cJSON_AddNumberToObject( e, PARAM_PUBLISHED, stream->getPublished() );
+    cJSON_AddNumberToObject( e, PARAM_DROPPED, stream->getDropped() );
+    cJSON_AddNumberToObject( e, PARAM_DISCONNECTED, stream->getDisconnected() );
+    cJSON_AddItemToObject( response, PARAM_EVENTS, e );
+    return r;
+}
+
+uint32_t CommandServer::getWebSocket( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    cJSON *w = cJSON_CreateObject();
+    cJSON_AddNumberToObject( w, PARAM_SESSIONS, getControl()->getSessions() );
+    cJSON_AddNumberToObject( w, PARAM_MAX, getControl()->getMaxSessions() );
+    cJSON_AddItemToObject( response, PARAM_WEBSOCKET, w );
+    return r;
+}
+
+uint32_t CommandServer::getArena( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    cJSON *a = cJSON_CreateObject();
+    cJSON_AddNumberToObject( a, PARAM_ALLOCATIONS, Arena::getArenaAllocations() );
+    cJSON_AddNumberToObject( a, PARAM_HEAP, Arena::getHeapAllocations() );
+    cJSON_AddItemToObject( response, PARAM_ARENA, a );
+    return r;
+}
+
+uint32_t CommandServer::getLatency( cJSON *response )
+{
+    uint32_t r = Error::Code::NONE;
+    cJSON_AddItemToObject( response, PARAM_LATENCY
+                           , CommandMetrics::createSummary( getControl()->getLatency() ) );
     return r;
 }
@@ -0,0 +1,316 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "common/error/error.h"
+#include "common/logger/log.h"
+#include "http/server/asset.h"
+
+namespace Http
+{
+
+// Let browsers keep a copy but check back with the ETag before using it
+const char *Asset::cache_control     = "no-cache";
+const char *Asset::vary              = "Accept-Encoding";
+const char *Asset::encoding_identity = "identity";
+
+/**
+ * @brief Constructor
+ * @param data Asset data, must stay valid for the life of the asset
+ * @param size Size of the data in bytes
+ * @param type Content type of the asset
+ */
+Asset::Asset( const char *data, size_t size, const char *type )
+    : mType( type )
+    , mHash( 0xcbf29ce484222325ULL )
+{
+    // FNV-1a over the content, the data never changes so neither does the tag
+    for( size_t i = 0; i < size; i++ ) {
+        mHash ^= static_cast< uint8_t >( data[ i ] );
+        mHash *= 0x100000001b3ULL;
+    }
+
+    Variant variant;
+    variant.encoding = encoding_identity;
+    variant.size     = size;
+    snprintf( variant.etag, sizeof( variant.etag ), "\"%016" PRIx64 "\"", mHash );
+
+    if( !createVariant( variant, data ) ) {
+        LOG_ERROR( "failed to create asset response" );
+    }
+    mVariants.push_back( variant );
+}
+
+/**
+ * @brief Destructor
+ */
+Asset::~Asset()
+{
+    for( auto it = mVariants.begin(); it != mVariants.end(); it++ ) {
+        if( it->response ) {
+            MHD_destroy_response( it->response );
+        }
+        if( it->notModified ) {
+            MHD_destroy_response( it->notModified );
+        }
+    }
+}
+
+/**
+ * @brief Adds a precompressed copy of the asset. Variants must be added before
+ * the server starts serving the asset.
+ * @param encoding Content coding of the data, e.g. gzip or br
+ * @param data Encoded data, must stay valid for the life of the asset
+ * @param size Size of the encoded data in bytes
+ * @return Error code
+ */
+uint32_t Asset::addEncoding( const char *encoding, const char *data, size_t size )
+{
+    uint32_t r = Error::Code::NONE;
+
+    if( encoding == nullptr || data == nullptr || size == 0 ) {
+        r = Error::Code::PARAM_INVALID;
+    } else {
+        // Each representation needs its own tag so caches don't mix them up
+        Variant variant;
+        variant.encoding = encoding;
+        variant.size     = size;
+        snprintf( variant.etag, sizeof( variant.etag )
+                  , "\"%016" PRIx64 "-%s\"", mHash, encoding );
+
+        if( createVariant( variant, data ) ) {
+            mVariants.push_back( variant );
+        } else {
+            LOG_ERROR( "failed to create %s asset response", encoding );
+            r = Error::Code::GENERIC;
+        }
+    }
+
+    return r;
+}
+
+/**
+ * @brief Queues the asset on a connection using the smallest representation
+ * the client accepts. A conditional request for the current version is
+ * answered with 304 Not Modified.
+ * @param connection Connection to respond on
+ * @return Integer indicating the success of the operation
+ */
+int Asset::serve( MHD_Connection *connection )
+{
+    Variant *variant = select( MHD_lookup_connection_value(
+                connection
+                , MHD_HEADER_KIND
+                , MHD_HTTP_HEADER_ACCEPT_ENCODING ) );
+
+    if( variant == nullptr ) {
+        return MHD_NO;
+    }
+
+    const char *ifNoneMatch = MHD_lookup_connection_value(
+                connection
+                , MHD_HEADER_KIND
+                , MHD_HTTP_HEADER_IF_NONE_MATCH );
+
+    if( matches( variant, ifNoneMatch ) ) {
+        return MHD_queue_response( connection, MHD_HTTP_NOT_MODIFIED
+                                   , variant->notModified );
+    }
+
+    return MHD_queue_response( connection, MHD_HTTP_OK, variant->response );
+}
+
+/**
+ * @brief Retrieves the entity tag of the unencoded asset
+ * @return Quoted entity tag
+ */
+const char *Asset::getETag()
+{
+    return mVariants.front().etag;
+}
+
+/**
+ * @brief Retrieves the size of the unencoded asset
+ * @return Size in bytes
+ */
+size_t Asset::getSize()
+{
+    return mVariants.front().size;
+}
+
+/**
+ * @brief Builds the full and not modified responses for a representation
+ * @param variant Representation to build
+ * @param data Representation data
+ * @return Boolean indicating the responses were created
+ */
+bool Asset::createVariant( Variant &variant, const char *data )
+{
+    variant.response = MHD_create_response_from_buffer(
+                variant.size
+                , const_cast< char* >( data )
+                , MHD_RESPMEM_PERSISTENT );
+    variant.notModified = MHD_create_response_from_buffer(
+                0
+                , nullptr
+                , MHD_RESPMEM_PERSISTENT );
+
+    if( variant.response == nullptr || variant.notModified == nullptr ) {
+        if( variant.response ) {
+            MHD_destroy_response( variant.response );
+            variant.response = nullptr;
+        }
+        if( variant.notModified ) {
+            MHD_destroy_response( variant.notModified );
+            variant.notModified = nullptr;
+        }
+        return false;
+    }
+
+    MHD_Response *responses[] = { variant.response, variant.notModified };
+    for( MHD_Response *response : responses ) {
+        MHD_add_response_header( response, MHD_HTTP_HEADER_ETAG, variant.etag );
+        MHD_add_response_header( response, MHD_HTTP_HEADER_CACHE_CONTROL
+                                 , cache_control );
+        MHD_add_response_header( response, MHD_HTTP_HEADER_VARY, vary );
+    }
+
+    MHD_add_response_header( variant.response, MHD_HTTP_HEADER_CONTENT_TYPE
+                             , mType );
+    if( variant.encoding != encoding_identity ) {
+        MHD_add_response_header( variant.response
+                                 , MHD_HTTP_HEADER_CONTENT_ENCODING
+                                 , variant.encoding );
+    }
+
+    return true;
+}
+
+/**
+ * @brief Picks the smallest representation the client accepts
+ * @param acceptEncoding Accept-Encoding header value, may be nullptr
+ * @return Pointer to the representation, nullptr if none could be created
+ */
+Asset::Variant *Asset::select( const char *acceptEncoding )
+{
+    Variant *selected = nullptr;
+
+    for( auto it = mVariants.begin(); it != mVariants.end(); it++ ) {
+        if( it->response == nullptr ) {
+            continue;
+        }
+
+        // Identity is always acceptable, anything else has to be asked for
+        if( it->encoding != encoding_identity
+                && quality( acceptEncoding, it->encoding ) <= 0 ) {
+            continue;
+        }
+
+        if( selected == nullptr || it->size < selected->size ) {
+            selected = &( *it );
+        }
+    }
+
+    return selected;
+}
+
+/**
+ * @brief Determines if an If-None-Match header names the current version
+ * @param variant Representation being served
+ * @param ifNoneMatch Header value, may be nullptr
+ * @return Boolean indicating a match
+ */
+bool Asset::matches( Variant *variant, const char *ifNoneMatch )
+{
+    if( ifNoneMatch == nullptr ) {
+        return false;
+    }
+
+    size_t length = strlen( variant->etag );
+    const char *c = ifNoneMatch;
+
+    while( *c != '\0' ) {
+        // Skip separators between tags
+        while( *c == ' ' || *c == '\t' || *c == ',' ) {
+            c++;
+        }
+
+        if( *c == '*' ) {
+            return true;
+        }
+
+        // Weak comparison is fine for a GET
+        if( c[ 0 ] == 'W' && c[ 1 ] == '/' ) {
+            c += 2;
+        }
+
+        if( strncmp( c, variant->etag, length ) == 0
+                && ( c[ length ] == '\0' || c[ length ] == ','
+                     || c[ length ] == ' ' || c[ length ] == '\t' ) ) {
+            return true;
+        }
+
+        // Move on to the next tag
+        while( *c != '\0' && *c != ',' ) {
+            c++;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Finds the quality value an Accept-Encoding header gives a coding
+ * @param acceptEncoding Accept-Encoding header value, may be nullptr
+ * @param encoding Content coding to look for
+ * @return Quality value, a named coding takes precedence over *, 0 if the
+ * coding isn't accepted
+ */
+float Asset::quality( const char *acceptEncoding, const char *encoding )
+{
+    if( acceptEncoding == nullptr ) {
+        return 0;
+    }
+
+    float named    = -1;
+    float wildcard = -1;
+    size_t length  = strlen( encoding );
+    const char *c  = acceptEncoding;
+
+    while( *c != '\0' ) {
+        while( *c == ' ' || *c == '\t' || *c == ',' ) {
+            c++;
+        }
+
+        // Coding name
+        const char *name = c;
+        while( *c != '\0' && *c != ',' && *c != ';' && *c != ' ' && *c != '\t' ) {
+            c++;
+        }
+        size_t nameLength = static_cast< size_t >( c - name );
+
+        // Optional parameters, only q is of interest
+        float q = 1;
+        while( *c != '\0' && *c != ',' ) {
+            if( ( *c == 'q' || *c == 'Q' ) && c[ 1 ] == '=' ) {
+                q = strtof( c + 2, nullptr );
+            }
+            c++;
+        }
+
+        if( nameLength == length && strncasecmp( name, encoding, length ) == 0 ) {
+            named = q;
+        } else if( nameLength == 1 && name[ 0 ] == '*' ) {
+            wildcard = q;
+        }
+    }
+
+    if( named >= 0 ) {
+        return named;
+    }
+    return ( wildcard >= 0 ) ? wildcard : 0;
+}
+
+}
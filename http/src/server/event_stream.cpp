@@ -0,0 +1,395 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/error/error.h"
+#include "common/logger/log.h"
+#include "http/server/event_stream.h"
+
+namespace Http
+{
+
+const uint32_t EventStream::default_max_subscribers = 8;
+const uint32_t EventStream::default_queue_depth     = 64;
+const size_t EventStream::block_size                = 1024;
+const char *EventStream::type_text_event_stream     = "text/event-stream";
+const char *EventStream::cache_control              = "no-cache";
+
+/**
+ * @brief Constructor
+ * @param maxSubscribers Maximum number of clients streaming at once
+ * @param queueDepth Number of events kept for each client, also the number of
+ * events replayed to a client that reconnects
+ */
+EventStream::EventStream( uint32_t maxSubscribers, uint32_t queueDepth )
+    : mMaxSubscribers( maxSubscribers )
+    , mQueueDepth( queueDepth )
+    , mLastId( 0 )
+    , mClosed( false )
+    , mPublished( 0 )
+    , mDropped( 0 )
+    , mDisconnected( 0 )
+{
+}
+
+/**
+ * @brief Destructor. The daemon must be stopped first, MHD releases the
+ * subscribers as it tears down their connections.
+ */
+EventStream::~EventStream()
+{
+}
+
+/**
+ * @brief Allows clients to subscribe again after the stream was closed
+ */
+void EventStream::open()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    mClosed = false;
+}
+
+/**
+ * @brief Ends every stream once its queued events have been sent. Must be
+ * called before the daemon is stopped since suspended connections can't be
+ * torn down.
+ */
+void EventStream::close()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    mClosed = true;
+    for( auto it = mSubscribers.begin(); it != mSubscribers.end(); it++ ) {
+        wake( *it );
+    }
+}
+
+/**
+ * @brief Publishes an event to every subscriber
+ * @param event Event name, must not contain line breaks
+ * @param data Event data, ownership remains with the caller
+ * @return Error code
+ */
+uint32_t EventStream::publish( const char *event, cJSON *data )
+{
+    uint32_t r = Error::Code::NONE;
+
+    if( event == nullptr || data == nullptr ) {
+        return Error::Code::PARAM_INVALID;
+    }
+
+    // Unformatted JSON never spans more than one data line
+    char *json = cJSON_PrintUnformatted( data );
+    if( json == nullptr ) {
+        return Error::Code::GENERIC;
+    }
+
+    std::lock_guard< std::mutex > lock( mMutex );
+
+    if( mClosed ) {
+        r = Error::Code::GENERIC;
+    } else {
+        uint64_t id = ++mLastId;
+
+        // Format once, every subscriber shares the same text
+        char header[ 64 ];
+        snprintf( header, sizeof( header ), "id: %" PRIu64 "\nevent: ", id );
+
+        std::string *text = new std::string( header );
+        text->append( event );
+        text->append( "\ndata: " );
+        text->append( json );
+        text->append( "\n\n" );
+
+        Event shared( text );
+
+        mHistory.push_back( Entry{ id, shared } );
+        if( mHistory.size() > mQueueDepth ) {
+            mHistory.pop_front();
+        }
+
+        for( auto it = mSubscribers.begin(); it != mSubscribers.end(); it++ ) {
+            enqueue( *it, shared );
+        }
+
+        mPublished++;
+    }
+
+    cJSON_free( json );
+    return r;
+}
+
+/**
+ * @brief Subscribes a connection to the stream
+ * @param connection Connection the events are streamed on
+ * @param lastEventId Last-Event-ID header of a reconnecting client, events
+ * published after it are replayed if they are still held. May be nullptr.
+ * @return Response to queue on the connection, nullptr if the stream is full
+ * or closed. The caller must destroy it once queued.
+ */
+MHD_Response *EventStream::subscribe( MHD_Connection *connection
+                                      , const char *lastEventId )
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+
+    if( mClosed || mSubscribers.size() >= mMaxSubscribers ) {
+        return nullptr;
+    }
+
+    Subscriber *subscriber = new Subscriber;
+    subscriber->stream     = this;
+    subscriber->connection = connection;
+    subscriber->offset     = 0;
+    subscriber->dropped    = 0;
+    subscriber->suspended  = false;
+    subscriber->overrun    = false;
+
+    // Send something straight away so the client sees the stream open
+    subscriber->events.push_back( Event( new std::string( ": connected\n\n" ) ) );
+
+    if( lastEventId != nullptr ) {
+        char *end = nullptr;
+        uint64_t last = strtoull( lastEventId, &end, 10 );
+        if( end != lastEventId ) {
+            for( auto it = mHistory.begin(); it != mHistory.end(); it++ ) {
+                if( it->id > last ) {
+                    subscriber->events.push_back( it->event );
+                }
+            }
+        }
+    }
+
+    MHD_Response *response = MHD_create_response_from_callback(
+                MHD_SIZE_UNKNOWN
+                , block_size
+                , &EventStream::read
+                , subscriber
+                , &EventStream::release );
+
+    if( response == nullptr ) {
+        delete subscriber;
+        return nullptr;
+    }
+
+    MHD_add_response_header( response, MHD_HTTP_HEADER_CONTENT_TYPE
+                             , type_text_event_stream );
+    MHD_add_response_header( response, MHD_HTTP_HEADER_CACHE_CONTROL
+                             , cache_control );
+
+    mSubscribers.push_back( subscriber );
+    return response;
+}
+
+/**
+ * @brief Sets the number of clients that may stream at once, existing
+ * subscribers are kept
+ * @param max Maximum number of subscribers
+ * @return Error code
+ */
+uint32_t EventStream::setMaxSubscribers( uint32_t max )
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    mMaxSubscribers = max;
+    return Error::Code::NONE;
+}
+
+/**
+ * @brief Retrieves the number of clients streaming
+ * @return Number of subscribers
+ */
+uint32_t EventStream::getSubscribers()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return static_cast< uint32_t >( mSubscribers.size() );
+}
+
+/**
+ * @brief Retrieves the number of clients that may stream at once
+ * @return Maximum number of subscribers
+ */
+uint32_t EventStream::getMaxSubscribers()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return mMaxSubscribers;
+}
+
+/**
+ * @brief Retrieves the number of events held for each client
+ * @return Queue depth
+ */
+uint32_t EventStream::getQueueDepth()
+{
+    return mQueueDepth;
+}
+
+/**
+ * @brief Retrieves the number of events published
+ * @return Number of events
+ */
+uint64_t EventStream::getPublished()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return mPublished;
+}
+
+/**
+ * @brief Retrieves the number of events dropped for slow clients
+ * @return Number of events
+ */
+uint64_t EventStream::getDropped()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return mDropped;
+}
+
+/**
+ * @brief Retrieves the number of clients disconnected for falling behind
+ * @return Number of clients
+ */
+uint64_t EventStream::getDisconnected()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return mDisconnected;
+}
+
+/**
+ * @brief Queues an event for a subscriber, dropping the oldest event when the
+ * queue is full. The stream mutex must be held.
+ * @param subscriber Subscriber to queue the event for
+ * @param event Formatted event
+ */
+void EventStream::enqueue( Subscriber *subscriber, const Event &event )
+{
+    if( subscriber->overrun ) {
+        return;
+    }
+
+    // Keep the event that is partway out the door
+    auto oldest = subscriber->events.begin();
+    if( subscriber->offset > 0 ) {
+        oldest++;
+    }
+
+    if( subscriber->events.size() >= mQueueDepth
+            && oldest != subscriber->events.end() ) {
+        subscriber->events.erase( oldest );
+        subscriber->dropped++;
+        mDropped++;
+
+        if( subscriber->dropped >= mQueueDepth ) {
+            // A whole queue has gone by without the client reading, give up
+            // on it rather than keep holding events
+            LOG_WARN( "event stream client fell behind, disconnecting" );
+            subscriber->overrun = true;
+            subscriber->events.clear();
+            wake( subscriber );
+            return;
+        }
+    }
+
+    subscriber->events.push_back( event );
+    wake( subscriber );
+}
+
+/**
+ * @brief Resumes a subscriber waiting on events. The stream mutex must be
+ * held.
+ * @param subscriber Subscriber to resume
+ */
+void EventStream::wake( Subscriber *subscriber )
+{
+    if( subscriber->suspended ) {
+        subscriber->suspended = false;
+        MHD_resume_connection( subscriber->connection );
+    }
+}
+
+/**
+ * @brief Fills a block of the response with queued events
+ * @param cls Subscriber
+ * @param pos Position in the stream, unused
+ * @param buf Buffer to fill
+ * @param max Size of the buffer
+ * @return Number of bytes written, 0 when the connection has been suspended
+ * to wait for events
+ */
+ssize_t EventStream::read( void *cls, uint64_t pos, char *buf, size_t max )
+{
+    (void)pos;
+
+    Subscriber *subscriber = static_cast< Subscriber* >( cls );
+    EventStream *stream = subscriber->stream;
+
+    std::lock_guard< std::mutex > lock( stream->mMutex );
+
+    if( subscriber->overrun ) {
+        stream->mDisconnected++;
+        return MHD_CONTENT_READER_END_WITH_ERROR;
+    }
+
+    size_t written = 0;
+
+    while( written < max && !subscriber->events.empty() ) {
+
+        // Let the client know it missed events so it can query the current
+        // state, the notice goes out between two events
+        if( subscriber->dropped > 0 && subscriber->offset == 0 ) {
+            int length = snprintf( buf + written, max - written
+                                   , "event: dropped\ndata: {\"count\":%" PRIu64 "}\n\n"
+                                   , subscriber->dropped );
+            if( length < 0 || static_cast< size_t >( length ) >= max - written ) {
+                break;
+            }
+            written += static_cast< size_t >( length );
+            subscriber->dropped = 0;
+            continue;
+        }
+
+        const std::string &event = *subscriber->events.front();
+
+        size_t length = event.size() - subscriber->offset;
+        if( length > max - written ) {
+            length = max - written;
+        }
+
+        memcpy( buf + written, event.data() + subscriber->offset, length );
+        written += length;
+        subscriber->offset += length;
+
+        if( subscriber->offset == event.size() ) {
+            subscriber->events.pop_front();
+            subscriber->offset = 0;
+        }
+    }
+
+    if( written == 0 ) {
+        if( stream->mClosed ) {
+            return MHD_CONTENT_READER_END_OF_STREAM;
+        }
+
+        // Nothing to send, wait for the next event instead of being polled
+        subscriber->suspended = true;
+        MHD_suspend_connection( subscriber->connection );
+    }
+
+    return static_cast< ssize_t >( written );
+}
+
+/**
+ * @brief Removes a subscriber once MHD is done with its response
+ * @param cls Subscriber
+ */
+void EventStream::release( void *cls )
+{
+    Subscriber *subscriber = static_cast< Subscriber* >( cls );
+    EventStream *stream = subscriber->stream;
+
+    {
+        std::lock_guard< std::mutex > lock( stream->mMutex );
+        stream->mSubscribers.remove( subscriber );
+    }
+
+    delete subscriber;
+}
+
+}
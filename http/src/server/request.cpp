@@ -13,11 +13,15 @@ const uint32_t Request::header_value_size_max = 1024;
 Request::Request( MHD_Connection *connection )
   : mConnection( connection )
   , mPostProcessor( nullptr )
-  , mFp( nullptr )
+  , mUpload( nullptr )
   , mMethod( nullptr )
   , mPath( nullptr )
   , mData( nullptr )
   , mDataSize( 0 )
+  , mState( State::RECEIVING )
+  , mCommand( nullptr )
+  , mResponse( nullptr )
+  , mStart( std::chrono::steady_clock::now() )
 {
 }
 
@@ -26,6 +30,16 @@ Request::Request( MHD_Connection *connection )
  */
 Request::~Request()
 {
+    // Removes any upload that didn't complete
+    delete mUpload;
+
+    if( mCommand ) {
+        cJSON_Delete( mCommand );
+    }
+
+    if( mResponse ) {
+        cJSON_Delete( mResponse );
+    }
 }
 
 /**
@@ -79,6 +93,45 @@ int Request::sendResponse( const char *responseData, const char *responseType
     return ret;
 }
 
+/**
+ * @brief Send a response built in a buffer. The buffer's memory is handed to
+ * MHD as is rather than copied, the buffer is left empty.
+ * @param responseData Buffer holding the data to send
+ * @param responseType Type of response
+ * @param statusCode Status code in relation to the response
+ * @return Integer indicating the success of the operation
+ */
+int Request::sendResponse( Buffer *responseData, const char *responseType
+                           , int statusCode )
+{
+    int ret;
+
+    size_t size = responseData->getSize();
+    char *data = responseData->release();
+
+    struct MHD_Response *response = nullptr;
+    if( data == nullptr ) {
+        response = MHD_create_response_from_buffer(
+                    0, (void*)( "" ), MHD_RESPMEM_PERSISTENT );
+    } else {
+        response = MHD_create_response_from_buffer(
+                    size, data, MHD_RESPMEM_MUST_FREE );
+    }
+
+    if( !response ) {
+        free( data );
+        return MHD_NO;
+    }
+    MHD_add_response_header( response
+                             , MHD_HTTP_HEADER_CONTENT_TYPE
+                             , responseType );
+    ret = MHD_queue_response( mConnection, statusCode, response );
+
+    MHD_destroy_response( response );
+
+    return ret;
+}
+
 /**
  * @brief Sets the method type of the request
  * @param method Desired method type
@@ -97,6 +150,15 @@ void Request::setPath( const char *path )
     mPath = path;
 }
 
+/**
+ * @brief Sets the processing state of the request
+ * @param state Desired state
+ */
+void Request::setState( State state )
+{
+    mState = state;
+}
+
 /**
  * @brief Retrieves the method type of the request
  * @return Character array representation of the method type
@@ -115,6 +177,15 @@ const char *Request::getPath()
     return mPath;
 }
 
+/**
+ * @brief Retrieves the processing state of the request
+ * @return Request state
+ */
+Request::State Request::getState()
+{
+    return mState;
+}
+
 /**
  * @brief Retrieves the body of the request
  * @return
@@ -133,4 +204,24 @@ Request::HeaderMap *Request::getHeaders()
     return &mHeaders;
 }
 
+/**
+ * @brief Retrieves the arena the request's command and response are built in
+ * @return Pointer to the arena
+ */
+Arena *Request::getArena()
+{
+    return &mArena;
+}
+
+/**
+ * @brief Retrieves the time since the request came in
+ * @return Elapsed time in nanoseconds
+ */
+uint64_t Request::getElapsed()
+{
+    return static_cast< uint64_t >(
+            std::chrono::duration_cast< std::chrono::nanoseconds >(
+                std::chrono::steady_clock::now() - mStart ).count() );
+}
+
 }
@@ -1,192 +1,537 @@
+#include <string.h>
+
+#include "common/error/error.h"
 #include "http/server/router.h"
 
-namespace NewHttp {
+namespace Http
+{
+
+const char *Router::param_type_strings[] = {
+    "string"
+    , "int"
+    , "hex"
+    , nullptr
+};
 
-static std::vector< NewHttp::Method > stringToHttpVerbs(const std::string &method)
+/**
+ * @brief Orders captures so the most specific type is tried first
+ * @param type Capture type
+ * @return Priority, lower is tried first
+ */
+static uint32_t paramPriority( Router::ParamType type )
 {
-    std::string str( method );
-    std::string token;
-    std::vector< Method > tokenized;
-    size_t last = 0;
-    size_t next = 0;
+    switch( type ) {
+    case Router::ParamType::INTEGER:
+        return 0;
+    case Router::ParamType::HEX:
+        return 1;
+    default:
+        return 2;
+    }
+}
 
-    // Split the input into segments by the delimeter
-    while( ( next = str.find( ",", last ) ) != std::string::npos ) {
-        if( next - last != 0 ) {
-            // There is data in the string
-            token = str.substr( last, next - last );
-            tokenized.push_back( stringToMethod( token.c_str() ) );
-        } else {
-            // If the next and last values are the same, the string is empty
-            // and we can ignore it
+/**
+ * @brief Match Constructor
+ */
+Router::Match::Match()
+    : mCount( 0 )
+{
+}
+
+/**
+ * @brief Retrieves the number of captured parameters
+ * @return Number of parameters
+ */
+uint32_t Router::Match::getCount() const
+{
+    return mCount;
+}
+
+/**
+ * @brief Retrieves a captured parameter
+ * @param key Name of the capture
+ * @return Pointer to the parameter, nullptr if it wasn't captured. The value
+ * points in to the request path and is not null terminated.
+ */
+const Router::Param *Router::Match::getParam( const char *key ) const
+{
+    for( uint32_t i = 0; i < mCount; i++ ) {
+        if( strcmp( mParams[ i ].key, key ) == 0 ) {
+            return &mParams[ i ];
         }
-        last = next + 1;
     }
+    return nullptr;
+}
 
-
-    if( !str.substr( last ).empty() ) {
-        // Need to place the the final substring in the list, unless it's empty
-        tokenized.push_back( stringToMethod( str.substr( last ).c_str() ) );
+/**
+ * @brief Retrieves the value of an int or hex capture
+ * @param key Name of the capture
+ * @param value Returns the value
+ * @return Boolean indicating the capture exists and is numeric
+ */
+bool Router::Match::getInteger( const char *key, int64_t *value ) const
+{
+    const Param *param = getParam( key );
+    if( param == nullptr || param->type == ParamType::STRING ) {
+        return false;
     }
+    *value = param->integer;
+    return true;
+}
 
-    return tokenized;
+/**
+ * @brief Retrieves a copy of a captured parameter
+ * @param key Name of the capture
+ * @return Captured value, empty if it wasn't captured
+ */
+std::string Router::Match::getString( const char *key ) const
+{
+    const Param *param = getParam( key );
+    if( param == nullptr ) {
+        return std::string();
+    }
+    return std::string( param->value, param->length );
 }
 
 /**
- * @brief Route constructor
+ * @brief Node Constructor
  */
-Route::Route()
+Router::Node::Node()
+    : type( ParamType::STRING )
+    , routed( false )
 {
+}
 
+/**
+ * @brief Node Destructor
+ */
+Router::Node::~Node()
+{
+    for( auto it = statics.begin(); it != statics.end(); it++ ) {
+        delete *it;
+    }
+    for( auto it = params.begin(); it != params.end(); it++ ) {
+        delete *it;
+    }
 }
 
 /**
- * @brief Get HTTP verbs
- * @return Reference to to the local verbs
+ * @brief Constructor
  */
-const std::vector< NewHttp::Method > &Route::getVerbs() const
+Router::Router()
+    : mNumRoutes( 0 )
 {
-    return mVerbs;
 }
 
 /**
- * @brief Set the local HTTP verbs
- * @param verbs Desired verbs to set
- * @return
+ * @brief Destructor
  */
-uint32_t Route::setVerbs( const std::vector<NewHttp::Method> &verbs )
+Router::~Router()
 {
-    mVerbs = verbs;
-    return 0;
 }
 
 /**
- * @brief Set the local HTTP verbs
- * @param verbs Desired verbs to set
- * @return
+ * @brief Converts a capture type name
+ * @param type Type name
+ * @return Capture type, PARAM_TYPE_MAX if the name is unknown
  */
-uint32_t Route::setVerbs( NewHttp::Method verb )
+Router::ParamType Router::stringToParamType( const char *type )
 {
-    mVerbs.clear();
-    mVerbs.push_back( verb );
-    return 0;
+    for( int i = 0; param_type_strings[ i ] != nullptr; i++ ) {
+        if( strcmp( param_type_strings[ i ], type ) == 0 ) {
+            return static_cast< ParamType >( i );
+        }
+    }
+    return ParamType::PARAM_TYPE_MAX;
 }
 
 /**
- * @brief Set the local action
- * @param action Desired action
- * @return
+ * @brief Adds a route for a comma separated list of methods
+ * @param methods Methods, e.g. "GET,POST"
+ * @param path Route path
+ * @param handler Handler invoked for matching requests
+ * @return Error code
  */
-uint32_t Route::setAction( const std::string &action )
+uint32_t Router::addRoute( const char *methods, const char *path, Handler handler )
 {
-    mAction = action;
-    return 0;
+    uint32_t r = Error::Code::NONE;
+
+    const char *c = methods;
+    while( r == Error::Code::NONE && c != nullptr && *c != '\0' ) {
+        const char *end = strchr( c, ',' );
+        size_t length = end ? static_cast< size_t >( end - c ) : strlen( c );
+
+        if( length > 0 ) {
+            std::string method( c, length );
+            Method m = stringToMethod( method.c_str() );
+            if( m == Method::UNKNOWNMETHOD ) {
+                LOG_ERROR( "unknown route method '%s'", method.c_str() );
+                r = Error::Code::PARAM_INVALID;
+            } else {
+                r = addRoute( m, path, handler );
+            }
+        }
+
+        c = end ? end + 1 : nullptr;
+    }
+
+    return r;
 }
 
 /**
- * @brief Sets the path for the route
- * @param path Desired path
+ * @brief Adds a route
+ * @param method Method the route handles
+ * @param path Route path
+ * @param handler Handler invoked for matching requests
  * @return Error code
  */
-uint32_t Route::setPath( const std::string &path )
+uint32_t Router::addRoute( Method method, const char *path, Handler handler )
 {
-    std::string pattern = "^" + path + "$";
-    std::regex re( ":(\\w+)(\\(.*\\))?" );
-    std::smatch match;
+    if( method < Method::GET || method > Method::DELETE
+            || path == nullptr || path[ 0 ] != '/' ) {
+        return Error::Code::PARAM_INVALID;
+    }
 
-    mPath = path;
-    mPathKeys.clear();
+    Node *node = &mRoot;
+    const char *c = path;
 
-    bool noMatch = true;
-    std::string pathIt = path;
-    while( std::regex_search( pathIt, match, re ) ) {
-        noMatch = false;
-        std::string c = match[ 0 ].str(); // from
-        std::string k = match[ 1 ].str();
-        std::string p = match[ 2 ].str(); // to
-        if( p.empty() ) {
-            p = "([a-zA-Z0-9-$_.+!*'(),%]+)";
+    while( node != nullptr && *c != '\0' ) {
+        // Step over the separator
+        if( *c == '/' ) {
+            c++;
+            continue;
         }
-        // Replace sub string with another string
-        size_t start_pos = pattern.find( c );
-        if( start_pos == std::string::npos ) {
-            return false;
+
+        const char *segment = c;
+        while( *c != '\0' && *c != '/' ) {
+            c++;
         }
-        pattern.replace(start_pos, c.length(), p);
+        size_t length = static_cast< size_t >( c - segment );
+
+        if( segment[ 0 ] == ':' ) {
+            node = insertParam( node, segment, length );
+        } else {
+            node = insertStatic( node, segment, length );
+        }
+    }
 
-        mPathKeys.push_back( k );
-        // pattern.rep;
-        mRegex = std::regex( pattern );
-        pathIt = match.suffix().str();
+    if( node == nullptr ) {
+        LOG_ERROR( "invalid route '%s'", path );
+        return Error::Code::PARAM_INVALID;
     }
 
-    if( noMatch ) {
-        mRegex = std::regex( path );
+    if( node->handlers[ method ] ) {
+        LOG_WARN( "replacing route %s %s", methodToString( method ), path );
+    } else {
+        mNumRoutes++;
     }
 
-    return 0;
+    node->handlers[ method ] = handler;
+    node->routed = true;
+
+    return Error::Code::NONE;
 }
 
-bool Route::match(
-        const std::string &path
-        , Method verb
-        , std::unordered_map<std::string, std::string> *paramsPtr
-        , bool *pathOkPtr
-        , bool *methodOkPtr ) const
+/**
+ * @brief Finds the route for a request path. Static segments take precedence
+ * over captures, and captures are tried most specific type first.
+ * @param method Request method
+ * @param path Request path
+ * @param handler Returns the matching handler
+ * @param match Returns the captured parameters
+ * @return Result of the lookup
+ */
+Router::Result Router::find( Method method
+                             , const char *path
+                             , const Handler **handler
+                             , Match *match )
 {
-    LOG_INFO( "Here\n" );
-    std::unordered_map< std::string, std::string > params;
-    bool pathOk = false;
-    bool methodOk = false;
+    Node *node = nullptr;
+    match->mCount = 0;
+
+    if( path == nullptr || path[ 0 ] != '/' || !matchNode( &mRoot, path, match, &node ) ) {
+        return Result::NOT_FOUND;
+    }
 
-    std::smatch match;
-    std::string pathIt = path;
-    if( std::regex_search( path, match, mRegex ) ) {
-        pathOk = true;
-        if( mPathKeys.size() > 0 ) {
-            size_t i = 0;
-            while( std::regex_search( pathIt, match, mRegex ) ) {
-                // params.insert( mPathKeys[ i ], match[ 1 ].str() );
-                i++;
+    if( method < Method::GET || method > Method::DELETE || !node->handlers[ method ] ) {
+        return Result::METHOD_NOT_ALLOWED;
+    }
+
+    *handler = &node->handlers[ method ];
+
+    return Result::FOUND;
+}
+
+/**
+ * @brief Routes a request to its handler. HEAD requests are routed as GET,
+ * the daemon drops the body.
+ * @param request Pointer to the request
+ * @return Result of the lookup, the handler has run if the route was found
+ */
+Router::Result Router::dispatch( Request *request )
+{
+    Method method = Method::UNKNOWNMETHOD;
+    if( strcmp( request->getMethod(), MHD_HTTP_METHOD_HEAD ) == 0 ) {
+        method = Method::GET;
+    } else {
+        method = stringToMethod( request->getMethod() );
+    }
+
+    const Handler *handler = nullptr;
+    Match match;
+
+    Result result = find( method, request->getPath(), &handler, &match );
+    if( result == Result::FOUND ) {
+        ( *handler )( request, match );
+    }
+
+    return result;
+}
+
+/**
+ * @brief Retrieves the number of method and path pairs routed
+ * @return Number of routes
+ */
+uint32_t Router::getNumRoutes()
+{
+    return mNumRoutes;
+}
+
+/**
+ * @brief Finds or adds a static child
+ * @param parent Parent node
+ * @param segment Segment text
+ * @param length Length of the segment
+ * @return Pointer to the child
+ */
+Router::Node *Router::insertStatic( Node *parent, const char *segment, size_t length )
+{
+    Node *node = findStatic( parent, segment, length );
+    if( node != nullptr ) {
+        return node;
+    }
+
+    node = new Node();
+    node->segment.assign( segment, length );
+
+    auto it = parent->statics.begin();
+    while( it != parent->statics.end() && ( *it )->segment < node->segment ) {
+        it++;
+    }
+    parent->statics.insert( it, node );
+
+    return node;
+}
+
+/**
+ * @brief Finds or adds a capture child
+ * @param parent Parent node
+ * @param segment Capture text in the form :key or :key(type)
+ * @param length Length of the segment
+ * @return Pointer to the child, nullptr if the capture is invalid
+ */
+Router::Node *Router::insertParam( Node *parent, const char *segment, size_t length )
+{
+    std::string text( segment + 1, length - 1 );
+    std::string key  = text;
+    ParamType type   = ParamType::STRING;
+
+    size_t open = text.find( '(' );
+    if( open != std::string::npos ) {
+        if( text.back() != ')' ) {
+            return nullptr;
+        }
+        key  = text.substr( 0, open );
+        type = stringToParamType(
+                    text.substr( open + 1, text.size() - open - 2 ).c_str() );
+        if( type == ParamType::PARAM_TYPE_MAX ) {
+            return nullptr;
+        }
+    }
+
+    if( key.empty() ) {
+        return nullptr;
+    }
+
+    for( auto it = parent->params.begin(); it != parent->params.end(); it++ ) {
+        if( ( *it )->type == type ) {
+            if( ( *it )->key != key ) {
+                // Two names for the same capture would be ambiguous
+                LOG_ERROR( "capture :%s conflicts with :%s"
+                           , key.c_str(), ( *it )->key.c_str() );
+                return nullptr;
             }
+            return *it;
+        }
+    }
+
+    Node *node = new Node();
+    node->key  = key;
+    node->type = type;
+
+    auto it = parent->params.begin();
+    while( it != parent->params.end()
+           && paramPriority( ( *it )->type ) <= paramPriority( type ) ) {
+        it++;
+    }
+    parent->params.insert( it, node );
+
+    return node;
+}
+
+/**
+ * @brief Binary searches the static children of a node
+ * @param parent Parent node
+ * @param segment Segment text, need not be null terminated
+ * @param length Length of the segment
+ * @return Pointer to the child, nullptr if there isn't one
+ */
+Router::Node *Router::findStatic( Node *parent, const char *segment, size_t length )
+{
+    size_t low  = 0;
+    size_t high = parent->statics.size();
+
+    while( low < high ) {
+        size_t mid = low + ( high - low ) / 2;
+        const std::string &s = parent->statics[ mid ]->segment;
+
+        int cmp = s.compare( 0, std::string::npos, segment, length );
+        if( cmp == 0 ) {
+            return parent->statics[ mid ];
+        } else if( cmp < 0 ) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
     }
 
+    return nullptr;
 }
 
+/**
+ * @brief Matches the remainder of a path below a node
+ * @param node Node matched so far
+ * @param path Remainder of the path
+ * @param match Collects the captured parameters
+ * @param found Returns the routed node
+ * @return Boolean indicating a route was found
+ */
+bool Router::matchNode( Node *node, const char *path, Match *match, Node **found )
+{
+    // Separators, including repeated and trailing ones, are skipped
+    while( *path == '/' ) {
+        path++;
+    }
 
+    if( *path == '\0' ) {
+        if( node->routed ) {
+            *found = node;
+            return true;
+        }
+        return false;
+    }
+
+    const char *end = path;
+    while( *end != '\0' && *end != '/' ) {
+        end++;
+    }
+    size_t length = static_cast< size_t >( end - path );
 
+    Node *child = findStatic( node, path, length );
+    if( child != nullptr && matchNode( child, end, match, found ) ) {
+        return true;
+    }
 
+    if( match->mCount >= max_params ) {
+        return false;
+    }
 
+    for( auto it = node->params.begin(); it != node->params.end(); it++ ) {
+        Param &param = match->mParams[ match->mCount ];
+        if( !parseParam( ( *it )->type, path, length, &param.integer ) ) {
+            continue;
+        }
 
+        param.key    = ( *it )->key.c_str();
+        param.value  = path;
+        param.length = length;
+        param.type   = ( *it )->type;
 
-void Router::addRoute(
-        const std::string &method
-        , const std::string &path
-        , const std::string action )
-{
-    Route route;
-    route.setVerbs( stringToHttpVerbs( method ) );
-    route.setPath( path );
-    route.setAction( action );
+        match->mCount++;
+        if( matchNode( *it, end, match, found ) ) {
+            return true;
+        }
+        match->mCount--;
+    }
 
-    mRoutes.push_back( route );
+    return false;
 }
 
-void Router::processRequest( Request *request )
+/**
+ * @brief Validates a captured segment against its type
+ * @param type Capture type
+ * @param segment Segment text
+ * @param length Length of the segment
+ * @param integer Returns the value of numeric captures
+ * @return Boolean indicating the segment is valid for the type
+ */
+bool Router::parseParam( ParamType type
+                         , const char *segment
+                         , size_t length
+                         , int64_t *integer )
 {
-    LOG_INFO( "Here\n" );
-    bool found      = false;
-    bool processed  = false;
+    *integer = 0;
 
-    for( uint32_t i = 0; !processed && i < mRoutes.size(); i++ ) {
-        const Route &route = mRoutes[ i ];
-        std::unordered_map< std::string, std::string > params;
-        bool pathOk;
-        bool methodOk;
+    if( type == ParamType::STRING ) {
+        return length > 0;
+    }
 
-        route.match(request->getPath(), request->getMethod(), &params, &pathOk, &methodOk);
+    size_t i = 0;
+    bool negative = false;
+    uint64_t value = 0;
+
+    if( type == ParamType::INTEGER ) {
+        if( i < length && segment[ i ] == '-' ) {
+            negative = true;
+            i++;
+        }
+        if( i == length || length - i > 18 ) {
+            return false;
+        }
+        for( ; i < length; i++ ) {
+            char c = segment[ i ];
+            if( c < '0' || c > '9' ) {
+                return false;
+            }
+            value = value * 10 + static_cast< uint64_t >( c - '0' );
+        }
+    } else {
+        if( length > 2 && segment[ 0 ] == '0'
+                && ( segment[ 1 ] == 'x' || segment[ 1 ] == 'X' ) ) {
+            i = 2;
+        }
+        if( i == length || length - i > 15 ) {
+            return false;
+        }
+        for( ; i < length; i++ ) {
+            char c = segment[ i ];
+            uint64_t digit = 0;
+            if( c >= '0' && c <= '9' ) {
+                digit = static_cast< uint64_t >( c - '0' );
+            } else if( c >= 'a' && c <= 'f' ) {
+                digit = static_cast< uint64_t >( c - 'a' + 10 );
+            } else if( c >= 'A' && c <= 'F' ) {
+                digit = static_cast< uint64_t >( c - 'A' + 10 );
+            } else {
+                return false;
+            }
+            value = ( value << 4 ) | digit;
+        }
     }
+
+    *integer = negative ? -static_cast< int64_t >( value )
+                        : static_cast< int64_t >( value );
+    return true;
 }
 
 }
@@ -1,3 +1,8 @@
+#include <stdlib.h>
+#include <strings.h>
+
+#include "common/json_parser.h"
+#include "common/json_writer.h"
 #include "http/server/server.h"
 
 /**
@@ -70,10 +75,6 @@ static void onResponseSent(
         MHD_destroy_post_processor( r->mPostProcessor );
     }
 
-    if( r->mFp ) {
-        fclose( r->mFp );
-    }
-
     // Delete the data contained within the request
     delete[] r->mData;
 
@@ -86,13 +87,63 @@ namespace Http {
 const char *Server::response_success     = "Success";
 const char *Server::response_failed      = "Failed";
 const char *Server::response_bad_request = "Bad Request";
+const char *Server::response_unavailable = "Service Unavailable";
+const char *Server::response_not_found   = "Not Found";
+const char *Server::response_method_not_allowed = "Method Not Allowed";
 
 const char *Server::type_text_html       = "text/html";
 const char *Server::type_text_javascript = "text/javascript";
+const char *Server::type_text_metrics    = "text/plain; version=0.0.4";
 
 const char *Server::path_base            = "/";
 const char *Server::path_index_html      = "/index.html";
 const char *Server::path_bundle_js         = "/bundle.js";
+const char *Server::path_upload          = "/upload";
+const char *Server::path_events          = "/events";
+const char *Server::path_websocket       = "/ws";
+const char *Server::path_metrics         = "/metrics";
+
+const uint32_t Server::default_thread_pool_size = 4;
+const uint32_t Server::default_max_sessions     = 8;
+
+const size_t Server::body_reserve_max = 1024 * 1024;
+
+const char *Server::default_upload_directory = ".";
+
+const char *Server::threading_strings[] = {
+    "connection"
+    , "pool"
+    , nullptr
+};
+
+/**
+ * @brief Converts a string to a threading model
+ * @param threading Threading model string
+ * @return Threading model, THREADING_MAX if the string is unknown
+ */
+Server::Threading Server::stringToThreading( const char *threading )
+{
+    Threading t = Threading::THREADING_MAX;
+    for( int i = 0; threading != nullptr && threading_strings[ i ] != nullptr; i++ ) {
+        if( strcmp( threading_strings[ i ], threading ) == 0 ) {
+            t = static_cast< Threading >( i );
+        }
+    }
+    return t;
+}
+
+/**
+ * @brief Converts a threading model to a string
+ * @param threading Threading model
+ * @return Character array representation of the threading model
+ */
+const char *Server::threadingToString( Threading threading )
+{
+    if( threading >= 0 && threading < Threading::THREADING_MAX ) {
+        return threading_strings[ threading ];
+    }
+    return nullptr;
+}
 
 /**
  * @brief Iterates over headers values found in the request
@@ -142,77 +193,96 @@ int Server::iteratePost(
         , const char *data
         , uint64_t off, size_t size )
 {
-    printf( "%s\n", __FUNCTION__ );
     // Unused
     (void)( kind );
+    (void)( key );
+    (void)( content_type );
+    (void)( transfer_encoding );
     (void)( off );
 
     Request *r = static_cast< Request* >( coninfo_cls );
 
-    if( key != nullptr ) {
-        printf( "Key: %s\n", key );
-    }
-
-    if( content_type != nullptr ) {
-        printf( "Content-Type: %s\n", content_type );
+    if( filename == nullptr || r->mUpload == nullptr ) {
+        // Plain form fields aren't stored
+        return MHD_YES;
     }
 
-    if( transfer_encoding != nullptr ) {
-        printf( "Transfer-Encoding: %s\n", transfer_encoding );
-    }
-
-    // con_info->answerstring = servererrorpage;
-    // con_info->answercode = MHD_HTTP_INTERNAL_SERVER_ERROR;
-
-    if( !r->mFp ) {
-        // The file pointer is invalid
-        // r->mFp = fopen( filename, "rb" );
-        // if( !r->mFp ) {
-        //     // We could read the file, which means it already exists
-        //     fclose( r->mFp );
-        //     // con_info->answerstring = fileexistspage;
-        //     // con_info->answercode = MHD_HTTP_FORBIDDEN;
-        //     return MHD_NO;
-        // }
+    Upload *upload = r->mUpload;
 
-        // Just write over the file
-        r->mFp = fopen( filename, "wb" );
-        if( !r->mFp ) {
-            // We failed to open the file for writing
-            // con_info->answercode = MHD_HTTP_FORBIDDEN;
+    // A new file in the form closes out the previous one
+    std::string name;
+    if( !upload->isOpen()
+            || ( Upload::sanitizeFilename( filename, name )
+                 && name != upload->getFilename() ) ) {
+        if( !upload->open( filename ) ) {
             return MHD_NO;
         }
     }
 
-    if( size > 0 ) {
-        if( !fwrite( data, size, sizeof(char), r->mFp ) ) {
-            return MHD_NO;
-        }
+    if( size > 0 && !upload->write( data, size ) ) {
+        return MHD_NO;
     }
 
-    // con_info->answerstring = completepage;
-    // con_info->answercode = MHD_HTTP_OK;
-
     return MHD_YES;
 }
 
 /**
  * @brief Constructor
- * @param index Index page to serve up
- * @param main Main javascript to serve up
+ * @param index Index page to serve up, must stay valid for the life of the
+ * server
+ * @param indexSize Size of the index page in bytes
+ * @param main Main javascript to serve up, must stay valid for the life of the
+ * server
+ * @param mainSize Size of the main javascript in bytes
  * @param port Port number to attach to
  * @param secure Enable/Disable secure server
+ * @param threading Threading model used to service connections
+ * @param poolSize Number of worker threads used by the thread pool model
  */
-Server::Server( const char *index, const char *main
-                          , uint16_t port, bool secure )
+Server::Server( const char *index, size_t indexSize
+                          , const char *main, size_t mainSize
+                          , uint16_t port, bool secure
+                          , Threading threading, uint32_t poolSize )
     // , mDone( false )
     : mServerDaemon( nullptr )
     , mCommandHandler( nullptr )
-    , mIndexHtml( index )
-    , mMainJs( main )
+    , mCommandQueue( nullptr )
+    , mIndexHtml( index, indexSize, type_text_html )
+    , mMainJs( main, mainSize, type_text_javascript )
     , mPort( port )
     , mSecure( secure )
+    , mThreading( threading )
+    , mThreadPoolSize( poolSize )
+    , mRestart( false )
+    , mSuspended( 0 )
+    , mRestartThread( nullptr )
+    , mRestarting( false )
+    , mUploadDirectory( default_upload_directory )
+    , mUploadFlags( Upload::Flags::NONE )
+    , mUploadFiles( 0 )
+    , mUploadBytes( 0 )
+    , mUploadTime( 0 )
+    , mUploadFailures( 0 )
+    , mMaxSessions( default_max_sessions )
 {
+    Router::Handler getIndex( this, &Server::processIndex );
+    Router::Handler getMain( this, &Server::processMain );
+    Router::Handler post( this, &Server::processPost );
+    Router::Handler events( this, &Server::processEvents );
+    Router::Handler socket( this, &Server::processWebSocket );
+    Router::Handler metrics( this, &Server::processMetrics );
+
+    mRouter.addRoute( Method::GET, path_base, getIndex );
+    mRouter.addRoute( Method::GET, path_index_html, getIndex );
+    mRouter.addRoute( Method::GET, path_bundle_js, getMain );
+    mRouter.addRoute( Method::GET, path_events, events );
+    mRouter.addRoute( Method::GET, path_websocket, socket );
+    mRouter.addRoute( Method::GET, path_metrics, metrics );
+
+    // Commands are posted to the page the client was loaded from
+    mRouter.addRoute( Method::POST, path_base, post );
+    mRouter.addRoute( Method::POST, path_index_html, post );
+    mRouter.addRoute( Method::POST, path_upload, post );
 }
 
 /**
@@ -220,7 +290,24 @@ Server::Server( const char *index, const char *main
  */
 Server::~Server()
 {
+    // The restart thread takes the lock on its way out, join it without
+    std::thread *restartThread = nullptr;
+    {
+        std::lock_guard< std::mutex > lock( mRestartMutex );
+        restartThread = mRestartThread;
+        mRestartThread = nullptr;
+    }
+    if( restartThread != nullptr ) {
+        restartThread->join();
+        delete restartThread;
+    }
+
     stop();
+
+    // Sessions still answering a command wait for it to finish
+    for( auto it = mSessions.begin(); it != mSessions.end(); it++ ) {
+        delete *it;
+    }
 }
 
 void Server::setCommandHandler( CommandHandler *handler )
@@ -228,6 +315,318 @@ void Server::setCommandHandler( CommandHandler *handler )
     mCommandHandler = handler;
 }
 
+/**
+ * @brief Sets the queue used to execute commands off the connection thread.
+ * Must be set before the server starts listening
+ * @param queue Desired command queue, nullptr executes commands inline
+ */
+void Server::setCommandQueue( CommandQueue *queue )
+{
+    mCommandQueue = queue;
+}
+
+/**
+ * @brief Retrieves the command queue
+ * @return Pointer to the command queue, nullptr if commands execute inline
+ */
+CommandQueue *Server::getCommandQueue()
+{
+    return mCommandQueue;
+}
+
+/**
+ * @brief Retrieves the index page asset, used to add precompressed variants
+ * before the server starts listening
+ * @return Pointer to the asset
+ */
+Asset *Server::getIndexHtml()
+{
+    return &mIndexHtml;
+}
+
+/**
+ * @brief Retrieves the main javascript asset, used to add precompressed
+ * variants before the server starts listening
+ * @return Pointer to the asset
+ */
+Asset *Server::getMainJs()
+{
+    return &mMainJs;
+}
+
+/**
+ * @brief Retrieves the stream state changes are published on
+ * @return Pointer to the event stream
+ */
+EventStream *Server::getEventStream()
+{
+    return &mEventStream;
+}
+
+/**
+ * @brief Retrieves the time from each request coming in to its response
+ * being queued, the command queue wait included
+ * @return Pointer to the histogram, in nanoseconds
+ */
+Histogram *Server::getLatency()
+{
+    return &mLatency;
+}
+
+/**
+ * @brief Sets the threading model, takes effect the next time settings are
+ * applied
+ * @param threading Desired threading model
+ * @return Error code
+ */
+uint32_t Server::setThreading( Threading threading )
+{
+    uint32_t r = Error::Code::NONE;
+    if( threading < 0 || threading >= Threading::THREADING_MAX ) {
+        r = Error::Code::PARAM_OUT_OF_RANGE;
+    } else if( threading != mThreading ) {
+        mThreading = threading;
+        mRestart = true;
+    }
+    return r;
+}
+
+/**
+ * @brief Sets the number of threads used by the thread pool model, takes
+ * effect the next time settings are applied
+ * @param size Desired number of threads
+ * @return Error code
+ */
+uint32_t Server::setThreadPoolSize( uint32_t size )
+{
+    uint32_t r = Error::Code::NONE;
+    if( size == 0 ) {
+        r = Error::Code::PARAM_OUT_OF_RANGE;
+    } else if( size != mThreadPoolSize ) {
+        mThreadPoolSize = size;
+        if( mThreading == Threading::THREAD_POOL ) {
+            mRestart = true;
+        }
+    }
+    return r;
+}
+
+/**
+ * @brief Retrieves the threading model
+ * @return Threading model
+ */
+Server::Threading Server::getThreading()
+{
+    return mThreading;
+}
+
+/**
+ * @brief Retrieves the number of threads used by the thread pool model
+ * @return Number of threads
+ */
+uint32_t Server::getThreadPoolSize()
+{
+    return mThreadPoolSize;
+}
+
+/**
+ * @brief Sets the directory uploaded files are written to. Takes effect for
+ * the next upload.
+ * @param directory Desired directory
+ * @return Error code
+ */
+uint32_t Server::setUploadDirectory( const char *directory )
+{
+    uint32_t r = Error::Code::NONE;
+    if( directory == nullptr || directory[ 0 ] == '\0' ) {
+        r = Error::Code::PARAM_INVALID;
+    } else {
+        std::lock_guard< std::mutex > lock( mUploadMutex );
+        mUploadDirectory = directory;
+    }
+    return r;
+}
+
+/**
+ * @brief Enables preallocating upload files from the request Content-Length,
+ * capped per file and by the free disk space
+ * @param preallocate Desired setting
+ * @return Error code
+ */
+uint32_t Server::setUploadPreallocate( bool preallocate )
+{
+    if( preallocate ) {
+        mUploadFlags |= Upload::Flags::PREALLOCATE;
+    } else {
+        mUploadFlags &= ~static_cast< uint32_t >( Upload::Flags::PREALLOCATE );
+    }
+    return Error::Code::NONE;
+}
+
+/**
+ * @brief Enables writing upload files with direct I/O, bypassing the page
+ * cache
+ * @param direct Desired setting
+ * @return Error code
+ */
+uint32_t Server::setUploadDirect( bool direct )
+{
+    if( direct ) {
+        mUploadFlags |= Upload::Flags::DIRECT;
+    } else {
+        mUploadFlags &= ~static_cast< uint32_t >( Upload::Flags::DIRECT );
+    }
+    return Error::Code::NONE;
+}
+
+/**
+ * @brief Retrieves the directory uploaded files are written to
+ * @return Upload directory
+ */
+std::string Server::getUploadDirectory()
+{
+    std::lock_guard< std::mutex > lock( mUploadMutex );
+    return mUploadDirectory;
+}
+
+/**
+ * @brief Determines if upload files are preallocated
+ * @return Boolean indicating the setting
+ */
+bool Server::isUploadPreallocate()
+{
+    return ( mUploadFlags & Upload::Flags::PREALLOCATE ) != 0;
+}
+
+/**
+ * @brief Determines if upload files are written with direct I/O
+ * @return Boolean indicating the setting
+ */
+bool Server::isUploadDirect()
+{
+    return ( mUploadFlags & Upload::Flags::DIRECT ) != 0;
+}
+
+/**
+ * @brief Retrieves the number of files uploaded
+ * @return Number of files
+ */
+uint64_t Server::getUploadFiles()
+{
+    return mUploadFiles;
+}
+
+/**
+ * @brief Retrieves the number of bytes written by uploads
+ * @return Number of bytes
+ */
+uint64_t Server::getUploadBytes()
+{
+    return mUploadBytes;
+}
+
+/**
+ * @brief Retrieves the number of uploads that failed
+ * @return Number of uploads
+ */
+uint64_t Server::getUploadFailures()
+{
+    return mUploadFailures;
+}
+
+/**
+ * @brief Retrieves the average rate uploads were written to disk
+ * @return Throughput in bytes per second
+ */
+uint64_t Server::getUploadThroughput()
+{
+    uint64_t time = mUploadTime;
+    return ( time > 0 ) ? ( mUploadBytes * 1000000 ) / time : 0;
+}
+
+/**
+ * @brief Sets the number of WebSocket sessions that may be open at once,
+ * existing sessions are kept
+ * @param max Maximum number of sessions
+ * @return Error code
+ */
+uint32_t Server::setMaxSessions( uint32_t max )
+{
+    std::lock_guard< std::mutex > lock( mSessionMutex );
+    mMaxSessions = max;
+    return Error::Code::NONE;
+}
+
+/**
+ * @brief Retrieves the number of open WebSocket sessions
+ * @return Number of sessions
+ */
+uint32_t Server::getSessions()
+{
+    std::lock_guard< std::mutex > lock( mSessionMutex );
+    reapSessions();
+    return static_cast< uint32_t >( mSessions.size() );
+}
+
+/**
+ * @brief Retrieves the number of WebSocket sessions that may be open at once
+ * @return Maximum number of sessions
+ */
+uint32_t Server::getMaxSessions()
+{
+    std::lock_guard< std::mutex > lock( mSessionMutex );
+    return mMaxSessions;
+}
+
+/**
+ * @brief Applies pending settings, restarting the daemon if the threading
+ * configuration changed while it was running. The restart happens on its own
+ * thread after this returns, settings are usually applied by a command that
+ * came in through this daemon and stopping it waits for that request.
+ * @return Error code
+ */
+uint32_t Server::applySettings()
+{
+    std::lock_guard< std::mutex > lock( mRestartMutex );
+    if( mRestarting ) {
+        // The restart in progress picks up the change
+    } else if( mRestart && isRunning() ) {
+        if( mRestartThread != nullptr ) {
+            mRestartThread->join();
+            delete mRestartThread;
+        }
+        mRestarting = true;
+        mRestartThread = new std::thread( &Server::restart, this );
+    } else {
+        mRestart = false;
+    }
+    return Error::Code::NONE;
+}
+
+/**
+ * @brief Restart thread. Stops the daemon once the requests in flight are
+ * answered and starts it with the current settings, again if they changed
+ * in the meantime.
+ */
+void Server::restart()
+{
+    std::unique_lock< std::mutex > lock( mRestartMutex );
+    while( mRestart ) {
+        mRestart = false;
+        lock.unlock();
+
+        LOG_INFO( "restarting server with %s threading"
+                  , threadingToString( mThreading ) );
+        stop();
+        if( !listen() ) {
+            LOG_ERROR( "server failed to restart" );
+        }
+
+        lock.lock();
+    }
+    mRestarting = false;
+}
+
 /**
  * @brief Retrieves the server port
  * @return uint16_t representation of the port used by the server
@@ -267,15 +666,28 @@ bool Server::listen()
 {
     bool success = false;
 
-    uint flags = MHD_USE_POLL_INTERNALLY
-            | MHD_USE_THREAD_PER_CONNECTION
-            | MHD_USE_PEDANTIC_CHECKS;
+    uint flags = MHD_USE_PEDANTIC_CHECKS;
+
+    if( mThreading == Threading::THREAD_POOL ) {
+        // A fixed number of threads multiplex all connections with epoll
+        flags |= MHD_USE_EPOLL_INTERNALLY;
+    } else {
+        // Every connection gets a dedicated thread
+        flags |= MHD_USE_POLL_INTERNALLY | MHD_USE_THREAD_PER_CONNECTION;
+    }
 
     if( mSecure ) {
         LOG_INFO( "server is secure" );
         flags |= MHD_USE_SSL;
     }
 
+    // Connections are suspended while their command sits in the queue and
+    // while event streams wait for events
+    flags |= MHD_USE_SUSPEND_RESUME;
+
+    // Command channels are upgraded to WebSockets
+    flags |= MHD_ALLOW_UPGRADE;
+
     /*
     if( mThreaded ) {
         flags |= MHD_USE_THREAD_PER_CONNECTION;
@@ -310,21 +722,37 @@ bool Server::listen()
     }
     */
 
-    mServerDaemon = MHD_start_daemon(
-                flags
-                , mPort
-                , nullptr
-                , nullptr
-                , &answerToConnection, this
-                , MHD_OPTION_NOTIFY_COMPLETED, &onResponseSent, this
-                // , MHD_OPTION_SOCK_ADDR, &socket
-                , MHD_OPTION_END
-                );
+    if( mThreading == Threading::THREAD_POOL ) {
+        mServerDaemon = MHD_start_daemon(
+                    flags
+                    , mPort
+                    , nullptr
+                    , nullptr
+                    , &answerToConnection, this
+                    , MHD_OPTION_NOTIFY_COMPLETED, &onResponseSent, this
+                    , MHD_OPTION_THREAD_POOL_SIZE
+                    , static_cast< unsigned int >( mThreadPoolSize )
+                    , MHD_OPTION_END
+                    );
+    } else {
+        mServerDaemon = MHD_start_daemon(
+                    flags
+                    , mPort
+                    , nullptr
+                    , nullptr
+                    , &answerToConnection, this
+                    , MHD_OPTION_NOTIFY_COMPLETED, &onResponseSent, this
+                    // , MHD_OPTION_SOCK_ADDR, &socket
+                    , MHD_OPTION_END
+                    );
+    }
 
     if( mServerDaemon == nullptr ) {
         LOG_WARN( "server daemon failed to start\n" );
     } else {
+        mEventStream.open();
         LOG_INFO( "server daemon started successfully" );
+        LOG_INFO( "using %s threading", threadingToString( mThreading ) );
         LOG_INFO( "listening on port %d", mPort );
         success = true;
     }
@@ -338,6 +766,13 @@ void Server::stop()
 {
     if( mServerDaemon != nullptr ) {
         LOG_INFO( "stopping server...\n" );
+        // Event streams wait suspended, end them first
+        mEventStream.close();
+        closeSessions();
+        // The daemon can't be stopped with connections still suspended
+        while( mSuspended > 0 ) {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        }
         MHD_stop_daemon( mServerDaemon );
         mServerDaemon = nullptr;
     }
@@ -378,6 +813,29 @@ int Server::onRequest( MHD_Connection *connection
         if( isVerbose() ) { printf( "PostProcessor is NULL\n" ); }
     }
 
+    // Size the body up front when the client tells us how much is coming.
+    // Anything too large to reserve is kept as a chunk list so it never has
+    // to be copied while it arrives.
+    const char *length = MHD_lookup_connection_value(
+                connection
+                , MHD_HEADER_KIND
+                , MHD_HTTP_HEADER_CONTENT_LENGTH );
+    size_t contentLength = ( length != nullptr )
+            ? static_cast< size_t >( strtoull( length, nullptr, 10 ) ) : 0;
+
+    if( r->mPostProcessor != nullptr ) {
+        // Form data is streamed through the post processor, files go
+        // straight to disk
+        std::lock_guard< std::mutex > lock( mUploadMutex );
+        r->mUpload = new Upload( mUploadDirectory.c_str()
+                                 , mUploadFlags
+                                 , contentLength );
+    } else if( contentLength > body_reserve_max ) {
+        r->getBody()->setMode( Buffer::Mode::CHUNKED );
+    } else if( contentLength > 0 ) {
+        r->getBody()->reserve( contentLength );
+    }
+
     // Fill out the rest of the request
     r->setMethod( method );
     r->setPath( path );
@@ -402,42 +860,17 @@ int Server::onRequestBody(
         , const char *data
         , size_t *size )
 {
-    request->appendData( data, *size );
-
-    /*
-    request->mDataSize += *size;
-    if( request->mData == nullptr ) {
-        // If we currently have no data lets copy over the incoming data
-        request->mData = new char[ request->mDataSize + 1 ];
-        memcpy( static_cast< void* >( request->mData ), data, request->mDataSize );
-
-        // Append the null character
-        request->mData[ request->mDataSize ] = '\0';
+    if( request->mPostProcessor != nullptr ) {
+        // Stream form data as it arrives rather than buffering the body. A
+        // failed upload keeps draining so the client still gets a response.
+        if( !request->mUpload->isFailed()
+                && MHD_post_process( request->mPostProcessor
+                                     , data, *size ) != MHD_YES ) {
+            request->mUpload->abort();
+        }
     } else {
-        // Concatinate new data with the old data
-
-        // Temporary pointer to the old data
-        const char* t = request->mData;
-
-        // Create a new memory block the size of total data received so far
-        request->mData = new char[ request->mDataSize + 1 ];
-
-        // Copy the old data to the new data block
-        memcpy( static_cast< void* >( request->mData ), t, request->mDataSize - *size );
-
-        // Get a pointer to the end of the old data
-        char* n = &request->mData[ request->mDataSize - *size ];
-
-        // Copy the new data to the end of the old
-        memcpy( static_cast< void* >( n ), data, *size );
-
-        // Append the null character
-        request->mData[ request->mDataSize ] = '\0';
-
-        // Delete the old data block
-        delete[] t;
+        request->appendData( data, *size );
     }
-    */
 
     *size = 0;
     return MHD_YES;
@@ -450,81 +883,587 @@ int Server::onRequestBody(
  */
 int Server::onRequestDone( Request *request )
 {
-    // processRequest( request );
-    process( request );
+    // Everything cJSON allocates for the request on this thread comes out of
+    // the request's arena and is released with the request
+    Arena::Scope scope( request->getArena() );
+
+    switch( request->getState() ) {
+    case Request::State::RECEIVING:
+        // processRequest( request );
+        if( mCommandQueue == nullptr || !queueCommand( request ) ) {
+            process( request );
+        }
+        break;
+    case Request::State::QUEUED:
+        // Still waiting on the command queue
+        break;
+    case Request::State::COMPLETE:
+    case Request::State::REJECTED:
+        // The connection has been resumed by the command queue
+        respondCommand( request );
+        break;
+    }
     return MHD_YES;
 }
 
-void Server::process(Request *request)
+/**
+ * @brief Hands a command request to the command queue and suspends the
+ * connection until the command has executed
+ * @param request Pointer to the request
+ * @return Boolean indicating the request was taken by the queue, false if it
+ * should be processed inline
+ */
+bool Server::queueCommand( Request *request )
 {
+    if( mCommandHandler == nullptr
+            || request->mPostProcessor != nullptr
+            || strcmp( request->getMethod(), MHD_HTTP_METHOD_POST ) != 0 ) {
+        return false;
+    }
+
+    // Unrouted paths are rejected inline
+    const Router::Handler *handler = nullptr;
+    Router::Match match;
+    if( mRouter.find( Method::POST, request->getPath(), &handler, &match )
+            != Router::Result::FOUND ) {
+        return false;
+    }
+
+    cJSON *command = Codec::decode( request->getBody()->getData()
+                                    , request->getBody()->getSize()
+                                    , getEncoding( request ) );
+    if( command == nullptr ) {
+        // Let the inline path report the bad command
+        return false;
+    }
+
     if( isVerbose() ) { printHeaders( request ); }
     if( isVerbose() ) { printBody( request ); }
 
-    const char *rspData = response_bad_request;
-    const char *rspType = type_text_html;
-    int rspCode   = MHD_HTTP_BAD_REQUEST;
+    request->mCommand  = command;
+    request->mResponse = CommandHandler::createResponse( command );
+    request->setState( Request::State::QUEUED );
+
+    // Suspend before queueing so a worker never resumes an active connection
+    MHD_Connection *connection = request->mConnection;
+    mSuspended++;
+    MHD_suspend_connection( connection );
+
+    bool queued = mCommandQueue->push(
+                command
+                , request->mResponse
+                , [ this, request, connection ]( bool ok ) {
+                    (void)ok;
+                    request->setState( Request::State::COMPLETE );
+                    MHD_resume_connection( connection );
+                    mSuspended--;
+                } );
+
+    if( !queued ) {
+        request->setState( Request::State::REJECTED );
+        MHD_resume_connection( connection );
+        mSuspended--;
+    }
 
-    // In case we get a response string for the post
-    char *rspStr = nullptr;
+    return true;
+}
 
-    if( strcmp( request->mMethod, MHD_HTTP_METHOD_GET ) == 0 ) {
-        // Handles a GET request
+/**
+ * @brief Sends the response for a request that went through the command queue
+ * @param request Pointer to the request
+ */
+void Server::respondCommand( Request *request )
+{
+    if( request->getState() == Request::State::REJECTED ) {
+        request->sendResponse( response_unavailable
+                               , type_text_html
+                               , MHD_HTTP_SERVICE_UNAVAILABLE );
+    } else {
+        // Answered in the encoding the command came in
+        Codec::Encoding encoding = getEncoding( request );
+        Buffer rspBuffer;
+        Codec::encode( request->mResponse, encoding, &rspBuffer );
+        request->sendResponse( &rspBuffer, getResponseType( encoding )
+                               , MHD_HTTP_OK );
+    }
 
-        if( strcmp( request->getPath(), path_base ) == 0
-                || strcmp( request->getPath(), mIndexHtml ) == 0 ) {
-            // The index has been requested
-            rspData = mIndexHtml;
-            rspType = type_text_html;
-            rspCode = MHD_HTTP_OK;
+    // From the request coming in, the queue wait included
+    mLatency.record( request->getElapsed() );
+}
 
-        } else if( strcmp( request->getPath(), path_bundle_js ) == 0 ) {
-            // The main script file has been requested
-            rspData = mMainJs;
-            rspType = type_text_javascript;
-            rspCode = MHD_HTTP_OK;
+/**
+ * @brief Determines the encoding of a request body from its content type
+ * @param request Pointer to the request
+ * @return Encoding, JSON unless the content type says otherwise
+ */
+Codec::Encoding Server::getEncoding( Request *request )
+{
+    return Codec::contentTypeToEncoding( MHD_lookup_connection_value(
+                request->mConnection
+                , MHD_HEADER_KIND
+                , MHD_HTTP_HEADER_CONTENT_TYPE ) );
+}
+
+/**
+ * @brief Retrieves the content type command responses are sent with
+ * @param encoding Encoding of the response
+ * @return Content type
+ */
+const char *Server::getResponseType( Codec::Encoding encoding )
+{
+    // JSON has always gone out as HTML, the web client doesn't look at it
+    return ( encoding == Codec::Encoding::MSGPACK )
+            ? Codec::content_type_msgpack : type_text_html;
+}
+
+/**
+ * @brief Completes the files streamed by a form request and records the
+ * upload statistics
+ * @param request Pointer to the request
+ * @return Boolean indicating every file was written
+ */
+bool Server::finishUpload( Request *request )
+{
+    Upload *upload = request->mUpload;
+
+    bool ok = upload->close();
+
+    mUploadFiles += upload->getFiles();
+    mUploadBytes += upload->getWritten();
+    mUploadTime  += upload->getElapsed();
+
+    if( !ok ) {
+        mUploadFailures++;
+    } else if( isVerbose() ) {
+        LOG_INFO( "uploaded %u file(s), %llu bytes"
+                  , upload->getFiles()
+                  , static_cast< unsigned long long >( upload->getWritten() ) );
+    }
+
+    return ok;
+}
+
+/**
+ * @brief Process a received request by handing it to its route
+ * @param request Pointer to the request
+ */
+void Server::process( Request *request )
+{
+    if( isVerbose() ) { printHeaders( request ); }
+    if( isVerbose() ) { printBody( request ); }
+
+    switch( mRouter.dispatch( request ) ) {
+    case Router::Result::FOUND:
+        break;
+    case Router::Result::METHOD_NOT_ALLOWED:
+        request->sendResponse( response_method_not_allowed
+                               , type_text_html
+                               , MHD_HTTP_METHOD_NOT_ALLOWED );
+        break;
+    case Router::Result::NOT_FOUND:
+    default:
+        request->sendResponse( response_not_found
+                               , type_text_html
+                               , MHD_HTTP_NOT_FOUND );
+        break;
+    }
+
+    // From the request coming in, receiving the body included
+    mLatency.record( request->getElapsed() );
+}
+
+/**
+ * @brief Serves the index page
+ * @param request Pointer to the request
+ * @param match Route captures, unused
+ */
+void Server::processIndex( Request *request, const Router::Match &match )
+{
+    (void)match;
+    mIndexHtml.serve( request->mConnection );
+}
+
+/**
+ * @brief Serves the main javascript
+ * @param request Pointer to the request
+ * @param match Route captures, unused
+ */
+void Server::processMain( Request *request, const Router::Match &match )
+{
+    (void)match;
+    mMainJs.serve( request->mConnection );
+}
+
+/**
+ * @brief Subscribes the client to the event stream
+ * @param request Pointer to the request
+ * @param match Route captures, unused
+ */
+void Server::processEvents( Request *request, const Router::Match &match )
+{
+    (void)match;
+
+    const char *lastEventId = MHD_lookup_connection_value(
+                request->mConnection
+                , MHD_HEADER_KIND
+                , "Last-Event-ID" );
+
+    MHD_Response *response = mEventStream.subscribe( request->mConnection
+                                                     , lastEventId );
+    if( response == nullptr ) {
+        // Too many clients are already streaming
+        request->sendResponse( response_unavailable
+                               , type_text_html
+                               , MHD_HTTP_SERVICE_UNAVAILABLE );
+        return;
+    }
+
+    MHD_queue_response( request->mConnection, MHD_HTTP_OK, response );
+    MHD_destroy_response( response );
+}
+
+/**
+ * @brief Upgrades the connection to a WebSocket command channel
+ * @param request Pointer to the request
+ * @param match Route captures, unused
+ */
+void Server::processWebSocket( Request *request, const Router::Match &match )
+{
+    (void)match;
+
+    MHD_Connection *connection = request->mConnection;
+
+    const char *upgrade = MHD_lookup_connection_value(
+                connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_UPGRADE );
+    const char *connectionHeader = MHD_lookup_connection_value(
+                connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_CONNECTION );
+    const char *version = MHD_lookup_connection_value(
+                connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_SEC_WEBSOCKET_VERSION );
+    const char *key = MHD_lookup_connection_value(
+                connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_SEC_WEBSOCKET_KEY );
+
+    char accept[ WebSocket::accept_size ];
+
+    if( mCommandHandler == nullptr
+            || upgrade == nullptr || strcasecmp( upgrade, "websocket" ) != 0
+            || connectionHeader == nullptr
+            || strcasestr( connectionHeader, "upgrade" ) == nullptr
+            || version == nullptr || strcmp( version, "13" ) != 0
+            || !WebSocket::createAccept( key, accept ) ) {
+        request->sendResponse( response_bad_request
+                               , type_text_html
+                               , MHD_HTTP_BAD_REQUEST );
+        return;
+    }
+
+    {
+        std::lock_guard< std::mutex > lock( mSessionMutex );
+        reapSessions();
+        if( mSessions.size() >= mMaxSessions ) {
+            request->sendResponse( response_unavailable
+                                   , type_text_html
+                                   , MHD_HTTP_SERVICE_UNAVAILABLE );
+            return;
         }
+    }
 
-    } else if ( strcmp( request->getMethod(), MHD_HTTP_METHOD_POST ) == 0 ) {
-        // Handles a POST request
+    MHD_Response *response = MHD_create_response_for_upgrade( &onUpgrade, this );
+    if( response == nullptr ) {
+        return;
+    }
 
-        if( request->mPostProcessor != nullptr ) {
-            // A POST processor exists
-            int ret = MHD_post_process( request->mPostProcessor
-                              , request->getBody()->getData()
-                              , request->getBody()->getSize() );
+    MHD_add_response_header( response, MHD_HTTP_HEADER_UPGRADE, "websocket" );
+    MHD_add_response_header( response, MHD_HTTP_HEADER_SEC_WEBSOCKET_ACCEPT
+                             , accept );
+    MHD_queue_response( connection, MHD_HTTP_SWITCHING_PROTOCOLS, response );
+    MHD_destroy_response( response );
+}
 
-            if( ret == MHD_YES ) {
-                rspData = response_success;
-            } else {
-                rspData = response_failed;
+/**
+ * @brief Serves the latency of every command and of request processing in the
+ * Prometheus text format
+ * @param request Pointer to the request
+ * @param match Route captures, unused
+ */
+void Server::processMetrics( Request *request, const Router::Match &match )
+{
+    (void)match;
+
+    Buffer buffer;
+    static const char request_header[] =
+            "# HELP http_request_duration_seconds Time from a request coming in to its response\n"
+            "# TYPE http_request_duration_seconds summary\n";
+    buffer.append( request_header, sizeof( request_header ) - 1 );
+    writeSummary( &buffer, "http_request_duration_seconds", "", &mLatency );
+
+    if( mCommandHandler != nullptr ) {
+        static const char command_header[] =
+                "# HELP command_duration_seconds Time taken to execute a command\n"
+                "# TYPE command_duration_seconds summary\n";
+        buffer.append( command_header, sizeof( command_header ) - 1 );
+
+        CommandMap *map = mCommandHandler->getCommandMap();
+        for( auto it = map->begin(); it != map->end(); it++ ) {
+            char labels[ COMMAND_NAME_MAX_SIZE + 16 ];
+            snprintf( labels, sizeof( labels ), "command=\"%s\"", it->first );
+            writeSummary( &buffer, "command_duration_seconds", labels
+                          , it->second->getLatency() );
+        }
+    }
+
+    request->sendResponse( &buffer, type_text_metrics, MHD_HTTP_OK );
+}
+
+/**
+ * @brief Writes a histogram as the samples of a Prometheus summary, with the
+ * median, the 99th percentile and the largest value, as quantile 1, for
+ * quantiles
+ * @param buffer Buffer to append to
+ * @param name Metric name
+ * @param labels Labels of the series without the braces, may be empty
+ * @param histogram Histogram in nanoseconds
+ */
+void Server::writeSummary( Buffer *buffer, const char *name
+                           , const char *labels, Histogram *histogram )
+{
+    Histogram::Snapshot snapshot;
+    histogram->snapshot( &snapshot );
+
+    const char *separator = ( labels[ 0 ] != '\0' ) ? "," : "";
+
+    char line[ 1024 ];
+    int size = snprintf(
+                line, sizeof( line )
+                , "%s{%s%squantile=\"0.5\"} %.9f\n"
+                  "%s{%s%squantile=\"0.99\"} %.9f\n"
+                  "%s{%s%squantile=\"1\"} %.9f\n"
+                  "%s_sum{%s} %.9f\n"
+                  "%s_count{%s} %llu\n"
+                , name, labels, separator, snapshot.getPercentile( 50.0 ) / 1e9
+                , name, labels, separator, snapshot.getPercentile( 99.0 ) / 1e9
+                , name, labels, separator, snapshot.max / 1e9
+                , name, labels, snapshot.sum / 1e9
+                , name, labels, static_cast< unsigned long long >( snapshot.count ) );
+
+    if( size > 0 && static_cast< size_t >( size ) < sizeof( line ) ) {
+        buffer->append( line, static_cast< size_t >( size ) );
+    }
+}
+
+/**
+ * @brief Starts a WebSocket session once MHD has handed over the connection
+ * @param cls Pointer to the server
+ * @param connection Upgraded connection, unused
+ * @param request Request that was upgraded, unused
+ * @param extra Data read past the end of the handshake
+ * @param extraSize Size of the extra data
+ * @param socket Socket to talk to the client on
+ * @param handle Handle used to close the connection
+ */
+void Server::onUpgrade( void *cls
+                        , MHD_Connection *connection
+                        , void *request
+                        , const char *extra
+                        , size_t extraSize
+                        , MHD_socket socket
+                        , MHD_UpgradeResponseHandle *handle )
+{
+    (void)connection;
+    (void)request;
+
+    using namespace std::placeholders;
+
+    Server *server = static_cast< Server* >( cls );
+
+    WebSocket *session = new WebSocket(
+                socket
+                , handle
+                , extra
+                , extraSize
+                , std::bind( &Server::onMessage, server, _1, _2, _3 ) );
+
+    std::lock_guard< std::mutex > lock( server->mSessionMutex );
+    server->mSessions.push_back( session );
+    session->start();
+}
+
+/**
+ * @brief Executes a message received on a WebSocket session. Messages carry
+ * the same commands as a POST, the reply echoes the id of each command so the
+ * client can match it up. Commands go through the command queue when there
+ * is one so a session can have several in flight.
+ * @param session Session the message was received on
+ * @param data Message data, null terminated
+ * @param size Size of the message
+ */
+void Server::onMessage( WebSocket *session, const char *data, size_t size )
+{
+    cJSON *command  = JsonParser::parse( data, size );
+    cJSON *response = CommandHandler::createResponse( command );
+
+    session->acquire();
+
+    auto done = [ session, command, response ]( bool rejected ) {
+        finishMessage( command, response, rejected );
+
+        Buffer rspBuffer;
+        JsonWriter writer( &rspBuffer );
+        writer.write( response );
+        if( writer.isComplete() ) {
+            session->send( rspBuffer.getData(), rspBuffer.getSize() );
+        }
+
+        cJSON_Delete( command );
+        cJSON_Delete( response );
+        session->release();
+    };
+
+    if( command == nullptr ) {
+        LOG_WARN( "%s: command string is invalid", __FUNCTION__ );
+        done( false );
+    } else if( mCommandQueue == nullptr ) {
+        mCommandHandler->dispatch( command, response );
+        done( false );
+    } else if( !mCommandQueue->push( command, response
+                                     , [ done ]( bool ok ) {
+                                         (void)ok;
+                                         done( false );
+                                     } ) ) {
+        done( true );
+    }
+}
+
+/**
+ * @brief Completes the reply to a WebSocket message, every command gets a
+ * success flag and the id it was sent with
+ * @param command Parsed command object or array of command objects, may be
+ * nullptr
+ * @param response Response created for the command
+ * @param rejected Boolean indicating the command queue turned the message
+ * away
+ */
+void Server::finishMessage( cJSON *command, cJSON *response, bool rejected )
+{
+    if( cJSON_IsArray( command ) ) {
+        cJSON *item = nullptr;
+        cJSON *result = response->child;
+        cJSON_ArrayForEach( item, command ) {
+            if( result == nullptr ) {
+                result = cJSON_CreateObject();
+                cJSON_AddItemToArray( response, result );
             }
+            finishMessage( item, result, rejected );
+            result = result->next;
+        }
+        return;
+    }
 
-            rspType = type_text_html;
-            rspCode = MHD_HTTP_OK;
-        } else if( mCommandHandler != nullptr ){
-            // A Command Handler exists so we can attempt to handle the POST
+    if( rejected ) {
+        cJSON_AddStringToObject( response, PARAM_ERROR, response_unavailable );
+    }
+
+    if( cJSON_GetObjectItem( response, PARAM_SUCCESS ) == nullptr ) {
+        cJSON_AddBoolToObject( response, PARAM_SUCCESS, false );
+    }
 
-            cJSON *response = cJSON_CreateObject();
-            mCommandHandler->handle( request->getBody()->getData(), response );
+    cJSON *id = cJSON_GetObjectItem( command, PARAM_ID );
+    if( id != nullptr ) {
+        cJSON_AddItemToObject( response, PARAM_ID, cJSON_Duplicate( id, true ) );
+    }
+}
 
-            if( response ) {
-                rspStr = cJSON_Print( response );
-                rspData = rspStr;
-                rspType = type_text_html;
+/**
+ * @brief Deletes WebSocket sessions that have ended. The session mutex must
+ * be held.
+ */
+void Server::reapSessions()
+{
+    for( auto it = mSessions.begin(); it != mSessions.end(); ) {
+        if( ( *it )->isDone() ) {
+            delete *it;
+            it = mSessions.erase( it );
+        } else {
+            it++;
+        }
+    }
+}
+
+/**
+ * @brief Closes every WebSocket session so the daemon can be stopped
+ */
+void Server::closeSessions()
+{
+    std::lock_guard< std::mutex > lock( mSessionMutex );
+    for( auto it = mSessions.begin(); it != mSessions.end(); it++ ) {
+        ( *it )->stop();
+    }
+    reapSessions();
+}
+
+/**
+ * @brief Handles a POST of form data or a command
+ * @param request Pointer to the request
+ * @param match Route captures, unused
+ */
+void Server::processPost( Request *request, const Router::Match &match )
+{
+    (void)match;
+
+    const char *rspData = response_bad_request;
+    const char *rspType = type_text_html;
+    int rspCode   = MHD_HTTP_BAD_REQUEST;
+
+    // In case we get a response for the post, written compactly straight into
+    // the memory handed to MHD
+    Buffer rspBuffer;
+    bool written = false;
+
+    if( request->mPostProcessor != nullptr ) {
+        // A POST processor exists, the form has already been streamed
+        if( finishUpload( request ) ) {
+            rspData = response_success;
+        } else {
+            rspData = response_failed;
+        }
+
+        rspType = type_text_html;
+        rspCode = MHD_HTTP_OK;
+    } else if( mCommandHandler != nullptr ){
+        // A Command Handler exists so we can attempt to handle the POST. The
+        // body is either one command object or an array of them, in JSON or
+        // MessagePack.
+        Codec::Encoding encoding = getEncoding( request );
+        cJSON *command = Codec::decode( request->getBody()->getData()
+                                        , request->getBody()->getSize()
+                                        , encoding );
+        cJSON *response = CommandHandler::createResponse( command );
+
+        if( command == nullptr ) {
+            LOG_WARN( "%s: command string is invalid", __FUNCTION__ );
+        } else {
+            mCommandHandler->dispatch( command, response );
+            cJSON_Delete( command );
+        }
+
+        if( response ) {
+            if( Codec::encode( response, encoding, &rspBuffer ) ) {
+                written = true;
+                rspType = getResponseType( encoding );
                 rspCode = MHD_HTTP_OK;
+            } else {
+                LOG_ERROR( "%s: failed to write the response", __FUNCTION__ );
             }
+        }
 
-            cJSON_Delete( response );
+        cJSON_Delete( response );
 
-        }
     }
 
     // The last thing we will do is send the response
-    request->sendResponse( rspData, rspType, rspCode );
-
-    if( rspStr ) {
-        // Free the post data
-        cJSON_free( rspStr );
+    if( written ) {
+        request->sendResponse( &rspBuffer, rspType, rspCode );
+    } else {
+        request->sendResponse( rspData, rspType, rspCode );
     }
 }
 
@@ -633,8 +1572,13 @@ void Server::processRequest( Request *request )
 
 uint32_t Server::getNumConnections()
 {
-    return MHD_get_daemon_info( mServerDaemon
-                         , MHD_DAEMON_INFO_CURRENT_CONNECTIONS )->num_connections;
+    uint32_t connections = 0;
+    if( mServerDaemon != nullptr ) {
+        connections = MHD_get_daemon_info(
+                    mServerDaemon
+                    , MHD_DAEMON_INFO_CURRENT_CONNECTIONS )->num_connections;
+    }
+    return connections;
 }
 
 void Server::printHeaders(Request *request)
@@ -650,7 +1594,9 @@ void Server::printHeaders(Request *request)
 void Server::printBody( Request *request )
 {
     printf( "-- BODY START -------------------------------------------\n");
-    printf( "%.*s\n", request->getBody()->getSize(), request->getBody()->getData() );
+    printf( "%.*s\n"
+            , static_cast< int >( request->getBody()->getSize() )
+            , request->getBody()->getData() );
     printf( "-- BODY END ---------------------------------------------\n");
 }
 
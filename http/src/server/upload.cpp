@@ -0,0 +1,405 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+#include "common/logger/log.h"
+#include "http/server/upload.h"
+
+namespace Http
+{
+
+const size_t Upload::direct_alignment   = 4096;
+const size_t Upload::direct_buffer_size = 256 * 1024;
+
+// The expected size comes from the client, never reserve more than this per
+// file or leave less than the reserve free on the disk
+const uint64_t Upload::preallocate_max      = 64 * 1024 * 1024;
+const uint64_t Upload::preallocate_reserve  = 256 * 1024 * 1024;
+
+/**
+ * @brief Constructor
+ * @param directory Directory uploaded files are written to
+ * @param flags Combination of Upload::Flags
+ * @param expected Expected upload size used to preallocate the file, 0 if
+ * unknown
+ */
+Upload::Upload( const char *directory, uint32_t flags, uint64_t expected )
+    : mDirectory( directory ? directory : "." )
+    , mFlags( flags )
+    , mExpected( expected )
+    , mFd( -1 )
+    , mDirect( false )
+    , mFailed( false )
+    , mStage( nullptr )
+    , mStaged( 0 )
+    , mFileWritten( 0 )
+    , mFiles( 0 )
+    , mWritten( 0 )
+    , mElapsed( 0 )
+{
+}
+
+/**
+ * @brief Destructor. An upload that was never closed is incomplete and gets
+ * removed.
+ */
+Upload::~Upload()
+{
+    if( mFd >= 0 ) {
+        abort();
+    }
+    free( mStage );
+}
+
+/**
+ * @brief Strips a client supplied filename down to a plain file name so an
+ * upload can't escape the upload directory
+ * @param filename Client supplied filename
+ * @param name Returns the sanitized name
+ * @return Boolean indicating the filename is usable
+ */
+bool Upload::sanitizeFilename( const char *filename, std::string &name )
+{
+    if( filename == nullptr ) {
+        return false;
+    }
+
+    // Browsers on some platforms send the full client side path
+    const char *base = filename;
+    for( const char *c = filename; *c != '\0'; c++ ) {
+        if( *c == '/' || *c == '\\' ) {
+            base = c + 1;
+        }
+    }
+
+    name.clear();
+    for( const char *c = base; *c != '\0'; c++ ) {
+        if( static_cast< unsigned char >( *c ) < 0x20 ) {
+            return false;
+        }
+        name.push_back( *c );
+    }
+
+    return !name.empty() && name != "." && name != "..";
+}
+
+/**
+ * @brief Opens a new file in the upload directory. A file that is already
+ * open is closed first.
+ * @param filename Client supplied filename
+ * @return Boolean indicating the file was opened
+ */
+bool Upload::open( const char *filename )
+{
+    if( mFd >= 0 && !close() ) {
+        return false;
+    }
+
+    if( mFailed ) {
+        return false;
+    }
+
+    if( !sanitizeFilename( filename, mFilename ) ) {
+        LOG_WARN( "rejecting upload with invalid filename '%s'"
+                  , filename ? filename : "" );
+        mFailed = true;
+        return false;
+    }
+
+    mPath = mDirectory + "/" + mFilename;
+
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    mDirect = false;
+
+#ifdef O_DIRECT
+    if( mFlags & Flags::DIRECT ) {
+        mFd = ::open( mPath.c_str(), flags | O_DIRECT, 0644 );
+        if( mFd >= 0 ) {
+            mDirect = true;
+        } else if( errno == EINVAL ) {
+            LOG_WARN( "direct I/O not supported for %s", mPath.c_str() );
+        }
+    }
+#endif
+
+    if( mFd < 0 ) {
+        mFd = ::open( mPath.c_str(), flags, 0644 );
+    }
+
+    if( mFd < 0 ) {
+        LOG_ERROR( "failed to open %s: %s", mPath.c_str(), strerror( errno ) );
+        mFailed = true;
+        return false;
+    }
+
+    if( mDirect && mStage == nullptr ) {
+        void *stage = nullptr;
+        if( posix_memalign( &stage, direct_alignment, direct_buffer_size ) != 0 ) {
+            LOG_ERROR( "failed to allocate direct I/O buffer" );
+            abort();
+            return false;
+        }
+        mStage = static_cast< char* >( stage );
+    }
+
+    uint64_t preallocate = getPreallocation();
+    if( preallocate > 0 ) {
+        // Reserve the blocks up front so the file isn't fragmented and a
+        // full disk is caught before any data is written
+        int err = posix_fallocate( mFd, 0, static_cast< off_t >( preallocate ) );
+        if( err == ENOSPC ) {
+            LOG_ERROR( "not enough space for %s", mPath.c_str() );
+            abort();
+            return false;
+        } else if( err != 0 ) {
+            LOG_WARN( "failed to preallocate %s: %s"
+                      , mPath.c_str(), strerror( err ) );
+        }
+    }
+
+    mStaged      = 0;
+    mFileWritten = 0;
+    mStart       = Clock::now();
+
+    return true;
+}
+
+/**
+ * @brief Determines how much of the open file to preallocate. The expected
+ * size is whatever Content-Length the client claimed, so it is capped, less
+ * whatever earlier files in the request already used, and never allowed to
+ * eat into the free space reserve.
+ * @return Bytes to preallocate, 0 for none
+ */
+uint64_t Upload::getPreallocation()
+{
+    if( !( mFlags & Flags::PREALLOCATE ) || mExpected <= mWritten ) {
+        return 0;
+    }
+
+    uint64_t size = mExpected - mWritten;
+    if( size > preallocate_max ) {
+        size = preallocate_max;
+    }
+
+    struct statvfs fs;
+    if( fstatvfs( mFd, &fs ) == 0 ) {
+        uint64_t available = static_cast< uint64_t >( fs.f_bavail ) * fs.f_frsize;
+        uint64_t usable = ( available > preallocate_reserve )
+                ? available - preallocate_reserve : 0;
+        if( size > usable ) {
+            size = usable;
+        }
+    }
+
+    return size;
+}
+
+/**
+ * @brief Writes the next block of the upload
+ * @param data Pointer to the data
+ * @param size Size of the data
+ * @return Boolean indicating the data was written
+ */
+bool Upload::write( const char *data, size_t size )
+{
+    if( mFd < 0 || mFailed ) {
+        return false;
+    }
+
+    if( mDirect ) {
+        // Direct I/O needs aligned blocks, stage the data until one is full
+        while( size > 0 && !mFailed ) {
+            size_t length = direct_buffer_size - mStaged;
+            if( length > size ) {
+                length = size;
+            }
+            memcpy( &mStage[ mStaged ], data, length );
+            mStaged      += length;
+            mFileWritten += length;
+            data         += length;
+            size         -= length;
+
+            if( mStaged == direct_buffer_size ) {
+                flushStage( false );
+            }
+        }
+    } else if( writeAll( data, size ) ) {
+        mFileWritten += size;
+    }
+
+    return !mFailed;
+}
+
+/**
+ * @brief Finishes the upload, trimming any preallocated space that wasn't
+ * used. A failed upload is removed.
+ * @return Boolean indicating the upload completed
+ */
+bool Upload::close()
+{
+    if( mFd < 0 ) {
+        return !mFailed;
+    }
+
+    if( mDirect && !mFailed ) {
+        flushStage( true );
+    }
+
+    if( !mFailed && ( mFlags & Flags::PREALLOCATE )
+            && ftruncate( mFd, static_cast< off_t >( mFileWritten ) ) != 0 ) {
+        LOG_ERROR( "failed to truncate %s: %s", mPath.c_str(), strerror( errno ) );
+        mFailed = true;
+    }
+
+    if( ::close( mFd ) != 0 && !mFailed ) {
+        LOG_ERROR( "failed to close %s: %s", mPath.c_str(), strerror( errno ) );
+        mFailed = true;
+    }
+    mFd = -1;
+
+    if( mFailed ) {
+        unlink( mPath.c_str() );
+    } else {
+        mFiles++;
+        mWritten += mFileWritten;
+        mElapsed += static_cast< uint64_t >(
+                    std::chrono::duration_cast< std::chrono::microseconds >(
+                        Clock::now() - mStart ).count() );
+    }
+
+    return !mFailed;
+}
+
+/**
+ * @brief Abandons the upload and removes the partial file. Any further files
+ * are refused.
+ */
+void Upload::abort()
+{
+    mFailed = true;
+    close();
+}
+
+/**
+ * @brief Determines if a file is currently open
+ * @return Boolean indicating a file is open
+ */
+bool Upload::isOpen()
+{
+    return mFd >= 0;
+}
+
+/**
+ * @brief Determines if the upload has failed
+ * @return Boolean indicating failure
+ */
+bool Upload::isFailed()
+{
+    return mFailed;
+}
+
+/**
+ * @brief Retrieves the sanitized name of the current file
+ * @return File name
+ */
+const char *Upload::getFilename()
+{
+    return mFilename.c_str();
+}
+
+/**
+ * @brief Retrieves the number of files completed
+ * @return Number of files
+ */
+uint32_t Upload::getFiles()
+{
+    return mFiles;
+}
+
+/**
+ * @brief Retrieves the number of bytes written by completed files
+ * @return Number of bytes
+ */
+uint64_t Upload::getWritten()
+{
+    return mWritten;
+}
+
+/**
+ * @brief Retrieves the time spent writing completed files
+ * @return Time in microseconds
+ */
+uint64_t Upload::getElapsed()
+{
+    return mElapsed;
+}
+
+/**
+ * @brief Writes a block to the file, retrying partial writes
+ * @param data Pointer to the data
+ * @param size Size of the data
+ * @return Boolean indicating the whole block was written
+ */
+bool Upload::writeAll( const char *data, size_t size )
+{
+    while( size > 0 ) {
+        ssize_t ret = ::write( mFd, data, size );
+        if( ret < 0 ) {
+            if( errno == EINTR ) {
+                continue;
+            }
+            LOG_ERROR( "failed to write %s: %s", mPath.c_str(), strerror( errno ) );
+            mFailed = true;
+            return false;
+        }
+        data += ret;
+        size -= static_cast< size_t >( ret );
+    }
+    return true;
+}
+
+/**
+ * @brief Writes the staged data for direct I/O
+ * @param final Set when the upload is finishing, the unaligned tail is then
+ * written through the page cache
+ * @return Boolean indicating the data was written
+ */
+bool Upload::flushStage( bool final )
+{
+    size_t aligned = mStaged - ( mStaged % direct_alignment );
+
+    if( aligned > 0 && !writeAll( mStage, aligned ) ) {
+        return false;
+    }
+
+    size_t tail = mStaged - aligned;
+    if( tail > 0 ) {
+        if( !final ) {
+            memmove( mStage, &mStage[ aligned ], tail );
+        } else {
+            int flags = fcntl( mFd, F_GETFL );
+#ifdef O_DIRECT
+            flags &= ~O_DIRECT;
+#endif
+            if( flags < 0 || fcntl( mFd, F_SETFL, flags ) != 0 ) {
+                LOG_ERROR( "failed to leave direct I/O for %s", mPath.c_str() );
+                mFailed = true;
+                return false;
+            }
+            mDirect = false;
+            if( !writeAll( &mStage[ aligned ], tail ) ) {
+                return false;
+            }
+            tail = 0;
+        }
+    }
+
+    mStaged = tail;
+    return true;
+}
+
+}
@@ -0,0 +1,576 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "common/logger/log.h"
+#include "http/server/websocket.h"
+
+namespace Http
+{
+
+const size_t WebSocket::message_size_max = 1024 * 1024;
+const char *WebSocket::accept_guid       = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+/**
+ * @brief SHA-1 digest, only needed to answer the opening handshake
+ * @param data Data to digest
+ * @param size Size of the data
+ * @param digest Container for the 20 byte digest
+ */
+static void sha1( const uint8_t *data, size_t size, uint8_t *digest )
+{
+    uint32_t h[ 5 ] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+    // Message plus the 0x80 marker and the 64 bit length, padded to 64 bytes
+    size_t total = ( ( size + 8 ) / 64 + 1 ) * 64;
+    uint64_t bits = static_cast< uint64_t >( size ) * 8;
+
+    for( size_t block = 0; block < total; block += 64 ) {
+        uint32_t w[ 80 ];
+
+        for( size_t i = 0; i < 16; i++ ) {
+            w[ i ] = 0;
+            for( size_t j = 0; j < 4; j++ ) {
+                size_t n = block + i * 4 + j;
+                uint8_t byte = 0;
+                if( n < size ) {
+                    byte = data[ n ];
+                } else if( n == size ) {
+                    byte = 0x80;
+                } else if( n >= total - 8 ) {
+                    byte = static_cast< uint8_t >( bits >> ( ( total - 1 - n ) * 8 ) );
+                }
+                w[ i ] = ( w[ i ] << 8 ) | byte;
+            }
+        }
+
+        for( size_t i = 16; i < 80; i++ ) {
+            uint32_t x = w[ i - 3 ] ^ w[ i - 8 ] ^ w[ i - 14 ] ^ w[ i - 16 ];
+            w[ i ] = ( x << 1 ) | ( x >> 31 );
+        }
+
+        uint32_t a = h[ 0 ], b = h[ 1 ], c = h[ 2 ], d = h[ 3 ], e = h[ 4 ];
+
+        for( size_t i = 0; i < 80; i++ ) {
+            uint32_t f, k;
+            if( i < 20 ) {
+                f = ( b & c ) | ( ~b & d );
+                k = 0x5A827999;
+            } else if( i < 40 ) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if( i < 60 ) {
+                f = ( b & c ) | ( b & d ) | ( c & d );
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+
+            uint32_t t = ( ( a << 5 ) | ( a >> 27 ) ) + f + e + k + w[ i ];
+            e = d;
+            d = c;
+            c = ( b << 30 ) | ( b >> 2 );
+            b = a;
+            a = t;
+        }
+
+        h[ 0 ] += a;
+        h[ 1 ] += b;
+        h[ 2 ] += c;
+        h[ 3 ] += d;
+        h[ 4 ] += e;
+    }
+
+    for( size_t i = 0; i < 20; i++ ) {
+        digest[ i ] = static_cast< uint8_t >( h[ i / 4 ] >> ( 24 - ( i % 4 ) * 8 ) );
+    }
+}
+
+/**
+ * @brief Base64 encodes data
+ * @param data Data to encode
+ * @param size Size of the data
+ * @param encoded Container for the encoded data, must hold 4 characters for
+ * every 3 bytes plus the null terminator
+ */
+static void base64( const uint8_t *data, size_t size, char *encoded )
+{
+    static const char alphabet[] =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    size_t i = 0;
+    for( ; i + 2 < size; i += 3 ) {
+        uint32_t v = ( data[ i ] << 16 ) | ( data[ i + 1 ] << 8 ) | data[ i + 2 ];
+        *encoded++ = alphabet[ ( v >> 18 ) & 0x3F ];
+        *encoded++ = alphabet[ ( v >> 12 ) & 0x3F ];
+        *encoded++ = alphabet[ ( v >> 6 ) & 0x3F ];
+        *encoded++ = alphabet[ v & 0x3F ];
+    }
+
+    if( i < size ) {
+        uint32_t v = data[ i ] << 16;
+        if( i + 1 < size ) {
+            v |= data[ i + 1 ] << 8;
+        }
+        *encoded++ = alphabet[ ( v >> 18 ) & 0x3F ];
+        *encoded++ = alphabet[ ( v >> 12 ) & 0x3F ];
+        *encoded++ = ( i + 1 < size ) ? alphabet[ ( v >> 6 ) & 0x3F ] : '=';
+        *encoded++ = '=';
+    }
+
+    *encoded = '\0';
+}
+
+/**
+ * @brief Constructor
+ * @param socket Socket of the upgraded connection
+ * @param handle Upgrade handle used to close the connection
+ * @param extra Data MHD read past the end of the handshake
+ * @param extraSize Size of the extra data
+ * @param handler Called from the session thread with every message received
+ */
+WebSocket::WebSocket( MHD_socket socket
+                      , MHD_UpgradeResponseHandle *handle
+                      , const char *extra
+                      , size_t extraSize
+                      , MessageHandler handler )
+    : mSocket( socket )
+    , mHandle( handle )
+    , mHandler( handler )
+    , mExtraOffset( 0 )
+    , mThread( nullptr )
+    , mOpen( true )
+    , mFinished( false )
+    , mReleased( false )
+    , mCloseSent( false )
+    , mPending( 0 )
+    , mFragmented( false )
+{
+    if( extraSize > 0 ) {
+        mExtra.append( extra, extraSize );
+    }
+
+    // The session thread blocks on the socket
+    int flags = fcntl( mSocket, F_GETFL );
+    if( flags != -1 ) {
+        fcntl( mSocket, F_SETFL, flags & ~O_NONBLOCK );
+    }
+}
+
+/**
+ * @brief Destructor, closes the session if it's still open and waits for any
+ * message still being worked on
+ */
+WebSocket::~WebSocket()
+{
+    stop();
+
+    // A session stopped from its own thread may still be on its way out
+    std::unique_lock< std::mutex > lock( mPendingMutex );
+    while( mPending > 0 || ( mThread != nullptr && !mFinished ) ) {
+        mPendingCondition.wait( lock );
+    }
+    lock.unlock();
+
+    delete mThread;
+}
+
+/**
+ * @brief Starts reading messages
+ */
+void WebSocket::start()
+{
+    if( mThread == nullptr ) {
+        mThread = new std::thread( &WebSocket::run, this );
+    }
+}
+
+/**
+ * @brief Closes the session and hands the connection back to MHD. May be
+ * called from a message handler, replies to messages still being worked on
+ * are dropped.
+ */
+void WebSocket::stop()
+{
+    close( Status::GOING_AWAY );
+
+    if( mThread && mThread->joinable() ) {
+        if( mThread->get_id() == std::this_thread::get_id() ) {
+            // The session thread exits once the handler returns
+            mThread->detach();
+        } else {
+            mThread->join();
+        }
+    }
+
+    releaseConnection();
+}
+
+/**
+ * @brief Closes the session, the session thread exits once the client has
+ * been told
+ * @param status Status reported to the client
+ */
+void WebSocket::close( Status status )
+{
+    if( mOpen.exchange( false ) ) {
+        sendClose( status );
+        // Wakes the session thread if it's waiting on the client
+        shutdown( mSocket, SHUT_RD );
+    }
+}
+
+/**
+ * @brief Sends a message to the client, safe to call from any thread
+ * @param data Message data
+ * @param size Size of the message
+ * @param opcode Type of message, TEXT or BINARY
+ * @return Boolean indicating the message was sent
+ */
+bool WebSocket::send( const char *data, size_t size, Opcode opcode )
+{
+    if( !mOpen ) {
+        return false;
+    }
+    return sendFrame( opcode, data, size );
+}
+
+/**
+ * @brief Marks a message as being worked on. The connection is held open
+ * until every acquired message is released so replies can still be sent.
+ */
+void WebSocket::acquire()
+{
+    std::lock_guard< std::mutex > lock( mPendingMutex );
+    mPending++;
+}
+
+/**
+ * @brief Marks a message as answered
+ */
+void WebSocket::release()
+{
+    std::lock_guard< std::mutex > lock( mPendingMutex );
+    mPending--;
+    mPendingCondition.notify_all();
+}
+
+/**
+ * @brief Determines if the session is open
+ * @return Boolean indicating the session is open
+ */
+bool WebSocket::isOpen()
+{
+    return mOpen;
+}
+
+/**
+ * @brief Determines if the session has ended and every message has been
+ * answered
+ * @return Boolean indicating the session can be deleted without blocking
+ */
+bool WebSocket::isDone()
+{
+    std::lock_guard< std::mutex > lock( mPendingMutex );
+    return mFinished && mPending == 0;
+}
+
+/**
+ * @brief Creates the Sec-WebSocket-Accept value for a handshake
+ * @param key Sec-WebSocket-Key sent by the client
+ * @param accept Container for the value, must hold accept_size bytes
+ * @return Boolean indicating the key was valid
+ */
+bool WebSocket::createAccept( const char *key, char *accept )
+{
+    // The key is a base64 encoded 16 byte nonce
+    if( key == nullptr || strlen( key ) != 24 ) {
+        return false;
+    }
+
+    uint8_t input[ 24 + 36 ];
+    memcpy( input, key, 24 );
+    memcpy( input + 24, accept_guid, 36 );
+
+    uint8_t digest[ 20 ];
+    sha1( input, sizeof( input ), digest );
+    base64( digest, sizeof( digest ), accept );
+
+    return true;
+}
+
+/**
+ * @brief Session thread loop
+ */
+void WebSocket::run()
+{
+    while( mOpen && readFrame() ) {
+    }
+
+    // Let the client know why the session ended if it wasn't already told.
+    // Nothing is sent after the close frame so the connection can go.
+    close( Status::NORMAL );
+    releaseConnection();
+
+    std::lock_guard< std::mutex > lock( mPendingMutex );
+    mFinished = true;
+    mPendingCondition.notify_all();
+}
+
+/**
+ * @brief Reads and handles a single frame
+ * @return Boolean indicating the session should continue
+ */
+bool WebSocket::readFrame()
+{
+    uint8_t header[ 2 ];
+    if( !readExact( reinterpret_cast< char* >( header ), sizeof( header ) ) ) {
+        return false;
+    }
+
+    bool fin        = ( header[ 0 ] & 0x80 ) != 0;
+    uint8_t opcode  = header[ 0 ] & 0x0F;
+    bool masked     = ( header[ 1 ] & 0x80 ) != 0;
+    uint64_t length = header[ 1 ] & 0x7F;
+
+    // Clients must mask and nothing is negotiated that would set RSV bits
+    if( !masked || ( header[ 0 ] & 0x70 ) != 0 ) {
+        close( Status::PROTOCOL_ERROR );
+        return false;
+    }
+
+    if( length == 126 || length == 127 ) {
+        uint8_t extended[ 8 ];
+        size_t count = ( length == 126 ) ? 2 : 8;
+        if( !readExact( reinterpret_cast< char* >( extended ), count ) ) {
+            return false;
+        }
+        // The most significant bit of a 64 bit length must be 0
+        if( count == 8 && ( extended[ 0 ] & 0x80 ) != 0 ) {
+            close( Status::PROTOCOL_ERROR );
+            return false;
+        }
+        length = 0;
+        for( size_t i = 0; i < count; i++ ) {
+            length = ( length << 8 ) | extended[ i ];
+        }
+    }
+
+    uint8_t mask[ 4 ];
+    if( !readExact( reinterpret_cast< char* >( mask ), sizeof( mask ) ) ) {
+        return false;
+    }
+
+    bool control = ( opcode & 0x08 ) != 0;
+    if( control && ( !fin || length > 125 ) ) {
+        close( Status::PROTOCOL_ERROR );
+        return false;
+    }
+
+    // The buffered message never exceeds the limit, so this can't wrap
+    if( !control && length > message_size_max - mMessage.getSize() ) {
+        close( Status::TOO_BIG );
+        return false;
+    }
+
+    // Control frames may arrive in the middle of a fragmented message so they
+    // never share its buffer
+    char payload[ 125 ];
+    if( !control ) {
+        // A message starts with TEXT or BINARY, the rest are continuations
+        if( ( opcode == Opcode::CONTINUATION ) != mFragmented ) {
+            close( Status::PROTOCOL_ERROR );
+            return false;
+        }
+        mFragmented = !fin;
+
+        if( !mMessage.reserve( mMessage.getSize() + static_cast< size_t >( length ) ) ) {
+            close( Status::INTERNAL_ERROR );
+            return false;
+        }
+        for( uint64_t read = 0; read < length; ) {
+            char block[ 4096 ];
+            size_t count = static_cast< size_t >( length - read );
+            if( count > sizeof( block ) ) {
+                count = sizeof( block );
+            }
+            if( !readExact( block, count ) ) {
+                return false;
+            }
+            for( size_t i = 0; i < count; i++ ) {
+                block[ i ] ^= mask[ ( read + i ) % 4 ];
+            }
+            if( !mMessage.append( block, count ) ) {
+                close( Status::INTERNAL_ERROR );
+                return false;
+            }
+            read += count;
+        }
+    } else {
+        if( !readExact( payload, static_cast< size_t >( length ) ) ) {
+            return false;
+        }
+        for( size_t i = 0; i < length; i++ ) {
+            payload[ i ] ^= mask[ i % 4 ];
+        }
+    }
+
+    switch( opcode ) {
+    case Opcode::CONTINUATION:
+    case Opcode::TEXT:
+    case Opcode::BINARY:
+        if( fin ) {
+            mHandler( this, mMessage.getData(), mMessage.getSize() );
+            mMessage.clear();
+        }
+        break;
+    case Opcode::PING:
+        sendFrame( Opcode::PONG, payload, static_cast< size_t >( length ) );
+        break;
+    case Opcode::PONG:
+        break;
+    case Opcode::CLOSE:
+        close( Status::NORMAL );
+        return false;
+    default:
+        close( Status::UNSUPPORTED );
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Reads an exact number of bytes, starting with any data MHD read past
+ * the handshake
+ * @param data Container for the data
+ * @param size Number of bytes to read
+ * @return Boolean indicating the bytes were read
+ */
+bool WebSocket::readExact( char *data, size_t size )
+{
+    while( size > 0 && mExtraOffset < mExtra.getSize() ) {
+        *data++ = mExtra.getData()[ mExtraOffset++ ];
+        size--;
+    }
+
+    while( size > 0 ) {
+        ssize_t count = recv( mSocket, data, size, 0 );
+        if( count < 0 && errno == EINTR ) {
+            continue;
+        }
+        if( count <= 0 ) {
+            return false;
+        }
+        data += count;
+        size -= static_cast< size_t >( count );
+    }
+
+    return true;
+}
+
+/**
+ * @brief Sends an unmasked frame
+ * @param opcode Type of frame
+ * @param data Payload
+ * @param size Size of the payload
+ * @return Boolean indicating the frame was sent
+ */
+bool WebSocket::sendFrame( Opcode opcode, const char *data, size_t size )
+{
+    uint8_t header[ 10 ];
+    size_t headerSize = 2;
+
+    header[ 0 ] = 0x80 | opcode;
+    if( size < 126 ) {
+        header[ 1 ] = static_cast< uint8_t >( size );
+    } else if( size <= 0xFFFF ) {
+        header[ 1 ] = 126;
+        header[ 2 ] = static_cast< uint8_t >( size >> 8 );
+        header[ 3 ] = static_cast< uint8_t >( size );
+        headerSize = 4;
+    } else {
+        header[ 1 ] = 127;
+        for( size_t i = 0; i < 8; i++ ) {
+            header[ 2 + i ] = static_cast< uint8_t >(
+                        static_cast< uint64_t >( size ) >> ( ( 7 - i ) * 8 ) );
+        }
+        headerSize = 10;
+    }
+
+    iovec iov[ 2 ];
+    iov[ 0 ].iov_base = header;
+    iov[ 0 ].iov_len  = headerSize;
+    iov[ 1 ].iov_base = const_cast< char* >( data );
+    iov[ 1 ].iov_len  = size;
+
+    msghdr message;
+    memset( &message, 0, sizeof( message ) );
+    message.msg_iov    = iov;
+    message.msg_iovlen = 2;
+
+    std::lock_guard< std::mutex > lock( mSendMutex );
+
+    if( mCloseSent ) {
+        return false;
+    }
+    if( opcode == Opcode::CLOSE ) {
+        mCloseSent = true;
+    }
+
+    // Header and payload go out in one call, partial sends pick up where
+    // they left off
+    while( message.msg_iovlen > 0 ) {
+        ssize_t sent = sendmsg( mSocket, &message, MSG_NOSIGNAL );
+        if( sent < 0 && errno == EINTR ) {
+            continue;
+        }
+        if( sent < 0 ) {
+            return false;
+        }
+
+        size_t remaining = static_cast< size_t >( sent );
+        while( message.msg_iovlen > 0 && remaining >= message.msg_iov->iov_len ) {
+            remaining -= message.msg_iov->iov_len;
+            message.msg_iov++;
+            message.msg_iovlen--;
+        }
+        if( message.msg_iovlen > 0 ) {
+            message.msg_iov->iov_base
+                    = static_cast< char* >( message.msg_iov->iov_base ) + remaining;
+            message.msg_iov->iov_len -= remaining;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Sends a close frame, only the first one is sent
+ * @param status Status reported to the client
+ */
+void WebSocket::sendClose( Status status )
+{
+    char payload[ 2 ];
+    payload[ 0 ] = static_cast< char >( status >> 8 );
+    payload[ 1 ] = static_cast< char >( status & 0xFF );
+    sendFrame( Opcode::CLOSE, payload, sizeof( payload ) );
+}
+
+/**
+ * @brief Hands the connection back to MHD to be closed, only done once
+ */
+void WebSocket::releaseConnection()
+{
+    // Hold off anyone still sending, no frame is sent once close was
+    std::lock_guard< std::mutex > lock( mSendMutex );
+    if( !mReleased.exchange( true ) ) {
+        MHD_upgrade_action( mHandle, MHD_UPGRADE_ACTION_CLOSE );
+    }
+}
+
+}
@@ -3,21 +3,21 @@
 CommandSmtp::CommandSmtp()
     : CommandTemplate< Smtp::Client >( COMMAND_SMTP, COMMAND_QSMTP )
 {
-    mMutatorMap[ PARAM_USERNAME ]   = PARAMETER_CALLBACK( &CommandSmtp::setUsername );
-    mMutatorMap[ PARAM_PASSWORD ]   = PARAMETER_CALLBACK( &CommandSmtp::setPassword );
-    mMutatorMap[ PARAM_SEND ]       = PARAMETER_CALLBACK( &CommandSmtp::setSend );
-    mMutatorMap[ PARAM_SERVER ]     = PARAMETER_CALLBACK( &CommandSmtp::setServer );
-    mMutatorMap[ PARAM_TO ]         = PARAMETER_CALLBACK( &CommandSmtp::setTo );
-    mMutatorMap[ PARAM_CC ]         = PARAMETER_CALLBACK( &CommandSmtp::setCc );
+    addMutator( PARAM_USERNAME, &CommandSmtp::setUsername, CommandSchema::STRING );
+    addMutator( PARAM_PASSWORD, &CommandSmtp::setPassword, CommandSchema::STRING );
+    addMutator( PARAM_SEND, &CommandSmtp::setSend, CommandSchema::STRING );
+    addMutator( PARAM_SERVER, &CommandSmtp::setServer, CommandSchema::STRING );
+    addMutator( PARAM_TO, &CommandSmtp::setTo, CommandSchema::STRING );
+    addMutator( PARAM_CC, &CommandSmtp::setCc, CommandSchema::STRING );
 
-    mAccessorMap[ PARAM_SERVER ]     = PARAMETER_CALLBACK( &CommandSmtp::getServer );
-    mAccessorMap[ PARAM_RECIPIENTS ] = PARAMETER_CALLBACK( &CommandSmtp::getRecipients );
+    addAccessor( PARAM_SERVER, &CommandSmtp::getServer );
+    addAccessor( PARAM_RECIPIENTS, &CommandSmtp::getRecipients );
 }
 
 uint32_t CommandSmtp::getServer( cJSON *response )
 {
     uint32_t r = Error::Code::NONE;
-    cJSON_AddStringToObject( response, PARAM_SERVER, mControlObject->getServer().c_str() );
+    cJSON_AddStringToObject( response, PARAM_SERVER, getControl()->getServer().c_str() );
     return r;
 }
 
@@ -26,7 +26,7 @@ uint32_t CommandSmtp::getRecipients( cJSON *response )
     uint32_t error = Error::Code::NONE;
     cJSON *array = cJSON_CreateArray();
     cJSON_AddItemToObject( response, PARAM_RECIPIENTS, array );
-    const curl_slist *recipients = mControlObject->getRecipientsList();
+    const curl_slist *recipients = getControl()->getRecipientsList();
     for( const curl_slist *it = recipients; it != nullptr; it = it->next ) {
         cJSON *str = cJSON_CreateString( it->data );
         cJSON_AddItemToArray( array, str );
@@ -38,7 +38,7 @@ uint32_t CommandSmtp::setTo( cJSON *val )
 {
     uint32_t error = Error::Code::NONE;
     if( cJSON_IsString( val ) ) {
-        error = mControlObject->addTo( val->valuestring );
+        error = getControl()->addTo( val->valuestring );
     } else {
         error = Error::Code::SYNTAX;
     }
@@ -49,7 +49,7 @@ uint32_t CommandSmtp::setCc( cJSON *val )
 {
     uint32_t error = Error::Code::NONE;
     if( cJSON_IsString( val ) ) {
-        error = mControlObject->addCarbonCopy( val->valuestring );
+        error = getControl()->addCarbonCopy( val->valuestring );
     } else {
         error = Error::Code::SYNTAX;
     }
@@ -60,7 +60,7 @@ uint32_t CommandSmtp::setServer( cJSON *val )
 {
     uint32_t error = Error::Code::NONE;
     if( cJSON_IsString( val ) ) {
-        error = mControlObject->setServer( val->valuestring );
+        error = getControl()->setServer( val->valuestring );
     } else {
         error = Error::Code::SYNTAX;
     }
@@ -71,7 +71,7 @@ uint32_t CommandSmtp::setUsername( cJSON *val )
 {
     uint32_t r = Error::Code::NONE;
     if( cJSON_IsString( val ) ) {
-        r = mControlObject->setUsername( val->valuestring );
+        r = getControl()->setUsername( val->valuestring );
     } else {
         r = Error::Code::SYNTAX;
     }
@@ -82,7 +82,7 @@ uint32_t CommandSmtp::setPassword( cJSON *val )
 {
     uint32_t r = Error::Code::NONE;
     if( cJSON_IsString( val ) ) {
-        r = mControlObject->setPassword( val->valuestring );
+        r = getControl()->setPassword( val->valuestring );
     } else {
         r = Error::Code::SYNTAX;
     }
@@ -93,7 +93,7 @@ uint32_t CommandSmtp::setSend( cJSON *val )
 {
     uint32_t r = Error::Code::NONE;
     if( cJSON_IsString( val ) ) {
-        r = mControlObject->send( val->valuestring );
+        r = getControl()->send( val->valuestring );
     } else {
         r = Error::Code::SYNTAX;
     }
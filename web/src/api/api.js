@@ -159,9 +159,20 @@ module.exports.sendCommandListToRadio = function(radio, payloadList) {
     return Promise.all(promiseList);
 }
 
+// Accepts an array of JSON radio commands as a parameter
+// Sends them in a single request, the backend responds with an array of
+// results in the same order as the commands
+module.exports.sendCommandBatch = function( payloadList ) {
+    return doPost( baseRoute, payloadList );
+}
+
 // Accepts an array of JSON radio commands as a parameter
 // Returns a promise that resolves if commands were succesful, and rejects otherwise
 module.exports.sendCommandList = function(payloadList) {
+    if( module.exports.proxyKey == null ) {
+        return module.exports.sendCommandBatch( payloadList );
+    }
+
     let promiseList = []
     payloadList.forEach(function(val, index, arr) {
         promiseList.push(module.exports.sendCommand(val))
@@ -169,6 +180,74 @@ module.exports.sendCommandList = function(payloadList) {
     return Promise.all(promiseList);
 }
 
+// Persistent command channel, replies are matched up with their command by id
+var socket = null
+var socketId = 0
+var socketPending = {}
+
+function openSocket() {
+    var route = baseRoute.replace( /^http/, 'ws' ) + 'ws'
+    socket = new WebSocket( route )
+
+    socket.onmessage = function( e ) {
+        var reply = JSON.parse( e.data )
+        var pending = socketPending[ reply.id ]
+        if( pending ) {
+            delete socketPending[ reply.id ]
+            pending.resolve( reply )
+        }
+    }
+
+    // Anything still waiting is failed, the next command opens a new socket
+    socket.onclose = function( e ) {
+        Object.keys( socketPending ).forEach( function( id ) {
+            socketPending[ id ].reject( e )
+        } )
+        socketPending = {}
+        socket = null
+    }
+}
+
+// Accepts a single JSON radio command as parameter
+// Sends it over the command channel, falling back to a POST when the channel
+// isn't available
+module.exports.sendCommandSocket = function( payload ) {
+    if( module.exports.proxyKey != null || typeof WebSocket === 'undefined' ) {
+        return module.exports.sendCommand( payload )
+    }
+
+    if( socket == null ) {
+        openSocket()
+    }
+
+    return new Promise( function( resolve, reject ) {
+        var id = ++socketId
+        var message = Object.assign( { id: id }, payload )
+        socketPending[ id ] = { resolve: resolve, reject: reject }
+
+        if( socket.readyState === WebSocket.OPEN ) {
+            socket.send( JSON.stringify( message ) )
+        } else {
+            socket.addEventListener( 'open', function() {
+                socket.send( JSON.stringify( message ) )
+            } )
+        }
+    } )
+}
+
+// Opens the server's event stream, the listener is called with the event
+// name and parsed data of every state change. Returns the EventSource so the
+// caller can close it.
+module.exports.subscribeEvents = function( names, listener ) {
+    var source = new EventSource( baseRoute + 'events' );
+    names.forEach( function( name ) {
+        source.addEventListener( name, function( e ) {
+            listener( name, JSON.parse( e.data ) );
+        } );
+    } );
+    return source;
+}
+
 module.exports.getRadioList = function() {
     return doPost(window.location.href + 'getRadioList/')
 }